@@ -1,11 +1,17 @@
 #include "tacDemo.h"
 #include "tacLibrary\imgui\imgui.h"
 #include "tacLibrary\tacRaycast.h"
+#include "tacLibrary\tacJobProfiler.h"
+#include "tacLibrary\tacProfiler.h"
+#include "tacLibrary\tacFastMath.h"
 #include "tacGraphics\tac3camera.h"
 #include "tacGraphics\tacRenderGroup.h"
+#include "tacGraphics\tacRendererSoftware.h"
 
 const char* demofinalfilepath = "tacData/Shaders/Directx/DemoFinal.fx";
 const char* demofxfilepath = "tacData/Shaders/Directx/Demo.fx";
+const char* demoinstancedfxfilepath =
+  "tacData/Shaders/Directx/DemoInstanced.fx";
 
 struct FrustumCorners
 {
@@ -62,6 +68,39 @@ struct CBufferSSAO
   static const int GetArrayCountSSAOKernel = 8;
 };
 
+// The random unit vectors the ssao pass rotates its kernel by
+struct RandomDirectionGenerator
+{
+  constexpr v4 operator()( u32 i ) const
+  {
+    r32 x = HashReal( i * 3 + 0, -1.0f, 1.0f );
+    r32 y = HashReal( i * 3 + 1, -1.0f, 1.0f );
+    r32 z = HashReal( i * 3 + 2, -1.0f, 1.0f );
+    r32 length = CompileTimeSquareRoot( x * x + y * y + z * z );
+    v4 result = V4( x / length, y / length, z / length, 0.0f );
+    return result;
+  }
+};
+
+// Offsets in the +z hemisphere, bunched up near the center
+struct SSAOKernelGenerator
+{
+  constexpr v4 operator()( u32 i ) const
+  {
+    u32 seed = HashU32( CBufferSSAO::GetArrayCountSSAOKernel ) + i * 3;
+    r32 x = HashReal( seed + 0, -1.0f, 1.0f );
+    r32 y = HashReal( seed + 1, -1.0f, 1.0f );
+    r32 z = HashReal( seed + 2, 0.0f, 1.0f );
+    r32 scale =
+      ( r32 )( i + 1 ) /
+      ( r32 )CBufferSSAO::GetArrayCountSSAOKernel;
+    r32 lengthScale =
+      scale * scale / CompileTimeSquareRoot( x * x + y * y + z * z );
+    v4 result = V4( x * lengthScale, y * lengthScale, z * lengthScale, 0.0f );
+    return result;
+  }
+};
+
 struct DemoFinalShader
 {
   // cbuffers
@@ -171,6 +210,138 @@ v3 GetRandomTreeColor()
   v3 color = colors[ colorIndex ];
   return color;
 }
+
+// c++ versions of Demo.fx, DemoInstanced.fx and DemoFinal.fx for
+// RendererSoftware. Only the first render target is drawn to, so the
+// gbuffer shaders just write the color, and the final pass copies it
+// without the ssao
+struct DemoSoftwareUniforms
+{
+  TacUniformHandle view;
+  TacUniformHandle proj;
+  TacUniformHandle world;
+  TacUniformHandle color;
+};
+globalVariable DemoSoftwareUniforms demoSoftwareUniforms;
+
+internalFunction v4 DemoSoftwareWorldToClip(
+  const TacSoftwareShaderContext& context,
+  v4 worldSpacePosition )
+{
+  const m4& view = *( const m4* )context.GetUniform(
+    demoSoftwareUniforms.view );
+  const m4& proj = *( const m4* )context.GetUniform(
+    demoSoftwareUniforms.proj );
+  v4 result = proj * ( view * worldSpacePosition );
+  return result;
+}
+
+internalFunction void DemoSoftwareVS(
+  const TacSoftwareShaderContext& context,
+  TacSoftwareVertex& out )
+{
+  const m4& world = *( const m4* )context.GetUniform(
+    demoSoftwareUniforms.world );
+  v4 position = context.GetAttribute( TacAttributeType::Position );
+  out.mPosition = DemoSoftwareWorldToClip( context, world * position );
+}
+
+internalFunction v4 DemoSoftwarePS(
+  const TacSoftwareShaderContext& context,
+  const r32* varyings )
+{
+  TacUnusedParameter( varyings );
+  const v3& color = *( const v3* )context.GetUniform(
+    demoSoftwareUniforms.color );
+  return V4( color, 1.0f );
+}
+
+// varyings are the instance color
+internalFunction void DemoSoftwareInstancedVS(
+  const TacSoftwareShaderContext& context,
+  TacSoftwareVertex& out )
+{
+  v4 position = context.GetAttribute( TacAttributeType::Position );
+  v4 worldSpacePosition;
+  for( u32 iRow = 0; iRow < 4; ++iRow )
+  {
+    v4 worldRow =
+      context.GetAttribute( TacAttributeType::InstanceWorld, iRow );
+    worldSpacePosition[ iRow ] = Dot( worldRow, position );
+  }
+  out.mPosition = DemoSoftwareWorldToClip( context, worldSpacePosition );
+  v4 color = context.GetAttribute( TacAttributeType::InstanceColor );
+  for( u32 i = 0; i < 3; ++i )
+    out.mVaryings[ i ] = color[ i ];
+}
+
+internalFunction v4 DemoSoftwareInstancedPS(
+  const TacSoftwareShaderContext& context,
+  const r32* varyings )
+{
+  TacUnusedParameter( context );
+  return V4( varyings[ 0 ], varyings[ 1 ], varyings[ 2 ], 1.0f );
+}
+
+// varyings are the uvs
+internalFunction void DemoSoftwareFinalVS(
+  const TacSoftwareShaderContext& context,
+  TacSoftwareVertex& out )
+{
+  v4 position = context.GetAttribute( TacAttributeType::Position );
+  v4 uvs = context.GetAttribute( TacAttributeType::Texcoord );
+  out.mPosition = V4( position.x, position.y, position.z, 1.0f );
+  // convert from opengl to directx
+  out.mVaryings[ 0 ] = uvs.x;
+  out.mVaryings[ 1 ] = 1.0f - uvs.y;
+}
+
+internalFunction v4 DemoSoftwareFinalPS(
+  const TacSoftwareShaderContext& context,
+  const r32* varyings )
+{
+  return context.Sample(
+    DemoFinalShader::GetNameGBufferColor(),
+    V2( varyings[ 0 ], varyings[ 1 ] ) );
+}
+
+// The callbacks point into this dll, so this runs again after every reload
+internalFunction void DemoSetSoftwareShaders(
+  TacGameState* state,
+  RendererSoftware* softwareRenderer )
+{
+  demoSoftwareUniforms.view =
+    softwareRenderer->GetUniformHandle( CBufferPerFrame::GetNameView() );
+  demoSoftwareUniforms.proj =
+    softwareRenderer->GetUniformHandle( CBufferPerFrame::GetNameProj() );
+  demoSoftwareUniforms.world = softwareRenderer->GetUniformHandle( "World" );
+  demoSoftwareUniforms.color = softwareRenderer->GetUniformHandle( "Color" );
+
+  // without these the shaders would read through null, so the demo's
+  // draws are skipped instead
+  if( demoSoftwareUniforms.view.mIndex == RENDERER_ID_NONE ||
+    demoSoftwareUniforms.proj.mIndex == RENDERER_ID_NONE ||
+    demoSoftwareUniforms.world.mIndex == RENDERER_ID_NONE ||
+    demoSoftwareUniforms.color.mIndex == RENDERER_ID_NONE )
+    return;
+
+  softwareRenderer->SetShaderCallbacks(
+    state->shaderHandle,
+    DemoSoftwareVS,
+    DemoSoftwarePS,
+    0 );
+  softwareRenderer->SetShaderCallbacks(
+    state->instancedShaderHandle,
+    DemoSoftwareInstancedVS,
+    DemoSoftwareInstancedPS,
+    3 );
+  softwareRenderer->SetShaderCallbacks(
+    state->gbufferFinalShader,
+    DemoSoftwareFinalVS,
+    DemoSoftwareFinalPS,
+    2 );
+}
+
 // ------------------------------------------------------------------------
 
 extern "C" __declspec( dllexport )
@@ -239,14 +410,22 @@ void GameOnLoad(
 
     }
 
-    statetransient->highPriorityQueue =
-      gameInterface.gameMemory->highPriorityQueue;
+    statetransient->workQueue =
+      gameInterface.gameMemory->workQueue;
 
 
     state->gameTransientState = statetransient;
     state->Init( gameInterface );
+    if( gameInterface.gameUnrecoverableErrors.size )
+      return;
   }
 
+  if( gameInterface.softwareRenderer )
+  {
+    TacGameState* state =
+      ( TacGameState* )gameInterface.gameMemory->permanentStorage;
+    DemoSetSoftwareShaders( state, gameInterface.softwareRenderer );
+  }
 }
 
 extern "C" __declspec( dllexport )
@@ -255,6 +434,7 @@ void GameUpdateAndRender(
 {
   TacGameState* state = ( TacGameState* )gameInterface.gameMemory->permanentStorage;
   state->Update( gameInterface );
+  ProfilerFrameEnd();
 }
 
 extern "C" __declspec( dllexport )
@@ -310,6 +490,35 @@ struct DemoVertex
   }
 };
 
+// Per instance data for DemoInstanced.fx, in the vertex buffer slot after
+// the DemoVertexes
+struct DemoInstance
+{
+  m4 world;
+  v3 color;
+  static const u32 numVertexFormats = 5;
+  static void Fill( TacVertexFormat* vertexFormats, u32 inputSlot )
+  {
+    for( u32 iRow = 0; iRow < 4; ++iRow )
+    {
+      TacVertexFormat& vertexFormat = vertexFormats[ iRow ];
+      vertexFormat.mAlignedByteOffset =
+        OffsetOf( DemoInstance, world ) + iRow * sizeof( v4 );
+      vertexFormat.mAttributeType = TacAttributeType::InstanceWorld;
+      vertexFormat.mInputSlot = inputSlot;
+      vertexFormat.textureFormat = TacTextureFormat::RGBA32Float;
+    }
+
+    {
+      TacVertexFormat& vertexFormat = vertexFormats[ 4 ];
+      vertexFormat.mAlignedByteOffset = OffsetOf( DemoInstance, color );
+      vertexFormat.mAttributeType = TacAttributeType::InstanceColor;
+      vertexFormat.mInputSlot = inputSlot;
+      vertexFormat.textureFormat = TacTextureFormat::RGB32Float;
+    }
+  }
+};
+
 void TacGameState::Init( TacGameInterface& gameInterface )
 {
   clearcolor = V4< r32 >(
@@ -317,6 +526,74 @@ void TacGameState::Init( TacGameInterface& gameInterface )
     192 / 255.0f,
     238 / 255.0f,
     255 / 255.0f );
+
+  // frame governor
+  {
+    GovernorInit( &governor, 12.0f );
+    const char* subsystemNames[ ( u32 )DemoGovernorSubsystem::Count ] =
+    {
+      "Entity transforms",
+      "Raycasts",
+      "Particles",
+      "Physics",
+      "Record draws",
+    };
+    for( const char* subsystemName : subsystemNames )
+    {
+      GovernorAddSubsystem( &governor, subsystemName );
+    }
+    GovernorAddKnob(
+      &governor,
+      "Particle cap",
+      ( u32 )DemoGovernorSubsystem::Particles,
+      10.0f,
+      ( r32 )TacEmitter::maxparticles,
+      10.0f );
+    GovernorAddKnob(
+      &governor,
+      "Physics substeps",
+      ( u32 )DemoGovernorSubsystem::Physics,
+      1.0f,
+      4.0f,
+      1.0f );
+    GovernorAddKnob(
+      &governor,
+      "Raycast rate",
+      ( u32 )DemoGovernorSubsystem::Raycasts,
+      0.25f,
+      1.0f,
+      0.25f );
+    GovernorAddKnob(
+      &governor,
+      "LOD detail",
+      ( u32 )DemoGovernorSubsystem::RecordDraws,
+      0.25f,
+      1.0f,
+      0.25f );
+    TacAssert( governor.numKnobs == ( u32 )DemoGovernorKnob::Count );
+    entityRaycast = {};
+    entityRaycastIndex = 0;
+    framesSinceEntityRaycast = 0;
+    numGovernorLogLinesShown = 0;
+  }
+
+  cullEntities = true;
+  cullEntitiesSimd = true;
+  entityCullStats = {};
+  occlusionCulling = true;
+  occluderMinRadius = 5.0f;
+  numOccluderTriangles = 0;
+
+  AabbTreeInit( &entityTree, 0.25f );
+  entityTreeStale = true;
+  for( b32& assetLoaded : entityTreeAssetLoaded )
+    assetLoaded = false;
+  useEntityTree = true;
+  useLods = true;
+  lodPixelError = 1.0f;
+  lodHysteresis = 0.25f;
+  for( u32& entityLodCount : entityLodCounts )
+    entityLodCount = 0;
   gameInterface.renderer->DebugBegin( "Game init" );
   OnDestruct( gameInterface.renderer->DebugEnd(); );
 
@@ -366,8 +643,8 @@ void TacGameState::Init( TacGameInterface& gameInterface )
     gameTransientState->messages.maxMessageTime = 2;
 
     gameTransientState->mTempAllocator;
-    gameTransientState->gameAssets.highPriorityQueue =
-      gameTransientState->highPriorityQueue;
+    gameTransientState->gameAssets.workQueue =
+      gameTransientState->workQueue;
     gameTransientState->gameAssets.renderer = gameInterface.renderer;
     for(
       u32 i = 0;
@@ -571,6 +848,74 @@ void TacGameState::Init( TacGameInterface& gameInterface )
       return;
   }
 
+  // instanced shader, world and color come from the instance buffer
+  // instead of the per object cbuffer
+  {
+    const char* shaderPaths[ ( u32 )TacShaderType::Count ] = {};
+    const char* entryPoints[ ( u32 )TacShaderType::Count ] = {};
+    const char* shaderModels[ ( u32 )TacShaderType::Count ] = {};
+
+    u32 shaderTypeIndex = ( u32 )TacShaderType::Vertex;
+    shaderPaths[ shaderTypeIndex ] = demoinstancedfxfilepath;
+    entryPoints[ shaderTypeIndex ] = "VS";
+    shaderModels[ shaderTypeIndex ] = "vs_4_0";
+
+    shaderTypeIndex = ( u32 )TacShaderType::Fragment;
+    shaderPaths[ shaderTypeIndex ] = demoinstancedfxfilepath;
+    entryPoints[ shaderTypeIndex ] = "PS";
+    shaderModels[ shaderTypeIndex ] = "ps_4_0";
+
+    instancedShaderHandle = gameInterface.renderer->LoadShader(
+      shaderPaths,
+      entryPoints,
+      shaderModels,
+      gameInterface.gameUnrecoverableErrors );
+    if( gameInterface.gameUnrecoverableErrors.size )
+      return;
+    gameInterface.renderer->SetName(
+      instancedShaderHandle,
+      STRINGIFY( instancedShaderHandle ) );
+
+    gameInterface.renderer->AddCbuffer(
+      instancedShaderHandle,
+      cbufferHandlePerFrame,
+      0,
+      TacShaderType::Vertex,
+      gameInterface.gameUnrecoverableErrors );
+    if( gameInterface.gameUnrecoverableErrors.size )
+      return;
+
+    const u32 numVertexFormats =
+      DemoVertex::numVertexFormats +
+      DemoInstance::numVertexFormats;
+    TacVertexFormat vertexFormats[ numVertexFormats ] = {};
+    DemoVertex::Fill( vertexFormats );
+    DemoInstance::Fill( vertexFormats + DemoVertex::numVertexFormats, 1 );
+    instancedVertexFormatHandle = gameInterface.renderer->AddVertexFormat(
+      vertexFormats,
+      numVertexFormats,
+      instancedShaderHandle,
+      gameInterface.gameUnrecoverableErrors );
+    if( gameInterface.gameUnrecoverableErrors.size )
+      return;
+    gameInterface.renderer->SetName(
+      instancedVertexFormatHandle,
+      STRINGIFY( instancedVertexFormatHandle ) );
+
+    maxInstances = minInstances;
+    instanceBuffer = gameInterface.renderer->AddVertexBuffer(
+      TacBufferAccess::Dynamic,
+      nullptr,
+      maxInstances,
+      sizeof( DemoInstance ),
+      gameInterface.gameUnrecoverableErrors );
+    if( gameInterface.gameUnrecoverableErrors.size )
+      return;
+    gameInterface.renderer->SetName(
+      instanceBuffer,
+      STRINGIFY( instanceBuffer ) );
+  }
+
   // ndc quad
   {
     // vbo
@@ -871,22 +1216,10 @@ void TacGameState::Init( TacGameInterface& gameInterface )
     if( gameInterface.gameUnrecoverableErrors.size )
       return;
 
-    srand( 0 );
-    std::vector< v4 > randomVectors;
-    randomVectors.resize( numRows * numCols );
-    for( u32 i = 0; i < numRows * numCols; ++i )
-    {
-      v4 v =
-      {
-        RandReal( -1, 1 ),
-        RandReal( -1, 1 ),
-        RandReal( -1, 1 ),
-        0
-      };
-      randomVectors[ i ] = Normalize( v );
-    }
+    static constexpr TacTable< v4, numRows * numCols > randomVectors =
+      MakeTable< v4, numRows * numCols >( RandomDirectionGenerator() );
     TacImage randomVectorImage = {};
-    randomVectorImage.mData = ( u8* )randomVectors.data();
+    randomVectorImage.mData = ( u8* )randomVectors.e;
     randomVectorImage.mWidth = numRows;
     randomVectorImage.mHeight = numCols;
     randomVectorImage.mPitch = sizeof( v4 ) * numCols;
@@ -990,11 +1323,315 @@ void DisplayEntity( TacEntity& entity )
   }
 }
 
+void DisplayJobProfiler(
+  TacThreadContext* thread,
+  TacJobProfiler* profiler,
+  MessageLoop& messages )
+{
+  bool enabled = profiler->enabled != 0;
+  if( ImGui::Checkbox( "Record", &enabled ) )
+  {
+    profiler->enabled = enabled;
+  }
+  ImGui::SameLine();
+  if( ImGui::Button( "Clear" ) )
+  {
+    JobProfilerClear( profiler );
+  }
+  ImGui::SameLine();
+  if( ImGui::Button( "Export chrome trace" ) )
+  {
+    const char* traceFilepath = "jobtrace.json";
+    FixedString< DEFAULT_ERR_LEN > traceErrors = {};
+    JobProfilerExportChromeTrace(
+      thread,
+      profiler,
+      traceFilepath,
+      traceErrors );
+    messages.AddMessage( traceErrors.size ?
+      traceErrors.buffer :
+      VA( "Saved %s, open it in chrome://tracing", traceFilepath ) );
+  }
+  static r32 timelineMs = 33.0f;
+  ImGui::DragFloat( "timeline ms", &timelineMs, 0.1f, 1.0f, 1000.0f );
+
+  // the newest events are on the right edge
+  u64 timelineEnd = JobProfilerNow();
+  u64 timelineNs = ( u64 )( timelineMs * 1000000.0f );
+  u64 timelineBegin = timelineEnd - timelineNs;
+
+  const r32 laneHeight = 20.0f;
+  const r32 laneLabelWidth = 90.0f;
+  r32 laneWidth =
+    Maximum( ImGui::GetContentRegionAvail().x - laneLabelWidth, 1.0f );
+  ImDrawList* drawList = ImGui::GetWindowDrawList();
+  const ImU32 priorityColors[ ( u32 )TacJobPriority::Count ] =
+  {
+    ImColor( 230, 80, 60 ),
+    ImColor( 240, 190, 60 ),
+    ImColor( 70, 140, 230 ),
+  };
+  const ImU32 sleepColor = ImColor( 60, 60, 60 );
+  auto TimeToX = [ & ]( r32 laneX, u64 time )
+  {
+    time = Maximum( time, timelineBegin );
+    r32 t = ( r32 )( time - timelineBegin ) / ( r32 )timelineNs;
+    return laneX + t * laneWidth;
+  };
+
+  for( u32 iThread = 0; iThread < profiler->numThreads; ++iThread )
+  {
+    TacJobProfilerThread& profilerThread = profiler->threads[ iThread ];
+    ImVec2 lanePos = ImGui::GetCursorScreenPos();
+    r32 laneX = lanePos.x + laneLabelWidth;
+    bool isPushingThread = iThread + 1 == profiler->numThreads;
+
+    u32 numEventsWritten = profilerThread.numEventsWritten;
+    u32 iOldest = numEventsWritten > TacJobProfilerThread::maxEvents ?
+      numEventsWritten - TacJobProfilerThread::maxEvents : 0;
+    u64 busyNs = 0;
+    const TacJobEvent* openEvent = nullptr;
+    for( u32 iEvent = iOldest; iEvent < numEventsWritten; ++iEvent )
+    {
+      const TacJobEvent& event =
+        profilerThread.events[ iEvent % TacJobProfilerThread::maxEvents ];
+      switch( event.type )
+      {
+        case TacJobEventType::Start:
+        case TacJobEventType::SleepBegin:
+        {
+          openEvent = &event;
+        } break;
+        case TacJobEventType::End:
+        case TacJobEventType::SleepEnd:
+        {
+          if( !openEvent || event.time < timelineBegin )
+          {
+            openEvent = nullptr;
+            break;
+          }
+          b32 sleeping = event.type == TacJobEventType::SleepEnd;
+          ImVec2 rectMin( TimeToX( laneX, openEvent->time ), lanePos.y );
+          ImVec2 rectMax( TimeToX( laneX, event.time ), lanePos.y + laneHeight );
+          rectMax.x = Maximum( rectMax.x, rectMin.x + 1.0f );
+          drawList->AddRectFilled(
+            rectMin,
+            rectMax,
+            sleeping ? sleepColor : priorityColors[ ( u32 )event.priority ] );
+          u64 durationNs = event.time - Maximum( openEvent->time, timelineBegin );
+          if( !sleeping )
+          {
+            busyNs += durationNs;
+          }
+          if( ImGui::IsMouseHoveringRect( rectMin, rectMax ) )
+          {
+            if( sleeping )
+            {
+              ImGui::SetTooltip( "sleep %.3f ms", durationNs / 1000000.0f );
+            }
+            else
+            {
+              ImGui::SetTooltip( "%p %s %.3f ms",
+                event.callback,
+                JobPriorityToString( event.priority ),
+                durationNs / 1000000.0f );
+            }
+          }
+          openEvent = nullptr;
+        } break;
+        case TacJobEventType::Enqueue:
+        {
+          if( event.time < timelineBegin )
+            break;
+          r32 x = TimeToX( laneX, event.time );
+          drawList->AddLine(
+            ImVec2( x, lanePos.y ),
+            ImVec2( x, lanePos.y + laneHeight ),
+            priorityColors[ ( u32 )event.priority ] );
+        } break;
+        case TacJobEventType::Count: TacInvalidCodePath; break;
+        TacInvalidDefaultCase;
+      }
+    }
+
+    ImGui::Text( isPushingThread ? "main" : "worker %i", iThread );
+    ImGui::SameLine( laneLabelWidth );
+    ImGui::Dummy( ImVec2( laneWidth, laneHeight ) );
+    if( ImGui::IsItemHovered() && !isPushingThread )
+    {
+      ImGui::SetTooltip( "busy %.1f%%", 100.0f * busyNs / timelineNs );
+    }
+  }
+}
+
+// Draws node and its children left to right, returns the width drawn
+r32 DisplayProfileNode(
+  TacProfiler* profiler,
+  u32 nodeIndex,
+  ImVec2 pos,
+  r32 pixelsPerMs,
+  r32 rowHeight )
+{
+  TacProfileNode& node = profiler->nodes[ nodeIndex ];
+  r32 width = node.avgMs * pixelsPerMs;
+  if( width < 1.0f )
+    return width;
+
+  ImVec2 rectMin = pos;
+  ImVec2 rectMax( pos.x + width, pos.y + rowHeight - 1.0f );
+  // hash the name so a zone keeps its color from frame to frame
+  u32 hash = ( u32 )( uintptr_t )node.name * 2654435761u;
+  ImU32 color = ImColor(
+    ( int )( 150 + ( hash >> 8 ) % 100 ),
+    ( int )( 80 + ( hash >> 16 ) % 100 ),
+    ( int )( 40 + ( hash >> 24 ) % 60 ) );
+  ImDrawList* drawList = ImGui::GetWindowDrawList();
+  drawList->AddRectFilled( rectMin, rectMax, color );
+  ImVec2 textSize = ImGui::CalcTextSize( node.name );
+  if( textSize.x + 4.0f < width )
+  {
+    drawList->AddText(
+      ImVec2( pos.x + 2.0f, pos.y ),
+      ImColor( 0, 0, 0 ),
+      node.name );
+  }
+  if( ImGui::IsMouseHoveringRect( rectMin, rectMax ) )
+  {
+    ImGui::SetTooltip(
+      "%s\n"
+      "min %.3f ms\n"
+      "avg %.3f ms\n"
+      "max %.3f ms\n"
+      "calls %i",
+      node.name,
+      node.minMs,
+      node.avgMs,
+      node.maxMs,
+      node.lastCalls );
+  }
+
+  ImVec2 childPos( pos.x, pos.y + rowHeight );
+  for( u32 childIndex : node.childIndexes )
+  {
+    childPos.x += DisplayProfileNode(
+      profiler,
+      childIndex,
+      childPos,
+      pixelsPerMs,
+      rowHeight );
+  }
+  return width;
+}
+
+u32 GetProfileNodeHeight( TacProfiler* profiler, u32 nodeIndex )
+{
+  u32 height = 0;
+  for( u32 childIndex : profiler->nodes[ nodeIndex ].childIndexes )
+  {
+    height = Maximum( height, GetProfileNodeHeight( profiler, childIndex ) );
+  }
+  return height + 1;
+}
+
+void DisplayProfiler( TacProfiler* profiler )
+{
+  ImGui::Text(
+    "min / avg / max over the last %i frames",
+    TacProfileNode::sNumFrames );
+  static r32 flameGraphMs = 33.0f;
+  ImGui::DragFloat( "flame graph ms", &flameGraphMs, 0.1f, 1.0f, 1000.0f );
+  r32 pixelsPerMs = ImGui::GetContentRegionAvail().x / flameGraphMs;
+  const r32 rowHeight = ImGui::GetTextLineHeightWithSpacing();
+  for( u32 rootIndex : profiler->threadRootIndexes )
+  {
+    TacProfileNode& root = profiler->nodes[ rootIndex ];
+    if( root.maxMs == 0 )
+      continue;
+    ImGui::Text( "%s avg %.3f ms", root.name, root.avgMs );
+    ImVec2 pos = ImGui::GetCursorScreenPos();
+    r32 x = pos.x;
+    for( u32 childIndex : root.childIndexes )
+    {
+      x += DisplayProfileNode(
+        profiler,
+        childIndex,
+        ImVec2( x, pos.y ),
+        pixelsPerMs,
+        rowHeight );
+    }
+    u32 height = GetProfileNodeHeight( profiler, rootIndex ) - 1;
+    ImGui::Dummy( ImVec2( 1.0f, height * rowHeight ) );
+  }
+}
+
+void DisplayGovernor( TacFrameGovernor* governor )
+{
+  ImGui::Checkbox( "Enabled", ( bool* )&governor->enabled );
+  ImGui::DragFloat( "Target ms", &governor->targetMs, 0.1f, 1.0f, 100.0f );
+  ImGui::DragFloat( "Headroom", &governor->headroom, 0.01f, 0.0f, 0.9f );
+  ImGui::Text(
+    "Frame %.2f ms, avg %.2f ms",
+    governor->lastFrameMs,
+    governor->avgFrameMs );
+  for( u32 iSubsystem = 0;
+    iSubsystem < governor->numSubsystems;
+    ++iSubsystem )
+  {
+    TacGovernorSubsystem& subsystem = governor->subsystems[ iSubsystem ];
+    ImGui::Text(
+      "%-20s %6.3f ms avg %6.3f ms",
+      subsystem.name.buffer,
+      subsystem.lastMs,
+      subsystem.avgMs );
+  }
+  ImGui::Separator();
+
+  // dragging a knob while enabled only lasts until the next change
+  for( u32 iKnob = 0; iKnob < governor->numKnobs; ++iKnob )
+  {
+    TacGovernorKnob& knob = governor->knobs[ iKnob ];
+    ImGui::SliderFloat(
+      knob.name.buffer,
+      &knob.value,
+      knob.minValue,
+      knob.maxValue );
+  }
+  ImGui::Separator();
+
+  u32 numLogLines = Minimum(
+    governor->numLogLinesWritten,
+    TacFrameGovernor::maxLogLines );
+  for( u32 i = 0; i < numLogLines; ++i )
+  {
+    u32 iLogLine = governor->numLogLinesWritten - 1 - i;
+    ImGui::Text(
+      "%s",
+      governor->log[ iLogLine % TacFrameGovernor::maxLogLines ].buffer );
+  }
+}
+
+TacSphere WorldSpaceBoundingSphere(
+  const TacEntity& entity,
+  const TacModelRaycastInfo& modelRaycastInfo )
+{
+  r32 scale = Maximum( Maximum(
+    entity.mScale.x,
+    entity.mScale.y ),
+    entity.mScale.z );
+
+  TacSphere result;
+  result.position = ( entity.world *
+    V4( modelRaycastInfo.boundingSphere.position, 1.0f ) ).xyz;
+  result.radius = modelRaycastInfo.boundingSphere.radius * scale;
+  return result;
+}
+
 TacRaycastResult RaycastEntityTris(
   TacEntity& entity,
   TacRay ray,
   TacGameAssets& gameAssets )
 {
+  TAC_PROFILE_SCOPE( "RaycastEntityTris" );
   TacRaycastResult raycastResultClosestTri = {};
   raycastResultClosestTri.dist = R32MAX;
   TacModelRaycastInfo* modelRaycastInfo =
@@ -1040,6 +1677,19 @@ TacRaycastResult RaycastEntityTris(
 
 void TacGameState::Update( TacGameInterface& gameInterface )
 {
+  TAC_PROFILE_SCOPE( "TacGameState::Update" );
+  GovernorBeginFrame( &governor );
+  OnDestruct( GovernorEndFrame( &governor ); );
+
+  // the changes the governor made last frame
+  for( ;
+    numGovernorLogLinesShown < governor.numLogLinesWritten;
+    ++numGovernorLogLinesShown )
+  {
+    gameTransientState->messages.AddMessage( governor.log[
+      numGovernorLogLinesShown % TacFrameGovernor::maxLogLines ].buffer );
+  }
+
   const r32 aspect =
     ( r32 )gameInterface.windowWidth /
     ( r32 )gameInterface.windowHeight;
@@ -1066,7 +1716,16 @@ void TacGameState::Update( TacGameInterface& gameInterface )
     camFOVYRad,
     aspect );
 
-  emitter.Update( gameInterface.gameInput->dt );
+  {
+    TacGovernorScope governorScope(
+      &governor,
+      ( u32 )DemoGovernorSubsystem::Particles );
+    emitter.Update(
+      gameInterface.gameInput->dt,
+      ( u32 )GetKnob( DemoGovernorKnob::ParticleCap ),
+      gameTransientState->workQueue,
+      gameInterface.thread );
+  }
   TacModel* spheremodel = gameTransientState->gameAssets.GetModel(
     TacGameAssetID::Sphere );
   TacModel* cubemodel = gameTransientState->gameAssets.GetModel(
@@ -1211,6 +1870,113 @@ void TacGameState::Update( TacGameInterface& gameInterface )
     ImGui::Unindent();
   }
 
+  if( ImGui::CollapsingHeader( "CPU profiler" ) )
+  {
+    DisplayProfiler( ProfilerGet() );
+  }
+
+  if( ImGui::CollapsingHeader( "Frame governor" ) )
+  {
+    DisplayGovernor( &governor );
+  }
+
+  if( ImGui::CollapsingHeader( "Render state" ) )
+  {
+    u32 numStateChanges =
+      renderStateStats.mNumIssued +
+      renderStateStats.mNumSkipped;
+    ImGui::Text( "Issued:  %u", renderStateStats.mNumIssued );
+    ImGui::Text( "Skipped: %u", renderStateStats.mNumSkipped );
+    if( numStateChanges )
+    {
+      ImGui::Text( "Skipped %.1f%%",
+        100.0f * renderStateStats.mNumSkipped / numStateChanges );
+    }
+  }
+
+  if( ImGui::CollapsingHeader( "Culling" ) )
+  {
+    ImGui::Checkbox( "Cull entities", ( bool* )&cullEntities );
+    ImGui::Checkbox( "Use SIMD", ( bool* )&cullEntitiesSimd );
+    ImGui::Checkbox( "Use entity tree", ( bool* )&useEntityTree );
+    ImGui::Text( "Tree leaves: %u", entityTree.numLeaves );
+    ImGui::Text( "Tree height: %i", AabbTreeHeight( &entityTree ) );
+    ImGui::Checkbox( "Occlusion culling", ( bool* )&occlusionCulling );
+    ImGui::DragFloat(
+      "Occluder min radius",
+      &occluderMinRadius,
+      0.1f,
+      0.0f,
+      1000.0f );
+    ImGui::Text( "Occluder triangles: %u", numOccluderTriangles );
+    u32 numCulled =
+      entityCullStats.numTested -
+      entityCullStats.numVisible;
+    ImGui::Text( "Tested:   %u", entityCullStats.numTested );
+    ImGui::Text( "Visible:  %u", entityCullStats.numVisible );
+    ImGui::Text( "Culled:   %u", numCulled );
+    ImGui::Text( "Occluded: %u", entityCullStats.numOccluded );
+    if( entityCullStats.numTested )
+    {
+      ImGui::Text( "Culled %.1f%%",
+        100.0f * numCulled / entityCullStats.numTested );
+    }
+  }
+
+  if( ImGui::CollapsingHeader( "LOD" ) )
+  {
+    ImGui::Checkbox( "Use LODs", ( bool* )&useLods );
+    ImGui::DragFloat(
+      "Max pixel error",
+      &lodPixelError,
+      0.05f,
+      0.05f,
+      100.0f );
+    ImGui::DragFloat( "Hysteresis", &lodHysteresis, 0.01f, 0.0f, 0.9f );
+    for( u32 iLod = 0; iLod < MAX_MODEL_LODS; ++iLod )
+      ImGui::Text( "LOD %u draws: %u", iLod, entityLodCounts[ iLod ] );
+    for( u32 iAsset = 0; iAsset < ( u32 )TacGameAssetID::Count; ++iAsset )
+    {
+      TacGameAssets::AsyncModelParams& param =
+        gameTransientState->gameAssets.params[ iAsset ];
+      if( param.status != TacGameAssets::AsyncTaskStatus::Finished )
+        continue;
+      TacModel* model = param.model;
+      ImGui::Text( "%s: %u lods", assetIDstrings[ iAsset ], model->numLods );
+      for( u32 iLod = 1; iLod < model->numLods; ++iLod )
+      {
+        ImGui::Text(
+          "  LOD %u error: %.2f%% of the radius",
+          iLod,
+          100.0f * model->lodErrors[ iLod ] );
+      }
+    }
+  }
+
+  if( ImGui::CollapsingHeader( "Job profiler" ) )
+  {
+    DisplayJobProfiler(
+      gameInterface.thread,
+      gameTransientState->workQueue->profiler,
+      gameTransientState->messages );
+  }
+
+  if( ImGui::CollapsingHeader( "Fast math" ) )
+  {
+#if TACFASTMATH
+    ImGui::Text( "tacMath trig: tacFastMath" );
+#else
+    ImGui::Text( "tacMath trig: libm" );
+#endif
+    // stalls the frame for a moment
+    if( ImGui::Button( "Run benchmark" ) )
+    {
+      FastMathBenchmark();
+      gameTransientState->messages.AddMessage(
+        "Fast math benchmark written to the debug output" );
+    }
+  }
+
   static r32 reloadt = 0;
   reloadt += gameInterface.gameInput->dt;
   if( reloadt > 1 )
@@ -1240,15 +2006,208 @@ void TacGameState::Update( TacGameInterface& gameInterface )
   ImGui::Text( "MouseX: %f", ( r32 )gameInterface.gameInput->mouseX );
   ImGui::Text( "MouseY: %f", ( r32 )gameInterface.gameInput->mouseY );
 
+  TacWorkQueue* queue = gameTransientState->workQueue;
+  TacThreadContext* thread = gameInterface.thread;
+
+  // resolve these up front so the workers don't touch the asset statuses
+  TacModelRaycastInfo* modelRaycastInfos[ ( u32 )TacGameAssetID::Count ];
+  for( u32 iAsset = 0; iAsset < ( u32 )TacGameAssetID::Count; ++iAsset )
+  {
+    modelRaycastInfos[ iAsset ] =
+      gameTransientState->gameAssets.GetModelRaycastInfo(
+      ( TacGameAssetID )iAsset );
+  }
+
   // Update entity transforms
-  for( u32 iEntity = 0; iEntity < entities.size(); ++iEntity )
   {
-    TacEntity& entity = entities[ iEntity ];
-    if( entity.transformDirty )
+    TacTemporaryMemory tempTransformMemory =
+      BeginTemporaryMemory( &gameTransientState->mTempAllocator );
+    OnDestruct( EndTemporaryMemory( tempTransformMemory ); );
+
+    // Each chunk lists the entities it moved, gathers their transforms by
+    // component, and rebuilds their matrixes in one batch
+    TacParallelChunks transformChunks = ComputeParallelChunks(
+      queue,
+      0,
+      entities.size(),
+      0 );
+    u32* movedEntities = PushArray(
+      &gameTransientState->mTempAllocator,
+      entities.size(),
+      u32 );
+    u32 numChunkMovedEntities[ TacParallelChunks::maxChunks ] = {};
+    r32* transformComponents = PushArray(
+      &gameTransientState->mTempAllocator,
+      entities.size() * 9,
+      r32 );
+    m4* movedWorlds = PushArray(
+      &gameTransientState->mTempAllocator,
+      entities.size(),
+      m4 );
+    m4* movedWorldInverses = PushArray(
+      &gameTransientState->mTempAllocator,
+      entities.size(),
+      m4 );
+    if( ( !movedEntities ||
+      !transformComponents ||
+      !movedWorlds ||
+      !movedWorldInverses ) &&
+      !entities.empty() )
+    {
+      gameInterface.gameUnrecoverableErrors =
+        "Could not allocate temporary moved entity memory";
+      return;
+    }
+
+    {
+      TAC_PROFILE_SCOPE( "Update entity transforms" );
+      TacGovernorScope governorScope(
+        &governor,
+        ( u32 )DemoGovernorSubsystem::EntityTransforms );
+      ParallelFor(
+        queue,
+        thread,
+        0,
+        transformChunks.numChunks,
+        1,
+        [ & ]( u32 iChunk )
+      {
+        u32 entityBegin = iChunk * transformChunks.grain;
+        u32 entityEnd = Minimum(
+          entityBegin + transformChunks.grain,
+          ( u32 )entities.size() );
+        u32* chunkMovedEntities = movedEntities + entityBegin;
+        u32& numMoved = numChunkMovedEntities[ iChunk ];
+        for( u32 iEntity = entityBegin; iEntity < entityEnd; ++iEntity )
+        {
+          TacEntity& entity = entities[ iEntity ];
+          if( entity.transformDirty )
+          {
+            entity.transformDirty = false;
+            chunkMovedEntities[ numMoved++ ] = iEntity;
+          }
+        }
+        if( !numMoved )
+          return;
+
+        u32 numEntities = entities.size();
+        r32* components = transformComponents + entityBegin;
+        TacTransformsSoA transforms;
+        transforms.scaleXs = components;
+        transforms.scaleYs = components + numEntities;
+        transforms.scaleZs = components + numEntities * 2;
+        transforms.rotateXs = components + numEntities * 3;
+        transforms.rotateYs = components + numEntities * 4;
+        transforms.rotateZs = components + numEntities * 5;
+        transforms.translateXs = components + numEntities * 6;
+        transforms.translateYs = components + numEntities * 7;
+        transforms.translateZs = components + numEntities * 8;
+        transforms.count = numMoved;
+        for( u32 i = 0; i < numMoved; ++i )
+        {
+          TacEntity& entity = entities[ chunkMovedEntities[ i ] ];
+          transforms.scaleXs[ i ] = entity.mScale.x;
+          transforms.scaleYs[ i ] = entity.mScale.y;
+          transforms.scaleZs[ i ] = entity.mScale.z;
+          transforms.rotateXs[ i ] = entity.mRot.x;
+          transforms.rotateYs[ i ] = entity.mRot.y;
+          transforms.rotateZs[ i ] = entity.mRot.z;
+          transforms.translateXs[ i ] = entity.mPos.x;
+          transforms.translateYs[ i ] = entity.mPos.y;
+          transforms.translateZs[ i ] = entity.mPos.z;
+        }
+        ComputeTransforms(
+          transforms,
+          movedWorlds + entityBegin,
+          movedWorldInverses + entityBegin );
+        for( u32 i = 0; i < numMoved; ++i )
+        {
+          TacEntity& entity = entities[ chunkMovedEntities[ i ] ];
+          entity.world = movedWorlds[ entityBegin + i ];
+          entity.worldInverse = movedWorldInverses[ entityBegin + i ];
+        }
+      } );
+    }
+
+    // pack the chunks' lists into one list of the entities that moved
+    u32 numMovedEntities = 0;
+    for( u32 iChunk = 0; iChunk < transformChunks.numChunks; ++iChunk )
+    {
+      memmove(
+        movedEntities + numMovedEntities,
+        movedEntities + iChunk * transformChunks.grain,
+        sizeof( u32 ) * numChunkMovedEntities[ iChunk ] );
+      numMovedEntities += numChunkMovedEntities[ iChunk ];
+    }
+
+    // Only the moved entities get their bounds refit, unless the bounds
+    // of everything changed
+    TAC_PROFILE_SCOPE( "Update entity tree" );
+    for( u32 iAsset = 0; iAsset < ( u32 )TacGameAssetID::Count; ++iAsset )
     {
-      entity.transformDirty = false;
-      entity.world = M4Transform( entity.mScale, entity.mRot, entity.mPos );
-      entity.worldInverse = M4TransformInverse( entity.mScale, entity.mRot, entity.mPos );
+      b32 assetLoaded = modelRaycastInfos[ iAsset ] != nullptr;
+      if( assetLoaded && !entityTreeAssetLoaded[ iAsset ] )
+        entityTreeStale = true;
+      entityTreeAssetLoaded[ iAsset ] = assetLoaded;
+    }
+    entitySpheres.resize( entities.size() );
+    u32* refitEntities = movedEntities;
+    u32 numRefitEntities = numMovedEntities;
+    if( entityTreeStale )
+    {
+      entityTreeStale = false;
+      AabbTreeClear( &entityTree );
+      numRefitEntities = entities.size();
+      for( u32 iEntity = 0; iEntity < numRefitEntities; ++iEntity )
+        refitEntities[ iEntity ] = iEntity;
+    }
+
+    // The model space bounding spheres are transformed together, in the
+    // scratch arrays the transform pass is done with
+    u32 numEntities = entities.size();
+    TacSpheresSoA refitSpheres;
+    refitSpheres.xs = transformComponents;
+    refitSpheres.ys = transformComponents + numEntities;
+    refitSpheres.zs = transformComponents + numEntities * 2;
+    refitSpheres.radii = transformComponents + numEntities * 3;
+    refitSpheres.count = 0;
+    for( u32 i = 0; i < numRefitEntities; ++i )
+    {
+      u32 iEntity = refitEntities[ i ];
+      TacEntity& entity = entities[ iEntity ];
+      TacModelRaycastInfo* modelRaycastInfo =
+        modelRaycastInfos[ ( u32 )entity.mAssetID ];
+      // until the model's raycast info loads the box is just the position
+      if( !modelRaycastInfo )
+      {
+        TacSphere& sphere = entitySpheres[ iEntity ];
+        sphere.position = entity.mPos;
+        sphere.radius = R32MAX;
+        TacAabb aabb;
+        aabb.mini = aabb.maxi = entity.mPos;
+        AabbTreeUpdate( &entityTree, iEntity, aabb );
+        continue;
+      }
+      const TacSphere& modelSphere = modelRaycastInfo->boundingSphere;
+      u32 iSphere = refitSpheres.count++;
+      refitEntities[ iSphere ] = iEntity;
+      refitSpheres.xs[ iSphere ] = modelSphere.position.x;
+      refitSpheres.ys[ iSphere ] = modelSphere.position.y;
+      refitSpheres.zs[ iSphere ] = modelSphere.position.z;
+      refitSpheres.radii[ iSphere ] = modelSphere.radius;
+      movedWorlds[ iSphere ] = entity.world;
+    }
+    TransformSpheres( movedWorlds, refitSpheres, refitSpheres );
+    for( u32 iSphere = 0; iSphere < refitSpheres.count; ++iSphere )
+    {
+      u32 iEntity = refitEntities[ iSphere ];
+      TacSphere& sphere = entitySpheres[ iEntity ];
+      sphere.position = V3(
+        refitSpheres.xs[ iSphere ],
+        refitSpheres.ys[ iSphere ],
+        refitSpheres.zs[ iSphere ] );
+      sphere.radius = refitSpheres.radii[ iSphere ];
+      AabbTreeUpdate( &entityTree, iEntity, AabbFromSphere( sphere ) );
     }
   }
 
@@ -1303,48 +2262,110 @@ void TacGameState::Update( TacGameInterface& gameInterface )
     gameTransientState->gameAssets );
 
   // render
-  TacRaycastResult raycastResultClosestTri;
-  raycastResultClosestTri.collided = false;
-  raycastResultClosestTri.dist = R32MAX;
-  u32 closestEntityIndex = 0;
-  for( u32 iEntity = 0; iEntity < entities.size(); ++iEntity )
+  struct EntityRaycast
   {
-    TacEntity& entity = entities[ iEntity ];
-    if( entity.mType == TacEntityType::Null )
-      continue;
+    TacRaycastResult result;
+    u32 entityIndex;
+  };
+  EntityRaycast noEntityRaycast = {};
+  noEntityRaycast.result.dist = R32MAX;
+
+  // skipped on some frames when over budget, the last result is used then
+  u32 framesBetweenRaycasts =
+    ( u32 )( 1.0f / GetKnob( DemoGovernorKnob::RaycastRate ) + 0.5f );
+  if( ++framesSinceEntityRaycast >= framesBetweenRaycasts ||
+    entityRaycastIndex >= entities.size() )
+  {
+    TAC_PROFILE_SCOPE( "Raycast entities" );
+    TacGovernorScope governorScope(
+      &governor,
+      ( u32 )DemoGovernorSubsystem::Raycasts );
+    framesSinceEntityRaycast = 0;
+
+    TacTemporaryMemory tempRaycastMemory =
+      BeginTemporaryMemory( &gameTransientState->mTempAllocator );
+    OnDestruct( EndTemporaryMemory( tempRaycastMemory ); );
+    u32* candidates = PushArray(
+      &gameTransientState->mTempAllocator,
+      entities.size(),
+      u32 );
+    if( !candidates && !entities.empty() )
+    {
+      gameInterface.gameUnrecoverableErrors =
+        "Could not allocate temporary raycast memory";
+      return;
+    }
+    u32 numCandidates = 0;
+    if( useEntityTree )
+    {
+      numCandidates = AabbTreeQueryRay(
+        &entityTree,
+        ray,
+        mCamera.camFar,
+        candidates,
+        entities.size() );
+    }
+    else
+    {
+      for( u32 iEntity = 0; iEntity < entities.size(); ++iEntity )
+        candidates[ numCandidates++ ] = iEntity;
+    }
 
-    TacModelRaycastInfo* modelRaycastInfo =
-      gameTransientState->gameAssets.GetModelRaycastInfo( entity.mAssetID );
-    if( !modelRaycastInfo )
-      continue;
+    EntityRaycast closestEntityRaycast = ParallelReduce(
+      queue,
+      thread,
+      0,
+      numCandidates,
+      0,
+      noEntityRaycast,
+      [ & ]( u32 iCandidate )
+    {
+      EntityRaycast entityRaycast = noEntityRaycast;
+      u32 iEntity = candidates[ iCandidate ];
+      TacEntity& entity = entities[ iEntity ];
+      if( entity.mType == TacEntityType::Null )
+        return entityRaycast;
 
-    r32 scale = Maximum( Maximum(
-      entity.mScale.x,
-      entity.mScale.y ),
-      entity.mScale.z );
+      TacModelRaycastInfo* modelRaycastInfo =
+        modelRaycastInfos[ ( u32 )entity.mAssetID ];
+      if( !modelRaycastInfo )
+        return entityRaycast;
 
-    TacSphere worldspaceBoundingSphere;
-    worldspaceBoundingSphere.position = ( entity.world *
-      V4( modelRaycastInfo->boundingSphere.position, 1.0f ) ).xyz;
-    worldspaceBoundingSphere.radius = modelRaycastInfo->boundingSphere.radius * scale;
+      TacSphere worldspaceBoundingSphere =
+        WorldSpaceBoundingSphere( entity, *modelRaycastInfo );
 
-    TacRaycastResult raycastBoundingSphereResult =
-      RaySphereIntersection( ray, worldspaceBoundingSphere );
-    if( raycastBoundingSphereResult.collided ||
-      raycastBoundingSphereResult.rayStartedInsideObject )
-    {
-      TacRaycastResult triResult = RaycastEntityTris(
-        entity,
-        ray,
-        gameTransientState->gameAssets );
-      if( triResult.collided &&
-        triResult.dist < raycastResultClosestTri.dist )
+      TacRaycastResult raycastBoundingSphereResult =
+        RaySphereIntersection( ray, worldspaceBoundingSphere );
+      if( raycastBoundingSphereResult.collided ||
+        raycastBoundingSphereResult.rayStartedInsideObject )
       {
-        raycastResultClosestTri = triResult;
-        closestEntityIndex = iEntity;
+        TacRaycastResult triResult = RaycastEntityTris(
+          entity,
+          ray,
+          gameTransientState->gameAssets );
+        if( triResult.collided )
+        {
+          entityRaycast.result = triResult;
+          entityRaycast.entityIndex = iEntity;
+        }
       }
-    }
+      return entityRaycast;
+    },
+      []( const EntityRaycast& a, const EntityRaycast& b )
+    {
+      // ties go to the lower entity index, the tree's order doesn't matter
+      if( !b.result.collided )
+        return a;
+      if( b.result.dist < a.result.dist ||
+        b.result.dist == a.result.dist && b.entityIndex < a.entityIndex )
+        return b;
+      return a;
+    } );
+    entityRaycast = closestEntityRaycast.result;
+    entityRaycastIndex = closestEntityRaycast.entityIndex;
   }
+  TacRaycastResult raycastResultClosestTri = entityRaycast;
+  u32 closestEntityIndex = entityRaycastIndex;
 
   if( raycastResultClosestTri.collided )
   {
@@ -1374,18 +2395,62 @@ void TacGameState::Update( TacGameInterface& gameInterface )
     }
   }
 
+  // every entity could be a visible tree, so make room for all of them
+  if( entities.size() > maxInstances )
+  {
+    u32 numInstances = maxInstances;
+    while( numInstances < entities.size() )
+      numInstances *= 2;
+    TacVertexBufferHandle newInstanceBuffer =
+      gameInterface.renderer->AddVertexBuffer(
+        TacBufferAccess::Dynamic,
+        nullptr,
+        numInstances,
+        sizeof( DemoInstance ),
+        gameInterface.gameUnrecoverableErrors );
+    if( gameInterface.gameUnrecoverableErrors.size )
+      return;
+    gameInterface.renderer->SetName(
+      newInstanceBuffer,
+      STRINGIFY( instanceBuffer ) );
+    gameInterface.renderer->RemoveVertexBuffer( instanceBuffer );
+    instanceBuffer = newInstanceBuffer;
+    maxInstances = numInstances;
+  }
+
   TacTemporaryMemory tempRenderMemory =
     BeginTemporaryMemory( &gameTransientState->mTempAllocator );
-  TacRenderGroup renderGroup = {};
-  renderGroup.mPushBufferMemory =
-    ( u8* )PushSize( &gameTransientState->mTempAllocator,
-      renderGroup.mPushBufferMemorySizeMax = Megabytes( 1 ) );
-  if( !renderGroup.mPushBufferMemory )
+  TacRenderGroup renderGroup;
+  if( !InitRenderGroup(
+    &renderGroup,
+    &gameTransientState->mTempAllocator,
+    Megabytes( 1 ),
+    4096,
+    gameInterface.renderer ) )
   {
     gameInterface.gameUnrecoverableErrors =
       "Could not allocate temporary push buffer memory";
     return;
   }
+  renderGroup.mInstanceBuffer = instanceBuffer;
+  renderGroup.mInstanceStride = sizeof( DemoInstance );
+  renderGroup.mNumInstancesMax = maxInstances;
+  renderGroup.mInstanceMemory = ( u8* )PushArray(
+    &gameTransientState->mTempAllocator,
+    maxInstances,
+    DemoInstance );
+  if( !renderGroup.mInstanceMemory )
+  {
+    gameInterface.gameUnrecoverableErrors =
+      "Could not allocate temporary instance memory";
+    return;
+  }
+
+  // resolved once here instead of by name for every draw
+  TacUniformHandle worldUniform =
+    gameInterface.renderer->GetUniformHandle( "World" );
+  TacUniformHandle colorUniform =
+    gameInterface.renderer->GetUniformHandle( "Color" );
 
   // rendering ------------------------------------------------------------
   ImGui::ColorEdit4( "clear color", &clearcolor.x, false );
@@ -1423,7 +2488,7 @@ void TacGameState::Update( TacGameInterface& gameInterface )
           m4 world =
             M4Transform( one, rot, translate ) *
             M4Transform( scale, zero, offset );
-          renderGroup.PushUniform( "World", &world, sizeof( m4 ) );
+          renderGroup.PushUniform( worldUniform, &world, sizeof( m4 ) );
           renderGroup.PushModel( cubemodel );
         }
       }
@@ -1504,19 +2569,424 @@ void TacGameState::Update( TacGameInterface& gameInterface )
   // add draw calls
   {
     // add entity draw calls
-    for( TacEntity& entity : entities )
+    // The entity tree narrows the entities down to the ones whose boxes
+    // touch the frustum. Each chunk of those is recorded into its own group
+    // on the workers, then the groups run in chunk order
+    v3 viewSpaceFarCorners[ 4 ];
+    for( u32 i = 0; i < 4; ++i )
     {
-      if( entity.mType == TacEntityType::Null )
-        continue;
+      viewSpaceFarCorners[ i ] =
+        viewSpaceFrustumCorners.viewSpaceFrustumCorners[ i ].xyz;
+    }
+    TacFrustum frustum = FrustumFromViewSpaceCorners(
+      viewSpaceFarCorners,
+      mCamera.camNear,
+      mCamera.camFar,
+      view );
+
+    u32* drawCandidates = PushArray(
+      &gameTransientState->mTempAllocator,
+      entities.size(),
+      u32 );
+    if( !drawCandidates && !entities.empty() )
+    {
+      gameInterface.gameUnrecoverableErrors =
+        "Could not allocate temporary draw candidate memory";
+      return;
+    }
+    u32 numDrawCandidates = 0;
+    if( cullEntities && useEntityTree )
+    {
+      TAC_PROFILE_SCOPE( "Query entity tree" );
+      numDrawCandidates = AabbTreeQueryFrustum(
+        &entityTree,
+        frustum,
+        drawCandidates,
+        entities.size() );
+    }
+    else
+    {
+      for( u32 iEntity = 0; iEntity < entities.size(); ++iEntity )
+        drawCandidates[ numDrawCandidates++ ] = iEntity;
+    }
 
-      TacModel* model =
-        gameTransientState->gameAssets.GetModel( entity.mAssetID );
-      if( !model )
-        continue;
+    // draw the ground and the big entities into the occlusion buffer
+    TacOcclusionBuffer occlusionBuffer;
+    if( occlusionCulling )
+    {
+      TAC_PROFILE_SCOPE( "Rasterize occluders" );
+      const u32 maxOccluderTriangles = 8192;
+      r32* invDepths = PushArray(
+        &gameTransientState->mTempAllocator,
+        TacOcclusionBuffer::width * TacOcclusionBuffer::height,
+        r32 );
+      TacOcclusionTriangle* occluderTriangles = PushArray(
+        &gameTransientState->mTempAllocator,
+        maxOccluderTriangles,
+        TacOcclusionTriangle );
+      if( !invDepths || !occluderTriangles )
+      {
+        gameInterface.gameUnrecoverableErrors =
+          "Could not allocate temporary occlusion buffer memory";
+        return;
+      }
+      OcclusionBufferBegin(
+        &occlusionBuffer,
+        invDepths,
+        occluderTriangles,
+        maxOccluderTriangles,
+        proj * view,
+        mCamera.camNear );
+
+      // the ground goes first so it's never left out
+      auto AddOccluder = [ & ]( u32 iEntity )
+      {
+        TacEntity& entity = entities[ iEntity ];
+        if( entity.mType == TacEntityType::Null )
+          return true;
+        TacModelRaycastInfo* modelRaycastInfo =
+          modelRaycastInfos[ ( u32 )entity.mAssetID ];
+        if( !modelRaycastInfo )
+          return true;
+        if( iEntity != groundEntityIndex &&
+          WorldSpaceBoundingSphere( entity, *modelRaycastInfo ).radius <
+          occluderMinRadius )
+          return true;
+        return OcclusionBufferAddOccluder(
+          &occlusionBuffer,
+          entity.world,
+          modelRaycastInfo->vertexes.data(),
+          modelRaycastInfo->indexes.data(),
+          modelRaycastInfo->indexes.size() ) != 0;
+      };
+      if( groundEntityIndex )
+        AddOccluder( groundEntityIndex );
+      for( u32 iCandidate = 0; iCandidate < numDrawCandidates; ++iCandidate )
+      {
+        u32 iEntity = drawCandidates[ iCandidate ];
+        if( iEntity != groundEntityIndex && !AddOccluder( iEntity ) )
+          break;
+      }
+      OcclusionBufferRasterize( &occlusionBuffer, queue, thread );
+      numOccluderTriangles = occlusionBuffer.numTriangles;
+    }
+
+    TacParallelChunks entityChunks = ComputeParallelChunks(
+      queue,
+      0,
+      numDrawCandidates,
+      256 );
+    TacRenderGroup entityRenderGroups[ TacParallelChunks::maxChunks ];
+
+    // what the recording lambda below pushes for one entity: a draw item
+    // holding the world and color uniforms and the model
+    const u32 commandAlignment = TacRenderGroup::sCommandAlignment;
+    const u32 entityDrawItemSize =
+      RoundUpToNearestMultiple(
+        sizeof( TacRenderCommandDrawItem ),
+        commandAlignment ) +
+      RoundUpToNearestMultiple(
+        sizeof( TacRenderCommandUniform ) + sizeof( m4 ),
+        commandAlignment ) +
+      RoundUpToNearestMultiple(
+        sizeof( TacRenderCommandUniform ) + sizeof( v3 ),
+        commandAlignment ) +
+      RoundUpToNearestMultiple(
+        sizeof( TacRenderCommandModel ),
+        commandAlignment );
+    // plus the one PushDrawItems, and padding to align the first command
+    const u32 entityPushBufferSize =
+      entityChunks.grain * entityDrawItemSize +
+      RoundUpToNearestMultiple(
+        sizeof( TacRenderCommandDrawItems ),
+        commandAlignment ) +
+      commandAlignment;
+
+    // trees aren't drawn one by one, each chunk collects them here
+    DemoInstance* chunkTrees[ TacParallelChunks::maxChunks ];
+    u8* chunkTreeLods[ TacParallelChunks::maxChunks ];
+    u32 numChunkTrees[ TacParallelChunks::maxChunks ] = {};
+
+    // each chunk gathers the bounding spheres of the entities it would
+    // draw, culls them as one batch, and records the visible ones
+    struct ChunkCulling
+    {
+      TacSpheresSoA spheres;
+      u32* entityIndexes;
+      u8* visible;
+      u32 numVisible;
+      u32 numOccluded;
+      u32 numLodDraws[ MAX_MODEL_LODS ];
+    };
+    ChunkCulling chunkCullings[ TacParallelChunks::maxChunks ];
+
+    for( u32 iChunk = 0; iChunk < entityChunks.numChunks; ++iChunk )
+    {
+      TacRenderGroup* entityRenderGroup = &entityRenderGroups[ iChunk ];
+      if( !InitRenderGroup(
+        entityRenderGroup,
+        &gameTransientState->mTempAllocator,
+        entityPushBufferSize,
+        entityChunks.grain,
+        gameInterface.renderer ) )
+      {
+        gameInterface.gameUnrecoverableErrors =
+          "Could not allocate temporary entity push buffer memory";
+        return;
+      }
+      renderGroup.PushRenderGroup( entityRenderGroup );
+
+      chunkTrees[ iChunk ] = PushArray(
+        &gameTransientState->mTempAllocator,
+        entityChunks.grain,
+        DemoInstance );
+      chunkTreeLods[ iChunk ] = PushArray(
+        &gameTransientState->mTempAllocator,
+        entityChunks.grain,
+        u8 );
+      if( !chunkTrees[ iChunk ] || !chunkTreeLods[ iChunk ] )
+      {
+        gameInterface.gameUnrecoverableErrors =
+          "Could not allocate temporary tree instance memory";
+        return;
+      }
+
+      ChunkCulling& chunkCulling = chunkCullings[ iChunk ];
+      r32* sphereComponents = PushArray(
+        &gameTransientState->mTempAllocator,
+        entityChunks.grain * 4,
+        r32 );
+      chunkCulling.entityIndexes = PushArray(
+        &gameTransientState->mTempAllocator,
+        entityChunks.grain,
+        u32 );
+      chunkCulling.visible = PushArray(
+        &gameTransientState->mTempAllocator,
+        entityChunks.grain,
+        u8 );
+      if( !sphereComponents ||
+        !chunkCulling.entityIndexes ||
+        !chunkCulling.visible )
+      {
+        gameInterface.gameUnrecoverableErrors =
+          "Could not allocate temporary culling memory";
+        return;
+      }
+      chunkCulling.spheres.xs = sphereComponents;
+      chunkCulling.spheres.ys = sphereComponents + entityChunks.grain;
+      chunkCulling.spheres.zs = sphereComponents + entityChunks.grain * 2;
+      chunkCulling.spheres.radii = sphereComponents + entityChunks.grain * 3;
+      chunkCulling.spheres.count = 0;
+      chunkCulling.numVisible = 0;
+      chunkCulling.numOccluded = 0;
+      for( u32& numLodDraws : chunkCulling.numLodDraws )
+        numLodDraws = 0;
+    }
 
-      renderGroup.PushUniform( "World", &entity.world, sizeof( m4 ) );
-      renderGroup.PushUniform( "Color", &entity.mColor, sizeof( v3 ) );
-      renderGroup.PushModel( model );
+
+    // resolve these up front so the workers don't touch the asset statuses.
+    // This starts loading every asset, not just the ones entities use
+    TacModel* models[ ( u32 )TacGameAssetID::Count ];
+    for( u32 iAsset = 0; iAsset < ( u32 )TacGameAssetID::Count; ++iAsset )
+    {
+      models[ iAsset ] = gameTransientState->gameAssets.GetModel(
+        ( TacGameAssetID )iAsset );
+    }
+
+    // a bounding sphere this many units across at a distance of 1 covers
+    // this many pixels
+    entityLods.resize( entities.size() );
+    r32 lodPixelsPerUnit =
+      gameInterface.windowHeight / ( 2.0f * Tan( camFOVYRad / 2.0f ) );
+    r32 maxLodPixelError =
+      lodPixelError / GetKnob( DemoGovernorKnob::LodDetail );
+
+    {
+      TAC_PROFILE_SCOPE( "Record entity draws" );
+      TacGovernorScope governorScope(
+        &governor,
+        ( u32 )DemoGovernorSubsystem::RecordDraws );
+      ParallelFor(
+        queue,
+        thread,
+        0,
+        entityChunks.numChunks,
+        1,
+        [ & ]( u32 iChunk )
+      {
+        TacRenderGroup& entityRenderGroup = entityRenderGroups[ iChunk ];
+        ChunkCulling& chunkCulling = chunkCullings[ iChunk ];
+        TacSpheresSoA& spheres = chunkCulling.spheres;
+        u32 candidateBegin = iChunk * entityChunks.grain;
+        u32 candidateEnd = Minimum(
+          candidateBegin + entityChunks.grain,
+          numDrawCandidates );
+        for( u32 iCandidate = candidateBegin;
+          iCandidate < candidateEnd;
+          ++iCandidate )
+        {
+          u32 iEntity = drawCandidates[ iCandidate ];
+          TacEntity& entity = entities[ iEntity ];
+          if( entity.mType == TacEntityType::Null )
+            continue;
+          if( !models[ ( u32 )entity.mAssetID ] )
+            continue;
+
+          // without raycast info there's no bounding sphere, so the
+          // entity is never culled
+          const TacSphere& sphere = entitySpheres[ iEntity ];
+
+          u32 iSphere = spheres.count++;
+          spheres.xs[ iSphere ] = sphere.position.x;
+          spheres.ys[ iSphere ] = sphere.position.y;
+          spheres.zs[ iSphere ] = sphere.position.z;
+          spheres.radii[ iSphere ] = sphere.radius;
+          chunkCulling.entityIndexes[ iSphere ] = iEntity;
+        }
+
+        if( !cullEntities )
+        {
+          memset( chunkCulling.visible, 1, spheres.count );
+          chunkCulling.numVisible = spheres.count;
+        }
+        else if( cullEntitiesSimd )
+        {
+          chunkCulling.numVisible =
+            CullSpheres( frustum, spheres, chunkCulling.visible );
+        }
+        else
+        {
+          chunkCulling.numVisible =
+            CullSpheresScalar( frustum, spheres, chunkCulling.visible );
+        }
+
+        for( u32 iSphere = 0; iSphere < spheres.count; ++iSphere )
+        {
+          if( !chunkCulling.visible[ iSphere ] )
+            continue;
+
+          u32 iEntity = chunkCulling.entityIndexes[ iSphere ];
+          TacEntity& entity = entities[ iEntity ];
+          TacModel* model = models[ ( u32 )entity.mAssetID ];
+          b32 hasSphere = modelRaycastInfos[ ( u32 )entity.mAssetID ] != 0;
+          TacSphere sphere;
+          sphere.position = V3(
+            spheres.xs[ iSphere ],
+            spheres.ys[ iSphere ],
+            spheres.zs[ iSphere ] );
+          sphere.radius = spheres.radii[ iSphere ];
+
+          // entities without a bounding sphere are never occluded
+          if( occlusionCulling && hasSphere )
+          {
+            if( !OcclusionBufferTestAabb(
+              &occlusionBuffer,
+              AabbFromSphere( sphere ) ) )
+            {
+              chunkCulling.numOccluded++;
+              continue;
+            }
+          }
+
+          // full detail when the camera is inside the sphere
+          u32 lod = 0;
+          if( useLods && hasSphere )
+          {
+            r32 dist = Length( sphere.position - mCamera.camPos );
+            if( dist > sphere.radius )
+            {
+              lod = ModelSelectLod(
+                model,
+                sphere.radius * lodPixelsPerUnit / dist,
+                maxLodPixelError,
+                lodHysteresis,
+                entityLods[ iEntity ] );
+            }
+          }
+          entityLods[ iEntity ] = ( u8 )lod;
+          chunkCulling.numLodDraws[ lod ]++;
+
+          if( entity.mAssetID == TacGameAssetID::Tree )
+          {
+            u32 iTree = numChunkTrees[ iChunk ]++;
+            DemoInstance& tree = chunkTrees[ iChunk ][ iTree ];
+            tree.world = entity.world;
+            tree.color = entity.mColor;
+            chunkTreeLods[ iChunk ][ iTree ] = ( u8 )lod;
+            continue;
+          }
+
+          u64 sortKey = TacDrawItemSortKey(
+            0,
+            shaderHandle,
+            vertexFormatHandle,
+            { RENDERER_ID_NONE },
+            Dot( entity.mPos - mCamera.camPos, mCamera.camDir ) );
+          entityRenderGroup.BeginDrawItem(
+            sortKey,
+            shaderHandle,
+            vertexFormatHandle );
+          entityRenderGroup.PushUniform(
+            worldUniform,
+            &entity.world,
+            sizeof( m4 ) );
+          entityRenderGroup.PushUniform(
+            colorUniform,
+            &entity.mColor,
+            sizeof( v3 ) );
+          entityRenderGroup.PushModel( model, lod );
+          entityRenderGroup.EndDrawItem();
+        }
+        entityRenderGroup.PushDrawItems();
+      } );
+    }
+
+    entityCullStats = {};
+    for( u32 iChunk = 0; iChunk < entityChunks.numChunks; ++iChunk )
+    {
+      entityCullStats.numTested += chunkCullings[ iChunk ].spheres.count;
+      entityCullStats.numVisible += chunkCullings[ iChunk ].numVisible;
+      entityCullStats.numOccluded += chunkCullings[ iChunk ].numOccluded;
+    }
+    for( u32 iLod = 0; iLod < MAX_MODEL_LODS; ++iLod )
+    {
+      entityLodCounts[ iLod ] = 0;
+      for( u32 iChunk = 0; iChunk < entityChunks.numChunks; ++iChunk )
+        entityLodCounts[ iLod ] += chunkCullings[ iChunk ].numLodDraws[ iLod ];
+    }
+
+    // all the trees, grouped by lod, one draw per lod
+    u32 numTrees = 0;
+    for( u32 iChunk = 0; iChunk < entityChunks.numChunks; ++iChunk )
+      numTrees += numChunkTrees[ iChunk ];
+    u32 firstTree;
+    DemoInstance* trees =
+      ( DemoInstance* )renderGroup.PushInstances( numTrees, &firstTree );
+    if( numTrees && trees )
+    {
+      renderGroup.PushShader( instancedShaderHandle );
+      renderGroup.PushVertexFormat( instancedVertexFormatHandle );
+      for( u32 iLod = 0; iLod < MAX_MODEL_LODS; ++iLod )
+      {
+        u32 numLodTrees = 0;
+        for( u32 iChunk = 0; iChunk < entityChunks.numChunks; ++iChunk )
+        {
+          for( u32 iTree = 0; iTree < numChunkTrees[ iChunk ]; ++iTree )
+          {
+            if( chunkTreeLods[ iChunk ][ iTree ] == iLod )
+              trees[ numLodTrees++ ] = chunkTrees[ iChunk ][ iTree ];
+          }
+        }
+        renderGroup.PushModelInstanced(
+          models[ ( u32 )TacGameAssetID::Tree ],
+          firstTree,
+          numLodTrees,
+          iLod );
+        trees += numLodTrees;
+        firstTree += numLodTrees;
+      }
+      renderGroup.PushShader( shaderHandle );
+      renderGroup.PushVertexFormat( vertexFormatHandle );
     }
 
     // draw the raycast point
@@ -1533,14 +3003,34 @@ void TacGameState::Update( TacGameInterface& gameInterface )
 
       TacEntity& closestEntity = entities[ closestEntityIndex ];
       v3 color = closestEntity.mColor / 4.0f;
-      renderGroup.PushUniform( "World", &world, sizeof( m4 ) );
-      renderGroup.PushUniform( "Color", &color, sizeof( v3 ) );
+      renderGroup.PushUniform( worldUniform, &world, sizeof( m4 ) );
+      renderGroup.PushUniform( colorUniform, &color, sizeof( v3 ) );
       renderGroup.PushModel( spheremodel );
     }
 
     // draw particles
     v3 zero = {};
 
+    // the sort depth of every particle
+    r32 particleXs[ TacEmitter::maxparticles ];
+    r32 particleYs[ TacEmitter::maxparticles ];
+    r32 particleZs[ TacEmitter::maxparticles ];
+    r32 particleDepths[ TacEmitter::maxparticles ];
+    TacVectorsSoA particlePositions;
+    particlePositions.xs = particleXs;
+    particlePositions.ys = particleYs;
+    particlePositions.zs = particleZs;
+    particlePositions.count = emitter.numAlive;
+    for( u32 iParticle = 0; iParticle < emitter.numAlive; ++iParticle )
+    {
+      TacParticle& particle = emitter.particles[ iParticle ];
+      particleXs[ iParticle ] = particle.pos.x;
+      particleYs[ iParticle ] = particle.pos.y;
+      particleZs[ iParticle ] = particle.pos.z;
+    }
+    DotProducts( particlePositions, mCamera.camDir, particleDepths );
+    r32 camDepth = Dot( mCamera.camPos, mCamera.camDir );
+
     for( u32 iParticle = 0; iParticle < emitter.numAlive; ++iParticle )
     {
       TacParticle& particle = emitter.particles[ iParticle ];
@@ -1549,10 +3039,19 @@ void TacGameState::Update( TacGameInterface& gameInterface )
         V3( 1.0f, 1.0f, 1.0f ) * particle.cursize,
         zero,
         particle.pos );
-      renderGroup.PushUniform( "World", &world, sizeof( m4 ) );
-      renderGroup.PushUniform( "Color", &particle.color, sizeof( v3 ) );
+      u64 sortKey = TacDrawItemSortKey(
+        0,
+        shaderHandle,
+        vertexFormatHandle,
+        { RENDERER_ID_NONE },
+        particleDepths[ iParticle ] - camDepth );
+      renderGroup.BeginDrawItem( sortKey, shaderHandle, vertexFormatHandle );
+      renderGroup.PushUniform( worldUniform, &world, sizeof( m4 ) );
+      renderGroup.PushUniform( colorUniform, &particle.color, sizeof( v3 ) );
       renderGroup.PushModel( spheremodel );
+      renderGroup.EndDrawItem();
     }
+    renderGroup.PushDrawItems();
 
     r32 imguidragspeed = 0.01f;
     ImGui::Begin( "Emitter" );
@@ -1572,7 +3071,7 @@ void TacGameState::Update( TacGameInterface& gameInterface )
     {
       ImGui::Indent();
       v3 shapecolor = V3< r32 >( 1, 1, 1 ) * 0.5f;
-      renderGroup.PushUniform( "Color", &shapecolor, sizeof( v3 ) );
+      renderGroup.PushUniform( colorUniform, &shapecolor, sizeof( v3 ) );
       int currentshapeType = ( int )emitter.shapetype;
       const char* shapeTypeStrings[ ( u32 )TacEmitter::Shape::Count ] =
       {
@@ -1615,7 +3114,7 @@ void TacGameState::Update( TacGameInterface& gameInterface )
               scale,
               zero,
               emitter.pos );
-            renderGroup.PushUniform( "World", &emitterworld, sizeof( m4 ) );
+            renderGroup.PushUniform( worldUniform, &emitterworld, sizeof( m4 ) );
             renderGroup.PushModel( cubemodel );
           }
         } break;
@@ -1811,7 +3310,7 @@ void TacGameState::Update( TacGameInterface& gameInterface )
     v3 scale = V3< r32 >( 1, 1, 1 ) * particleSize;
     v3 zero = V3< r32 >( 0, 0, 0 );
 
-    renderGroup.PushUniform( "Color", &physicsBoxColor, sizeof( v3 ) );
+    renderGroup.PushUniform( colorUniform, &physicsBoxColor, sizeof( v3 ) );
     static float boxThickness = 0.1f;
     ImGui::DragFloat( "Box thickness", &boxThickness, imguispeed );
     static float vertexRadius = 0.3f;
@@ -1860,7 +3359,7 @@ void TacGameState::Update( TacGameInterface& gameInterface )
           boxVertexScale,
           zero,
           currentVertex );
-        renderGroup.PushUniform( "World", &world, sizeof( m4 ) );
+        renderGroup.PushUniform( worldUniform, &world, sizeof( m4 ) );
         renderGroup.PushModel( spheremodel );
       }
     }
@@ -1946,7 +3445,14 @@ void TacGameState::Update( TacGameInterface& gameInterface )
     }
 
     // physics step
-    mPhysicsTest.Update( gameInterface.gameInput->dt );
+    {
+      TacGovernorScope governorScope(
+        &governor,
+        ( u32 )DemoGovernorSubsystem::Physics );
+      mPhysicsTest.Update(
+        gameInterface.gameInput->dt,
+        ( u32 )GetKnob( DemoGovernorKnob::PhysicsSubsteps ) );
+    }
 
     // display manifolds
     for( u32 iManifold = 0; iManifold < mPhysicsTest.mNumManifolds; ++iManifold )
@@ -1973,8 +3479,8 @@ void TacGameState::Update( TacGameInterface& gameInterface )
         {
           m4 world = M4Transform( boxVertexScale * 1.1f, zero, verts[ tri ] );
           v3 color = colors[ tri ];
-          renderGroup.PushUniform( "Color", &color, sizeof( v3 ) );
-          renderGroup.PushUniform( "World", &world, sizeof( m4 ) );
+          renderGroup.PushUniform( colorUniform, &color, sizeof( v3 ) );
+          renderGroup.PushUniform( worldUniform, &world, sizeof( m4 ) );
           renderGroup.PushModel( spheremodel );
         }
         v3 closestPoint =
@@ -1983,8 +3489,8 @@ void TacGameState::Update( TacGameInterface& gameInterface )
           verts[ 2 ] * manifold.mIsColliding.mBarycentric[ 2 ];
         m4 world = M4Transform( boxVertexScale * 1.1f, zero, closestPoint );
         v3 color = V3< r32 >( 0.5f, 0.5f, 0.5f );
-        renderGroup.PushUniform( "Color", &color, sizeof( v3 ) );
-        renderGroup.PushUniform( "World", &world, sizeof( m4 ) );
+        renderGroup.PushUniform( colorUniform, &color, sizeof( v3 ) );
+        renderGroup.PushUniform( worldUniform, &world, sizeof( m4 ) );
         renderGroup.PushModel( spheremodel );
       };
 
@@ -2001,7 +3507,7 @@ void TacGameState::Update( TacGameInterface& gameInterface )
     }
 
     // draw each particle
-    renderGroup.PushUniform( "Color", &physicsParticleColor, sizeof( v3 ) );
+    renderGroup.PushUniform( colorUniform, &physicsParticleColor, sizeof( v3 ) );
     for(
       u32 iphysicsparticle = 0;
       iphysicsparticle < mPhysicsTest.mNumParticles;
@@ -2010,7 +3516,7 @@ void TacGameState::Update( TacGameInterface& gameInterface )
       TacPhysicsParticle& particle =
         mPhysicsTest.mParticles[ iphysicsparticle ];
       m4 world = M4Transform( scale, zero, particle.mPosition );
-      renderGroup.PushUniform( "World", &world, sizeof( m4 ) );
+      renderGroup.PushUniform( worldUniform, &world, sizeof( m4 ) );
       renderGroup.PushModel( spheremodel );
     }
     ImGui::End();
@@ -2054,29 +3560,12 @@ void TacGameState::Update( TacGameInterface& gameInterface )
     DemoFinalShader::GetNameviewSpacePositionTexture(),
     viewSpacePositionTexture );
 
-  static v4 ssaoKernel[ CBufferSSAO::GetArrayCountSSAOKernel ];
-  static bool once = true;
-  if( once )
-  {
-    once = false;
-    for( u32 i = 0; i < CBufferSSAO::GetArrayCountSSAOKernel; ++i )
-    {
-      v4& offset = ssaoKernel[ i ];
-      offset = V4(
-        RandReal( -1.0f, 1.0f ),
-        RandReal( -1.0f, 1.0f ),
-        RandReal( 0.0f, 1.0f ),
-        0.0f );
-      offset = Normalize( offset );
-      r32 scale =
-        ( r32 )( i + 1 ) /
-        ( r32 )CBufferSSAO::GetArrayCountSSAOKernel;
-      offset *= scale * scale;
-    }
-  }
+  static constexpr TacTable< v4, CBufferSSAO::GetArrayCountSSAOKernel >
+    ssaoKernel = MakeTable< v4, CBufferSSAO::GetArrayCountSSAOKernel >(
+    SSAOKernelGenerator() );
   renderGroup.PushUniform(
     CBufferSSAO::GetNameSSAOKernel(),
-    ssaoKernel,
+    ( void* )ssaoKernel.e,
     sizeof( v4 ) * CBufferSSAO::GetArrayCountSSAOKernel );
 
   v2 randomVectorsSize =
@@ -2121,8 +3610,12 @@ void TacGameState::Update( TacGameInterface& gameInterface )
         gameInterface.gameInput->KeyboardJustDown( KeyboardKey::Backspace ) ||
         gameInterface.gameInput->KeyboardJustDown( KeyboardKey::Delete ) )
       {
+        AabbTreeRemove( &entityTree, entities.size() - 1 );
         entities[ selectedEntityIndex ] = entities.back();
+        entities[ selectedEntityIndex ].transformDirty = true;
         entities.pop_back();
+        if( selectedEntityIndex < entityLods.size() )
+          entityLods[ selectedEntityIndex ] = entityLods.back();
         selectedEntityIndex = 0;
       }
       DisplayEntity( entities[ selectedEntityIndex ] );
@@ -2194,20 +3687,44 @@ void TacGameState::Update( TacGameInterface& gameInterface )
       }
     }
 
-    // move trees away from each other
+    // move trees away from each other.
+    // The tree has last frame's boxes, which contain the tree positions
+    u32* neighbors = PushArray(
+      &gameTransientState->mTempAllocator,
+      entities.size(),
+      u32 );
     for(
       u32 iEntity = 0;
-      iEntity < entities.size();
+      neighbors && iEntity < entities.size();
       ++iEntity )
     {
       TacEntity& entity0 = entities[ iEntity ];
       if( entity0.mType != TacEntityType::Tree )
         continue;
-      for(
-        u32 jEntity = iEntity + 1;
-        jEntity < entities.size();
-        ++jEntity )
+
+      u32 numNeighbors = 0;
+      if( useEntityTree )
+      {
+        TacSphere neighborhood;
+        neighborhood.position = entity0.mPos;
+        neighborhood.radius = minEntityDist;
+        numNeighbors = AabbTreeQuerySphere(
+          &entityTree,
+          neighborhood,
+          neighbors,
+          entities.size() );
+      }
+      else
+      {
+        for( u32 jEntity = 0; jEntity < entities.size(); ++jEntity )
+          neighbors[ numNeighbors++ ] = jEntity;
+      }
+
+      for( u32 iNeighbor = 0; iNeighbor < numNeighbors; ++iNeighbor )
       {
+        u32 jEntity = neighbors[ iNeighbor ];
+        if( jEntity <= iEntity )
+          continue;
         TacEntity& entity1 = entities[ jEntity ];
         if( entity1.mType != TacEntityType::Tree )
           continue;
@@ -2414,6 +3931,7 @@ void TacGameState::Update( TacGameInterface& gameInterface )
 
 
   renderGroup.Execute( gameInterface.renderer );
+  renderStateStats = renderGroup.mStateCache.mStats;
   EndTemporaryMemory( tempRenderMemory );
 }
 
@@ -2431,6 +3949,7 @@ void TacGameState::Uninit( TacGameInterface& gameInterface )
   gameInterface.renderer->RemoveShader( shaderHandle );
   gameInterface.renderer->RemoveShader( perPixelFrustumVectorsCreator );
   gameInterface.renderer->RemoveShader( gbufferFinalShader );
+  gameInterface.renderer->RemoveShader( instancedShaderHandle );
   gameInterface.renderer->RemoveSamplerState( linearSampler );
   gameInterface.renderer->RemoveSamplerState( pointSampler );
   gameInterface.renderer->RemoveTextureResoure( gbufferViewSpaceNormal );
@@ -2438,7 +3957,9 @@ void TacGameState::Uninit( TacGameInterface& gameInterface )
   gameInterface.renderer->RemoveTextureResoure( viewSpacePositionTexture );
   gameInterface.renderer->RemoveTextureResoure( randomVectorTexture );
   gameInterface.renderer->RemoveVertexFormat( vertexFormatHandle );
+  gameInterface.renderer->RemoveVertexFormat( instancedVertexFormatHandle );
   gameInterface.renderer->RemoveVertexBuffer( ndcQuadVBO );
+  gameInterface.renderer->RemoveVertexBuffer( instanceBuffer );
 
   {
     const u32 numRenderTargets = 1;
@@ -2475,16 +3996,19 @@ void TacGameState::Uninit( TacGameInterface& gameInterface )
     for( u32 i = 0; i < model->numSubModels; ++i )
     {
       TacSubModel& subModel = model->subModels[ i ];
-      ModelBuffers& buffers = subModel.buffers;
-      gameInterface.renderer->RemoveIndexBuffer(
-        buffers.indexBufferHandle );
-      for(
-        u32 iVertexBuffer = 0;
-        iVertexBuffer < buffers.numVertexBuffers;
-        ++iVertexBuffer )
+      for( u32 iLod = 0; iLod < subModel.numLods; ++iLod )
       {
-        gameInterface.renderer->RemoveVertexBuffer(
-          buffers.vertexBufferHandles[ iVertexBuffer ] );
+        ModelBuffers& buffers = subModel.lods[ iLod ];
+        gameInterface.renderer->RemoveIndexBuffer(
+          buffers.indexBufferHandle );
+        for(
+          u32 iVertexBuffer = 0;
+          iVertexBuffer < buffers.numVertexBuffers;
+          ++iVertexBuffer )
+        {
+          gameInterface.renderer->RemoveVertexBuffer(
+            buffers.vertexBufferHandles[ iVertexBuffer ] );
+        }
       }
     }
 
@@ -2584,6 +4108,7 @@ void TacGameState::LoadEntities(
   FixedString< DEFAULT_ERR_LEN >& errors )
 {
   OnDestruct( if( errors.size ) { entities.clear(); } );
+  entityTreeStale = true;
 
   u32 numEntities;
   PlatformReadEntireFile(
@@ -2820,29 +4345,47 @@ void QueueCallbackLoadModel(
   OnDestruct( PopSize( memoryArena, size ); );
   TacAssert( memory );
 
-  PlatformReadEntireFile(
-    thread,
-    file,
-    memory,
-    size,
-    errors );
+  {
+    TAC_PROFILE_SCOPE( "Read model file" );
+    PlatformReadEntireFile(
+      thread,
+      file,
+      memory,
+      size,
+      errors );
+  }
   TacAssert( !errors.size );
 
   TacModelLoader modelLoader;
   OnDestruct( modelLoader.Release(); );
-  modelLoader.OpenScene(
-    memory,
-    size,
-    callbackData->filepath,
-    errors );
+  {
+    TAC_PROFILE_SCOPE( "Parse model" );
+    modelLoader.OpenScene(
+      memory,
+      size,
+      callbackData->filepath,
+      errors );
+  }
   TacAssert( !errors.size );
 
-  callbackData->param->loadedformat = modelLoader.AllocateVertexFormat(
-    memoryArena,
-    callbackData->vertexFormats,
-    callbackData->numVertexFormats );
+  {
+    TAC_PROFILE_SCOPE( "Allocate model vertex format" );
+    callbackData->param->loadedformat = modelLoader.AllocateVertexFormat(
+      memoryArena,
+      callbackData->vertexFormats,
+      callbackData->numVertexFormats );
+  }
   TacAssert( !errors.size );
 
+  {
+    TAC_PROFILE_SCOPE( "Simplify model lods" );
+    ModelFormatGenerateLods(
+      memoryArena,
+      callbackData->param->loadedformat,
+      callbackData->vertexFormats,
+      callbackData->numVertexFormats,
+      MAX_MODEL_LODS );
+  }
 }
 
 TacModel* TacGameAssets::GetModel(
@@ -2898,9 +4441,10 @@ TacModel* TacGameAssets::GetModel(
         callbackData->param = &param;
         param.status = AsyncTaskStatus::Started;
         PushEntry(
-          highPriorityQueue,
+          workQueue,
           QueueCallbackLoadModel,
-          callbackData );
+          callbackData,
+          TacJobPriority::Background );
       }
     } break;
     case AsyncTaskStatus::Started:
@@ -2909,45 +4453,58 @@ TacModel* TacGameAssets::GetModel(
     } break;
     case AsyncTaskStatus::PendingCompletion:
     {
+      TAC_PROFILE_SCOPE( "Create model buffers" );
       std::atomic_thread_fence( std::memory_order_consume );
 
       FixedString< DEFAULT_ERR_LEN > errors = {};
 
       ModelFormat& format = param.loadedformat;
       param.model->numSubModels = format.numsubformtas;
+      param.model->numLods = 1;
       for( u32 imodel = 0; imodel < format.numsubformtas; ++imodel )
       {
         SubModelFormat& subformat = format.subformats[ imodel ];
         TacSubModel& submodel = param.model->subModels[ imodel ];
-        submodel.buffers = ModelBuffersCreate(
-          renderer,
-          subformat.numVertexes,
-          subformat.vertexBuffers,
-          format.vertexBufferStrides,
-          format.numVertexBuffers,
-          subformat.numIndexes,
-          subformat.indexBuffer,
-          format.indexFormat,
-          subformat.numIndexes * sizeof( u32 ),
-          errors );
-        TacAssert( !errors.size );
-
-        // set debug names
+        submodel.numLods = 1 + Minimum(
+          subformat.numLods,
+          ( u32 )MAX_MODEL_LODS - 1 );
+        param.model->numLods =
+          Maximum( param.model->numLods, submodel.numLods );
+        for( u32 iLod = 0; iLod < submodel.numLods; ++iLod )
         {
-
-          const char* assetIDString = assetIDstrings[ index ];
-          TacUnusedParameter( assetIDString );
-          renderer->SetName(
-            submodel.buffers.indexBufferHandle,
-            assetIDString );
-          for(
-            u32 iVertexBuffer = 0;
-            iVertexBuffer < submodel.buffers.numVertexBuffers;
-            ++iVertexBuffer )
+          SubModelFormat& lodformat =
+            iLod ? subformat.lods[ iLod - 1 ] : subformat;
+          ModelBuffers& buffers = submodel.lods[ iLod ];
+          buffers = ModelBuffersCreate(
+            renderer,
+            lodformat.numVertexes,
+            lodformat.vertexBuffers,
+            format.vertexBufferStrides,
+            format.numVertexBuffers,
+            lodformat.numIndexes,
+            lodformat.indexBuffer,
+            format.indexFormat,
+            lodformat.numIndexes * sizeof( u32 ),
+            errors );
+          TacAssert( !errors.size );
+
+          // set debug names
           {
+
+            const char* assetIDString = assetIDstrings[ index ];
+            TacUnusedParameter( assetIDString );
             renderer->SetName(
-              submodel.buffers.vertexBufferHandles[ iVertexBuffer ],
+              buffers.indexBufferHandle,
               assetIDString );
+            for(
+              u32 iVertexBuffer = 0;
+              iVertexBuffer < buffers.numVertexBuffers;
+              ++iVertexBuffer )
+            {
+              renderer->SetName(
+                buffers.vertexBufferHandles[ iVertexBuffer ],
+                assetIDString );
+            }
           }
         }
       }
@@ -3030,6 +4587,27 @@ TacModel* TacGameAssets::GetModel(
         modelRaycastInfo.boundingSphere = SphereExtents(
           modelRaycastInfo.vertexes.data(),
           modelRaycastInfo.vertexes.size() );
+
+        // A lod is as far off as its worst submodel. Submodels with fewer
+        // lods draw their last one, so it counts for the rest
+        TacModel* model = param.model;
+        r32 radius = modelRaycastInfo.boundingSphere.radius;
+        for( u32 iLod = 0; iLod < model->numLods; ++iLod )
+        {
+          r32& lodError = model->lodErrors[ iLod ];
+          lodError = iLod ? model->lodErrors[ iLod - 1 ] : 0;
+          for( u32 imodel = 0; imodel < format.numsubformtas; ++imodel )
+          {
+            SubModelFormat& subformat = format.subformats[ imodel ];
+            u32 iSubformatLod =
+              Minimum( iLod, model->subModels[ imodel ].numLods - 1 );
+            if( !iSubformatLod || radius <= 0 )
+              continue;
+            lodError = Maximum(
+              lodError,
+              subformat.lods[ iSubformatLod - 1 ].lodError / radius );
+          }
+        }
       }
 
       TacMemoryArena* taskArena = &taskArenas[ param.iTaskArena ];
@@ -3110,10 +4688,19 @@ void MessageLoop::PopMessage()
   }
 }
 
-void TacEmitter::Update( r32 dt )
+void TacEmitter::Update(
+  r32 dt,
+  u32 maxAlive,
+  TacWorkQueue* queue,
+  TacThreadContext* thread )
 {
   spawncounter += spawnrate * dt;
-  spawncounter -= SpawnParticles( ( u32 )spawncounter );
+  u32 numSpawnable = maxAlive > numAlive ? maxAlive - numAlive : 0;
+  spawncounter -= SpawnParticles(
+    Minimum( ( u32 )spawncounter, numSpawnable ) );
+
+  // particles held back by the cap aren't owed once it goes back up
+  spawncounter = Minimum( spawncounter, 1.0f );
 
   //static v3 wind1 = { 3, 1, 0 };
   //static v3 wind2 = { 3, 1, 0 };
@@ -3124,8 +4711,7 @@ void TacEmitter::Update( r32 dt )
   static float damping = 0.99f;
   ImGui::DragFloat( "damping", &damping, 0.001f );
 
-  u32 iParticle = 0;
-  while( iParticle < numAlive )
+  ParallelFor( queue, thread, 0, numAlive, 32, [ & ]( u32 iParticle )
   {
     TacParticle& p = particles[ iParticle ];
     p.cursize = p.maxsize * sizeByLife.GetPoint( 1.0f - p.curlife * p.maxlifeinverse ).y;
@@ -3136,6 +4722,13 @@ void TacEmitter::Update( r32 dt )
     //p.pos.z += wind2.x * sin( ( p.pos.y + RandReal( 0, wind2.z ) ) * wind2.y ) * dt;
     p.pos += p.vel;
     p.curlife -= dt;
+  } );
+
+  // remove dead particles after the parallel part, since it reorders them
+  u32 iParticle = 0;
+  while( iParticle < numAlive )
+  {
+    TacParticle& p = particles[ iParticle ];
     if( p.curlife <= 0 )
     {
       p = particles[ --numAlive ];
@@ -3,7 +3,14 @@
 #include "tacLibrary\tacPlatform.h"
 #include "tacLibrary\tacMemoryManager.h"
 #include "tacLibrary\tacMemoryAllocator.h"
+#include "tacLibrary\tacFrameGovernor.h"
+#include "tacLibrary\tacCulling.h"
+#include "tacLibrary\tacAabbTree.h"
+#include "tacLibrary\tacOcclusion.h"
+#include "tacLibrary\tacTransforms.h"
+#include "tacLibrary\tacRaycast.h"
 #include "tacGraphics\tacRenderer.h"
+#include "tacGraphics\tacRenderGroup.h"
 #include "tacGraphics\tac4Model.h"
 #include "tacGraphics\tacModelLoader.h"
 #include "tacPhysics\tacPhysics.h"
@@ -34,7 +41,7 @@ struct TacModelRaycastInfo
 
 struct TacGameAssets
 {
-  TacWorkQueue* highPriorityQueue;
+  TacWorkQueue* workQueue;
   enum class AsyncTaskStatus
   {
     NotStarted,
@@ -121,7 +128,7 @@ struct TacGameTransientState
 {
   TacMemoryArena mTempAllocator;
   TacGameAssets gameAssets;
-  TacWorkQueue* highPriorityQueue;
+  TacWorkQueue* workQueue;
   MessageLoop messages;
 };
 
@@ -243,7 +250,12 @@ struct TacEmitter
     numDead -= numToSpawn;
     return numToSpawn;
   }
-  void Update( r32 dt );
+  // stops spawning at maxAlive particles
+  void Update(
+    r32 dt,
+    u32 maxAlive,
+    TacWorkQueue* queue,
+    TacThreadContext* thread );
 
   static const u32 maxparticles = 100;
   TacParticle particles[ maxparticles ];
@@ -278,6 +290,28 @@ struct TacEmitter
   v3 colormax;
 };
 
+// Added to TacGameState::governor in this order, so these are the indexes
+enum class DemoGovernorSubsystem
+{
+  EntityTransforms,
+  Raycasts,
+  Particles,
+  Physics,
+  RecordDraws,
+  Count
+};
+
+enum class DemoGovernorKnob
+{
+  ParticleCap,
+  PhysicsSubsteps,
+  // raycasts per frame, 1 / the number of frames between them
+  RaycastRate,
+  // divides the pixels a lod's error can cover
+  LodDetail,
+  Count
+};
+
 struct TacGameState
 {
   TacPhysics mPhysicsTest;
@@ -308,6 +342,66 @@ struct TacGameState
   TacCBufferHandle cbufferHandlePerFrame;
   TacCBufferHandle cbufferHandlePerObject;
 
+  // trees are drawn with one instanced draw per lod. The instance buffer
+  // grows to hold an instance for every entity, so the trees always fit
+  static const u32 minInstances = 4096;
+  u32 maxInstances;
+  TacShaderHandle instancedShaderHandle;
+  TacVertexFormatHandle instancedVertexFormatHandle;
+  TacVertexBufferHandle instanceBuffer;
+  // from the last frame's TacRenderGroup::Execute
+  TacRenderStateStats renderStateStats;
+
+  TacFrameGovernor governor;
+  r32 GetKnob( DemoGovernorKnob knob )
+  {
+    return governor.knobs[ ( u32 )knob ].value;
+  }
+
+  // the entity under the mouse, kept for the frames the raycast is skipped
+  TacRaycastResult entityRaycast;
+  u32 entityRaycastIndex;
+  u32 framesSinceEntityRaycast;
+
+  // governor log lines already shown as messages
+  u32 numGovernorLogLinesShown;
+
+  // entities outside the camera frustum aren't drawn
+  b32 cullEntities;
+  b32 cullEntitiesSimd;
+  // from the last frame
+  TacCullStats entityCullStats;
+
+  // Entities hidden behind the ground and the entities at least
+  // occluderMinRadius big aren't drawn
+  b32 occlusionCulling;
+  r32 occluderMinRadius;
+  // from the last frame
+  u32 numOccluderTriangles;
+
+  // The bounding boxes of the entities, keyed by entity index. Moved
+  // entities are updated after their transforms, the whole tree is rebuilt
+  // when the entities are loaded or an asset's bounding sphere shows up
+  TacAabbTree entityTree;
+  b32 entityTreeStale;
+  b32 entityTreeAssetLoaded[ ( u32 )TacGameAssetID::Count ];
+  // The world space bounding sphere of each entity, refit with the tree.
+  // The radius is R32MAX until the model's raycast info loads
+  std::vector< TacSphere, TacMemoryAllocator< TacSphere > > entitySpheres;
+  // picking, culling, and spacing trees query the tree instead of looping
+  // over every entity
+  b32 useEntityTree;
+
+  // Entities draw the coarsest lod of their model whose error covers at
+  // most lodPixelError pixels on screen
+  b32 useLods;
+  r32 lodPixelError;
+  r32 lodHysteresis;
+  // the lod each entity drew last frame, by entity index
+  std::vector< u8, TacMemoryAllocator< u8 > > entityLods;
+  // from the last frame
+  u32 entityLodCounts[ MAX_MODEL_LODS ];
+
   TacTextureHandle randomVectorTexture;
   TacTextureHandle gbufferViewSpaceNormal;
   TacTextureHandle gbufferDiffuse;
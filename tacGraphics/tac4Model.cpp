@@ -104,6 +104,25 @@ void ModelBuffersRender(
   myRenderer->Draw();
 }
 
+u32 ModelSelectLod(
+  const TacModel* model,
+  r32 projectedRadius,
+  r32 maxPixelError,
+  r32 hysteresis,
+  u32 currentLod )
+{
+  if( model->numLods < 2 )
+    return 0;
+  u32 result = Minimum( currentLod, model->numLods - 1 );
+  while( result &&
+    model->lodErrors[ result ] * projectedRadius > maxPixelError )
+    --result;
+  while( result + 1 < model->numLods &&
+    model->lodErrors[ result + 1 ] * projectedRadius <
+    maxPixelError * ( 1.0f - hysteresis ) )
+    ++result;
+  return result;
+}
 
 void TacModelInstance::CopyAnimatedTransforms()
 {
@@ -35,9 +35,13 @@ void ModelBuffersRender(
   TacRenderer* myRenderer,
   const ModelBuffers& buffers );
 
+#define MAX_MODEL_LODS 4
+
 struct TacSubModel
 {
-  ModelBuffers buffers;
+  // lods[ 0 ] is the full detail mesh, the rest are simplified from it
+  ModelBuffers lods[ MAX_MODEL_LODS ];
+  u32 numLods;
   TacTextureHandle myDiffuseID;
   TacTextureHandle myNormalID;
   TacTextureHandle mySpecularID;
@@ -51,8 +55,25 @@ struct TacModel
   u32 numSubModels;
   std::vector< TacNode > skeleton;
   std::vector< TacAnimation > animations;
+
+  // the most lods of any submodel, a submodel with fewer draws its last one
+  u32 numLods;
+  // How far each lod strays from lod 0, as a fraction of the radius of the
+  // model's bounding sphere. Never decreases
+  r32 lodErrors[ MAX_MODEL_LODS ];
 };
 
+// The coarsest lod whose error covers at most maxPixelError pixels, when the
+// model's bounding sphere has a radius of projectedRadius pixels.
+// Going to a coarser lod than currentLod needs the error to be a hysteresis
+// fraction under the limit, so models sitting on the boundary don't flicker
+u32 ModelSelectLod(
+  const TacModel* model,
+  r32 projectedRadius,
+  r32 maxPixelError,
+  r32 hysteresis,
+  u32 currentLod );
+
 struct TacSubModelInstance
 {
   // NOTE( N8 ):
@@ -0,0 +1,457 @@
+#include "tacMeshSimplify.h"
+#include "tacLibrary/tacDefines.h"
+
+#include <algorithm>
+#include <string.h>
+#include <vector>
+
+// the sum of the squared distances to a set of weighted planes
+struct TacQuadric
+{
+  r64 a00, a01, a02, a11, a12, a22;
+  r64 b0, b1, b2;
+  r64 c;
+  r64 weight;
+};
+
+internalFunction void QuadricAddPlane(
+  TacQuadric& quadric,
+  v3 normal,
+  r32 d,
+  r32 weight )
+{
+  quadric.a00 += weight * normal.x * normal.x;
+  quadric.a01 += weight * normal.x * normal.y;
+  quadric.a02 += weight * normal.x * normal.z;
+  quadric.a11 += weight * normal.y * normal.y;
+  quadric.a12 += weight * normal.y * normal.z;
+  quadric.a22 += weight * normal.z * normal.z;
+  quadric.b0 += weight * normal.x * d;
+  quadric.b1 += weight * normal.y * d;
+  quadric.b2 += weight * normal.z * d;
+  quadric.c += weight * d * d;
+  quadric.weight += weight;
+}
+
+internalFunction void QuadricAdd( TacQuadric& quadric, const TacQuadric& other )
+{
+  quadric.a00 += other.a00;
+  quadric.a01 += other.a01;
+  quadric.a02 += other.a02;
+  quadric.a11 += other.a11;
+  quadric.a12 += other.a12;
+  quadric.a22 += other.a22;
+  quadric.b0 += other.b0;
+  quadric.b1 += other.b1;
+  quadric.b2 += other.b2;
+  quadric.c += other.c;
+  quadric.weight += other.weight;
+}
+
+// the mean squared distance from p to the planes
+internalFunction r64 QuadricError( const TacQuadric& quadric, v3 p )
+{
+  if( quadric.weight <= 0 )
+    return 0;
+  r64 x = p.x;
+  r64 y = p.y;
+  r64 z = p.z;
+  r64 result =
+    quadric.a00 * x * x +
+    quadric.a11 * y * y +
+    quadric.a22 * z * z +
+    2 * ( quadric.a01 * x * y + quadric.a02 * x * z + quadric.a12 * y * z ) +
+    2 * ( quadric.b0 * x + quadric.b1 * y + quadric.b2 * z ) +
+    quadric.c;
+  result /= quadric.weight;
+  return Maximum( result, 0.0 );
+}
+
+enum class TacSimplifyVertexKind : u8
+{
+  Manifold,
+  // on exactly one open edge loop
+  Border,
+  // a seam, or on more open edges than a border
+  Locked,
+};
+
+struct TacSimplifyCollapse
+{
+  u32 from;
+  u32 to;
+  r32 error;
+};
+
+u32 MeshSimplify(
+  u32* resultIndexes,
+  const u32* indexes,
+  u32 numIndexes,
+  const void* positions,
+  u32 positionStride,
+  u32 numVertexes,
+  u32 targetNumIndexes,
+  r32 maxError,
+  r32* resultError )
+{
+  // the open edges are pulled on this much harder than the faces
+  const r32 borderWeight = 10.0f;
+
+  *resultError = 0;
+  memcpy( resultIndexes, indexes, sizeof( u32 ) * numIndexes );
+  u32 numResultIndexes = numIndexes;
+  if( numResultIndexes <= targetNumIndexes )
+    return numResultIndexes;
+
+  std::vector< v3 > points( numVertexes );
+  for( u32 iVertex = 0; iVertex < numVertexes; ++iVertex )
+  {
+    points[ iVertex ] =
+      *( const v3* )( ( const u8* )positions + iVertex * positionStride );
+  }
+
+  // Vertexes with the same position share one canonical vertex, which
+  // holds the topology and the quadric for all of them
+  std::vector< u32 > canonicals( numVertexes );
+  std::vector< TacSimplifyVertexKind > kinds(
+    numVertexes,
+    TacSimplifyVertexKind::Manifold );
+  {
+    std::vector< u32 > sorted( numVertexes );
+    for( u32 iVertex = 0; iVertex < numVertexes; ++iVertex )
+      sorted[ iVertex ] = iVertex;
+    std::sort( sorted.begin(), sorted.end(), [ & ]( u32 lhs, u32 rhs )
+    {
+      const v3& a = points[ lhs ];
+      const v3& b = points[ rhs ];
+      if( a.x != b.x )
+        return a.x < b.x;
+      if( a.y != b.y )
+        return a.y < b.y;
+      return a.z < b.z;
+    } );
+    for( u32 iSorted = 0; iSorted < numVertexes; )
+    {
+      u32 canonical = sorted[ iSorted ];
+      u32 iSortedEnd = iSorted + 1;
+      while( iSortedEnd < numVertexes &&
+        points[ sorted[ iSortedEnd ] ] == points[ canonical ] )
+        ++iSortedEnd;
+      b32 seam = iSortedEnd - iSorted > 1;
+      for( ; iSorted < iSortedEnd; ++iSorted )
+      {
+        canonicals[ sorted[ iSorted ] ] = canonical;
+        if( seam )
+          kinds[ sorted[ iSorted ] ] = TacSimplifyVertexKind::Locked;
+      }
+    }
+  }
+
+  std::vector< TacQuadric > quadrics( numVertexes, TacQuadric() );
+  for( u32 iIndex = 0; iIndex < numResultIndexes; iIndex += 3 )
+  {
+    const v3& a = points[ canonicals[ resultIndexes[ iIndex + 0 ] ] ];
+    const v3& b = points[ canonicals[ resultIndexes[ iIndex + 1 ] ] ];
+    const v3& c = points[ canonicals[ resultIndexes[ iIndex + 2 ] ] ];
+    v3 normal = Cross( b - a, c - a );
+    r32 doubleArea = Length( normal );
+    if( doubleArea <= 0 )
+      continue;
+    normal /= doubleArea;
+    r32 d = -Dot( normal, a );
+    for( u32 iCorner = 0; iCorner < 3; ++iCorner )
+    {
+      QuadricAddPlane(
+        quadrics[ canonicals[ resultIndexes[ iIndex + iCorner ] ] ],
+        normal,
+        d,
+        doubleArea * 0.5f );
+    }
+  }
+
+  std::vector< u32 > triangleOffsets( numVertexes + 1 );
+  std::vector< u32 > vertexTriangles;
+  std::vector< TacSimplifyCollapse > collapses;
+  std::vector< u32 > remap( numVertexes );
+  std::vector< u8 > touched( numVertexes );
+  b32 addedBorderQuadrics = false;
+  for( ;; )
+  {
+    u32 numTriangles = numResultIndexes / 3;
+
+    // the triangles around each canonical vertex
+    std::fill( triangleOffsets.begin(), triangleOffsets.end(), 0 );
+    for( u32 iIndex = 0; iIndex < numResultIndexes; ++iIndex )
+      triangleOffsets[ canonicals[ resultIndexes[ iIndex ] ] + 1 ]++;
+    for( u32 iVertex = 0; iVertex < numVertexes; ++iVertex )
+      triangleOffsets[ iVertex + 1 ] += triangleOffsets[ iVertex ];
+    vertexTriangles.resize( numResultIndexes );
+    {
+      std::vector< u32 > cursors(
+        triangleOffsets.begin(),
+        triangleOffsets.end() - 1 );
+      for( u32 iIndex = 0; iIndex < numResultIndexes; ++iIndex )
+      {
+        u32 canonical = canonicals[ resultIndexes[ iIndex ] ];
+        vertexTriangles[ cursors[ canonical ]++ ] = iIndex / 3;
+      }
+    }
+    auto TriangleCanonical = [ & ]( u32 iTriangle, u32 iCorner )
+    {
+      return canonicals[ resultIndexes[ iTriangle * 3 + iCorner ] ];
+    };
+
+    // true if no triangle has the edge b -> a, ie: a -> b is open
+    auto IsOpenEdge = [ & ]( u32 a, u32 b )
+    {
+      for( u32 iAdjacent = triangleOffsets[ b ];
+        iAdjacent < triangleOffsets[ b + 1 ];
+        ++iAdjacent )
+      {
+        u32 iTriangle = vertexTriangles[ iAdjacent ];
+        for( u32 iCorner = 0; iCorner < 3; ++iCorner )
+        {
+          if( TriangleCanonical( iTriangle, iCorner ) == b &&
+            TriangleCanonical( iTriangle, ( iCorner + 1 ) % 3 ) == a )
+            return false;
+        }
+      }
+      return true;
+    };
+
+    // classify the vertexes from their open edges
+    for( u32 iVertex = 0; iVertex < numVertexes; ++iVertex )
+    {
+      if( canonicals[ iVertex ] != iVertex ||
+        kinds[ iVertex ] == TacSimplifyVertexKind::Locked )
+        continue;
+      u32 numOpenEdges = 0;
+      for( u32 iAdjacent = triangleOffsets[ iVertex ];
+        iAdjacent < triangleOffsets[ iVertex + 1 ];
+        ++iAdjacent )
+      {
+        u32 iTriangle = vertexTriangles[ iAdjacent ];
+        for( u32 iCorner = 0; iCorner < 3; ++iCorner )
+        {
+          u32 a = TriangleCanonical( iTriangle, iCorner );
+          u32 b = TriangleCanonical( iTriangle, ( iCorner + 1 ) % 3 );
+          if( ( a == iVertex || b == iVertex ) && IsOpenEdge( a, b ) )
+            numOpenEdges++;
+        }
+      }
+      kinds[ iVertex ] =
+        numOpenEdges == 0 ? TacSimplifyVertexKind::Manifold :
+        numOpenEdges == 2 ? TacSimplifyVertexKind::Border :
+        TacSimplifyVertexKind::Locked;
+    }
+
+    // Planes through the open edges, perpendicular to their faces, so the
+    // border vertexes stay on the border. The borders only ever get
+    // shorter, so this is done once
+    if( !addedBorderQuadrics )
+    {
+      addedBorderQuadrics = true;
+      for( u32 iTriangle = 0; iTriangle < numTriangles; ++iTriangle )
+      {
+        const v3& p0 = points[ TriangleCanonical( iTriangle, 0 ) ];
+        const v3& p1 = points[ TriangleCanonical( iTriangle, 1 ) ];
+        const v3& p2 = points[ TriangleCanonical( iTriangle, 2 ) ];
+        v3 faceNormal = Cross( p1 - p0, p2 - p0 );
+        if( LengthSq( faceNormal ) <= 0 )
+          continue;
+        for( u32 iCorner = 0; iCorner < 3; ++iCorner )
+        {
+          u32 a = TriangleCanonical( iTriangle, iCorner );
+          u32 b = TriangleCanonical( iTriangle, ( iCorner + 1 ) % 3 );
+          if( !IsOpenEdge( a, b ) )
+            continue;
+          v3 edge = points[ b ] - points[ a ];
+          v3 normal = Cross( edge, faceNormal );
+          r32 normalLength = Length( normal );
+          if( normalLength <= 0 )
+            continue;
+          normal /= normalLength;
+          r32 d = -Dot( normal, points[ a ] );
+          r32 weight = LengthSq( edge ) * borderWeight;
+          QuadricAddPlane( quadrics[ a ], normal, d, weight );
+          QuadricAddPlane( quadrics[ b ], normal, d, weight );
+        }
+      }
+    }
+
+    // every edge, in the cheaper direction that's allowed
+    collapses.clear();
+    for( u32 iTriangle = 0; iTriangle < numTriangles; ++iTriangle )
+    {
+      for( u32 iCorner = 0; iCorner < 3; ++iCorner )
+      {
+        u32 vertexA = resultIndexes[ iTriangle * 3 + iCorner ];
+        u32 vertexB = resultIndexes[ iTriangle * 3 + ( iCorner + 1 ) % 3 ];
+        u32 a = canonicals[ vertexA ];
+        u32 b = canonicals[ vertexB ];
+
+        // the other side of the edge adds it too
+        if( a == b || ( a > b && !IsOpenEdge( a, b ) ) )
+          continue;
+
+        auto CanCollapse = [ & ]( u32 from, u32 to )
+        {
+          switch( kinds[ from ] )
+          {
+            case TacSimplifyVertexKind::Manifold: return true;
+            case TacSimplifyVertexKind::Border:
+              return
+                kinds[ to ] == TacSimplifyVertexKind::Border &&
+                ( IsOpenEdge( from, to ) || IsOpenEdge( to, from ) );
+          }
+          return false;
+        };
+
+        TacQuadric quadric = quadrics[ a ];
+        QuadricAdd( quadric, quadrics[ b ] );
+        TacSimplifyCollapse collapse;
+        collapse.error = R32MAX;
+        if( CanCollapse( a, b ) )
+        {
+          collapse.from = vertexA;
+          collapse.to = vertexB;
+          collapse.error = ( r32 )QuadricError( quadric, points[ b ] );
+        }
+        if( CanCollapse( b, a ) )
+        {
+          r32 error = ( r32 )QuadricError( quadric, points[ a ] );
+          if( error < collapse.error )
+          {
+            collapse.from = vertexB;
+            collapse.to = vertexA;
+            collapse.error = error;
+          }
+        }
+        if( collapse.error != R32MAX )
+          collapses.push_back( collapse );
+      }
+    }
+    std::sort(
+      collapses.begin(),
+      collapses.end(),
+      []( const TacSimplifyCollapse& lhs, const TacSimplifyCollapse& rhs )
+    {
+      return lhs.error < rhs.error;
+    } );
+
+    // Collapse the cheapest edges whose neighborhoods haven't changed yet
+    // this pass, so the adjacency above is still right for them
+    for( u32 iVertex = 0; iVertex < numVertexes; ++iVertex )
+      remap[ iVertex ] = iVertex;
+    std::fill( touched.begin(), touched.end(), 0 );
+    u32 numTrianglesToRemove = ( numResultIndexes - targetNumIndexes ) / 3;
+    u32 numTrianglesRemoved = 0;
+    u32 numCollapsed = 0;
+    for( const TacSimplifyCollapse& collapse : collapses )
+    {
+      if( numTrianglesRemoved >= numTrianglesToRemove ||
+        collapse.error > maxError * maxError )
+        break;
+      u32 from = canonicals[ collapse.from ];
+      u32 to = canonicals[ collapse.to ];
+      if( touched[ from ] || touched[ to ] )
+        continue;
+
+      // don't flip the triangles that stay
+      b32 flips = false;
+      for( u32 iAdjacent = triangleOffsets[ from ];
+        !flips && iAdjacent < triangleOffsets[ from + 1 ];
+        ++iAdjacent )
+      {
+        u32 iTriangle = vertexTriangles[ iAdjacent ];
+        v3 before[ 3 ];
+        v3 after[ 3 ];
+        b32 removed = false;
+        for( u32 iCorner = 0; iCorner < 3; ++iCorner )
+        {
+          u32 canonical = TriangleCanonical( iTriangle, iCorner );
+          removed |= canonical == to;
+          before[ iCorner ] = points[ canonical ];
+          after[ iCorner ] =
+            canonical == from ? points[ to ] : points[ canonical ];
+        }
+        if( removed )
+          continue;
+        v3 normalBefore = Cross(
+          before[ 1 ] - before[ 0 ],
+          before[ 2 ] - before[ 0 ] );
+        v3 normalAfter = Cross(
+          after[ 1 ] - after[ 0 ],
+          after[ 2 ] - after[ 0 ] );
+        flips =
+          Dot( normalBefore, normalAfter ) <=
+          0.25f * Length( normalBefore ) * Length( normalAfter );
+      }
+      if( flips )
+        continue;
+
+      remap[ collapse.from ] = collapse.to;
+      QuadricAdd( quadrics[ to ], quadrics[ from ] );
+      *resultError = Maximum( *resultError, SquareRoot( collapse.error ) );
+      for( u32 iAdjacent = triangleOffsets[ from ];
+        iAdjacent < triangleOffsets[ from + 1 ];
+        ++iAdjacent )
+      {
+        u32 iTriangle = vertexTriangles[ iAdjacent ];
+        for( u32 iCorner = 0; iCorner < 3; ++iCorner )
+          touched[ TriangleCanonical( iTriangle, iCorner ) ] = 1;
+      }
+      touched[ to ] = 1;
+      numTrianglesRemoved +=
+        kinds[ from ] == TacSimplifyVertexKind::Border ? 1 : 2;
+      numCollapsed++;
+    }
+    if( !numCollapsed )
+      break;
+
+    // apply the collapses, dropping the triangles that lost an edge
+    u32 numKeptIndexes = 0;
+    for( u32 iIndex = 0; iIndex < numResultIndexes; iIndex += 3 )
+    {
+      u32 vertex0 = remap[ resultIndexes[ iIndex + 0 ] ];
+      u32 vertex1 = remap[ resultIndexes[ iIndex + 1 ] ];
+      u32 vertex2 = remap[ resultIndexes[ iIndex + 2 ] ];
+      u32 canonical0 = canonicals[ vertex0 ];
+      u32 canonical1 = canonicals[ vertex1 ];
+      u32 canonical2 = canonicals[ vertex2 ];
+      if( canonical0 == canonical1 ||
+        canonical1 == canonical2 ||
+        canonical2 == canonical0 )
+        continue;
+      resultIndexes[ numKeptIndexes++ ] = vertex0;
+      resultIndexes[ numKeptIndexes++ ] = vertex1;
+      resultIndexes[ numKeptIndexes++ ] = vertex2;
+    }
+    numResultIndexes = numKeptIndexes;
+    if( numResultIndexes <= targetNumIndexes )
+      break;
+  }
+  return numResultIndexes;
+}
+
+u32 MeshCompactVertexes(
+  u32* indexes,
+  u32 numIndexes,
+  u32 numVertexes,
+  u32* oldVertexes )
+{
+  const u32 unused = ( u32 )-1;
+  std::vector< u32 > newVertexes( numVertexes, unused );
+  u32 numUsedVertexes = 0;
+  for( u32 iIndex = 0; iIndex < numIndexes; ++iIndex )
+  {
+    u32& newVertex = newVertexes[ indexes[ iIndex ] ];
+    if( newVertex == unused )
+    {
+      newVertex = numUsedVertexes++;
+      oldVertexes[ newVertex ] = indexes[ iIndex ];
+    }
+    indexes[ iIndex ] = newVertex;
+  }
+  return numUsedVertexes;
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include "tacLibrary/tacMath.h"
+
+// Quadric error mesh simplification ( Garland and Heckbert ).
+//
+// Edges are collapsed cheapest first, each vertex onto one of its neighbors,
+// so the result only indexes vertexes of the original mesh and the vertex
+// attributes don't have to be touched.
+//
+// Vertexes that share their position with another vertex ( uv seams ) never
+// move, and vertexes on an open edge only slide along it, so the mesh
+// doesn't tear or grow holes.
+//
+// Writes at most numIndexes indexes to resultIndexes and returns how many it
+// wrote. Stops once the mesh is down to targetNumIndexes, or when the next
+// collapse would move the surface farther than maxError. resultError gets
+// how far the surface moved, in the same units as the positions.
+u32 MeshSimplify(
+  u32* resultIndexes,
+  const u32* indexes,
+  u32 numIndexes,
+  const void* positions,
+  u32 positionStride,
+  u32 numVertexes,
+  u32 targetNumIndexes,
+  r32 maxError,
+  r32* resultError );
+
+// Packs the vertexes that indexes uses to the front, and rewrites indexes to
+// match. Writes the old vertex of each new vertex to oldVertexes so the
+// caller can copy the vertex data. Returns the number of vertexes used
+u32 MeshCompactVertexes(
+  u32* indexes,
+  u32 numIndexes,
+  u32 numVertexes,
+  u32* oldVertexes );
@@ -2,6 +2,7 @@
 #include "tacRenderer.h"
 #include "tac4Animation.h"
 #include "tac4Model.h"
+#include "tacMeshSimplify.h"
 #include "tacLibrary\tacMemoryAllocator.h"
 
 u32 GetTextureFormatSize( TacTextureFormat textureFormat )
@@ -190,6 +191,9 @@ ModelFormat TacModelLoader::AllocateVertexFormat(
     SubModelFormat& subformat = format.subformats[ iMesh ];
 
     subformat.numVertexes = mesh->mNumVertices;
+    subformat.lodError = 0;
+    subformat.lods = nullptr;
+    subformat.numLods = 0;
 
     // allocate memory
     {
@@ -334,3 +338,124 @@ ModelFormat TacModelLoader::AllocateVertexFormat(
 
   return format;
 }
+
+void ModelFormatGenerateLods(
+  TacMemoryArena* arena,
+  ModelFormat& format,
+  TacVertexFormat* vertexFormats,
+  u32 numVertexFormats,
+  u32 maxLods )
+{
+  // each lod has about this many of the triangles of the one before
+  const r32 lodTriangleRatio = 0.5f;
+  // a lod has to drop at least this many of the triangles to be kept
+  const r32 lodMinSavings = 0.15f;
+  // the farthest lod i can stray from lod 0, as a fraction of the size of
+  // the submodel, is lodMaxError * 4 ^ ( i - 1 )
+  const r32 lodMaxError = 0.01f;
+
+  TacVertexFormat* positionVertexFormat = nullptr;
+  for( u32 i = 0; i < numVertexFormats; ++i )
+  {
+    if( vertexFormats[ i ].mAttributeType == TacAttributeType::Position )
+      positionVertexFormat = &vertexFormats[ i ];
+  }
+  if( !positionVertexFormat || maxLods < 2 )
+    return;
+  TacAssert( positionVertexFormat->textureFormat ==
+    TacTextureFormat::RGB32Float );
+  u32 positionStride =
+    format.vertexBufferStrides[ positionVertexFormat->mInputSlot ];
+
+  for( u32 iSubformat = 0; iSubformat < format.numsubformtas; ++iSubformat )
+  {
+    SubModelFormat& subformat = format.subformats[ iSubformat ];
+    if( !subformat.numIndexes )
+      continue;
+    u8* positions =
+      ( u8* )subformat.vertexBuffers[ positionVertexFormat->mInputSlot ] +
+      positionVertexFormat->mAlignedByteOffset;
+
+    r32 size;
+    {
+      v3 mini = *( v3* )positions;
+      v3 maxi = mini;
+      for( u32 iVertex = 1; iVertex < subformat.numVertexes; ++iVertex )
+      {
+        v3 position = *( v3* )( positions + iVertex * positionStride );
+        for( u32 i = 0; i < 3; ++i )
+        {
+          mini[ i ] = Minimum( mini[ i ], position[ i ] );
+          maxi[ i ] = Maximum( maxi[ i ], position[ i ] );
+        }
+      }
+      size = Length( maxi - mini );
+    }
+
+    subformat.lods = PushArray( arena, maxLods - 1, SubModelFormat );
+    if( !subformat.lods )
+      return;
+    u32 numLodIndexes = subformat.numIndexes;
+    r32 maxError = lodMaxError * size;
+    for( u32 iLod = 1; iLod < maxLods; ++iLod, maxError *= 4.0f )
+    {
+      u32* lodIndexes = PushArray( arena, subformat.numIndexes, u32 );
+      u32* oldVertexes = PushArray( arena, subformat.numVertexes, u32 );
+      if( !lodIndexes || !oldVertexes )
+        return;
+      r32 lodError;
+      u32 targetNumIndexes = ( u32 )( numLodIndexes * lodTriangleRatio );
+      u32 numIndexes = MeshSimplify(
+        lodIndexes,
+        subformat.indexBuffer,
+        subformat.numIndexes,
+        positions,
+        positionStride,
+        subformat.numVertexes,
+        targetNumIndexes,
+        maxError,
+        &lodError );
+      if( !numIndexes ||
+        numIndexes > numLodIndexes * ( 1.0f - lodMinSavings ) )
+        break;
+      numLodIndexes = numIndexes;
+
+      SubModelFormat& lod = subformat.lods[ subformat.numLods ];
+      lod.numIndexes = numIndexes;
+      lod.indexBuffer = lodIndexes;
+      lod.numVertexes = MeshCompactVertexes(
+        lodIndexes,
+        numIndexes,
+        subformat.numVertexes,
+        oldVertexes );
+      lod.lodError = lodError;
+      lod.lods = nullptr;
+      lod.numLods = 0;
+
+      // copy the vertexes the lod still uses
+      lod.vertexBuffers = PushArray( arena, format.numVertexBuffers, void* );
+      if( !lod.vertexBuffers )
+        return;
+      for(
+        u32 iVertexBuffer = 0;
+        iVertexBuffer < format.numVertexBuffers;
+        ++iVertexBuffer )
+      {
+        u32 stride = format.vertexBufferStrides[ iVertexBuffer ];
+        u8* from = ( u8* )subformat.vertexBuffers[ iVertexBuffer ];
+        u8* to = ( u8* )PushSize( arena, stride * lod.numVertexes );
+        if( !to )
+          return;
+        for( u32 iVertex = 0; iVertex < lod.numVertexes; ++iVertex )
+        {
+          memcpy(
+            to + iVertex * stride,
+            from + oldVertexes[ iVertex ] * stride,
+            stride );
+        }
+        lod.vertexBuffers[ iVertexBuffer ] = to;
+      }
+      subformat.numLods++;
+    }
+  }
+}
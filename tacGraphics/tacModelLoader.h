@@ -17,6 +17,13 @@ struct SubModelFormat
 
   u32* indexBuffer;
   u32 numIndexes;
+
+  // how far a lod's surface is from the full detail one, in model space
+  r32 lodError;
+
+  // simplified versions of this submodel, most detailed first
+  SubModelFormat* lods;
+  u32 numLods;
 };
 struct ModelFormat
 {
@@ -55,3 +62,14 @@ struct TacModelLoader
   const aiScene* mScene;
 };
 
+// Simplifies each submodel into up to maxLods lods, each with about half the
+// triangles of the one before. A lod that doesn't save much isn't kept.
+// The lods are allocated from the arena, if it runs out the submodels just
+// get fewer lods
+void ModelFormatGenerateLods(
+  TacMemoryArena* arena,
+  ModelFormat& format,
+  TacVertexFormat* vertexFormats,
+  u32 numVertexFormats,
+  u32 maxLods );
+
@@ -1,19 +1,224 @@
 #include "tacRenderGroup.h"
 #include "tac4Model.h"
+#include "tacLibrary\tacProfiler.h"
 
-void TacRenderGroup::PushModel( TacModel* model )
+void TacRenderStateCache::Reset()
+{
+  mShaderHandle.mIndex = sUnknown;
+  mVertexFormatHandle.mIndex = sUnknown;
+  mBlendStateHandle.mIndex = sUnknown;
+  mDepthStateHandle.mIndex = sUnknown;
+  mRasterizerStateHandle.mIndex = sUnknown;
+  mIndexBufferHandle.mIndex = sUnknown;
+  mVertexBuffersKnown = false;
+  InvalidateShaderResources();
+  TacRenderStateStats stats = {};
+  mStats = stats;
+}
+
+void TacRenderStateCache::InvalidateShaderResources()
+{
+  mNumSamplers = 0;
+  mNumTextures = 0;
+}
+
+b32 TacRenderStateCache::Count( b32 changed )
+{
+  if( changed )
+    ++mStats.mNumIssued;
+  else
+    ++mStats.mNumSkipped;
+  return changed;
+}
+
+b32 TacRenderStateCache::CacheShader( TacShaderHandle shaderHandle )
+{
+  if( shaderHandle.mIndex == mShaderHandle.mIndex )
+    return Count( false );
+  mShaderHandle = shaderHandle;
+  InvalidateShaderResources();
+  return Count( true );
+}
+
+b32 TacRenderStateCache::CacheVertexFormat(
+  TacVertexFormatHandle vertexFormatHandle )
+{
+  if( vertexFormatHandle.mIndex == mVertexFormatHandle.mIndex )
+    return Count( false );
+  mVertexFormatHandle = vertexFormatHandle;
+  return Count( true );
+}
+
+b32 TacRenderStateCache::CacheBlendState(
+  TacBlendStateHandle blendStateHandle,
+  v4 blendFactorRGBA,
+  u32 sampleMask )
+{
+  if( blendStateHandle.mIndex == mBlendStateHandle.mIndex &&
+    sampleMask == mSampleMask &&
+    !memcmp( &blendFactorRGBA, &mBlendFactorRGBA, sizeof( v4 ) ) )
+    return Count( false );
+  mBlendStateHandle = blendStateHandle;
+  mBlendFactorRGBA = blendFactorRGBA;
+  mSampleMask = sampleMask;
+  return Count( true );
+}
+
+b32 TacRenderStateCache::CacheDepthState(
+  TacDepthStateHandle depthStateHandle,
+  u32 stencilRef )
+{
+  if( depthStateHandle.mIndex == mDepthStateHandle.mIndex &&
+    stencilRef == mStencilRef )
+    return Count( false );
+  mDepthStateHandle = depthStateHandle;
+  mStencilRef = stencilRef;
+  return Count( true );
+}
+
+b32 TacRenderStateCache::CacheRasterizerState(
+  TacRasterizerStateHandle rasterizerStateHandle )
+{
+  if( rasterizerStateHandle.mIndex == mRasterizerStateHandle.mIndex )
+    return Count( false );
+  mRasterizerStateHandle = rasterizerStateHandle;
+  return Count( true );
+}
+
+b32 TacRenderStateCache::CacheIndexBuffer(
+  TacIndexBufferHandle indexBufferHandle )
+{
+  if( indexBufferHandle.mIndex == mIndexBufferHandle.mIndex )
+    return Count( false );
+  mIndexBufferHandle = indexBufferHandle;
+  return Count( true );
+}
+
+b32 TacRenderStateCache::CacheVertexBuffers(
+  const TacVertexBufferHandle* vertexBufferHandles,
+  u32 numVertexBufferHandles )
+{
+  if( mVertexBuffersKnown &&
+    numVertexBufferHandles == mNumVertexBufferHandles &&
+    !memcmp(
+      vertexBufferHandles,
+      mVertexBufferHandles,
+      sizeof( TacVertexBufferHandle ) * numVertexBufferHandles ) )
+    return Count( false );
+  mVertexBuffersKnown = numVertexBufferHandles <= sMaxBindings;
+  if( mVertexBuffersKnown )
+  {
+    mNumVertexBufferHandles = numVertexBufferHandles;
+    memcpy(
+      mVertexBufferHandles,
+      vertexBufferHandles,
+      sizeof( TacVertexBufferHandle ) * numVertexBufferHandles );
+  }
+  return Count( true );
+}
+
+// Binds name to handle in the parallel names / handles arrays
+// returns true if that changed anything
+template< typename THandle >
+internalFunction b32 CacheNamedBinding(
+  const char** names,
+  THandle* handles,
+  u32& numBindings,
+  const char* name,
+  THandle handle )
+{
+  for( u32 iBinding = 0; iBinding < numBindings; ++iBinding )
+  {
+    if( names[ iBinding ] != name )
+      continue;
+    if( handles[ iBinding ].mIndex == handle.mIndex )
+      return false;
+    handles[ iBinding ] = handle;
+    return true;
+  }
+  // when full, the binding just isn't remembered
+  if( numBindings < TacRenderStateCache::sMaxBindings )
+  {
+    names[ numBindings ] = name;
+    handles[ numBindings ] = handle;
+    ++numBindings;
+  }
+  return true;
+}
+
+b32 TacRenderStateCache::CacheSamplerState(
+  const char* name,
+  TacSamplerStateHandle samplerStateHandle )
+{
+  return Count( CacheNamedBinding(
+    mSamplerNames,
+    mSamplerStateHandles,
+    mNumSamplers,
+    name,
+    samplerStateHandle ) );
+}
+
+b32 TacRenderStateCache::CacheTexture(
+  const char* name,
+  TacTextureHandle textureHandle )
+{
+  return Count( CacheNamedBinding(
+    mTextureNames,
+    mTextureHandles,
+    mNumTextures,
+    name,
+    textureHandle ) );
+}
+
+void TacRenderGroup::PushModel( TacModel* model, u32 lod )
 {
   if( !model )
     return;
-  PushData( TacRenderEntryType::Model );
-  PushData( model );
+  TacRenderCommandModel* command = PushCommand< TacRenderCommandModel >();
+  if( !command )
+    return;
+  command->mModel = model;
+  command->mLod = lod;
+}
+
+void* TacRenderGroup::PushInstances( u32 numInstances, u32* firstInstance )
+{
+  if( mNumInstances + numInstances > mNumInstancesMax )
+  {
+    TacInvalidCodePath;
+    return nullptr;
+  }
+  *firstInstance = mNumInstances;
+  mNumInstances += numInstances;
+  return mInstanceMemory + *firstInstance * mInstanceStride;
+}
+
+void TacRenderGroup::PushModelInstanced(
+  TacModel* model,
+  u32 firstInstance,
+  u32 numInstances,
+  u32 lod )
+{
+  if( !model || !numInstances )
+    return;
+  TacRenderCommandModelInstanced* command =
+    PushCommand< TacRenderCommandModelInstanced >();
+  if( !command )
+    return;
+  command->mModel = model;
+  command->mFirstInstance = firstInstance;
+  command->mNumInstances = numInstances;
+  command->mLod = lod;
 }
 
 void TacRenderGroup::PushClearColor( TacTextureHandle textureHandle, v4 rgba )
 {
-  PushData( TacRenderEntryType::ClearColor );
-  PushData( textureHandle );
-  PushData( rgba );
+  TacRenderCommandClearColor* command =
+    PushCommand< TacRenderCommandClearColor >();
+  if( !command )
+    return;
+  command->mTextureHandle = textureHandle;
+  command->mRGBA = rgba;
 }
 
 void TacRenderGroup::PushClearDepthStencil(
@@ -23,12 +228,15 @@ void TacRenderGroup::PushClearDepthStencil(
   b32 clearStencil,
   u8 stencil )
 {
-  PushData( TacRenderEntryType::ClearDepthStencil );
-  PushData( depthBufferHandle );
-  PushData( clearDepth );
-  PushData( depth );
-  PushData( clearStencil );
-  PushData( stencil );
+  TacRenderCommandClearDepthStencil* command =
+    PushCommand< TacRenderCommandClearDepthStencil >();
+  if( !command )
+    return;
+  command->mDepthBufferHandle = depthBufferHandle;
+  command->mClearDepth = clearDepth;
+  command->mDepth = depth;
+  command->mClearStencil = clearStencil;
+  command->mStencil = stencil;
 }
 
 
@@ -37,10 +245,14 @@ void TacRenderGroup::PushRenderTargets(
   u32 numTextureHandles,
   TacDepthBufferHandle depthBufferHandle )
 {
-  PushData( TacRenderEntryType::SetRenderTargets );
-  PushData( numTextureHandles );
-  PushData( textureHandles, numTextureHandles * sizeof( TacTextureHandle ) );
-  PushData( depthBufferHandle );
+  u32 textureHandlesSize = numTextureHandles * sizeof( TacTextureHandle );
+  TacRenderCommandSetRenderTargets* command =
+    PushCommand< TacRenderCommandSetRenderTargets >( textureHandlesSize );
+  if( !command )
+    return;
+  command->mDepthBufferHandle = depthBufferHandle;
+  command->mNumTextureHandles = numTextureHandles;
+  memcpy( command + 1, textureHandles, textureHandlesSize );
 }
 
 void TacRenderGroup::PushBlendState(
@@ -48,47 +260,76 @@ void TacRenderGroup::PushBlendState(
   v4 blendFactorRGBA,
   u32 sampleMask )
 {
-  PushData( TacRenderEntryType::SetBlendState );
-  PushData( blendStateHandle );
-  PushData( blendFactorRGBA );
-  PushData( sampleMask );
+  TacRenderCommandSetBlendState* command =
+    PushCommand< TacRenderCommandSetBlendState >();
+  if( !command )
+    return;
+  command->mBlendStateHandle = blendStateHandle;
+  command->mBlendFactorRGBA = blendFactorRGBA;
+  command->mSampleMask = sampleMask;
 }
 
 void TacRenderGroup::PushDepthState( TacDepthStateHandle depthStateHandle, u32 stencilRef )
 {
-  PushData( TacRenderEntryType::SetDepthState );
-  PushData( depthStateHandle );
-  PushData( stencilRef );
+  TacRenderCommandSetDepthState* command =
+    PushCommand< TacRenderCommandSetDepthState >();
+  if( !command )
+    return;
+  command->mDepthStateHandle = depthStateHandle;
+  command->mStencilRef = stencilRef;
 }
 
 
 void TacRenderGroup::PushUniform( const char* name, void* data, u32 size )
 {
-  PushData( TacRenderEntryType::Uniform );
-  PushData( name );
-  PushData( size );
-  PushData( data, size );
+  TacAssert( mRenderer );
+  TacUniformHandle uniform = mRenderer->GetUniformHandle( name );
+  TacAssert( uniform.mIndex != RENDERER_ID_NONE );
+  PushUniform( uniform, data, size );
+}
+
+void TacRenderGroup::PushUniform( TacUniformHandle uniform, void* data, u32 size )
+{
+  TacRenderCommandUniform* command =
+    PushCommand< TacRenderCommandUniform >( size );
+  if( !command )
+    return;
+  command->mUniform = uniform;
+  command->mSize = size;
+  memcpy( command + 1, data, size );
 }
 
 void TacRenderGroup::PushShader( TacShaderHandle shaderHandle )
 {
-  PushData( TacRenderEntryType::SetShader );
-  PushData( shaderHandle );
+  TacRenderCommandSetShader* command =
+    PushCommand< TacRenderCommandSetShader >();
+  if( !command )
+    return;
+  command->mShaderHandle = shaderHandle;
 }
 void TacRenderGroup::PushPrimitive( TacPrimitive primitive )
 {
-  PushData( TacRenderEntryType::SetPrimitive );
-  PushData( primitive );
+  TacRenderCommandSetPrimitive* command =
+    PushCommand< TacRenderCommandSetPrimitive >();
+  if( !command )
+    return;
+  command->mPrimitive = primitive;
 }
 void TacRenderGroup::PushVertexFormat( TacVertexFormatHandle vertexFormatHandle )
 {
-  PushData( TacRenderEntryType::SetVertexFormat );
-  PushData( vertexFormatHandle );
+  TacRenderCommandSetVertexFormat* command =
+    PushCommand< TacRenderCommandSetVertexFormat >();
+  if( !command )
+    return;
+  command->mVertexFormatHandle = vertexFormatHandle;
 }
 void TacRenderGroup::PushRasterizerState( TacRasterizerStateHandle rasterizerStateHandle )
 {
-  PushData( TacRenderEntryType::SetRasterizerState );
-  PushData( rasterizerStateHandle );
+  TacRenderCommandSetRasterizerState* command =
+    PushCommand< TacRenderCommandSetRasterizerState >();
+  if( !command )
+    return;
+  command->mRasterizerStateHandle = rasterizerStateHandle;
 }
 
 void TacRenderGroup::PushViewport(
@@ -97,216 +338,428 @@ void TacRenderGroup::PushViewport(
   r32 wIncreasingRight,
   r32 hIncreasingUp )
 {
-  PushData( TacRenderEntryType::SetViewport );
-  PushData( xRelBotLeftCorner );
-  PushData( yRelBotLeftCorner );
-  PushData( wIncreasingRight );
-  PushData( hIncreasingUp );
+  TacRenderCommandSetViewport* command =
+    PushCommand< TacRenderCommandSetViewport >();
+  if( !command )
+    return;
+  command->mXRelBotLeftCorner = xRelBotLeftCorner;
+  command->mYRelBotLeftCorner = yRelBotLeftCorner;
+  command->mWIncreasingRight = wIncreasingRight;
+  command->mHIncreasingUp = hIncreasingUp;
 }
 
 void TacRenderGroup::PushApply()
 {
-  PushData( TacRenderEntryType::Apply );
+  PushCommand< TacRenderCommandApply >();
 }
 
 void TacRenderGroup::PushDraw()
 {
-  PushData( TacRenderEntryType::Draw );
+  PushCommand< TacRenderCommandDraw >();
 }
 
 void TacRenderGroup::PushVertexBuffers(
   TacVertexBufferHandle* vertexBufferHandles,
   u32 numVertexBufferHandles )
 {
-  PushData( TacRenderEntryType::SetVertexBuffers );
-  PushData( numVertexBufferHandles );
-  PushData(
-    vertexBufferHandles,
-    sizeof( TacVertexBufferHandle ) * numVertexBufferHandles );
+  u32 vertexBufferHandlesSize =
+    sizeof( TacVertexBufferHandle ) * numVertexBufferHandles;
+  TacRenderCommandSetVertexBuffers* command =
+    PushCommand< TacRenderCommandSetVertexBuffers >( vertexBufferHandlesSize );
+  if( !command )
+    return;
+  command->mNumVertexBufferHandles = numVertexBufferHandles;
+  memcpy( command + 1, vertexBufferHandles, vertexBufferHandlesSize );
 }
 
 void TacRenderGroup::PushIndexBuffer(
   TacIndexBufferHandle indexBufferHandle )
 {
-  PushData( TacRenderEntryType::SetIndexBuffer );
-  PushData( indexBufferHandle );
+  TacRenderCommandSetIndexBuffer* command =
+    PushCommand< TacRenderCommandSetIndexBuffer >();
+  if( !command )
+    return;
+  command->mIndexBufferHandle = indexBufferHandle;
 }
 void TacRenderGroup::PushSamplerState(
   const char* name,
   TacSamplerStateHandle samplerStateHandle )
 {
-  PushData( TacRenderEntryType::SetSamplerState );
-  PushData( name );
-  PushData( samplerStateHandle );
-
+  TacRenderCommandSetSamplerState* command =
+    PushCommand< TacRenderCommandSetSamplerState >();
+  if( !command )
+    return;
+  command->mName = name;
+  command->mSamplerStateHandle = samplerStateHandle;
 }
 void TacRenderGroup::PushTexture(
   const char* name,
   TacTextureHandle textureHandle )
 {
-  PushData( TacRenderEntryType::SetTexture );
-  PushData( name );
-  PushData( textureHandle );
+  TacRenderCommandSetTexture* command =
+    PushCommand< TacRenderCommandSetTexture >();
+  if( !command )
+    return;
+  command->mName = name;
+  command->mTextureHandle = textureHandle;
+}
+
+u64 TacDrawItemSortKey(
+  u32 pass,
+  TacShaderHandle shaderHandle,
+  TacVertexFormatHandle vertexFormatHandle,
+  TacTextureHandle textureHandle,
+  r32 viewSpaceDepth )
+{
+  TacAssert( pass < ( 1 << 4 ) );
+  TacAssert( ( u32 )shaderHandle.mIndex < ( 1 << 8 ) );
+  TacAssert( ( u32 )vertexFormatHandle.mIndex < ( 1 << 8 ) );
+  TacAssert( ( u32 )textureHandle.mIndex < ( 1 << 12 ) );
+
+  // positive floats sort the same as their bits
+  viewSpaceDepth = Maximum( viewSpaceDepth, 0.0f );
+  u32 depthBits;
+  memcpy( &depthBits, &viewSpaceDepth, sizeof( r32 ) );
+
+  u64 result =
+    ( ( u64 )pass << 60 ) |
+    ( ( u64 )shaderHandle.mIndex << 52 ) |
+    ( ( u64 )vertexFormatHandle.mIndex << 44 ) |
+    ( ( u64 )textureHandle.mIndex << 32 ) |
+    ( u64 )depthBits;
+  return result;
 }
 
-struct Popper
+// Least significant digit first, a byte at a time
+internalFunction void RadixSortDrawItems(
+  TacDrawItem* items,
+  TacDrawItem* scratch,
+  u32 numItems )
 {
-  template< typename T >
-  void Pop( T*& t, u32 count = 1 )
+  TacDrawItem* src = items;
+  TacDrawItem* dst = scratch;
+  for( u32 shift = 0; shift < 64; shift += 8 )
   {
-    t = ( T* )runningAddress;
-    runningAddress += sizeof( T ) * count;
+    u32 counts[ 256 ] = {};
+    for( u32 iItem = 0; iItem < numItems; ++iItem )
+      ++counts[ ( src[ iItem ].mSortKey >> shift ) & 0xff ];
+
+    // every key has the same byte, nothing to move
+    if( counts[ ( src[ 0 ].mSortKey >> shift ) & 0xff ] == numItems )
+      continue;
+
+    u32 offset = 0;
+    for( u32 iDigit = 0; iDigit < 256; ++iDigit )
+    {
+      u32 count = counts[ iDigit ];
+      counts[ iDigit ] = offset;
+      offset += count;
+    }
+    for( u32 iItem = 0; iItem < numItems; ++iItem )
+    {
+      TacDrawItem& item = src[ iItem ];
+      dst[ counts[ ( item.mSortKey >> shift ) & 0xff ]++ ] = item;
+    }
+    TacDrawItem* temp = src;
+    src = dst;
+    dst = temp;
   }
-  u8* runningAddress;
-};
+
+  // skipped passes can leave the result in scratch
+  if( src != items )
+    memcpy( items, src, sizeof( TacDrawItem ) * numItems );
+}
+
+void TacRenderGroup::BeginDrawItem(
+  u64 sortKey,
+  TacShaderHandle shaderHandle,
+  TacVertexFormatHandle vertexFormatHandle,
+  const char* textureName,
+  TacTextureHandle textureHandle )
+{
+  TacAssert( !mInDrawItem );
+  if( mNumDrawItems == mNumDrawItemsMax )
+  {
+    TacInvalidCodePath;
+    return;
+  }
+  TacRenderCommandDrawItem* command =
+    PushCommand< TacRenderCommandDrawItem >();
+  if( !command )
+    return;
+  command->mShaderHandle = shaderHandle;
+  command->mVertexFormatHandle = vertexFormatHandle;
+  command->mTextureName = textureName;
+  command->mTextureHandle = textureHandle;
+
+  mCurrentDrawItemOffset = ( u32 )( ( u8* )command - mPushBufferMemory );
+  mInDrawItem = true;
+
+  TacDrawItem& item = mDrawItems[ mNumDrawItems++ ];
+  item.mSortKey = sortKey;
+  item.mCommandOffset = mCurrentDrawItemOffset;
+}
+
+void TacRenderGroup::EndDrawItem()
+{
+  if( !mInDrawItem )
+    return;
+  mInDrawItem = false;
+  TacRenderCommandHeader* header = ( TacRenderCommandHeader* )(
+    mPushBufferMemory + mCurrentDrawItemOffset );
+  header->mSize = mPushBufferMemorySize - mCurrentDrawItemOffset;
+}
+
+void TacRenderGroup::PushDrawItems()
+{
+  TacAssert( !mInDrawItem );
+  u32 numDrawItems = mNumDrawItems - mFirstUnsortedDrawItem;
+  if( !numDrawItems )
+    return;
+  TacRenderCommandDrawItems* command =
+    PushCommand< TacRenderCommandDrawItems >();
+  if( !command )
+    return;
+  command->mFirstDrawItem = mFirstUnsortedDrawItem;
+  command->mNumDrawItems = numDrawItems;
+  RadixSortDrawItems(
+    mDrawItems + mFirstUnsortedDrawItem,
+    mDrawItemsScratch,
+    numDrawItems );
+  mFirstUnsortedDrawItem = mNumDrawItems;
+}
+
+void TacRenderGroup::ExecuteDrawItems(
+  TacRenderer* renderer,
+  TacRenderCommandDrawItems* command )
+{
+  for( u32 iItem = 0; iItem < command->mNumDrawItems; ++iItem )
+  {
+    TacDrawItem& item = mDrawItems[ command->mFirstDrawItem + iItem ];
+    u8* itemAddress = mPushBufferMemory + item.mCommandOffset;
+    auto itemCommand = ( TacRenderCommandDrawItem* )itemAddress;
+    if( mStateCache.CacheShader( itemCommand->mShaderHandle ) )
+      renderer->SetActiveShader( itemCommand->mShaderHandle );
+    if( mStateCache.CacheVertexFormat( itemCommand->mVertexFormatHandle ) )
+      renderer->SetVertexFormat( itemCommand->mVertexFormatHandle );
+    if( itemCommand->mTextureHandle.mIndex != RENDERER_ID_NONE &&
+      mStateCache.CacheTexture(
+        itemCommand->mTextureName,
+        itemCommand->mTextureHandle ) )
+      renderer->SetTexture(
+        itemCommand->mTextureName,
+        itemCommand->mTextureHandle );
+    u32 commandSize = RoundUpToNearestMultiple(
+      sizeof( TacRenderCommandDrawItem ),
+      sCommandAlignment );
+    ExecuteCommands(
+      renderer,
+      itemAddress + commandSize,
+      itemAddress + itemCommand->mHeader.mSize );
+  }
+}
+
+void TacRenderGroup::PushRenderGroup( TacRenderGroup* renderGroup )
+{
+  TacRenderCommandRenderGroup* command =
+    PushCommand< TacRenderCommandRenderGroup >();
+  if( !command )
+    return;
+  command->mRenderGroup = renderGroup;
+}
 
 void TacRenderGroup::Execute( TacRenderer* renderer )
 {
-  Popper p;
-  p.runningAddress = mPushBufferMemory;
-  const u8* endAddress =
-    mPushBufferMemory +
-    mPushBufferMemorySize;
+  TAC_PROFILE_SCOPE( "TacRenderGroup::Execute" );
+  TacAssert( !mInDrawItem );
+  mStateCache.Reset();
+  if( mNumInstances )
+  {
+    // the instance buffer is mapped through the bound vertex buffer
+    FixedString< DEFAULT_ERR_LEN > errors = {};
+    renderer->SetVertexBuffers( &mInstanceBuffer, 1 );
+    mStateCache.CacheVertexBuffers( &mInstanceBuffer, 1 );
+    void* instances;
+    renderer->MapVertexBuffer( &instances, TacMap::WriteDiscard, errors );
+    if( errors.size )
+    {
+      // the instanced draws are skipped
+      TacInvalidCodePath;
+      mNumInstances = 0;
+    }
+    else
+    {
+      memcpy( instances, mInstanceMemory, mNumInstances * mInstanceStride );
+      renderer->UnmapVertexBuffer( errors );
+    }
+  }
+  ExecuteCommands(
+    renderer,
+    GetCommandsBegin(),
+    mPushBufferMemory + mPushBufferMemorySize );
+}
 
-  TacRenderEntryType* renderEntryType;
-  while( p.runningAddress < endAddress )
+void TacRenderGroup::ExecuteCommands(
+  TacRenderer* renderer,
+  u8* runningAddress,
+  const u8* endAddress )
+{
+  while( runningAddress < endAddress )
   {
-    p.Pop( renderEntryType );
-    switch( *renderEntryType )
+    TacRenderCommandHeader* header = ( TacRenderCommandHeader* )runningAddress;
+    runningAddress += header->mSize;
+    switch( header->mType )
     {
       case TacRenderEntryType::ClearColor:
       {
-        TacTextureHandle* textureHandle;
-        p.Pop( textureHandle );
-        v4* clearcolor;
-        p.Pop( clearcolor );
+        auto command = ( TacRenderCommandClearColor* )header;
         renderer->ClearColor(
-          *textureHandle,
-          *clearcolor );
+          command->mTextureHandle,
+          command->mRGBA );
       } break;
       case TacRenderEntryType::ClearDepthStencil:
       {
-        TacDepthBufferHandle* depthBufferHandle;
-        p.Pop( depthBufferHandle );
-        b32* clearDepth;
-        p.Pop( clearDepth );
-        r32* depth;
-        p.Pop( depth );
-        b32* clearStencil;
-        p.Pop( clearStencil );
-        u8* stencil;
-        p.Pop( stencil );
+        auto command = ( TacRenderCommandClearDepthStencil* )header;
         renderer->ClearDepthStencil(
-          *depthBufferHandle,
-          *clearDepth,
-          *depth,
-          *clearStencil,
-          *stencil );
+          command->mDepthBufferHandle,
+          command->mClearDepth,
+          command->mDepth,
+          command->mClearStencil,
+          command->mStencil );
       } break;
       case TacRenderEntryType::SetBlendState:
       {
-        TacBlendStateHandle* blendStateHandle;
-        p.Pop( blendStateHandle );
-        v4* blendFactorRGBA;
-        p.Pop( blendFactorRGBA );
-        u32* sampleMask;
-        p.Pop( sampleMask );
-        renderer->SetBlendState(
-          *blendStateHandle,
-          *blendFactorRGBA,
-          *sampleMask );
+        auto command = ( TacRenderCommandSetBlendState* )header;
+        if( mStateCache.CacheBlendState(
+          command->mBlendStateHandle,
+          command->mBlendFactorRGBA,
+          command->mSampleMask ) )
+          renderer->SetBlendState(
+            command->mBlendStateHandle,
+            command->mBlendFactorRGBA,
+            command->mSampleMask );
       } break;
       case TacRenderEntryType::SetDepthState:
       {
-        TacDepthStateHandle* depthStateHandle;
-        p.Pop( depthStateHandle );
-        u32* stencilRef;
-        p.Pop( stencilRef );
-        renderer->SetDepthState(
-          *depthStateHandle,
-          *stencilRef );
+        auto command = ( TacRenderCommandSetDepthState* )header;
+        if( mStateCache.CacheDepthState(
+          command->mDepthStateHandle,
+          command->mStencilRef ) )
+          renderer->SetDepthState(
+            command->mDepthStateHandle,
+            command->mStencilRef );
       } break;
       case TacRenderEntryType::SetRenderTargets:
       {
-        TacTextureHandle* textureHandles;
-        u32* numTextureHandles;
-        TacDepthBufferHandle* depthBufferHandle;
-        p.Pop( numTextureHandles );
-        p.Pop( textureHandles, *numTextureHandles );
-        p.Pop( depthBufferHandle );
+        auto command = ( TacRenderCommandSetRenderTargets* )header;
+        mStateCache.InvalidateShaderResources();
         renderer->SetRenderTargets(
-          textureHandles,
-          *numTextureHandles,
-          *depthBufferHandle );
+          ( TacTextureHandle* )( command + 1 ),
+          command->mNumTextureHandles,
+          command->mDepthBufferHandle );
       } break;
       case TacRenderEntryType::Model:
       {
-        TacModel** pmodel;
-        p.Pop( pmodel );
+        auto command = ( TacRenderCommandModel* )header;
+        renderer->Apply();
+        TacModel* model = command->mModel;
+        for(
+          u32 iSubModel = 0;
+          iSubModel < model->numSubModels;
+          ++iSubModel )
+        {
+          // ModelBuffersRender, but through the state cache
+          TacSubModel& subModel = model->subModels[ iSubModel ];
+          ModelBuffers& buffers =
+            subModel.lods[ Minimum( command->mLod, subModel.numLods - 1 ) ];
+          if( mStateCache.CacheIndexBuffer( buffers.indexBufferHandle ) )
+            renderer->SetIndexBuffer( buffers.indexBufferHandle );
+          if( mStateCache.CacheVertexBuffers(
+            buffers.vertexBufferHandles,
+            buffers.numVertexBuffers ) )
+            renderer->SetVertexBuffers(
+              buffers.vertexBufferHandles,
+              buffers.numVertexBuffers );
+          renderer->Draw();
+        }
+      } break;
+      case TacRenderEntryType::ModelInstanced:
+      {
+        auto command = ( TacRenderCommandModelInstanced* )header;
+        if( !mNumInstances )
+          break;
         renderer->Apply();
-        TacModel* model = *pmodel;
+        TacModel* model = command->mModel;
         for(
           u32 iSubModel = 0;
           iSubModel < model->numSubModels;
           ++iSubModel )
         {
-          ModelBuffersRender(
-            renderer,
-            model->subModels[ iSubModel ].buffers );
+          TacSubModel& subModel = model->subModels[ iSubModel ];
+          ModelBuffers& buffers =
+            subModel.lods[ Minimum( command->mLod, subModel.numLods - 1 ) ];
+          TacVertexBufferHandle vertexBufferHandles[
+            ArraySize( buffers.vertexBufferHandles ) + 1 ];
+          memcpy(
+            vertexBufferHandles,
+            buffers.vertexBufferHandles,
+            sizeof( TacVertexBufferHandle ) * buffers.numVertexBuffers );
+          vertexBufferHandles[ buffers.numVertexBuffers ] = mInstanceBuffer;
+          u32 numVertexBufferHandles = buffers.numVertexBuffers + 1;
+
+          if( mStateCache.CacheIndexBuffer( buffers.indexBufferHandle ) )
+            renderer->SetIndexBuffer( buffers.indexBufferHandle );
+          if( mStateCache.CacheVertexBuffers(
+            vertexBufferHandles,
+            numVertexBufferHandles ) )
+            renderer->SetVertexBuffers(
+              vertexBufferHandles,
+              numVertexBufferHandles );
+          renderer->DrawInstanced(
+            command->mNumInstances,
+            command->mFirstInstance );
         }
       } break;
       case TacRenderEntryType::Uniform:
       {
-        const char** name;
-        u32* size;
-        u8* data;
-        p.Pop( name );
-        p.Pop( size );
-        p.Pop( data, *size );
+        auto command = ( TacRenderCommandUniform* )header;
         renderer->SendUniform(
-          *name,
-          data,
-          *size );
+          command->mUniform,
+          command + 1,
+          command->mSize );
       } break;
       case TacRenderEntryType::SetShader:
       {
-        TacShaderHandle* shaderHandle;
-        p.Pop( shaderHandle );
-        renderer->SetActiveShader( *shaderHandle );
+        auto command = ( TacRenderCommandSetShader* )header;
+        if( mStateCache.CacheShader( command->mShaderHandle ) )
+          renderer->SetActiveShader( command->mShaderHandle );
       } break;
       case TacRenderEntryType::SetPrimitive:
       {
-        TacPrimitive* primitive;
-        p.Pop( primitive );
-        renderer->SetPrimitiveTopology( *primitive );
+        auto command = ( TacRenderCommandSetPrimitive* )header;
+        renderer->SetPrimitiveTopology( command->mPrimitive );
       } break;
       case TacRenderEntryType::SetVertexFormat:
       {
-        TacVertexFormatHandle* vertexFormatHandle;
-        p.Pop( vertexFormatHandle );
-        renderer->SetVertexFormat( *vertexFormatHandle );
+        auto command = ( TacRenderCommandSetVertexFormat* )header;
+        if( mStateCache.CacheVertexFormat( command->mVertexFormatHandle ) )
+          renderer->SetVertexFormat( command->mVertexFormatHandle );
       } break;
       case TacRenderEntryType::SetRasterizerState:
       {
-        TacRasterizerStateHandle* rasterizerStateHandle;
-        p.Pop( rasterizerStateHandle );
-        renderer->SetRasterizerState( *rasterizerStateHandle );
+        auto command = ( TacRenderCommandSetRasterizerState* )header;
+        if( mStateCache.CacheRasterizerState(
+          command->mRasterizerStateHandle ) )
+          renderer->SetRasterizerState( command->mRasterizerStateHandle );
       } break;
       case TacRenderEntryType::SetViewport:
       {
-        r32* xRelBotLeftCorner;
-        p.Pop( xRelBotLeftCorner );
-        r32* yRelBotLeftCorner;
-        p.Pop( yRelBotLeftCorner );
-        r32* wIncreasingRight;
-        p.Pop( wIncreasingRight );
-        r32* hIncreasingUp;
-        p.Pop( hIncreasingUp );
+        auto command = ( TacRenderCommandSetViewport* )header;
         renderer->SetViewport(
-          *xRelBotLeftCorner,
-          *yRelBotLeftCorner,
-          *wIncreasingRight,
-          *hIncreasingUp );
+          command->mXRelBotLeftCorner,
+          command->mYRelBotLeftCorner,
+          command->mWIncreasingRight,
+          command->mHIncreasingUp );
       } break;
       case TacRenderEntryType::Apply:
       {
@@ -318,44 +771,95 @@ void TacRenderGroup::Execute( TacRenderer* renderer )
       } break;
       case TacRenderEntryType::SetVertexBuffers:
       {
-        u32* numVertexBufferHandles;
-        TacVertexBufferHandle* vertexBufferHandles;
-        p.Pop( numVertexBufferHandles );
-        p.Pop(
+        auto command = ( TacRenderCommandSetVertexBuffers* )header;
+        auto vertexBufferHandles = ( TacVertexBufferHandle* )( command + 1 );
+        if( mStateCache.CacheVertexBuffers(
           vertexBufferHandles,
-          *numVertexBufferHandles );
-        renderer->SetVertexBuffers(
-          vertexBufferHandles,
-          *numVertexBufferHandles );
+          command->mNumVertexBufferHandles ) )
+          renderer->SetVertexBuffers(
+            vertexBufferHandles,
+            command->mNumVertexBufferHandles );
       } break;
       case TacRenderEntryType::SetIndexBuffer:
       {
-        TacIndexBufferHandle* indexBufferHandle;
-        p.Pop( indexBufferHandle );
-        renderer->SetIndexBuffer(
-          *indexBufferHandle );
+        auto command = ( TacRenderCommandSetIndexBuffer* )header;
+        if( mStateCache.CacheIndexBuffer( command->mIndexBufferHandle ) )
+          renderer->SetIndexBuffer(
+            command->mIndexBufferHandle );
       } break;
       case TacRenderEntryType::SetSamplerState:
       {
-        const char** name;
-        p.Pop( name );
-        TacSamplerStateHandle* samplerStateHandle;
-        p.Pop( samplerStateHandle );
-        renderer->SetSamplerState(
-          *name,
-          *samplerStateHandle );
+        auto command = ( TacRenderCommandSetSamplerState* )header;
+        if( mStateCache.CacheSamplerState(
+          command->mName,
+          command->mSamplerStateHandle ) )
+          renderer->SetSamplerState(
+            command->mName,
+            command->mSamplerStateHandle );
       } break;
       case TacRenderEntryType::SetTexture:
       {
-        const char** name;
-        p.Pop( name );
-        TacTextureHandle* textureHandle;
-        p.Pop( textureHandle );
-        renderer->SetTexture(
-          *name,
-          *textureHandle );
+        auto command = ( TacRenderCommandSetTexture* )header;
+        if( mStateCache.CacheTexture(
+          command->mName,
+          command->mTextureHandle ) )
+          renderer->SetTexture(
+            command->mName,
+            command->mTextureHandle );
+      } break;
+      case TacRenderEntryType::DrawItem:
+      {
+        // runs from DrawItems
+      } break;
+      case TacRenderEntryType::DrawItems:
+      {
+        ExecuteDrawItems(
+          renderer,
+          ( TacRenderCommandDrawItems* )header );
+      } break;
+      case TacRenderEntryType::RenderGroup:
+      {
+        auto command = ( TacRenderCommandRenderGroup* )header;
+        TacRenderGroup* renderGroup = command->mRenderGroup;
+        TacAssert( !renderGroup->mInDrawItem );
+        // only the executed group uploads its instance buffer
+        TacAssert( !renderGroup->mNumInstances );
+
+        // the child carries on from the state this group has set
+        renderGroup->mStateCache = mStateCache;
+        renderGroup->ExecuteCommands(
+          renderer,
+          renderGroup->GetCommandsBegin(),
+          renderGroup->mPushBufferMemory +
+          renderGroup->mPushBufferMemorySize );
+        mStateCache = renderGroup->mStateCache;
       } break;
       TacInvalidDefaultCase;
     }
   }
 }
+
+b32 InitRenderGroup(
+  TacRenderGroup* renderGroup,
+  TacMemoryArena* arena,
+  u32 pushBufferMemorySize,
+  u32 numDrawItemsMax,
+  TacRenderer* renderer )
+{
+  TacRenderGroup empty = {};
+  *renderGroup = empty;
+  renderGroup->mRenderer = renderer;
+  renderGroup->mPushBufferMemorySizeMax = pushBufferMemorySize;
+  renderGroup->mPushBufferMemory =
+    ( u8* )PushSize( arena, pushBufferMemorySize );
+  renderGroup->mNumDrawItemsMax = numDrawItemsMax;
+  renderGroup->mDrawItems =
+    PushArray( arena, numDrawItemsMax, TacDrawItem );
+  renderGroup->mDrawItemsScratch =
+    PushArray( arena, numDrawItemsMax, TacDrawItem );
+  b32 result =
+    renderGroup->mPushBufferMemory &&
+    renderGroup->mDrawItems &&
+    renderGroup->mDrawItemsScratch;
+  return result;
+}
@@ -1,7 +1,9 @@
 #pragma once
 #include "tacLibrary\tacPlatform.h"
+#include "tacLibrary\tacMemoryManager.h"
 #include "tacRenderer.h"
 struct TacModel;
+struct TacRenderGroup;
 
 enum class TacRenderEntryType
 {
@@ -23,6 +25,281 @@ enum class TacRenderEntryType
   Draw,
   SetSamplerState,
   SetTexture,
+  DrawItem,
+  DrawItems,
+  RenderGroup,
+  ModelInstanced,
+};
+
+// Every command starts with a header, and is padded out to a multiple of
+// sCommandAlignment so the next header ( and any v4s ) stay aligned
+struct TacRenderCommandHeader
+{
+  TacRenderEntryType mType;
+  // size of the whole command, including the header and any trailing data
+  u32 mSize;
+};
+
+#define TAC_RENDER_COMMAND( type )\
+  static const TacRenderEntryType sType = TacRenderEntryType::type;\
+  TacRenderCommandHeader mHeader;
+
+struct TacRenderCommandClearColor
+{
+  TAC_RENDER_COMMAND( ClearColor );
+  v4 mRGBA;
+  TacTextureHandle mTextureHandle;
+};
+
+struct TacRenderCommandClearDepthStencil
+{
+  TAC_RENDER_COMMAND( ClearDepthStencil );
+  TacDepthBufferHandle mDepthBufferHandle;
+  b32 mClearDepth;
+  r32 mDepth;
+  b32 mClearStencil;
+  u8 mStencil;
+};
+
+// followed by mNumTextureHandles TacTextureHandles
+struct TacRenderCommandSetRenderTargets
+{
+  TAC_RENDER_COMMAND( SetRenderTargets );
+  TacDepthBufferHandle mDepthBufferHandle;
+  u32 mNumTextureHandles;
+};
+
+// followed by mSize bytes of data
+struct TacRenderCommandUniform
+{
+  TAC_RENDER_COMMAND( Uniform );
+  TacUniformHandle mUniform;
+  u32 mSize;
+};
+
+struct TacRenderCommandModel
+{
+  TAC_RENDER_COMMAND( Model );
+  TacModel* mModel;
+  u32 mLod;
+};
+
+struct TacRenderCommandSetBlendState
+{
+  TAC_RENDER_COMMAND( SetBlendState );
+  v4 mBlendFactorRGBA;
+  TacBlendStateHandle mBlendStateHandle;
+  u32 mSampleMask;
+};
+
+struct TacRenderCommandSetDepthState
+{
+  TAC_RENDER_COMMAND( SetDepthState );
+  TacDepthStateHandle mDepthStateHandle;
+  u32 mStencilRef;
+};
+
+struct TacRenderCommandSetShader
+{
+  TAC_RENDER_COMMAND( SetShader );
+  TacShaderHandle mShaderHandle;
+};
+
+struct TacRenderCommandSetPrimitive
+{
+  TAC_RENDER_COMMAND( SetPrimitive );
+  TacPrimitive mPrimitive;
+};
+
+struct TacRenderCommandSetVertexFormat
+{
+  TAC_RENDER_COMMAND( SetVertexFormat );
+  TacVertexFormatHandle mVertexFormatHandle;
+};
+
+struct TacRenderCommandSetRasterizerState
+{
+  TAC_RENDER_COMMAND( SetRasterizerState );
+  TacRasterizerStateHandle mRasterizerStateHandle;
+};
+
+struct TacRenderCommandSetViewport
+{
+  TAC_RENDER_COMMAND( SetViewport );
+  r32 mXRelBotLeftCorner;
+  r32 mYRelBotLeftCorner;
+  r32 mWIncreasingRight;
+  r32 mHIncreasingUp;
+};
+
+// followed by mNumVertexBufferHandles TacVertexBufferHandles
+struct TacRenderCommandSetVertexBuffers
+{
+  TAC_RENDER_COMMAND( SetVertexBuffers );
+  u32 mNumVertexBufferHandles;
+};
+
+struct TacRenderCommandSetIndexBuffer
+{
+  TAC_RENDER_COMMAND( SetIndexBuffer );
+  TacIndexBufferHandle mIndexBufferHandle;
+};
+
+// Instances [ mFirstInstance, mFirstInstance + mNumInstances ) of the
+// render group's instance buffer
+struct TacRenderCommandModelInstanced
+{
+  TAC_RENDER_COMMAND( ModelInstanced );
+  TacModel* mModel;
+  u32 mFirstInstance;
+  u32 mNumInstances;
+  u32 mLod;
+};
+
+struct TacRenderCommandApply
+{
+  TAC_RENDER_COMMAND( Apply );
+};
+
+struct TacRenderCommandDraw
+{
+  TAC_RENDER_COMMAND( Draw );
+};
+
+struct TacRenderCommandSetSamplerState
+{
+  TAC_RENDER_COMMAND( SetSamplerState );
+  const char* mName;
+  TacSamplerStateHandle mSamplerStateHandle;
+};
+
+struct TacRenderCommandSetTexture
+{
+  TAC_RENDER_COMMAND( SetTexture );
+  const char* mName;
+  TacTextureHandle mTextureHandle;
+};
+
+// The commands between BeginDrawItem and EndDrawItem.
+// mHeader.mSize covers all of them, so executing in push order skips the
+// draw item, and it only runs from the DrawItems command, in key order
+struct TacRenderCommandDrawItem
+{
+  TAC_RENDER_COMMAND( DrawItem );
+  TacShaderHandle mShaderHandle;
+  TacVertexFormatHandle mVertexFormatHandle;
+  // optional, mTextureHandle can be RENDERER_ID_NONE
+  const char* mTextureName;
+  TacTextureHandle mTextureHandle;
+};
+
+// Runs mNumDrawItems draw items starting at mFirstDrawItem, which are
+// sorted by the time this is pushed
+struct TacRenderCommandDrawItems
+{
+  TAC_RENDER_COMMAND( DrawItems );
+  u32 mFirstDrawItem;
+  u32 mNumDrawItems;
+};
+
+// Runs all of mRenderGroup's commands in place
+struct TacRenderCommandRenderGroup
+{
+  TAC_RENDER_COMMAND( RenderGroup );
+  TacRenderGroup* mRenderGroup;
+};
+
+struct TacDrawItem
+{
+  u64 mSortKey;
+  // offset of the TacRenderCommandDrawItem in the push buffer
+  u32 mCommandOffset;
+};
+
+// Bits, from most significant
+// 4  pass
+// 8  shader
+// 8  vertex format
+// 12 texture
+// 32 view space depth
+// so draws are grouped by state first, and front to back within a group
+u64 TacDrawItemSortKey(
+  u32 pass,
+  TacShaderHandle shaderHandle,
+  TacVertexFormatHandle vertexFormatHandle,
+  TacTextureHandle textureHandle,
+  r32 viewSpaceDepth );
+
+struct TacRenderStateStats
+{
+  // state changes sent to the renderer
+  u32 mNumIssued;
+  // state changes dropped because the same state was already set
+  u32 mNumSkipped;
+};
+
+// What Execute has sent to the renderer so far, so setting the same state
+// again can be skipped.
+// Each Cache function returns true if the state differs and should be
+// sent. Names are compared by pointer, so the same name from different
+// strings is sent anyway
+struct TacRenderStateCache
+{
+  static const u32 sMaxBindings = 16;
+  // a handle index that never matches, so the next set is issued
+  static const s32 sUnknown = -1;
+
+  TacShaderHandle mShaderHandle;
+  TacVertexFormatHandle mVertexFormatHandle;
+
+  TacBlendStateHandle mBlendStateHandle;
+  v4 mBlendFactorRGBA;
+  u32 mSampleMask;
+
+  TacDepthStateHandle mDepthStateHandle;
+  u32 mStencilRef;
+
+  TacRasterizerStateHandle mRasterizerStateHandle;
+
+  TacIndexBufferHandle mIndexBufferHandle;
+  TacVertexBufferHandle mVertexBufferHandles[ sMaxBindings ];
+  u32 mNumVertexBufferHandles;
+  b32 mVertexBuffersKnown;
+
+  const char* mSamplerNames[ sMaxBindings ];
+  TacSamplerStateHandle mSamplerStateHandles[ sMaxBindings ];
+  u32 mNumSamplers;
+
+  const char* mTextureNames[ sMaxBindings ];
+  TacTextureHandle mTextureHandles[ sMaxBindings ];
+  u32 mNumTextures;
+
+  TacRenderStateStats mStats;
+
+  void Reset();
+  // sampler and texture names are looked up per shader, and render
+  // targets can unbind textures
+  void InvalidateShaderResources();
+
+  b32 CacheShader( TacShaderHandle shaderHandle );
+  b32 CacheVertexFormat( TacVertexFormatHandle vertexFormatHandle );
+  b32 CacheBlendState(
+    TacBlendStateHandle blendStateHandle,
+    v4 blendFactorRGBA,
+    u32 sampleMask );
+  b32 CacheDepthState( TacDepthStateHandle depthStateHandle, u32 stencilRef );
+  b32 CacheRasterizerState( TacRasterizerStateHandle rasterizerStateHandle );
+  b32 CacheIndexBuffer( TacIndexBufferHandle indexBufferHandle );
+  b32 CacheVertexBuffers(
+    const TacVertexBufferHandle* vertexBufferHandles,
+    u32 numVertexBufferHandles );
+  b32 CacheSamplerState(
+    const char* name,
+    TacSamplerStateHandle samplerStateHandle );
+  b32 CacheTexture( const char* name, TacTextureHandle textureHandle );
+
+  // counts the result of a Cache function
+  b32 Count( b32 changed );
 };
 
 struct TacRenderGroup
@@ -31,15 +308,44 @@ struct TacRenderGroup
   u32 mPushBufferMemorySize;
   u32 mPushBufferMemorySizeMax;
 
+  // used to resolve uniform names when they are pushed
+  TacRenderer* mRenderer;
+
+  // Optional per frame instance data, all of it is copied into
+  // mInstanceBuffer ( a dynamic vertex buffer of mNumInstancesMax
+  // instances of mInstanceStride bytes ) once at the start of Execute
+  TacVertexBufferHandle mInstanceBuffer;
+  u8* mInstanceMemory;
+  u32 mInstanceStride;
+  u32 mNumInstances;
+  u32 mNumInstancesMax;
+
+  // mDrawItemsScratch is the same size as mDrawItems, for sorting
+  TacDrawItem* mDrawItems;
+  TacDrawItem* mDrawItemsScratch;
+  u32 mNumDrawItems;
+  u32 mNumDrawItemsMax;
+  // draw items before this one have already been pushed by PushDrawItems
+  u32 mFirstUnsortedDrawItem;
+  // offset of the draw item between BeginDrawItem and EndDrawItem
+  u32 mCurrentDrawItemOffset;
+  b32 mInDrawItem;
+
+  // reset by Execute, read mStateCache.mStats afterwards for the counts
+  TacRenderStateCache mStateCache;
+
+  static const u32 sCommandAlignment = 16;
+
   // push commands
-  void PushModel( TacModel* model );
+  // submodels with fewer lods draw their last one
+  void PushModel( TacModel* model, u32 lod = 0 );
   void PushClearColor( TacTextureHandle textureHandle, v4 rgba );
   void PushClearDepthStencil(
     TacDepthBufferHandle depthBufferHandle, 
     b32 clearDepth = true,
     r32 depth = 1.0f,
     b32 clearStencil = false,
-    u8 stencil = 0.0f );
+    u8 stencil = 0 );
   void PushRenderTargets(
     TacTextureHandle* textureHandles,
     u32 numTextureHandles,
@@ -49,7 +355,21 @@ struct TacRenderGroup
     v4 blendFactorRGBA = V4( 1.0f, 1.0f, 1.0f, 1.0f ),
     u32 sampleMask = 0xffffffff );
   void PushDepthState( TacDepthStateHandle depthStateHandle, u32 stencilRef = 0 );
+  // Returns space for numInstances instances, or null if there's no room.
+  // The index of the first one goes in firstInstance
+  void* PushInstances( u32 numInstances, u32* firstInstance );
+  // Draws every submodel numInstances times with one draw call each.
+  // The instance buffer goes in the vertex buffer slot after the model's
+  // vertex buffers, so the vertex format's instance attributes go there
+  void PushModelInstanced(
+    TacModel* model,
+    u32 firstInstance,
+    u32 numInstances,
+    u32 lod = 0 );
+  // prefer the TacUniformHandle version in loops, this one searches for
+  // the name every call
   void PushUniform( const char* name, void* data, u32 size );
+  void PushUniform( TacUniformHandle uniform, void* data, u32 size );
   void PushShader( TacShaderHandle shaderHandle );
   void PushPrimitive( TacPrimitive primitive );
   void PushVertexFormat( TacVertexFormatHandle vertexFormatHandle );
@@ -74,28 +394,88 @@ struct TacRenderGroup
     const char* name,
     TacTextureHandle textureHandle );
 
+  // Draw item mode.
+  // Instead of running in push order, the commands pushed between
+  // BeginDrawItem and EndDrawItem ( uniforms and a model ) are sorted by
+  // sortKey and run when PushDrawItems is reached. The shader, vertex
+  // format and texture are set through the state cache, so they are only
+  // sent when they differ from the previous draw item, and stay set for
+  // whatever is pushed after
+  void BeginDrawItem(
+    u64 sortKey,
+    TacShaderHandle shaderHandle,
+    TacVertexFormatHandle vertexFormatHandle,
+    const char* textureName = nullptr,
+    TacTextureHandle textureHandle = { RENDERER_ID_NONE } );
+  void EndDrawItem();
+  void PushDrawItems();
+
+  // Runs renderGroup's commands at this point in the execute.
+  // Groups can be filled on different threads ( one per group ), then
+  // pushed here in a fixed order so the frame is the same however the
+  // work was split up. renderGroup must be filled before Execute
+  void PushRenderGroup( TacRenderGroup* renderGroup );
+
   // execute all stored commands
   void Execute( TacRenderer* renderer );
+  void ExecuteCommands(
+    TacRenderer* renderer,
+    u8* runningAddress,
+    const u8* endAddress );
+  void ExecuteDrawItems(
+    TacRenderer* renderer,
+    TacRenderCommandDrawItems* command );
 
   // helper functions
-  void PushData( const void* source, u32 size )
+
+  // the first command, after any padding for alignment
+  u8* GetCommandsBegin()
   {
-    u8* result = nullptr;
-    if( mPushBufferMemorySize + size <= mPushBufferMemorySizeMax )
-    {
-      result = mPushBufferMemory + mPushBufferMemorySize;
-      mPushBufferMemorySize += size;
-      memcpy( result, source, size );
-    }
-    else
+    uintptr_t address = ( uintptr_t )mPushBufferMemory;
+    return mPushBufferMemory +
+      ( sCommandAlignment - address % sCommandAlignment ) %
+      sCommandAlignment;
+  }
+
+  // returns aligned, uninitialized memory, or null if the group is full
+  u8* PushSize( u32 size )
+  {
+    uintptr_t address = ( uintptr_t )( mPushBufferMemory + mPushBufferMemorySize );
+    u32 padding = ( u32 )(
+      ( sCommandAlignment - address % sCommandAlignment ) %
+      sCommandAlignment );
+    if( mPushBufferMemorySize + padding + size > mPushBufferMemorySizeMax )
     {
       TacInvalidCodePath;
+      return nullptr;
     }
+    u8* result = mPushBufferMemory + mPushBufferMemorySize + padding;
+    mPushBufferMemorySize += padding + size;
+    return result;
   }
-  template< typename T>
-  void PushData( const T& t )
+
+  // extraSize is for data that trails the command struct
+  template< typename T >
+  T* PushCommand( u32 extraSize = 0 )
   {
-    PushData( &t, sizeof( T ) );
+    u32 size = RoundUpToNearestMultiple(
+      sizeof( T ) + extraSize,
+      sCommandAlignment );
+    T* command = ( T* )PushSize( size );
+    if( command )
+    {
+      command->mHeader.mType = T::sType;
+      command->mHeader.mSize = size;
+    }
+    return command;
   }
 };
 
+// Allocates the push buffer and draw items from arena.
+// Returns false if the arena doesn't have room
+b32 InitRenderGroup(
+  TacRenderGroup* renderGroup,
+  TacMemoryArena* arena,
+  u32 pushBufferMemorySize,
+  u32 numDrawItemsMax,
+  TacRenderer* renderer );
@@ -20,6 +20,7 @@ DEFINE_HANDLE( TacShaderHandle )
   DEFINE_HANDLE( TacRasterizerStateHandle )
   DEFINE_HANDLE( TacDepthStateHandle )
   DEFINE_HANDLE( TacVertexFormatHandle )
+  DEFINE_HANDLE( TacUniformHandle )
 
   enum class TacAttributeType
 {
@@ -29,6 +30,12 @@ DEFINE_HANDLE( TacShaderHandle )
   Color,
   BoneIndex,
   BoneWeight,
+
+  // Per instance instead of per vertex.
+  // A matrix takes one vertex format per row, formats with the same
+  // attribute type get increasing semantic indexes
+  InstanceWorld,
+  InstanceColor,
 };
 
 enum class TacVariableType
@@ -213,6 +220,16 @@ public:
   //u32 variableNumComponents;
 };
 
+// Memory from TacRenderer::AllocateUpload()
+struct TacUploadAllocation
+{
+  // write only, null if the allocation failed
+  void* mData;
+
+  // from the start of the upload ring, in bytes
+  u32 mOffset;
+};
+
 struct TacRenderer
 {
   virtual ~TacRenderer(){}
@@ -271,6 +288,26 @@ struct TacRenderer
     TacIndexBufferHandle handle,
     const char* name ) = 0;
 
+  // upload ring ----------------------------------------------------------
+
+  // Per frame memory for data the gpu reads once, ie: dynamic vertexes.
+  // Allocations come out of one big ring buffer, so they don't each pay
+  // for a map / unmap or a buffer rename. They're only good until
+  // SwapBuffers(), and fail when the frame has used up the whole ring.
+  virtual TacUploadAllocation AllocateUpload( u32 size, u32 alignment ) = 0;
+
+  // Binds upload memory as the vertex buffer of inputSlot, the other slots
+  // are left alone. offset is a TacUploadAllocation::mOffset
+  virtual void SetVertexBufferUpload(
+    u32 inputSlot,
+    u32 offset,
+    u32 stride ) = 0;
+
+  // The index count isn't known, so draw with DrawIndexed()
+  virtual void SetIndexBufferUpload(
+    u32 offset,
+    TacTextureFormat indexFormat ) = 0;
+
   // clear ----------------------------------------------------------------
 
   virtual void ClearColor(
@@ -401,6 +438,11 @@ struct TacRenderer
     TacCBufferHandle handle,
     const char* name ) = 0;
 
+  // Finds the cbuffer constant called name once, so sending it doesn't
+  // need to search by name.
+  // Returns RENDERER_ID_NONE if no cbuffer has a constant called name
+  virtual TacUniformHandle GetUniformHandle( const char* name ) = 0;
+
   // blend state ----------------------------------------------------------
 
   virtual TacBlendStateHandle AddBlendState(
@@ -487,7 +529,22 @@ struct TacRenderer
     u32 elementCount,
     u32 idxOffset,
     u32 vtxOffset ) = 0;
+
+  // Like Draw(), but draws the whole index buffer numInstances times,
+  // reading per instance attributes from instance firstInstance onwards
+  virtual void DrawInstanced( u32 numInstances, u32 firstInstance ) = 0;
+
+  virtual void DrawIndexedInstanced(
+    u32 elementCount,
+    u32 numInstances,
+    u32 idxOffset,
+    u32 vtxOffset,
+    u32 firstInstance ) = 0;
   virtual void SendUniform( const char* name, void* data, u32 size ) = 0;
+  virtual void SendUniform(
+    TacUniformHandle uniform,
+    void* data,
+    u32 size ) = 0;
 
   virtual void Apply() = 0;
 
@@ -127,6 +127,58 @@ internalFunction void TacCompileShaderFromString(
   }
 }
 
+// fnv-1a, never 0 so 0 can mark an empty slot
+internalFunction u32 HashUniformName( const char* name )
+{
+  u32 hash = 2166136261;
+  for( const char* c = name; *c; ++c )
+  {
+    hash ^= ( u8 )*c;
+    hash *= 16777619;
+  }
+  if( !hash )
+    hash = 1;
+  return hash;
+}
+
+// Returns the uniform called name, or the empty slot it would go in
+internalFunction TacShaderUniformDX11* FindShaderUniformSlot(
+  TacShaderDX11& shader,
+  u32 nameHash,
+  const char* name )
+{
+  u32 mask = TacShaderDX11::UNIFORM_TABLE_SIZE - 1;
+  for( u32 i = 0; i < TacShaderDX11::UNIFORM_TABLE_SIZE; ++i )
+  {
+    TacShaderUniformDX11* uniform =
+      &shader.mUniformTable[ ( nameHash + i ) & mask ];
+    if( !uniform->mNameHash )
+      return uniform;
+    if( uniform->mNameHash == nameHash && uniform->mName == name )
+      return uniform;
+  }
+  return nullptr;
+}
+
+internalFunction TacShaderUniformDX11* FindShaderUniform(
+  TacShaderDX11& shader,
+  const char* name )
+{
+  TacShaderUniformDX11* uniform =
+    FindShaderUniformSlot( shader, HashUniformName( name ), name );
+  if( uniform && !uniform->mNameHash )
+    uniform = nullptr;
+  return uniform;
+}
+
+internalFunction void ClearShaderUniforms( TacShaderDX11& shader )
+{
+  TacShaderUniformDX11 empty = {};
+  for( u32 i = 0; i < TacShaderDX11::UNIFORM_TABLE_SIZE; ++i )
+    shader.mUniformTable[ i ] = empty;
+  shader.mNumUniforms = 0;
+}
+
 internalFunction D3D11_USAGE GetUsage( TacBufferAccess access )
 {
   switch ( access )
@@ -311,8 +363,24 @@ RendererDX11::RendererDX11(
   mCurrentShader.mIndex = RENDERER_ID_NONE;
   mCurrentVertexBuffer.mIndex = RENDERER_ID_NONE;
   mCurrentIndexBuffer.mIndex = RENDERER_ID_NONE;
+  mIndexBufferUploadBound = false;
   backBufferColorIndex.mIndex = RENDERER_ID_NONE;
   backBufferDepthIndex.mIndex = RENDERER_ID_NONE;
+  mUploadRing = {};
+  mConstantRing = {};
+  mDeviceContext1 = nullptr;
+  mNumFrames = 1;
+  for(
+    u32 iShaderType = 0;
+    iShaderType < ( u32 )TacShaderType::Count;
+  ++iShaderType )
+  {
+    for( u32 iRegister = 0; iRegister < CBUFFER_REGISTERS; ++iRegister )
+    {
+      TacBoundConstantsDX11 none = {};
+      mBoundConstants[ iShaderType ][ iRegister ] = none;
+    }
+  }
 
   // Initialize null indexes
   {
@@ -327,6 +395,7 @@ RendererDX11::RendererDX11(
     AddEmpty( mRasterizerStates );
     AddEmpty( mDepthStates );
     AddEmpty( mDepthBuffers );
+    AddEmpty( mUniforms );
   }
 
   RECT myrect;
@@ -696,12 +765,50 @@ RendererDX11::RendererDX11(
         RENDERER_ID_NONE;
     }
   }
+
+  // upload rings ---------------------------------------------------------
+  InitRing(
+    mUploadRing,
+    UPLOAD_RING_SIZE,
+    D3D11_BIND_VERTEX_BUFFER | D3D11_BIND_INDEX_BUFFER,
+    errors );
+  if( errors.size )
+    return;
+
+  D3D11_FEATURE_DATA_D3D11_OPTIONS options = {};
+  hr = mDevice->CheckFeatureSupport(
+    D3D11_FEATURE_D3D11_OPTIONS,
+    &options,
+    sizeof( options ) );
+  if( SUCCEEDED( hr ) &&
+    options.ConstantBufferOffsetting &&
+    options.MapNoOverwriteOnDynamicConstantBuffer )
+  {
+    hr = mDeviceContext->QueryInterface(
+      __uuidof( ID3D11DeviceContext1 ),
+      ( void** )&mDeviceContext1 );
+    if( SUCCEEDED( hr ) )
+    {
+      InitRing(
+        mConstantRing,
+        CONSTANT_RING_SIZE,
+        D3D11_BIND_CONSTANT_BUFFER,
+        errors );
+      if( errors.size )
+        return;
+    }
+  }
 }
 
 RendererDX11::~RendererDX11()
 {
   RemoveDepthBuffer( backBufferDepthIndex );
   RemoveTextureResoure( backBufferColorIndex );
+  UnmapRings();
+  ReleaseRing( mUploadRing );
+  ReleaseRing( mConstantRing );
+  if( mDeviceContext1 )
+    mDeviceContext1->Release();
 
   if( mSwapChain )
     mSwapChain->Release();
@@ -999,6 +1106,7 @@ void RendererDX11::SetIndexBuffer(
   }
 
   mCurrentIndexBuffer = indexBuffer;
+  mIndexBufferUploadBound = false;
 
   if( mCurrentIndexBuffer.mIndex != RENDERER_ID_NONE )
   {
@@ -1061,6 +1169,45 @@ void RendererDX11::SetName(
     TacStrLen( name ),
     name );
 }
+// upload ring ----------------------------------------------------------
+
+TacUploadAllocation RendererDX11::AllocateUpload( u32 size, u32 alignment )
+{
+  TacUploadAllocation result = {};
+  result.mData = AllocateFromRing(
+    mUploadRing,
+    size,
+    alignment,
+    &result.mOffset );
+  return result;
+}
+
+void RendererDX11::SetVertexBufferUpload(
+  u32 inputSlot,
+  u32 offset,
+  u32 stride )
+{
+  mDeviceContext->IASetVertexBuffers(
+    inputSlot,
+    1,
+    &mUploadRing.mHandle,
+    &stride,
+    &offset );
+}
+
+void RendererDX11::SetIndexBufferUpload(
+  u32 offset,
+  TacTextureFormat indexFormat )
+{
+  // so the next SetIndexBuffer() isn't skipped
+  mCurrentIndexBuffer.mIndex = RENDERER_ID_NONE;
+  mIndexBufferUploadBound = true;
+  mDeviceContext->IASetIndexBuffer(
+    mUploadRing.mHandle,
+    GetDXGIFormat( indexFormat ),
+    offset );
+}
+
 // clear ----------------------------------------------------------------
 
 void RendererDX11::ClearColor(
@@ -1218,6 +1365,14 @@ void RendererDX11::SetActiveShader( TacShaderHandle shaderID )
           PerShaderData::CBufferBinding& bufferBinding =
             shaderData->mCBufferBindings[ i ];
 
+          // Apply() binds them from the constant ring
+          if( mConstantRing.mHandle )
+          {
+            TacBoundConstantsDX11 none = {};
+            mBoundConstants[ iShaderType ][ bufferBinding.mRegister ] = none;
+            continue;
+          }
+
           TacCBufferDX11& bufferdx11 =
             mCbuffers[ bufferBinding.mCBufferHandle.mIndex ];
 
@@ -1263,6 +1418,8 @@ void RendererDX11::ReloadShader( TacShaderHandle shader )
     }
   } while( errors.size );
 
+  UpdateUniformHandles( shaderDX11 );
+
 }
 
 TacShaderHandle RendererDX11::LoadShaderFromString(
@@ -1341,6 +1498,8 @@ void RendererDX11::ReloadShader(
   TacShaderDX11& shader,
   FixedString< DEFAULT_ERR_LEN >& errors )
 {
+  ClearShaderUniforms( shader );
+
   PerShaderData& vertexData =
     shader.mPerShaderData[ ( u32 )TacShaderType::Vertex ];
 
@@ -1372,6 +1531,10 @@ void RendererDX11::ReloadShader(
       pVSBlob->GetBufferSize(),
       &shader.mInputSig );
     TacAssert( SUCCEEDED( hr ) );
+
+    ReflectShader( shader, TacShaderType::Vertex, pVSBlob, errors );
+    if( errors.size )
+      return;
   }
 
   PerShaderData& fragmentData =
@@ -1399,7 +1562,13 @@ void RendererDX11::ReloadShader(
       errors = "CreatePixelShader failed";
       return;
     }
+
+    ReflectShader( shader, TacShaderType::Fragment, pPSBlob, errors );
+    if( errors.size )
+      return;
   }
+
+  ResolveShaderUniforms( shader, errors );
 }
 
 void RendererDX11::ReloadShaderFromString(
@@ -1407,6 +1576,8 @@ void RendererDX11::ReloadShaderFromString(
   const char* shaderStrings[ ( u32 )TacShaderType::Count ],
   FixedString< DEFAULT_ERR_LEN >& errors )
 {
+  ClearShaderUniforms( shader );
+
   if( shaderStrings[ ( u32 )TacShaderType::Vertex ] &&
     *shaderStrings[ ( u32 )TacShaderType::Vertex ] )
   {
@@ -1441,6 +1612,10 @@ void RendererDX11::ReloadShaderFromString(
       pVSBlob->GetBufferSize(),
       &shader.mInputSig );
     TacAssert( SUCCEEDED( hr ) );
+
+    ReflectShader( shader, TacShaderType::Vertex, pVSBlob, errors );
+    if( errors.size )
+      return;
   }
 
   if( shaderStrings[ ( u32 )TacShaderType::Fragment ] &&
@@ -1469,6 +1644,164 @@ void RendererDX11::ReloadShaderFromString(
       errors = "CreatePixelShader failed";
       return;
     }
+
+    ReflectShader( shader, TacShaderType::Fragment, pPSBlob, errors );
+    if( errors.size )
+      return;
+  }
+
+  ResolveShaderUniforms( shader, errors );
+}
+
+void RendererDX11::ReflectShader(
+  TacShaderDX11& shader,
+  TacShaderType shaderType,
+  ID3DBlob* blob,
+  FixedString< DEFAULT_ERR_LEN >& errors )
+{
+  CComPtr< ID3D11ShaderReflection > reflection;
+  HRESULT hr = D3DReflect(
+    blob->GetBufferPointer(),
+    blob->GetBufferSize(),
+    __uuidof( ID3D11ShaderReflection ),
+    ( void** )&reflection );
+  if( FAILED( hr ) )
+  {
+    errors = "D3DReflect failed";
+    AppendFileInfo( errors );
+    return;
+  }
+
+  D3D11_SHADER_DESC shaderDesc;
+  reflection->GetDesc( &shaderDesc );
+  for( u32 iCbuffer = 0; iCbuffer < shaderDesc.ConstantBuffers; ++iCbuffer )
+  {
+    ID3D11ShaderReflectionConstantBuffer* cbuffer =
+      reflection->GetConstantBufferByIndex( iCbuffer );
+    D3D11_SHADER_BUFFER_DESC bufferDesc;
+    cbuffer->GetDesc( &bufferDesc );
+    if( bufferDesc.Type != D3D_CT_CBUFFER )
+      continue;
+
+    D3D11_SHADER_INPUT_BIND_DESC bindDesc;
+    hr = reflection->GetResourceBindingDescByName(
+      bufferDesc.Name,
+      &bindDesc );
+    if( FAILED( hr ) )
+      continue;
+
+    for( u32 iVariable = 0; iVariable < bufferDesc.Variables; ++iVariable )
+    {
+      D3D11_SHADER_VARIABLE_DESC variableDesc;
+      cbuffer->GetVariableByIndex( iVariable )->GetDesc( &variableDesc );
+
+      if( TacStrLen( variableDesc.Name ) >=
+        ArraySize( shader.mUniformTable[ 0 ].mName.buffer ) )
+      {
+        errors.size = sprintf_s(
+          errors.buffer,
+          "Uniform name %s is too long",
+          variableDesc.Name );
+        AppendFileInfo( errors );
+        return;
+      }
+
+      u32 nameHash = HashUniformName( variableDesc.Name );
+      TacShaderUniformDX11* uniform =
+        FindShaderUniformSlot( shader, nameHash, variableDesc.Name );
+      // keep it under half full so probes stay short
+      if( !uniform || ( !uniform->mNameHash &&
+        shader.mNumUniforms == TacShaderDX11::UNIFORM_TABLE_SIZE / 2 ) )
+      {
+        errors = "Too many uniforms";
+        AppendFileInfo( errors );
+        return;
+      }
+
+      if( uniform->mNameHash )
+      {
+        // both stages share the cpu memory of one cbuffer
+        if( uniform->mOffset != variableDesc.StartOffset ||
+          uniform->mSize != variableDesc.Size )
+        {
+          errors.size = sprintf_s(
+            errors.buffer,
+            "Uniform %s has a different layout in each shader stage",
+            variableDesc.Name );
+          AppendFileInfo( errors );
+          return;
+        }
+      }
+      else
+      {
+        uniform->mNameHash = nameHash;
+        uniform->mName = variableDesc.Name;
+        for( u32 i = 0; i < ( u32 )TacShaderType::Count; ++i )
+          uniform->mRegisters[ i ] = SHADER_UNIFORM_UNUSED;
+        uniform->mOffset = variableDesc.StartOffset;
+        uniform->mSize = variableDesc.Size;
+        uniform->mCBufferHandle.mIndex = RENDERER_ID_NONE;
+        ++shader.mNumUniforms;
+      }
+      uniform->mRegisters[ ( u32 )shaderType ] = bindDesc.BindPoint;
+    }
+  }
+}
+
+void RendererDX11::ResolveShaderUniforms(
+  TacShaderDX11& shader,
+  FixedString< DEFAULT_ERR_LEN >& errors )
+{
+  for( u32 iUniform = 0;
+    iUniform < TacShaderDX11::UNIFORM_TABLE_SIZE;
+    ++iUniform )
+  {
+    TacShaderUniformDX11& uniform = shader.mUniformTable[ iUniform ];
+    if( !uniform.mNameHash )
+      continue;
+    uniform.mCBufferHandle.mIndex = RENDERER_ID_NONE;
+    for(
+      u32 iShaderType = 0;
+      iShaderType < ( u32 )TacShaderType::Count;
+    ++iShaderType )
+    {
+      PerShaderData& shaderData = shader.mPerShaderData[ iShaderType ];
+      for( u32 i = 0; i < shaderData.mNumCBufferBindings; ++i )
+      {
+        PerShaderData::CBufferBinding& binding =
+          shaderData.mCBufferBindings[ i ];
+        if( binding.mRegister != uniform.mRegisters[ iShaderType ] )
+          continue;
+        TacCBufferDX11& cbuffer = mCbuffers[ binding.mCBufferHandle.mIndex ];
+        if( uniform.mOffset + uniform.mSize > cbuffer.mSize )
+        {
+          errors.size = sprintf_s(
+            errors.buffer,
+            "Uniform %s is past the end of cbuffer %s",
+            uniform.mName.buffer,
+            cbuffer.mName.buffer );
+          AppendFileInfo( errors );
+          return;
+        }
+        uniform.mCBufferHandle = binding.mCBufferHandle;
+      }
+    }
+  }
+}
+
+void RendererDX11::UpdateUniformHandles( TacShaderDX11& shader )
+{
+  for( TacUniformDX11& uniform : mUniforms )
+  {
+    if( uniform.mCBufferHandle.mIndex == RENDERER_ID_NONE )
+      continue;
+    TacShaderUniformDX11* shaderUniform =
+      FindShaderUniform( shader, uniform.mName.buffer );
+    if( !shaderUniform ||
+      shaderUniform->mCBufferHandle.mIndex != uniform.mCBufferHandle.mIndex )
+      continue;
+    uniform.mOffset = shaderUniform->mOffset;
+    uniform.mSize = shaderUniform->mSize;
   }
 }
 
@@ -2194,6 +2527,15 @@ void RendererDX11::RemoveCbuffer( TacCBufferHandle cbuffer )
   cBufferDX11.mHandle->Release();
   mCbufferIndexes.push_back( cbuffer.mIndex );
 
+  // the uniforms in this cbuffer can't be sent anymore
+  for( TacUniformDX11& uniform : mUniforms )
+  {
+    if( uniform.mCBufferHandle.mIndex == cbuffer.mIndex )
+    {
+      uniform.mCBufferHandle.mIndex = RENDERER_ID_NONE;
+    }
+  }
+
   TacCBufferDX11 empty = {};
   cBufferDX11 = empty;
 }
@@ -2209,7 +2551,6 @@ void RendererDX11::AddCbuffer(
   TacAssert( cbufferID.mIndex != RENDERER_ID_NONE );
 
   TacShaderDX11& shader = mShaders[ shaderID.mIndex ];
-  TacCBufferDX11& cbuffer = mCbuffers[ cbufferID.mIndex ];
 
   PerShaderData& myPerShaderData = shader.mPerShaderData[ ( u32 )myShaderType ];
   if( myPerShaderData.mNumCBufferBindings >
@@ -2228,84 +2569,10 @@ void RendererDX11::AddCbuffer(
   bufferBinding.mCBufferHandle = cbufferID;
   bufferBinding.mRegister = cbufferRegister;
 
-
-
-
-  for( u32 iConstant = 0; iConstant < cbuffer.mNumConstants; ++iConstant )
-  {
-    TacConstant& myConstant = cbuffer.mConstants[ iConstant ];
-
-
-    bool exists = false;
-    // search for the constant in the shader constnats
-    for(
-      u32 iConstantFinder = 0;
-      iConstantFinder < shader.mNumConstantFinders;
-    ++iConstantFinder )
-    {
-      ConstantFinder& curConstantFinder =
-        shader.mConstantFinders[ iConstantFinder ];
-
-      exists = 
-        ( curConstantFinder.mName == myConstant.name ) &&
-        ( curConstantFinder.mCBufferHandle.mIndex == cbufferID.mIndex ) &&
-        ( curConstantFinder.mConstantIndex == iConstant );
-      if( exists )
-      {
-        break;
-      }
-    }
-
-    if( !exists )
-    {
-
-      if( shader.mNumConstantFinders ==
-        ArraySize( shader.mConstantFinders ) )
-      {
-        errors = "Too many constants";
-        AppendFileInfo( errors );
-        return;
-      }
-
-      ConstantFinder& myConstantFinder =
-        shader.mConstantFinders[ shader.mNumConstantFinders++ ];
-
-      myConstantFinder.mConstantIndex = iConstant;
-      myConstantFinder.mCBufferHandle = cbufferID;
-      myConstantFinder.mName = myConstant.name;
-    }
-
-
-
-
-    //ConstantFinder& myConstantFinder =
-    //  shader.mConstantFinders[ shader.mNumConstantFinders++ ];
-
-    //myConstantFinder.mConstantIndex = i;
-    //myConstantFinder.mCBufferHandle = cbufferID;
-    //myConstantFinder.mName = myConstant.name;
-  }
-
-
-
-
-
-  //if( shader.mNumConstantFinders + cbuffer.mNumConstants >
-  //  ArraySize( shader.mConstantFinders ) )
-  //{
-  //  errors = "Too many constants";
-  //  AppendFileInfo( errors );
-  //  return;
-  //}
-  //for( u32 i = 0; i < cbuffer.mNumConstants; ++i )
-  //{
-  //  TacConstant& myConstant = cbuffer.mConstants[ i ];
-  //  ConstantFinder& myConstantFinder =
-  //    shader.mConstantFinders[ shader.mNumConstantFinders++ ];
-  //  myConstantFinder.mConstantIndex = i;
-  //  myConstantFinder.mCBufferHandle = cbufferID;
-  //  myConstantFinder.mName = myConstant.name;
-  //}
+  ResolveShaderUniforms( shader, errors );
+  if( errors.size )
+    return;
+  UpdateUniformHandles( shader );
 }
 
 void RendererDX11::SetName(
@@ -2318,6 +2585,66 @@ void RendererDX11::SetName(
     name );
 }
 
+TacUniformHandle RendererDX11::GetUniformHandle( const char* name )
+{
+  TacUniformHandle result;
+  result.mIndex = RENDERER_ID_NONE;
+
+  for( u32 iUniform = 1; iUniform < mUniforms.size(); ++iUniform )
+  {
+    TacUniformDX11& uniform = mUniforms[ iUniform ];
+    if( uniform.mCBufferHandle.mIndex != RENDERER_ID_NONE &&
+      TacStrCmp( uniform.mName.buffer, name ) == 0 )
+    {
+      result.mIndex = iUniform;
+      return result;
+    }
+  }
+
+  // cbuffers are shared between shaders, so the first cbuffer with a
+  // constant of this name is the one every shader uses. Prefer the layout
+  // a shader was compiled with over the one given to LoadCbuffer()
+  TacUniformDX11 uniform = {};
+  uniform.mName = name;
+  for( u32 iShader = 1; iShader < mShaders.size(); ++iShader )
+  {
+    TacShaderUniformDX11* shaderUniform =
+      FindShaderUniform( mShaders[ iShader ], name );
+    if( !shaderUniform ||
+      shaderUniform->mCBufferHandle.mIndex == RENDERER_ID_NONE )
+      continue;
+    uniform.mCBufferHandle = shaderUniform->mCBufferHandle;
+    uniform.mOffset = shaderUniform->mOffset;
+    uniform.mSize = shaderUniform->mSize;
+    break;
+  }
+  for( u32 iCbuffer = 1;
+    iCbuffer < mCbuffers.size() &&
+    uniform.mCBufferHandle.mIndex == RENDERER_ID_NONE;
+    ++iCbuffer )
+  {
+    TacCBufferDX11& cbuffer = mCbuffers[ iCbuffer ];
+    if( !cbuffer.mHandle )
+      continue;
+    for( u32 iConstant = 0; iConstant < cbuffer.mNumConstants; ++iConstant )
+    {
+      TacConstant& constant = cbuffer.mConstants[ iConstant ];
+      if( TacStrCmp( constant.name.buffer, name ) )
+        continue;
+      uniform.mCBufferHandle.mIndex = iCbuffer;
+      uniform.mOffset = constant.offset;
+      uniform.mSize = constant.size;
+      break;
+    }
+  }
+  if( uniform.mCBufferHandle.mIndex == RENDERER_ID_NONE )
+    return result;
+
+  result.mIndex = mUniforms.size();
+  mUniforms.push_back( uniform );
+  return result;
+}
+
 // blend state ----------------------------------------------------------
 
 TacBlendStateHandle RendererDX11::AddBlendState(
@@ -2701,6 +3028,8 @@ TacVertexFormatHandle RendererDX11::AddVertexFormat(
       case TacAttributeType::Color: return "COLOR";
       case TacAttributeType::BoneIndex: return "BONEINDEX";
       case TacAttributeType::BoneWeight: return "BONEWEIGHT";
+      case TacAttributeType::InstanceWorld: return "INSTANCEWORLD";
+      case TacAttributeType::InstanceColor: return "INSTANCECOLOR";
         TacInvalidDefaultCase;
       }
       return nullptr;
@@ -2711,9 +3040,29 @@ TacVertexFormatHandle RendererDX11::AddVertexFormat(
     //curTacFormat.mNumBytes,
     //curTacFormat.mNumComponents );
     curDX11Input.InputSlot = curTacFormat.mInputSlot;
-    curDX11Input.InputSlotClass = D3D11_INPUT_PER_VERTEX_DATA;
-    curDX11Input.InstanceDataStepRate = 0;
+    switch( curTacFormat.mAttributeType )
+    {
+      case TacAttributeType::InstanceWorld:
+      case TacAttributeType::InstanceColor:
+      {
+        curDX11Input.InputSlotClass = D3D11_INPUT_PER_INSTANCE_DATA;
+        curDX11Input.InstanceDataStepRate = 1;
+      } break;
+      default:
+      {
+        curDX11Input.InputSlotClass = D3D11_INPUT_PER_VERTEX_DATA;
+        curDX11Input.InstanceDataStepRate = 0;
+      } break;
+    }
+
+    // ie: the rows of a matrix are INSTANCEWORLD0, INSTANCEWORLD1, ...
     curDX11Input.SemanticIndex = 0;
+    for( u32 iPrevious = 0; iPrevious < i; ++iPrevious )
+    {
+      if( vertexFormat[ iPrevious ].mAttributeType ==
+        curTacFormat.mAttributeType )
+        ++curDX11Input.SemanticIndex;
+    }
     curDX11Input.SemanticName = GetSemanticName(
       curTacFormat.mAttributeType );
     curDX11Input.AlignedByteOffset = curTacFormat.mAlignedByteOffset;
@@ -2819,6 +3168,14 @@ void RendererDX11::DebugEnd()
 
 void RendererDX11::Draw()
 {
+  // upload memory doesn't have an index count, draw it with DrawIndexed()
+  TacAssert( !mIndexBufferUploadBound );
+  if( mCurrentIndexBuffer.mIndex == RENDERER_ID_NONE )
+  {
+    TacInvalidCodePath;
+    return;
+  }
+  UnmapRings();
   TacIndexBufferDX11& indexBuffer = mIndexBuffers[ mCurrentIndexBuffer.mIndex ];
   mDeviceContext->DrawIndexed( indexBuffer.mNumIndexes, 0, 0 );
 }
@@ -2828,9 +3185,45 @@ void RendererDX11::DrawIndexed(
   u32 idxOffset,
   u32 vtxOffset )
 {
+  UnmapRings();
   mDeviceContext->DrawIndexed( elementCount, idxOffset, vtxOffset );
 }
 
+void RendererDX11::DrawInstanced( u32 numInstances, u32 firstInstance )
+{
+  // upload memory doesn't have an index count, draw it with
+  // DrawIndexedInstanced()
+  TacAssert( !mIndexBufferUploadBound );
+  if( mCurrentIndexBuffer.mIndex == RENDERER_ID_NONE )
+  {
+    TacInvalidCodePath;
+    return;
+  }
+  TacIndexBufferDX11& indexBuffer = mIndexBuffers[ mCurrentIndexBuffer.mIndex ];
+  DrawIndexedInstanced(
+    indexBuffer.mNumIndexes,
+    numInstances,
+    0,
+    0,
+    firstInstance );
+}
+
+void RendererDX11::DrawIndexedInstanced(
+  u32 elementCount,
+  u32 numInstances,
+  u32 idxOffset,
+  u32 vtxOffset,
+  u32 firstInstance )
+{
+  UnmapRings();
+  mDeviceContext->DrawIndexedInstanced(
+    elementCount,
+    numInstances,
+    idxOffset,
+    vtxOffset,
+    firstInstance );
+}
+
 void RendererDX11::SendUniform(
   const char* name,
   void* data,
@@ -2840,29 +3233,31 @@ void RendererDX11::SendUniform(
 
   TacShaderDX11& shader = mShaders[ mCurrentShader.mIndex ];
 
-  ConstantFinder* myFinder;
-  ConstantFinder* endFinder =
-    shader.mConstantFinders + shader.mNumConstantFinders;
-
-  for( myFinder = shader.mConstantFinders;
-    myFinder != endFinder;
-    ++myFinder )
-  {
-    if( TacStrCmp( myFinder->mName.buffer, name ) == 0 )
-    {
-      break;
-    }
-  }
-
-  TacAssert( myFinder != endFinder );
-
-  TacCBufferDX11& cbuffer = mCbuffers[ myFinder->mCBufferHandle.mIndex ];
-  TacConstant& myConstant =
-    cbuffer.mConstants[ myFinder->mConstantIndex ];
+  TacShaderUniformDX11* uniform = FindShaderUniform( shader, name );
+  TacAssert( uniform );
+  TacAssert( uniform->mCBufferHandle.mIndex != RENDERER_ID_NONE );
+  TacAssert( size <= uniform->mSize );
 
+  TacCBufferDX11& cbuffer = mCbuffers[ uniform->mCBufferHandle.mIndex ];
+  memcpy(
+    cbuffer.mMemory + uniform->mOffset,
+    data,
+    size );
+  cbuffer.mDirty = true;
+}
 
+void RendererDX11::SendUniform(
+  TacUniformHandle uniform,
+  void* data,
+  u32 size )
+{
+  TacAssert( uniform.mIndex != RENDERER_ID_NONE );
+  TacUniformDX11& uniformDX11 = mUniforms[ uniform.mIndex ];
+  TacAssert( uniformDX11.mCBufferHandle.mIndex != RENDERER_ID_NONE );
+  TacCBufferDX11& cbuffer = mCbuffers[ uniformDX11.mCBufferHandle.mIndex ];
+  TacAssert( size <= uniformDX11.mSize );
   memcpy(
-    cbuffer.mMemory + myConstant.offset,
+    cbuffer.mMemory + uniformDX11.mOffset,
     data,
     size );
   cbuffer.mDirty = true;
@@ -2881,6 +3276,23 @@ void RendererDX11::Apply()
   setShaderResourcesFns[ ( u32 )TacShaderType::Fragment ] =
     &ID3D11DeviceContext::PSSetShaderResources;
 
+  typedef decltype( &ID3D11DeviceContext::VSSetConstantBuffers )
+    SetConstantBuffersFn;
+  SetConstantBuffersFn setConstantBuffersFns[ ( u32 )TacShaderType::Count ] = {};
+  setConstantBuffersFns[ ( u32 )TacShaderType::Vertex ] =
+    &ID3D11DeviceContext::VSSetConstantBuffers;
+  setConstantBuffersFns[ ( u32 )TacShaderType::Fragment ] =
+    &ID3D11DeviceContext::PSSetConstantBuffers;
+
+  typedef decltype( &ID3D11DeviceContext1::VSSetConstantBuffers1 )
+    SetConstantBuffers1Fn;
+  SetConstantBuffers1Fn setConstantBuffers1Fns
+    [ ( u32 )TacShaderType::Count ] = {};
+  setConstantBuffers1Fns[ ( u32 )TacShaderType::Vertex ] =
+    &ID3D11DeviceContext1::VSSetConstantBuffers1;
+  setConstantBuffers1Fns[ ( u32 )TacShaderType::Fragment ] =
+    &ID3D11DeviceContext1::PSSetConstantBuffers1;
+
   typedef decltype( &ID3D11DeviceContext::VSSetSamplers ) SetSamplerFn;
   SetSamplerFn setSamplerFns[ ( u32 )TacShaderType::Count ] = {};
   setSamplerFns[ ( u32 )TacShaderType::Vertex ] =
@@ -2901,6 +3313,43 @@ void RendererDX11::Apply()
       PerShaderData::CBufferBinding id = myPerShaderData.mCBufferBindings[ i ];
 
       TacCBufferDX11& mycbufferStuff = mCbuffers[ id.mCBufferHandle.mIndex ];
+      TacBoundConstantsDX11& boundConstants =
+        mBoundConstants[ iShaderType ][ id.mRegister ];
+      if( mConstantRing.mHandle && UploadCBuffer( mycbufferStuff ) )
+      {
+        // bound in groups of 16 constants of 16 bytes
+        u32 firstConstant = mycbufferStuff.mUploadOffset / 16;
+        u32 numConstants =
+          RoundUpToNearestMultiple( mycbufferStuff.mSize, 256 ) / 16;
+        if( boundConstants.mFirstConstant != firstConstant ||
+          boundConstants.mNumConstants != numConstants )
+        {
+          boundConstants.mFirstConstant = firstConstant;
+          boundConstants.mNumConstants = numConstants;
+          SetConstantBuffers1Fn fn = setConstantBuffers1Fns[ iShaderType ];
+          ( mDeviceContext1->*fn )(
+            id.mRegister,
+            1,
+            &mConstantRing.mHandle,
+            &firstConstant,
+            &numConstants );
+        }
+        continue;
+      }
+
+      // the ring is full, or there isn't one
+      if( mConstantRing.mHandle )
+      {
+        TacBoundConstantsDX11 none = {};
+        boundConstants = none;
+        SetConstantBuffersFn fn = setConstantBuffersFns[ iShaderType ];
+        ( mDeviceContext->*fn )( id.mRegister, 1, &mycbufferStuff.mHandle );
+
+        // the cbuffer's own buffer isn't kept up to date while the ring is
+        // used, and the ring copy is now older than it
+        mycbufferStuff.mDirty = true;
+        mycbufferStuff.mUploadFrame = 0;
+      }
       if( mycbufferStuff.mDirty )
       {
         mycbufferStuff.mDirty = false;
@@ -2968,7 +3417,11 @@ void RendererDX11::Apply()
 
 void RendererDX11::SwapBuffers()
 {
+  UnmapRings();
   mSwapChain->Present( 0, 0 );
+  FenceRing( mUploadRing );
+  FenceRing( mConstantRing );
+  ++mNumFrames;
 }
 
 void RendererDX11::SetViewport(
@@ -3040,6 +3493,161 @@ void RendererDX11::MapResource(
   *data = mappedResource.pData;
 }
 
+void RendererDX11::InitRing(
+  TacUploadRingDX11& ring,
+  u32 size,
+  u32 bindFlags,
+  FixedString< DEFAULT_ERR_LEN >& errors )
+{
+  D3D11_BUFFER_DESC bd = {};
+  bd.ByteWidth = size;
+  bd.BindFlags = bindFlags;
+  bd.Usage = D3D11_USAGE_DYNAMIC;
+  bd.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+  HRESULT hr = mDevice->CreateBuffer( &bd, nullptr, &ring.mHandle );
+  if( FAILED( hr ) )
+  {
+    errors = "CreateBuffer failed for upload ring";
+    AppendInfoQueueMessage( hr, errors );
+    AppendFileInfo( errors );
+    return;
+  }
+  ring.mSize = size;
+
+  D3D11_QUERY_DESC queryDesc = {};
+  queryDesc.Query = D3D11_QUERY_EVENT;
+  for( u32 i = 0; i < TacUploadRingDX11::FRAMES_IN_FLIGHT; ++i )
+  {
+    hr = mDevice->CreateQuery( &queryDesc, &ring.mFrameQueries[ i ] );
+    if( FAILED( hr ) )
+    {
+      errors = "CreateQuery failed for upload ring";
+      AppendInfoQueueMessage( hr, errors );
+      AppendFileInfo( errors );
+      return;
+    }
+  }
+}
+
+void RendererDX11::ReleaseRing( TacUploadRingDX11& ring )
+{
+  if( ring.mHandle )
+    ring.mHandle->Release();
+  for( u32 i = 0; i < TacUploadRingDX11::FRAMES_IN_FLIGHT; ++i )
+  {
+    if( ring.mFrameQueries[ i ] )
+      ring.mFrameQueries[ i ]->Release();
+  }
+  TacUploadRingDX11 empty = {};
+  ring = empty;
+}
+
+u8* RendererDX11::AllocateFromRing(
+  TacUploadRingDX11& ring,
+  u32 size,
+  u32 alignment,
+  u32* offset )
+{
+  if( !ring.mHandle || size > ring.mSize )
+    return nullptr;
+
+  // allocations don't wrap around the end of the ring
+  u32 headOffset = ( u32 )( ring.mHead % ring.mSize );
+  u32 alignedOffset = RoundUpToNearestMultiple( headOffset, alignment );
+  if( alignedOffset + size > ring.mSize )
+    alignedOffset = ring.mSize;
+  u64 begin = ring.mHead + ( alignedOffset - headOffset );
+  u64 end = begin + size;
+  while( end - ring.mTail > ring.mSize )
+  {
+    if( !ring.mNumFramesInFlight )
+      return nullptr;
+    WaitForOldestFrame( ring );
+  }
+
+  if( !ring.mMapped )
+  {
+    FixedString< DEFAULT_ERR_LEN > errors = {};
+    MapResource(
+      ( void** )&ring.mMapped,
+      ring.mHandle,
+      ring.mMappedOnce ? D3D11_MAP_WRITE_NO_OVERWRITE : D3D11_MAP_WRITE_DISCARD,
+      errors );
+    if( errors.size )
+    {
+      ring.mMapped = nullptr;
+      return nullptr;
+    }
+    ring.mMappedOnce = true;
+  }
+
+  ring.mHead = end;
+  *offset = ( u32 )( begin % ring.mSize );
+  return ring.mMapped + *offset;
+}
+
+void RendererDX11::WaitForOldestFrame( TacUploadRingDX11& ring )
+{
+  TacAssert( ring.mNumFramesInFlight );
+  ID3D11Query* query = ring.mFrameQueries[ ring.mOldestFrame ];
+  while( mDeviceContext->GetData( query, nullptr, 0, 0 ) == S_FALSE )
+  {
+    std::this_thread::yield();
+  }
+  ring.mTail = ring.mFrameEnds[ ring.mOldestFrame ];
+  ring.mOldestFrame =
+    ( ring.mOldestFrame + 1 ) % TacUploadRingDX11::FRAMES_IN_FLIGHT;
+  --ring.mNumFramesInFlight;
+}
+
+void RendererDX11::FenceRing( TacUploadRingDX11& ring )
+{
+  if( !ring.mHandle )
+    return;
+  if( ring.mNumFramesInFlight == TacUploadRingDX11::FRAMES_IN_FLIGHT )
+    WaitForOldestFrame( ring );
+  u32 iFrame =
+    ( ring.mOldestFrame + ring.mNumFramesInFlight ) %
+    TacUploadRingDX11::FRAMES_IN_FLIGHT;
+  mDeviceContext->End( ring.mFrameQueries[ iFrame ] );
+  ring.mFrameEnds[ iFrame ] = ring.mHead;
+  ++ring.mNumFramesInFlight;
+}
+
+void RendererDX11::UnmapRings()
+{
+  TacUploadRingDX11* rings[] = { &mUploadRing, &mConstantRing };
+  for( TacUploadRingDX11* ring : rings )
+  {
+    if( !ring->mMapped )
+      continue;
+    mDeviceContext->Unmap( ring->mHandle, 0 );
+    ring->mMapped = nullptr;
+  }
+}
+
+b32 RendererDX11::UploadCBuffer( TacCBufferDX11& cbuffer )
+{
+  // the ring memory from an older frame may have been written over
+  if( !cbuffer.mDirty && cbuffer.mUploadFrame == mNumFrames )
+    return true;
+
+  // offsets are in groups of 16 constants of 16 bytes
+  u32 offset;
+  u8* memory = AllocateFromRing(
+    mConstantRing,
+    RoundUpToNearestMultiple( cbuffer.mSize, 256 ),
+    256,
+    &offset );
+  if( !memory )
+    return false;
+  memcpy( memory, cbuffer.mMemory, cbuffer.mSize );
+  cbuffer.mUploadOffset = offset;
+  cbuffer.mUploadFrame = mNumFrames;
+  cbuffer.mDirty = false;
+  return true;
+}
+
 void RendererDX11::AppendInfoQueueMessage(
   HRESULT hr,
   FixedString< DEFAULT_ERR_LEN >& errors )
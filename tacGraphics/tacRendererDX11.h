@@ -13,11 +13,30 @@
 #include <d3d11_1.h>
 #include <d3dcompiler.h>
 
-struct ConstantFinder
+// A constant that GetUniformHandle() found, indexed by TacUniformHandle
+struct TacUniformDX11
 {
   FixedString< 32 > mName;
   TacCBufferHandle mCBufferHandle;
-  u32 mConstantIndex;
+  u32 mOffset;
+  u32 mSize;
+};
+
+// A cbuffer variable of a compiled shader, from its reflection.
+// mRegisters is the cbuffer register in each shader stage, or
+// SHADER_UNIFORM_UNUSED if that stage doesn't use the variable
+static const u32 SHADER_UNIFORM_UNUSED = ( u32 )-1;
+struct TacShaderUniformDX11
+{
+  // 0 if the table slot is empty
+  u32 mNameHash;
+  FixedString< 32 > mName;
+  u32 mRegisters[ ( u32 )TacShaderType::Count ];
+  u32 mOffset;
+  u32 mSize;
+
+  // the cbuffer AddCbuffer() bound to one of mRegisters
+  TacCBufferHandle mCBufferHandle;
 };
 
 struct PerShaderData
@@ -53,6 +72,11 @@ struct TacCBufferDX11
 
   b32 mDirty;
 
+  // where mMemory was last copied to in the constant ring, and in which
+  // frame, see RendererDX11::Apply()
+  u32 mUploadOffset;
+  u32 mUploadFrame;
+
   TacConstant mConstants[ 10 ];
   u32 mNumConstants;
 };
@@ -84,8 +108,11 @@ struct TacShaderDX11
   ID3D11PixelShader* mPixelShader;
   ID3DBlob* mInputSig;
 
-  ConstantFinder mConstantFinders[ 10 ];
-  u32 mNumConstantFinders;
+  // Open addressed by the hash of the name, filled in when the shader
+  // is compiled so SendUniform() doesn't compare strings
+  static const u32 UNIFORM_TABLE_SIZE = 64;
+  TacShaderUniformDX11 mUniformTable[ UNIFORM_TABLE_SIZE ];
+  u32 mNumUniforms;
 
   PerShaderData mPerShaderData[ ( u32 )TacShaderType::Count ];
 
@@ -133,6 +160,37 @@ struct TacRasterizerStateDX11
   ID3D11RasterizerState* mHandle;
 };
 
+// A dynamic buffer that's sub allocated front to back, wrapping around.
+// mHead and mTail count every byte ever allocated, so the part of the ring
+// in use is [ mTail, mHead ) modulo mSize. Each frame in flight ends with
+// an event query, and mTail moves past the frame once the query is done.
+struct TacUploadRingDX11
+{
+  static const u32 FRAMES_IN_FLIGHT = 3;
+
+  ID3D11Buffer* mHandle;
+  u32 mSize;
+  u64 mHead;
+  u64 mTail;
+
+  // mapped no overwrite until the next draw, the first map discards
+  u8* mMapped;
+  b32 mMappedOnce;
+
+  ID3D11Query* mFrameQueries[ FRAMES_IN_FLIGHT ];
+  u64 mFrameEnds[ FRAMES_IN_FLIGHT ];
+  u32 mOldestFrame;
+  u32 mNumFramesInFlight;
+};
+
+// What's bound to a cbuffer register from the constant ring.
+// mNumConstants is 0 if it's something else
+struct TacBoundConstantsDX11
+{
+  u32 mFirstConstant;
+  u32 mNumConstants;
+};
+
 struct RendererDX11 : public TacRenderer
 {
   RendererDX11(
@@ -203,6 +261,42 @@ struct RendererDX11 : public TacRenderer
   std::vector< TacIndexBufferDX11 > mIndexBuffers;
   std::vector< u32 > mIndexBufferIndexes;
 
+  // upload ring ----------------------------------------------------------
+
+  TacUploadAllocation AllocateUpload( u32 size, u32 alignment ) override;
+
+  void SetVertexBufferUpload(
+    u32 inputSlot,
+    u32 offset,
+    u32 stride ) override;
+
+  void SetIndexBufferUpload(
+    u32 offset,
+    TacTextureFormat indexFormat ) override;
+
+  // set by SetIndexBufferUpload(), cleared by SetIndexBuffer().
+  // mCurrentIndexBuffer is RENDERER_ID_NONE while it's set
+  b32 mIndexBufferUploadBound;
+
+  static const u32 UPLOAD_RING_SIZE = 8 * 1024 * 1024;
+  static const u32 CONSTANT_RING_SIZE = 4 * 1024 * 1024;
+
+  // vertexes and indexes
+  TacUploadRingDX11 mUploadRing;
+
+  // Apply() copies dirty cbuffers here instead of updating each of their
+  // buffers. There's no mHandle if the device can't bind cbuffers at an
+  // offset ( d3d 11.1 ), then the cbuffers are updated like before
+  TacUploadRingDX11 mConstantRing;
+  ID3D11DeviceContext1* mDeviceContext1;
+  static const u32 CBUFFER_REGISTERS =
+    D3D11_COMMONSHADER_CONSTANT_BUFFER_API_SLOT_COUNT;
+  TacBoundConstantsDX11 mBoundConstants
+    [ ( u32 )TacShaderType::Count ][ CBUFFER_REGISTERS ];
+
+  // counts SwapBuffers(), starts at 1
+  u32 mNumFrames;
+
   // clear ----------------------------------------------------------------
 
   void ClearColor(
@@ -247,6 +341,22 @@ struct RendererDX11 : public TacRenderer
     const char* shaderStrings[ ( u32 )TacShaderType::Count ],
     FixedString< DEFAULT_ERR_LEN >& errors );
 
+  // Adds the cbuffer variables of one stage to shader.mUniformTable
+  void ReflectShader(
+    TacShaderDX11& shader,
+    TacShaderType shaderType,
+    ID3DBlob* blob,
+    FixedString< DEFAULT_ERR_LEN >& errors );
+
+  // Points the uniform table at the cbuffers bound with AddCbuffer()
+  void ResolveShaderUniforms(
+    TacShaderDX11& shader,
+    FixedString< DEFAULT_ERR_LEN >& errors );
+
+  // Moves the uniform handles in the shader's cbuffers to the offsets it
+  // was compiled with
+  void UpdateUniformHandles( TacShaderDX11& shader );
+
   void SetName(
     TacShaderHandle handle,
     const char* name ) override;
@@ -379,9 +489,14 @@ struct RendererDX11 : public TacRenderer
     TacCBufferHandle handle,
     const char* name ) override;
 
+  TacUniformHandle GetUniformHandle( const char* name ) override;
+
   std::vector< TacCBufferDX11 > mCbuffers;
   std::vector< u32 > mCbufferIndexes;
 
+  // indexed by TacUniformHandle
+  std::vector< TacUniformDX11 > mUniforms;
+
   // blend state ----------------------------------------------------------
 
   TacBlendStateHandle AddBlendState(
@@ -483,7 +598,18 @@ struct RendererDX11 : public TacRenderer
     u32 elementCount,
     u32 idxOffset,
     u32 vtxOffset ) override;
+  void DrawInstanced( u32 numInstances, u32 firstInstance ) override;
+  void DrawIndexedInstanced(
+    u32 elementCount,
+    u32 numInstances,
+    u32 idxOffset,
+    u32 vtxOffset,
+    u32 firstInstance ) override;
   void SendUniform( const char* name, void* data, u32 size ) override;
+  void SendUniform(
+    TacUniformHandle uniform,
+    void* data,
+    u32 size ) override;
   void Apply() override;
   void SwapBuffers() override;
   void SetViewport(
@@ -519,6 +645,32 @@ struct RendererDX11 : public TacRenderer
     D3D11_MAP d3d11mapType,
     FixedString< DEFAULT_ERR_LEN >& errors );
 
+  void InitRing(
+    TacUploadRingDX11& ring,
+    u32 size,
+    u32 bindFlags,
+    FixedString< DEFAULT_ERR_LEN >& errors );
+  void ReleaseRing( TacUploadRingDX11& ring );
+
+  // Waits for the frames in flight if it has to.
+  // Returns null if the current frame has used up the ring
+  u8* AllocateFromRing(
+    TacUploadRingDX11& ring,
+    u32 size,
+    u32 alignment,
+    u32* offset );
+  void WaitForOldestFrame( TacUploadRingDX11& ring );
+
+  // Ends the frame's allocations with a query
+  void FenceRing( TacUploadRingDX11& ring );
+
+  // The gpu can't read a mapped buffer, so this is called before draws
+  void UnmapRings();
+
+  // Copies the cbuffer to the constant ring if it changed this frame.
+  // Returns false if the ring is full
+  b32 UploadCBuffer( TacCBufferDX11& cbuffer );
+
   void AppendInfoQueueMessage(
     HRESULT hr,
     FixedString< DEFAULT_ERR_LEN >& errors );
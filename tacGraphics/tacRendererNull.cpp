@@ -0,0 +1,1398 @@
+#include "tacRendererNull.h"
+
+const char* NullCallToString( TacNullCall call )
+{
+  switch( call )
+  {
+    case TacNullCall::SetVertexBuffers: return "SetVertexBuffers";
+    case TacNullCall::SetIndexBuffer: return "SetIndexBuffer";
+    case TacNullCall::ClearColor: return "ClearColor";
+    case TacNullCall::ClearDepthStencil: return "ClearDepthStencil";
+    case TacNullCall::SetActiveShader: return "SetActiveShader";
+    case TacNullCall::SetSamplerState: return "SetSamplerState";
+    case TacNullCall::SetTexture: return "SetTexture";
+    case TacNullCall::SetRenderTargets: return "SetRenderTargets";
+    case TacNullCall::SetBlendState: return "SetBlendState";
+    case TacNullCall::SetRasterizerState: return "SetRasterizerState";
+    case TacNullCall::SetDepthState: return "SetDepthState";
+    case TacNullCall::SetVertexFormat: return "SetVertexFormat";
+    case TacNullCall::Draw: return "Draw";
+    case TacNullCall::DrawIndexed: return "DrawIndexed";
+    case TacNullCall::DrawInstanced: return "DrawInstanced";
+    case TacNullCall::DrawIndexedInstanced: return "DrawIndexedInstanced";
+    case TacNullCall::SendUniform: return "SendUniform";
+    case TacNullCall::Apply: return "Apply";
+    case TacNullCall::SwapBuffers: return "SwapBuffers";
+    case TacNullCall::SetViewport: return "SetViewport";
+    case TacNullCall::SetPrimitiveTopology: return "SetPrimitiveTopology";
+    case TacNullCall::SetScissorRect: return "SetScissorRect";
+    case TacNullCall::SetVertexBufferUpload: return "SetVertexBufferUpload";
+    case TacNullCall::SetIndexBufferUpload: return "SetIndexBufferUpload";
+    case TacNullCall::SendUniformHandle: return "SendUniformHandle";
+    TacInvalidDefaultCase;
+  }
+  return nullptr;
+}
+
+s32 TacNullResources::Add()
+{
+  // slot 0 is RENDERER_ID_NONE
+  if( mAlive.empty() )
+    mAlive.push_back( false );
+
+  s32 result;
+  if( mFreeIndexes.empty() )
+  {
+    result = ( s32 )mAlive.size();
+    mAlive.push_back( true );
+  }
+  else
+  {
+    result = ( s32 )mFreeIndexes.back();
+    mFreeIndexes.pop_back();
+    mAlive[ result ] = true;
+  }
+  return result;
+}
+
+b32 TacNullResources::Remove( s32 index )
+{
+  if( !IsAlive( index ) )
+    return false;
+  mAlive[ index ] = false;
+  mFreeIndexes.push_back( index );
+  return true;
+}
+
+b32 TacNullResources::IsAlive( s32 index )
+{
+  b32 result =
+    index != RENDERER_ID_NONE &&
+    index > 0 &&
+    index < ( s32 )mAlive.size() &&
+    mAlive[ index ];
+  return result;
+}
+
+internalFunction void AppendBytes(
+  std::vector< u8 >& bytes,
+  const void* data,
+  u32 size )
+{
+  const u8* begin = ( const u8* )data;
+  bytes.insert( bytes.end(), begin, begin + size );
+}
+
+internalFunction void AppendName(
+  std::vector< u8 >& bytes,
+  const char* name )
+{
+  AppendBytes( bytes, name, TacStrLen( name ) + 1 );
+}
+
+RendererNull::RendererNull( u32 width, u32 height )
+{
+  mWidth = width;
+  mHeight = height;
+
+  TacRendererNullStats emptyStats = {};
+  mStats = emptyStats;
+  mLastFrameStats = emptyStats;
+  FixedStringClear( mFirstError );
+  mNumFrames = 0;
+  mRecording = false;
+
+  mNumCurrentVertexBuffers = 0;
+  mCurrentIndexBuffer.mIndex = RENDERER_ID_NONE;
+  mCurrentShader.mIndex = RENDERER_ID_NONE;
+  mCurrentBlendState.mIndex = RENDERER_ID_NONE;
+  mCurrentRasterizerState.mIndex = RENDERER_ID_NONE;
+  mCurrentDepthState.mIndex = RENDERER_ID_NONE;
+  mCurrentVertexFormat.mIndex = RENDERER_ID_NONE;
+
+  mUploadMemory.resize( UPLOAD_MEMORY_SIZE );
+  mUploadHead = 0;
+  TacNullUploadBinding emptyUpload = {};
+  for( u32 i = 0; i < VERTEX_BUFFERS_PER_DRAW; ++i )
+    mVertexBufferUploads[ i ] = emptyUpload;
+  mIndexBufferUpload = emptyUpload;
+  mIndexBufferUploadFormat = TacTextureFormat::R16Uint;
+
+  // index 0 of the uniforms is RENDERER_ID_NONE too
+  TacNullUniform emptyUniform = {};
+  mUniforms.push_back( emptyUniform );
+
+  mBackbufferColor.mIndex = mTextureResources.Add();
+  mBackbufferDepth.mIndex = mDepthBufferResources.Add();
+}
+
+void RendererNull::Validate( b32 valid, const char* error )
+{
+  if( valid )
+    return;
+  if( !mStats.mNumValidationErrors && !mFirstError.size )
+    mFirstError = error;
+  ++mStats.mNumValidationErrors;
+}
+
+void RendererNull::ValidateDraw()
+{
+  Validate(
+    mShaderResources.IsAlive( mCurrentShader.mIndex ),
+    "Draw without a shader" );
+  Validate(
+    mVertexFormatResources.IsAlive( mCurrentVertexFormat.mIndex ),
+    "Draw without a vertex format" );
+  Validate(
+    mNumCurrentVertexBuffers != 0,
+    "Draw without vertex buffers" );
+  for( u32 i = 0; i < mNumCurrentVertexBuffers; ++i )
+  {
+    if( mVertexBufferUploads[ i ].mActive )
+      continue;
+    Validate(
+      mVertexBufferResources.IsAlive( mCurrentVertexBuffers[ i ].mIndex ),
+      "Draw with a removed vertex buffer" );
+  }
+  Validate(
+    mIndexBufferUpload.mActive ||
+    mIndexBufferResources.IsAlive( mCurrentIndexBuffer.mIndex ),
+    "Draw without an index buffer" );
+}
+
+void RendererNull::CountStateChange( b32 changed )
+{
+  if( changed )
+    ++mStats.mNumStateChanges;
+  else
+    ++mStats.mNumRedundantStateChanges;
+}
+
+void RendererNull::Record( TacNullCall call, const void* data, u32 size )
+{
+  ++mStats.mNumCalls;
+  if( !mRecording )
+    return;
+  u32 header[ 2 ] = { ( u32 )call, size };
+  AppendBytes( mRecord, header, sizeof( header ) );
+  if( size )
+    AppendBytes( mRecord, data, size );
+}
+
+void RendererNull::SaveRecording(
+  TacThreadContext* thread,
+  const char* filepath,
+  FixedString< DEFAULT_ERR_LEN >& errors )
+{
+  TacFile file = PlatformOpenFile(
+    thread,
+    filepath,
+    OpenFileDisposition::CreateAlways,
+    FileAccess::Write,
+    errors );
+  if( errors.size )
+    return;
+  OnDestruct( PlatformCloseFile( thread, file, errors ); );
+  PlatformWriteEntireFile(
+    thread,
+    file,
+    mRecord.data(),
+    ( u32 )mRecord.size(),
+    errors );
+}
+
+// vertex buffer --------------------------------------------------------
+
+TacVertexBufferHandle RendererNull::AddVertexBuffer(
+  TacBufferAccess access,
+  void* data,
+  u32 numVertexes,
+  u32 stride,
+  FixedString< DEFAULT_ERR_LEN >& errors )
+{
+  TacUnusedParameter( access );
+  TacUnusedParameter( errors );
+  TacVertexBufferHandle result;
+  result.mIndex = mVertexBufferResources.Add();
+  ResizeForIndex( mVertexBuffers, result.mIndex );
+  TacNullBuffer& vertexBuffer = mVertexBuffers[ result.mIndex ];
+  vertexBuffer.mMemory.resize( numVertexes * stride );
+  vertexBuffer.mNumElements = numVertexes;
+  if( data )
+  {
+    memcpy( vertexBuffer.mMemory.data(), data, numVertexes * stride );
+    mStats.mNumBytesUploaded += numVertexes * stride;
+  }
+  ++mStats.mNumResourcesCreated;
+  return result;
+}
+
+void RendererNull::RemoveVertexBuffer( TacVertexBufferHandle vertexBuffer )
+{
+  Validate(
+    mVertexBufferResources.Remove( vertexBuffer.mIndex ),
+    "RemoveVertexBuffer of a vertex buffer that isn't alive" );
+  if( vertexBuffer.mIndex > 0 &&
+    vertexBuffer.mIndex < ( s32 )mVertexBuffers.size() )
+  {
+    TacNullBuffer empty = {};
+    mVertexBuffers[ vertexBuffer.mIndex ] = empty;
+  }
+  ++mStats.mNumResourcesRemoved;
+}
+
+void RendererNull::SetVertexBuffers(
+  const TacVertexBufferHandle* vertexBuffers,
+  u32 numVertexBuffers )
+{
+  Record(
+    TacNullCall::SetVertexBuffers,
+    vertexBuffers,
+    sizeof( TacVertexBufferHandle ) * numVertexBuffers );
+  Validate(
+    numVertexBuffers <= VERTEX_BUFFERS_PER_DRAW,
+    "SetVertexBuffers with too many vertex buffers" );
+  numVertexBuffers = Minimum( numVertexBuffers, VERTEX_BUFFERS_PER_DRAW );
+
+  b32 changed = numVertexBuffers != mNumCurrentVertexBuffers;
+  TacNullUploadBinding emptyUpload = {};
+  for( u32 i = 0; i < VERTEX_BUFFERS_PER_DRAW; ++i )
+  {
+    changed |= mVertexBufferUploads[ i ].mActive;
+    mVertexBufferUploads[ i ] = emptyUpload;
+  }
+  for( u32 i = 0; i < numVertexBuffers; ++i )
+  {
+    Validate(
+      mVertexBufferResources.IsAlive( vertexBuffers[ i ].mIndex ),
+      "SetVertexBuffers with a vertex buffer that isn't alive" );
+    if( i >= mNumCurrentVertexBuffers ||
+      mCurrentVertexBuffers[ i ].mIndex != vertexBuffers[ i ].mIndex )
+      changed = true;
+    mCurrentVertexBuffers[ i ] = vertexBuffers[ i ];
+  }
+  mNumCurrentVertexBuffers = numVertexBuffers;
+  CountStateChange( changed );
+}
+
+void RendererNull::MapVertexBuffer(
+  void** data,
+  TacMap mapType,
+  FixedString< DEFAULT_ERR_LEN >& errors )
+{
+  TacUnusedParameter( mapType );
+  if( !mNumCurrentVertexBuffers ||
+    !mVertexBufferResources.IsAlive( mCurrentVertexBuffers[ 0 ].mIndex ) )
+  {
+    errors = "No vertex buffer set, call Renderer::SetVertexBuffer";
+    return;
+  }
+  *data = mVertexBuffers[ mCurrentVertexBuffers[ 0 ].mIndex ].mMemory.data();
+}
+
+void RendererNull::UnmapVertexBuffer(
+  FixedString< DEFAULT_ERR_LEN >& errors )
+{
+  if( !mNumCurrentVertexBuffers ||
+    !mVertexBufferResources.IsAlive( mCurrentVertexBuffers[ 0 ].mIndex ) )
+  {
+    errors = "No vertex buffer set, call Renderer::SetVertexBuffer";
+    return;
+  }
+
+  // the whole buffer, the renderer can't know how much was written
+  mStats.mNumBytesUploaded +=
+    mVertexBuffers[ mCurrentVertexBuffers[ 0 ].mIndex ].mMemory.size();
+}
+
+void RendererNull::SetName(
+  TacVertexBufferHandle handle,
+  const char* name )
+{
+  TacUnusedParameter( name );
+  Validate(
+    mVertexBufferResources.IsAlive( handle.mIndex ),
+    "SetName of a vertex buffer that isn't alive" );
+}
+
+// index buffer ---------------------------------------------------------
+
+TacIndexBufferHandle RendererNull::AddIndexBuffer(
+  TacBufferAccess access,
+  void* data,
+  u32 numIndexes,
+  TacTextureFormat dataType,
+  u32 totalBufferSize,
+  FixedString< DEFAULT_ERR_LEN >& errors )
+{
+  TacUnusedParameter( access );
+  TacUnusedParameter( dataType );
+  TacUnusedParameter( errors );
+  TacIndexBufferHandle result;
+  result.mIndex = mIndexBufferResources.Add();
+  ResizeForIndex( mIndexBuffers, result.mIndex );
+  TacNullBuffer& indexBuffer = mIndexBuffers[ result.mIndex ];
+  indexBuffer.mMemory.resize( totalBufferSize );
+  indexBuffer.mNumElements = numIndexes;
+  if( data )
+  {
+    memcpy( indexBuffer.mMemory.data(), data, totalBufferSize );
+    mStats.mNumBytesUploaded += totalBufferSize;
+  }
+  ++mStats.mNumResourcesCreated;
+  return result;
+}
+
+void RendererNull::RemoveIndexBuffer( TacIndexBufferHandle indexBuffer )
+{
+  Validate(
+    mIndexBufferResources.Remove( indexBuffer.mIndex ),
+    "RemoveIndexBuffer of an index buffer that isn't alive" );
+  if( indexBuffer.mIndex > 0 &&
+    indexBuffer.mIndex < ( s32 )mIndexBuffers.size() )
+  {
+    TacNullBuffer empty = {};
+    mIndexBuffers[ indexBuffer.mIndex ] = empty;
+  }
+  ++mStats.mNumResourcesRemoved;
+}
+
+void RendererNull::SetIndexBuffer( TacIndexBufferHandle indexBuffer )
+{
+  Record(
+    TacNullCall::SetIndexBuffer,
+    &indexBuffer,
+    sizeof( TacIndexBufferHandle ) );
+  Validate(
+    mIndexBufferResources.IsAlive( indexBuffer.mIndex ),
+    "SetIndexBuffer with an index buffer that isn't alive" );
+  CountStateChange(
+    indexBuffer.mIndex != mCurrentIndexBuffer.mIndex ||
+    mIndexBufferUpload.mActive );
+  mCurrentIndexBuffer = indexBuffer;
+  TacNullUploadBinding emptyUpload = {};
+  mIndexBufferUpload = emptyUpload;
+}
+
+void RendererNull::MapIndexBuffer(
+  void** data,
+  TacMap mapType,
+  FixedString< DEFAULT_ERR_LEN >& errors )
+{
+  TacUnusedParameter( mapType );
+  if( !mIndexBufferResources.IsAlive( mCurrentIndexBuffer.mIndex ) )
+  {
+    errors = "No index buffer set, call Renderer::SetIndexBuffer";
+    return;
+  }
+  *data = mIndexBuffers[ mCurrentIndexBuffer.mIndex ].mMemory.data();
+}
+
+void RendererNull::UnmapIndexBuffer(
+  FixedString< DEFAULT_ERR_LEN >& errors )
+{
+  if( !mIndexBufferResources.IsAlive( mCurrentIndexBuffer.mIndex ) )
+  {
+    errors = "No index buffer set, call Renderer::SetIndexBuffer";
+    return;
+  }
+  mStats.mNumBytesUploaded +=
+    mIndexBuffers[ mCurrentIndexBuffer.mIndex ].mMemory.size();
+}
+
+void RendererNull::SetName(
+  TacIndexBufferHandle handle,
+  const char* name )
+{
+  TacUnusedParameter( name );
+  Validate(
+    mIndexBufferResources.IsAlive( handle.mIndex ),
+    "SetName of an index buffer that isn't alive" );
+}
+
+// upload ring ----------------------------------------------------------
+
+TacUploadAllocation RendererNull::AllocateUpload( u32 size, u32 alignment )
+{
+  TacUploadAllocation result = {};
+  u32 offset = RoundUpToNearestMultiple( mUploadHead, alignment );
+  if( offset + size > UPLOAD_MEMORY_SIZE )
+    return result;
+  mUploadHead = offset + size;
+  mStats.mNumBytesUploaded += size;
+  result.mData = mUploadMemory.data() + offset;
+  result.mOffset = offset;
+  return result;
+}
+
+void RendererNull::SetVertexBufferUpload(
+  u32 inputSlot,
+  u32 offset,
+  u32 stride )
+{
+  u32 args[] = { inputSlot, offset, stride };
+  Record( TacNullCall::SetVertexBufferUpload, args, sizeof( args ) );
+  Validate(
+    inputSlot < VERTEX_BUFFERS_PER_DRAW,
+    "SetVertexBufferUpload with too many vertex buffers" );
+  Validate(
+    offset < UPLOAD_MEMORY_SIZE,
+    "SetVertexBufferUpload past the end of the upload memory" );
+  if( inputSlot >= VERTEX_BUFFERS_PER_DRAW )
+    return;
+
+  // slots skipped over stay unset, and fail ValidateDraw()
+  for( u32 i = mNumCurrentVertexBuffers; i < inputSlot; ++i )
+    mCurrentVertexBuffers[ i ].mIndex = RENDERER_ID_NONE;
+  mNumCurrentVertexBuffers = Maximum( mNumCurrentVertexBuffers, inputSlot + 1 );
+  mCurrentVertexBuffers[ inputSlot ].mIndex = RENDERER_ID_NONE;
+
+  TacNullUploadBinding& upload = mVertexBufferUploads[ inputSlot ];
+  CountStateChange(
+    !upload.mActive ||
+    upload.mOffset != offset ||
+    upload.mStride != stride );
+  upload.mActive = true;
+  upload.mOffset = offset;
+  upload.mStride = stride;
+}
+
+void RendererNull::SetIndexBufferUpload(
+  u32 offset,
+  TacTextureFormat indexFormat )
+{
+  u32 args[] = { offset, ( u32 )indexFormat };
+  Record( TacNullCall::SetIndexBufferUpload, args, sizeof( args ) );
+  b32 validFormat =
+    indexFormat == TacTextureFormat::R16Uint ||
+    indexFormat == TacTextureFormat::R32Uint;
+  Validate(
+    validFormat,
+    "SetIndexBufferUpload with an index format that isn't R16Uint or R32Uint" );
+  Validate(
+    offset < UPLOAD_MEMORY_SIZE,
+    "SetIndexBufferUpload past the end of the upload memory" );
+  CountStateChange(
+    !mIndexBufferUpload.mActive ||
+    mIndexBufferUpload.mOffset != offset ||
+    mIndexBufferUploadFormat != indexFormat );
+  mCurrentIndexBuffer.mIndex = RENDERER_ID_NONE;
+  mIndexBufferUpload.mActive = true;
+  mIndexBufferUpload.mOffset = offset;
+  mIndexBufferUpload.mStride =
+    indexFormat == TacTextureFormat::R16Uint ? 2 : 4;
+  mIndexBufferUploadFormat = indexFormat;
+}
+
+// clear ----------------------------------------------------------------
+
+void RendererNull::ClearColor(
+  TacTextureHandle textureHandle,
+  v4 rgba )
+{
+  if( mRecording )
+  {
+    std::vector< u8 > args;
+    AppendBytes( args, &textureHandle, sizeof( textureHandle ) );
+    AppendBytes( args, &rgba, sizeof( rgba ) );
+    Record( TacNullCall::ClearColor, args.data(), ( u32 )args.size() );
+  }
+  else
+  {
+    Record( TacNullCall::ClearColor );
+  }
+  Validate(
+    mTextureResources.IsAlive( textureHandle.mIndex ),
+    "ClearColor of a texture that isn't alive" );
+}
+
+void RendererNull::ClearDepthStencil(
+  TacDepthBufferHandle depthBufferHandle,
+  b32 clearDepth,
+  r32 depth,
+  b32 clearStencil,
+  u8 stencil )
+{
+  if( mRecording )
+  {
+    std::vector< u8 > args;
+    AppendBytes( args, &depthBufferHandle, sizeof( depthBufferHandle ) );
+    AppendBytes( args, &clearDepth, sizeof( clearDepth ) );
+    AppendBytes( args, &depth, sizeof( depth ) );
+    AppendBytes( args, &clearStencil, sizeof( clearStencil ) );
+    AppendBytes( args, &stencil, sizeof( stencil ) );
+    Record( TacNullCall::ClearDepthStencil, args.data(), ( u32 )args.size() );
+  }
+  else
+  {
+    Record( TacNullCall::ClearDepthStencil );
+  }
+  Validate(
+    mDepthBufferResources.IsAlive( depthBufferHandle.mIndex ),
+    "ClearDepthStencil of a depth buffer that isn't alive" );
+}
+
+// shader ---------------------------------------------------------------
+
+TacShaderHandle RendererNull::LoadShader(
+  const char* paths[ ( u32 )TacShaderType::Count ],
+  const char* entryPoints[ ( u32 )TacShaderType::Count ],
+  const char* shaderModels[ ( u32 )TacShaderType::Count ],
+  FixedString< DEFAULT_ERR_LEN >& errors )
+{
+  TacUnusedParameter( paths );
+  TacUnusedParameter( entryPoints );
+  TacUnusedParameter( shaderModels );
+  TacUnusedParameter( errors );
+
+  // nothing is compiled, so the shader files don't need to exist
+  TacShaderHandle result;
+  result.mIndex = mShaderResources.Add();
+  ResizeForIndex( mShaders, result.mIndex );
+  TacNullShader empty = {};
+  mShaders[ result.mIndex ] = empty;
+  ++mStats.mNumResourcesCreated;
+  return result;
+}
+
+void RendererNull::RemoveShader( TacShaderHandle shader )
+{
+  Validate(
+    mShaderResources.Remove( shader.mIndex ),
+    "RemoveShader of a shader that isn't alive" );
+  ++mStats.mNumResourcesRemoved;
+}
+
+void RendererNull::ReloadShader( TacShaderHandle shader )
+{
+  Validate(
+    mShaderResources.IsAlive( shader.mIndex ),
+    "ReloadShader of a shader that isn't alive" );
+}
+
+TacShaderHandle RendererNull::LoadShaderFromString(
+  const char* shaderStr[ ( u32 )TacShaderType::Count ],
+  const char* entryPoints[ ( u32 )TacShaderType::Count ],
+  const char* shaderModels[ ( u32 )TacShaderType::Count ],
+  FixedString< DEFAULT_ERR_LEN >& errors )
+{
+  return LoadShader( shaderStr, entryPoints, shaderModels, errors );
+}
+
+void RendererNull::SetActiveShader( TacShaderHandle shader )
+{
+  Record( TacNullCall::SetActiveShader, &shader, sizeof( shader ) );
+  Validate(
+    shader.mIndex == RENDERER_ID_NONE ||
+    mShaderResources.IsAlive( shader.mIndex ),
+    "SetActiveShader with a shader that isn't alive" );
+  CountStateChange( shader.mIndex != mCurrentShader.mIndex );
+  mCurrentShader = shader;
+}
+
+TacShaderHandle RendererNull::GetCurrentlyBoundShader()
+{
+  return mCurrentShader;
+}
+
+void RendererNull::SetName(
+  TacShaderHandle handle,
+  const char* name )
+{
+  TacUnusedParameter( name );
+  Validate(
+    mShaderResources.IsAlive( handle.mIndex ),
+    "SetName of a shader that isn't alive" );
+}
+
+// sampler state --------------------------------------------------------
+
+TacSamplerStateHandle RendererNull::AddSamplerState(
+  const TacAddressMode u,
+  const TacAddressMode v,
+  const TacAddressMode w,
+  TacComparison compare,
+  TacFilter filter,
+  FixedString< DEFAULT_ERR_LEN >& errors )
+{
+  TacUnusedParameter( u );
+  TacUnusedParameter( v );
+  TacUnusedParameter( w );
+  TacUnusedParameter( compare );
+  TacUnusedParameter( filter );
+  TacUnusedParameter( errors );
+  TacSamplerStateHandle result;
+  result.mIndex = mSamplerStateResources.Add();
+  ++mStats.mNumResourcesCreated;
+  return result;
+}
+
+void RendererNull::RemoveSamplerState( TacSamplerStateHandle samplerState )
+{
+  Validate(
+    mSamplerStateResources.Remove( samplerState.mIndex ),
+    "RemoveSamplerState of a sampler state that isn't alive" );
+  ++mStats.mNumResourcesRemoved;
+}
+
+void RendererNull::AddSampler(
+  const char* samplerName,
+  TacShaderHandle shader,
+  TacShaderType shaderType,
+  u32 samplerIndex,
+  FixedString< DEFAULT_ERR_LEN >& errors )
+{
+  TacUnusedParameter( samplerName );
+  TacUnusedParameter( shaderType );
+  TacUnusedParameter( samplerIndex );
+  if( !mShaderResources.IsAlive( shader.mIndex ) )
+    errors = "AddSampler to a shader that isn't alive";
+}
+
+void RendererNull::SetSamplerState(
+  const char* samplerName,
+  TacSamplerStateHandle samplerState )
+{
+  if( mRecording )
+  {
+    std::vector< u8 > args;
+    AppendName( args, samplerName );
+    AppendBytes( args, &samplerState, sizeof( samplerState ) );
+    Record( TacNullCall::SetSamplerState, args.data(), ( u32 )args.size() );
+  }
+  else
+  {
+    Record( TacNullCall::SetSamplerState );
+  }
+  Validate(
+    mShaderResources.IsAlive( mCurrentShader.mIndex ),
+    "SetSamplerState without a shader" );
+  Validate(
+    mSamplerStateResources.IsAlive( samplerState.mIndex ),
+    "SetSamplerState with a sampler state that isn't alive" );
+
+  // samplers are bound by name per shader, so don't try to find repeats
+  CountStateChange( true );
+}
+
+void RendererNull::SetName(
+  TacSamplerStateHandle handle,
+  const char* name )
+{
+  TacUnusedParameter( name );
+  Validate(
+    mSamplerStateResources.IsAlive( handle.mIndex ),
+    "SetName of a sampler state that isn't alive" );
+}
+
+// texture --------------------------------------------------------------
+
+TacTextureHandle RendererNull::AddTextureResource(
+  const TacImage& myImage,
+  TacTextureUsage textureUsage,
+  TacBinding binding,
+  FixedString< DEFAULT_ERR_LEN >& errors )
+{
+  TacUnusedParameter( textureUsage );
+  TacUnusedParameter( binding );
+  TacUnusedParameter( errors );
+  TacTextureHandle result;
+  result.mIndex = mTextureResources.Add();
+  if( myImage.mData )
+  {
+    u32 numRows = Maximum( myImage.mHeight, 1u ) * Maximum( myImage.mDepth, 1u );
+    mStats.mNumBytesUploaded += myImage.mPitch * numRows;
+  }
+  ++mStats.mNumResourcesCreated;
+  return result;
+}
+
+void RendererNull::RemoveTextureResoure( TacTextureHandle texture )
+{
+  Validate(
+    mTextureResources.Remove( texture.mIndex ),
+    "RemoveTextureResoure of a texture that isn't alive" );
+  ++mStats.mNumResourcesRemoved;
+}
+
+void RendererNull::AddTexture(
+  const char* textureName,
+  TacShaderHandle shader,
+  TacShaderType shaderType,
+  u32 samplerIndex,
+  FixedString< DEFAULT_ERR_LEN >& errors )
+{
+  TacUnusedParameter( textureName );
+  TacUnusedParameter( shaderType );
+  TacUnusedParameter( samplerIndex );
+  if( !mShaderResources.IsAlive( shader.mIndex ) )
+    errors = "AddTexture to a shader that isn't alive";
+}
+
+void RendererNull::SetTexture(
+  const char* textureName,
+  TacTextureHandle texture )
+{
+  if( mRecording )
+  {
+    std::vector< u8 > args;
+    AppendName( args, textureName );
+    AppendBytes( args, &texture, sizeof( texture ) );
+    Record( TacNullCall::SetTexture, args.data(), ( u32 )args.size() );
+  }
+  else
+  {
+    Record( TacNullCall::SetTexture );
+  }
+  Validate(
+    mShaderResources.IsAlive( mCurrentShader.mIndex ),
+    "SetTexture without a shader" );
+  Validate(
+    texture.mIndex == RENDERER_ID_NONE ||
+    mTextureResources.IsAlive( texture.mIndex ),
+    "SetTexture with a texture that isn't alive" );
+  CountStateChange( true );
+}
+
+void RendererNull::SetName(
+  TacTextureHandle handle,
+  const char* name )
+{
+  TacUnusedParameter( name );
+  Validate(
+    mTextureResources.IsAlive( handle.mIndex ),
+    "SetName of a texture that isn't alive" );
+}
+
+// render targets -------------------------------------------------------
+
+TacDepthBufferHandle RendererNull::AddDepthBuffer(
+  u32 width,
+  u32 height,
+  TacTextureFormat textureFormat,
+  FixedString< DEFAULT_ERR_LEN >& errors )
+{
+  TacUnusedParameter( width );
+  TacUnusedParameter( height );
+  TacUnusedParameter( textureFormat );
+  TacUnusedParameter( errors );
+  TacDepthBufferHandle result;
+  result.mIndex = mDepthBufferResources.Add();
+  ++mStats.mNumResourcesCreated;
+  return result;
+}
+
+void RendererNull::RemoveDepthBuffer( TacDepthBufferHandle depthBufer )
+{
+  Validate(
+    mDepthBufferResources.Remove( depthBufer.mIndex ),
+    "RemoveDepthBuffer of a depth buffer that isn't alive" );
+  ++mStats.mNumResourcesRemoved;
+}
+
+void RendererNull::SetRenderTargets(
+  TacTextureHandle* renderTargets,
+  u32 numRenderTargets,
+  TacDepthBufferHandle depthBuffer )
+{
+  if( mRecording )
+  {
+    std::vector< u8 > args;
+    AppendBytes( args, &depthBuffer, sizeof( depthBuffer ) );
+    AppendBytes(
+      args,
+      renderTargets,
+      sizeof( TacTextureHandle ) * numRenderTargets );
+    Record( TacNullCall::SetRenderTargets, args.data(), ( u32 )args.size() );
+  }
+  else
+  {
+    Record( TacNullCall::SetRenderTargets );
+  }
+  for( u32 i = 0; i < numRenderTargets; ++i )
+  {
+    Validate(
+      mTextureResources.IsAlive( renderTargets[ i ].mIndex ),
+      "SetRenderTargets with a texture that isn't alive" );
+  }
+  Validate(
+    depthBuffer.mIndex == RENDERER_ID_NONE ||
+    mDepthBufferResources.IsAlive( depthBuffer.mIndex ),
+    "SetRenderTargets with a depth buffer that isn't alive" );
+  CountStateChange( true );
+}
+
+TacTextureHandle RendererNull::GetBackbufferColor()
+{
+  return mBackbufferColor;
+}
+
+TacDepthBufferHandle RendererNull::GetBackbufferDepth()
+{
+  return mBackbufferDepth;
+}
+
+void RendererNull::SetName(
+  TacDepthBufferHandle handle,
+  const char* name )
+{
+  TacUnusedParameter( name );
+  Validate(
+    mDepthBufferResources.IsAlive( handle.mIndex ),
+    "SetName of a depth buffer that isn't alive" );
+}
+
+// cbuffer --------------------------------------------------------------
+
+TacCBufferHandle RendererNull::LoadCbuffer(
+  const char* name,
+  TacConstant* constants,
+  u32 numConstants,
+  FixedString< DEFAULT_ERR_LEN >& errors )
+{
+  TacCBufferHandle result;
+  result.mIndex = RENDERER_ID_NONE;
+  if( numConstants > ArraySize( mCbuffers[ 0 ].mConstants ) )
+  {
+    errors = "Too many constants in cbuffer";
+    return result;
+  }
+
+  result.mIndex = mCbufferResources.Add();
+  ResizeForIndex( mCbuffers, result.mIndex );
+  TacNullCBuffer& cbuffer = mCbuffers[ result.mIndex ];
+  cbuffer.mName = name;
+  cbuffer.mNumConstants = numConstants;
+  for( u32 i = 0; i < numConstants; ++i )
+    cbuffer.mConstants[ i ] = constants[ i ];
+  ++mStats.mNumResourcesCreated;
+  return result;
+}
+
+void RendererNull::RemoveCbuffer( TacCBufferHandle cbuffer )
+{
+  Validate(
+    mCbufferResources.Remove( cbuffer.mIndex ),
+    "RemoveCbuffer of a cbuffer that isn't alive" );
+  ++mStats.mNumResourcesRemoved;
+}
+
+void RendererNull::AddCbuffer(
+  TacShaderHandle shader,
+  TacCBufferHandle cbuffer,
+  u32 cbufferRegister,
+  TacShaderType myShaderType,
+  FixedString< DEFAULT_ERR_LEN >& errors )
+{
+  TacUnusedParameter( cbufferRegister );
+  TacUnusedParameter( myShaderType );
+  if( !mShaderResources.IsAlive( shader.mIndex ) )
+  {
+    errors = "AddCbuffer to a shader that isn't alive";
+    return;
+  }
+  if( !mCbufferResources.IsAlive( cbuffer.mIndex ) )
+  {
+    errors = "AddCbuffer of a cbuffer that isn't alive";
+    return;
+  }
+
+  // the same cbuffer can be added for several shader types
+  TacNullShader& nullShader = mShaders[ shader.mIndex ];
+  for( u32 i = 0; i < nullShader.mNumCbuffers; ++i )
+  {
+    if( nullShader.mCbuffers[ i ].mIndex == cbuffer.mIndex )
+      return;
+  }
+  if( nullShader.mNumCbuffers == ArraySize( nullShader.mCbuffers ) )
+  {
+    errors = "Too many cbuffers in shader";
+    return;
+  }
+  nullShader.mCbuffers[ nullShader.mNumCbuffers++ ] = cbuffer;
+}
+
+void RendererNull::SetName(
+  TacCBufferHandle handle,
+  const char* name )
+{
+  TacUnusedParameter( name );
+  Validate(
+    mCbufferResources.IsAlive( handle.mIndex ),
+    "SetName of a cbuffer that isn't alive" );
+}
+
+TacUniformHandle RendererNull::GetUniformHandle( const char* name )
+{
+  TacUniformHandle result;
+  result.mIndex = RENDERER_ID_NONE;
+  for( u32 iCbuffer = 1; iCbuffer < mCbuffers.size(); ++iCbuffer )
+  {
+    if( !mCbufferResources.IsAlive( iCbuffer ) )
+      continue;
+    TacNullCBuffer& cbuffer = mCbuffers[ iCbuffer ];
+    for( u32 iConstant = 0; iConstant < cbuffer.mNumConstants; ++iConstant )
+    {
+      if( TacStrCmp( cbuffer.mConstants[ iConstant ].name.buffer, name ) )
+        continue;
+
+      // reuse the handle if it was asked for before
+      for( u32 iUniform = 1; iUniform < mUniforms.size(); ++iUniform )
+      {
+        TacNullUniform& uniform = mUniforms[ iUniform ];
+        if( uniform.mCBufferHandle.mIndex == ( s32 )iCbuffer &&
+          uniform.mConstantIndex == iConstant )
+        {
+          result.mIndex = iUniform;
+          return result;
+        }
+      }
+      TacNullUniform uniform;
+      uniform.mCBufferHandle.mIndex = iCbuffer;
+      uniform.mConstantIndex = iConstant;
+      result.mIndex = mUniforms.size();
+      mUniforms.push_back( uniform );
+      return result;
+    }
+  }
+  return result;
+}
+
+// blend state ----------------------------------------------------------
+
+TacBlendStateHandle RendererNull::AddBlendState(
+  TacBlendConstants srcRGB,
+  TacBlendConstants dstRGB,
+  TacBlendMode blendRGB,
+  TacBlendConstants srcA,
+  TacBlendConstants dstA,
+  TacBlendMode blendA,
+  FixedString< DEFAULT_ERR_LEN >& errors )
+{
+  TacUnusedParameter( srcRGB );
+  TacUnusedParameter( dstRGB );
+  TacUnusedParameter( blendRGB );
+  TacUnusedParameter( srcA );
+  TacUnusedParameter( dstA );
+  TacUnusedParameter( blendA );
+  TacUnusedParameter( errors );
+  TacBlendStateHandle result;
+  result.mIndex = mBlendStateResources.Add();
+  ++mStats.mNumResourcesCreated;
+  return result;
+}
+
+void RendererNull::RemoveBlendState( TacBlendStateHandle blendState )
+{
+  Validate(
+    mBlendStateResources.Remove( blendState.mIndex ),
+    "RemoveBlendState of a blend state that isn't alive" );
+  ++mStats.mNumResourcesRemoved;
+}
+
+void RendererNull::SetBlendState(
+  TacBlendStateHandle blendState,
+  v4 blendFactorRGBA,
+  u32 sampleMask )
+{
+  if( mRecording )
+  {
+    std::vector< u8 > args;
+    AppendBytes( args, &blendState, sizeof( blendState ) );
+    AppendBytes( args, &blendFactorRGBA, sizeof( blendFactorRGBA ) );
+    AppendBytes( args, &sampleMask, sizeof( sampleMask ) );
+    Record( TacNullCall::SetBlendState, args.data(), ( u32 )args.size() );
+  }
+  else
+  {
+    Record( TacNullCall::SetBlendState );
+  }
+  Validate(
+    mBlendStateResources.IsAlive( blendState.mIndex ),
+    "SetBlendState with a blend state that isn't alive" );
+  CountStateChange( blendState.mIndex != mCurrentBlendState.mIndex );
+  mCurrentBlendState = blendState;
+}
+
+void RendererNull::SetName(
+  TacBlendStateHandle handle,
+  const char* name )
+{
+  TacUnusedParameter( name );
+  Validate(
+    mBlendStateResources.IsAlive( handle.mIndex ),
+    "SetName of a blend state that isn't alive" );
+}
+
+// rasterizer state -----------------------------------------------------
+
+TacRasterizerStateHandle RendererNull::AddRasterizerState(
+  TacFillMode fillMode,
+  TacCullMode cullMode,
+  b32 frontCounterClockwise,
+  b32 scissor,
+  b32 multisample,
+  FixedString< DEFAULT_ERR_LEN >& errors )
+{
+  TacUnusedParameter( fillMode );
+  TacUnusedParameter( cullMode );
+  TacUnusedParameter( frontCounterClockwise );
+  TacUnusedParameter( scissor );
+  TacUnusedParameter( multisample );
+  TacUnusedParameter( errors );
+  TacRasterizerStateHandle result;
+  result.mIndex = mRasterizerStateResources.Add();
+  ++mStats.mNumResourcesCreated;
+  return result;
+}
+
+void RendererNull::RemoveRasterizerState(
+  TacRasterizerStateHandle rasterizerState )
+{
+  Validate(
+    mRasterizerStateResources.Remove( rasterizerState.mIndex ),
+    "RemoveRasterizerState of a rasterizer state that isn't alive" );
+  ++mStats.mNumResourcesRemoved;
+}
+
+void RendererNull::SetRasterizerState(
+  TacRasterizerStateHandle rasterizerState )
+{
+  Record(
+    TacNullCall::SetRasterizerState,
+    &rasterizerState,
+    sizeof( rasterizerState ) );
+  Validate(
+    mRasterizerStateResources.IsAlive( rasterizerState.mIndex ),
+    "SetRasterizerState with a rasterizer state that isn't alive" );
+  CountStateChange(
+    rasterizerState.mIndex != mCurrentRasterizerState.mIndex );
+  mCurrentRasterizerState = rasterizerState;
+}
+
+void RendererNull::SetName(
+  TacRasterizerStateHandle handle,
+  const char* name )
+{
+  TacUnusedParameter( name );
+  Validate(
+    mRasterizerStateResources.IsAlive( handle.mIndex ),
+    "SetName of a rasterizer state that isn't alive" );
+}
+
+// depth state ----------------------------------------------------------
+
+TacDepthStateHandle RendererNull::AddDepthState(
+  b32 depthTest,
+  b32 depthWrite,
+  TacDepthFunc depthFunc,
+  FixedString< DEFAULT_ERR_LEN >& errors )
+{
+  TacUnusedParameter( depthTest );
+  TacUnusedParameter( depthWrite );
+  TacUnusedParameter( depthFunc );
+  TacUnusedParameter( errors );
+  TacDepthStateHandle result;
+  result.mIndex = mDepthStateResources.Add();
+  ++mStats.mNumResourcesCreated;
+  return result;
+}
+
+void RendererNull::RemoveDepthState( TacDepthStateHandle depthState )
+{
+  Validate(
+    mDepthStateResources.Remove( depthState.mIndex ),
+    "RemoveDepthState of a depth state that isn't alive" );
+  ++mStats.mNumResourcesRemoved;
+}
+
+void RendererNull::SetDepthState(
+  TacDepthStateHandle depthState,
+  u32 stencilRef )
+{
+  TacUnusedParameter( stencilRef );
+  Record( TacNullCall::SetDepthState, &depthState, sizeof( depthState ) );
+  Validate(
+    mDepthStateResources.IsAlive( depthState.mIndex ),
+    "SetDepthState with a depth state that isn't alive" );
+  CountStateChange( depthState.mIndex != mCurrentDepthState.mIndex );
+  mCurrentDepthState = depthState;
+}
+
+void RendererNull::SetName(
+  TacDepthStateHandle handle,
+  const char* name )
+{
+  TacUnusedParameter( name );
+  Validate(
+    mDepthStateResources.IsAlive( handle.mIndex ),
+    "SetName of a depth state that isn't alive" );
+}
+
+// vertex format --------------------------------------------------------
+
+TacVertexFormatHandle RendererNull::AddVertexFormat(
+  TacVertexFormat* vertexFormats,
+  u32 numVertexFormats,
+  TacShaderHandle shader,
+  FixedString< DEFAULT_ERR_LEN >& errors )
+{
+  TacUnusedParameter( vertexFormats );
+  TacUnusedParameter( numVertexFormats );
+  TacVertexFormatHandle result;
+  result.mIndex = RENDERER_ID_NONE;
+  if( !mShaderResources.IsAlive( shader.mIndex ) )
+  {
+    errors = "AddVertexFormat with a shader that isn't alive";
+    return result;
+  }
+  result.mIndex = mVertexFormatResources.Add();
+  ++mStats.mNumResourcesCreated;
+  return result;
+}
+
+void RendererNull::RemoveVertexFormat( TacVertexFormatHandle vertexFormat )
+{
+  Validate(
+    mVertexFormatResources.Remove( vertexFormat.mIndex ),
+    "RemoveVertexFormat of a vertex format that isn't alive" );
+  ++mStats.mNumResourcesRemoved;
+}
+
+void RendererNull::SetVertexFormat( TacVertexFormatHandle vertexFormat )
+{
+  Record(
+    TacNullCall::SetVertexFormat,
+    &vertexFormat,
+    sizeof( vertexFormat ) );
+  Validate(
+    mVertexFormatResources.IsAlive( vertexFormat.mIndex ),
+    "SetVertexFormat with a vertex format that isn't alive" );
+  CountStateChange( vertexFormat.mIndex != mCurrentVertexFormat.mIndex );
+  mCurrentVertexFormat = vertexFormat;
+}
+
+void RendererNull::SetName(
+  TacVertexFormatHandle handle,
+  const char* name )
+{
+  TacUnusedParameter( name );
+  Validate(
+    mVertexFormatResources.IsAlive( handle.mIndex ),
+    "SetName of a vertex format that isn't alive" );
+}
+
+// etc ------------------------------------------------------------------
+
+void RendererNull::DebugBegin( const char* section )
+{
+  TacUnusedParameter( section );
+}
+
+void RendererNull::DebugMark( const char* remark )
+{
+  TacUnusedParameter( remark );
+}
+
+void RendererNull::DebugEnd()
+{
+}
+
+void RendererNull::Draw()
+{
+  Record( TacNullCall::Draw );
+  ValidateDraw();
+  Validate(
+    !mIndexBufferUpload.mActive,
+    "Draw with an upload index buffer, it has no count, use DrawIndexed" );
+  ++mStats.mNumDraws;
+  ++mStats.mNumInstances;
+  if( mIndexBufferResources.IsAlive( mCurrentIndexBuffer.mIndex ) )
+    mStats.mNumIndexes += mIndexBuffers[ mCurrentIndexBuffer.mIndex ].mNumElements;
+}
+
+void RendererNull::DrawIndexed(
+  u32 elementCount,
+  u32 idxOffset,
+  u32 vtxOffset )
+{
+  u32 args[] = { elementCount, idxOffset, vtxOffset };
+  Record( TacNullCall::DrawIndexed, args, sizeof( args ) );
+  ValidateDraw();
+  ++mStats.mNumDraws;
+  ++mStats.mNumInstances;
+  mStats.mNumIndexes += elementCount;
+}
+
+void RendererNull::DrawInstanced( u32 numInstances, u32 firstInstance )
+{
+  u32 args[] = { numInstances, firstInstance };
+  Record( TacNullCall::DrawInstanced, args, sizeof( args ) );
+  ValidateDraw();
+  Validate(
+    !mIndexBufferUpload.mActive,
+    "DrawInstanced with an upload index buffer, it has no count" );
+  ++mStats.mNumDraws;
+  mStats.mNumInstances += numInstances;
+  if( mIndexBufferResources.IsAlive( mCurrentIndexBuffer.mIndex ) )
+  {
+    mStats.mNumIndexes +=
+      mIndexBuffers[ mCurrentIndexBuffer.mIndex ].mNumElements * numInstances;
+  }
+}
+
+void RendererNull::DrawIndexedInstanced(
+  u32 elementCount,
+  u32 numInstances,
+  u32 idxOffset,
+  u32 vtxOffset,
+  u32 firstInstance )
+{
+  u32 args[] =
+  {
+    elementCount,
+    numInstances,
+    idxOffset,
+    vtxOffset,
+    firstInstance
+  };
+  Record( TacNullCall::DrawIndexedInstanced, args, sizeof( args ) );
+  ValidateDraw();
+  ++mStats.mNumDraws;
+  mStats.mNumInstances += numInstances;
+  mStats.mNumIndexes += elementCount * numInstances;
+}
+
+void RendererNull::SendUniform( const char* name, void* data, u32 size )
+{
+  if( mRecording )
+  {
+    std::vector< u8 > args;
+    AppendName( args, name );
+    AppendBytes( args, data, size );
+    Record( TacNullCall::SendUniform, args.data(), ( u32 )args.size() );
+  }
+  else
+  {
+    Record( TacNullCall::SendUniform );
+  }
+
+  // like the dx11 renderer, only the current shader's cbuffers are searched
+  b32 found = false;
+  if( mShaderResources.IsAlive( mCurrentShader.mIndex ) )
+  {
+    TacNullShader& shader = mShaders[ mCurrentShader.mIndex ];
+    for( u32 iCbuffer = 0; iCbuffer < shader.mNumCbuffers && !found; ++iCbuffer )
+    {
+      TacNullCBuffer& cbuffer = mCbuffers[ shader.mCbuffers[ iCbuffer ].mIndex ];
+      for( u32 iConstant = 0; iConstant < cbuffer.mNumConstants; ++iConstant )
+      {
+        TacConstant& constant = cbuffer.mConstants[ iConstant ];
+        if( TacStrCmp( constant.name.buffer, name ) )
+          continue;
+        Validate( size <= constant.size, "SendUniform is too big" );
+        found = true;
+        break;
+      }
+    }
+  }
+  Validate( found, "SendUniform of a name the shader doesn't have" );
+  mStats.mNumBytesUploaded += size;
+}
+
+void RendererNull::SendUniform(
+  TacUniformHandle uniform,
+  void* data,
+  u32 size )
+{
+  if( mRecording )
+  {
+    std::vector< u8 > args;
+    AppendBytes( args, &uniform, sizeof( uniform ) );
+    AppendBytes( args, data, size );
+    Record( TacNullCall::SendUniformHandle, args.data(), ( u32 )args.size() );
+  }
+  else
+  {
+    Record( TacNullCall::SendUniformHandle );
+  }
+
+  b32 valid =
+    uniform.mIndex > RENDERER_ID_NONE &&
+    uniform.mIndex < ( s32 )mUniforms.size() &&
+    mCbufferResources.IsAlive(
+      mUniforms[ uniform.mIndex ].mCBufferHandle.mIndex );
+  Validate( valid, "SendUniform with a uniform that isn't alive" );
+  if( valid )
+  {
+    TacNullUniform& nullUniform = mUniforms[ uniform.mIndex ];
+    TacNullCBuffer& cbuffer = mCbuffers[ nullUniform.mCBufferHandle.mIndex ];
+    TacConstant& constant = cbuffer.mConstants[ nullUniform.mConstantIndex ];
+    Validate( size <= constant.size, "SendUniform is too big" );
+  }
+  mStats.mNumBytesUploaded += size;
+}
+
+void RendererNull::Apply()
+{
+  Record( TacNullCall::Apply );
+  Validate(
+    mShaderResources.IsAlive( mCurrentShader.mIndex ),
+    "Apply without a shader" );
+}
+
+void RendererNull::SwapBuffers()
+{
+  Record( TacNullCall::SwapBuffers );
+  mLastFrameStats = mStats;
+  TacRendererNullStats empty = {};
+  mStats = empty;
+  ++mNumFrames;
+  mUploadHead = 0;
+}
+
+void RendererNull::SetViewport(
+  r32 xRelBotLeftCorner,
+  r32 yRelBotLeftCorner,
+  r32 wIncreasingRight,
+  r32 hIncreasingUp )
+{
+  r32 args[] =
+  {
+    xRelBotLeftCorner,
+    yRelBotLeftCorner,
+    wIncreasingRight,
+    hIncreasingUp
+  };
+  Record( TacNullCall::SetViewport, args, sizeof( args ) );
+  CountStateChange( true );
+}
+
+void RendererNull::SetPrimitiveTopology( TacPrimitive primitive )
+{
+  Record( TacNullCall::SetPrimitiveTopology, &primitive, sizeof( primitive ) );
+  CountStateChange( true );
+}
+
+void RendererNull::SetScissorRect(
+  float x1,
+  float y1,
+  float x2,
+  float y2 )
+{
+  r32 args[] = { x1, y1, x2, y2 };
+  Record( TacNullCall::SetScissorRect, args, sizeof( args ) );
+  CountStateChange( true );
+}
+
+void RendererNull::GetPerspectiveProjectionAB(
+  r32 f,
+  r32 n,
+  r32& A,
+  r32& B )
+{
+  TacAssert( f >= n ); // make sure you didnt switch them
+
+  // Same as the dx11 renderer, ( A, B ) maps ( -n, -f ) to ( 0, 1 )
+  B = n * ( A = f / ( n - f ) );
+}
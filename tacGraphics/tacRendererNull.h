@@ -0,0 +1,530 @@
+#pragma once
+
+// tac
+#include "tacRenderer.h"
+#include "tacLibrary/tacPlatform.h"
+
+// stl
+#include <vector>
+
+// A TacRenderer that doesn't draw anything.
+// It checks that handles are alive when they're used, and counts calls,
+// draws, uploaded bytes and state changes, so everything above the gpu api
+// can be run and timed without a device.
+// It can also record the calls it gets and save them to a file.
+
+struct TacRendererNullStats
+{
+  u32 mNumCalls;
+  u32 mNumDraws;
+  u32 mNumInstances;
+  u32 mNumIndexes;
+  // sets that changed what was bound
+  u32 mNumStateChanges;
+  // sets of what was already bound
+  u32 mNumRedundantStateChanges;
+  // buffer and texture data, uniforms
+  u64 mNumBytesUploaded;
+  u32 mNumResourcesCreated;
+  u32 mNumResourcesRemoved;
+  u32 mNumValidationErrors;
+};
+
+// The recorded file is a sequence of
+//   u32 TacNullCall
+//   u32 size of the arguments that follow, in bytes
+//   the arguments, as they were passed
+// Handles are recorded as their s32 mIndex, names as null terminated strings
+enum class TacNullCall
+{
+  SetVertexBuffers,
+  SetIndexBuffer,
+  ClearColor,
+  ClearDepthStencil,
+  SetActiveShader,
+  SetSamplerState,
+  SetTexture,
+  SetRenderTargets,
+  SetBlendState,
+  SetRasterizerState,
+  SetDepthState,
+  SetVertexFormat,
+  Draw,
+  DrawIndexed,
+  DrawInstanced,
+  DrawIndexedInstanced,
+  SendUniform,
+  Apply,
+  SwapBuffers,
+  SetViewport,
+  SetPrimitiveTopology,
+  SetScissorRect,
+  SetVertexBufferUpload,
+  SetIndexBufferUpload,
+  // SendUniform by TacUniformHandle rather than by name
+  SendUniformHandle,
+  Count
+};
+
+const char* NullCallToString( TacNullCall call );
+
+// Which handles are alive. Like the other renderers, index 0 is
+// RENDERER_ID_NONE and is never given out
+struct TacNullResources
+{
+  std::vector< b32 > mAlive;
+  std::vector< u32 > mFreeIndexes;
+
+  s32 Add();
+  // returns false if index wasn't alive
+  b32 Remove( s32 index );
+  b32 IsAlive( s32 index );
+};
+
+// Grows a vector that goes with a TacNullResources so index is in range
+template< typename T >
+void ResizeForIndex( std::vector< T >& v, s32 index )
+{
+  if( index >= ( s32 )v.size() )
+    v.resize( index + 1 );
+}
+
+struct TacNullBuffer
+{
+  std::vector< u8 > mMemory;
+  u32 mNumElements;
+};
+
+struct TacNullCBuffer
+{
+  FixedString< 32 > mName;
+  TacConstant mConstants[ 10 ];
+  u32 mNumConstants;
+};
+
+struct TacNullShader
+{
+  TacCBufferHandle mCbuffers[ 10 ];
+  u32 mNumCbuffers;
+};
+
+// Memory from AllocateUpload() bound in place of a buffer
+struct TacNullUploadBinding
+{
+  b32 mActive;
+  u32 mOffset;
+  // vertex stride, or index size
+  u32 mStride;
+};
+
+struct TacNullUniform
+{
+  TacCBufferHandle mCBufferHandle;
+  u32 mConstantIndex;
+};
+
+struct RendererNull : public TacRenderer
+{
+  RendererNull( u32 width, u32 height );
+
+  // vertex buffer --------------------------------------------------------
+
+  TacVertexBufferHandle AddVertexBuffer(
+    TacBufferAccess access,
+    void* data,
+    u32 numVertexes,
+    u32 stride,
+    FixedString< DEFAULT_ERR_LEN >& errors ) override;
+
+  void RemoveVertexBuffer( TacVertexBufferHandle vertexBuffer ) override;
+
+  void SetVertexBuffers(
+    const TacVertexBufferHandle* vertexBuffers,
+    u32 numVertexBuffers ) override;
+
+  void MapVertexBuffer(
+    void** data,
+    TacMap mapType,
+    FixedString< DEFAULT_ERR_LEN >& errors ) override;
+
+  void UnmapVertexBuffer(
+    FixedString< DEFAULT_ERR_LEN >& errors ) override;
+
+  void SetName(
+    TacVertexBufferHandle handle,
+    const char* name ) override;
+
+  static const u32 VERTEX_BUFFERS_PER_DRAW = 16;
+  TacNullResources mVertexBufferResources;
+  std::vector< TacNullBuffer > mVertexBuffers;
+  TacVertexBufferHandle mCurrentVertexBuffers[ VERTEX_BUFFERS_PER_DRAW ];
+  u32 mNumCurrentVertexBuffers;
+
+  // index buffer ---------------------------------------------------------
+
+  TacIndexBufferHandle AddIndexBuffer(
+    TacBufferAccess access,
+    void* data,
+    u32 numIndexes,
+    TacTextureFormat dataType,
+    u32 totalBufferSize,
+    FixedString< DEFAULT_ERR_LEN >& errors ) override;
+
+  void RemoveIndexBuffer( TacIndexBufferHandle indexBuffer ) override;
+
+  void SetIndexBuffer( TacIndexBufferHandle indexBuffer ) override;
+
+  void MapIndexBuffer(
+    void** data,
+    TacMap mapType,
+    FixedString< DEFAULT_ERR_LEN >& errors ) override;
+
+  void UnmapIndexBuffer(
+    FixedString< DEFAULT_ERR_LEN >& errors ) override;
+
+  void SetName(
+    TacIndexBufferHandle handle,
+    const char* name ) override;
+
+  TacNullResources mIndexBufferResources;
+  std::vector< TacNullBuffer > mIndexBuffers;
+  TacIndexBufferHandle mCurrentIndexBuffer;
+
+  // upload ring ----------------------------------------------------------
+
+  TacUploadAllocation AllocateUpload( u32 size, u32 alignment ) override;
+
+  void SetVertexBufferUpload(
+    u32 inputSlot,
+    u32 offset,
+    u32 stride ) override;
+
+  void SetIndexBufferUpload(
+    u32 offset,
+    TacTextureFormat indexFormat ) override;
+
+  // Not a ring, there's no gpu to wait for. It's all handed out again
+  // after SwapBuffers()
+  static const u32 UPLOAD_MEMORY_SIZE = 8 * 1024 * 1024;
+  std::vector< u8 > mUploadMemory;
+  u32 mUploadHead;
+
+  // cleared by SetVertexBuffers() and SetIndexBuffer()
+  TacNullUploadBinding mVertexBufferUploads[ VERTEX_BUFFERS_PER_DRAW ];
+  TacNullUploadBinding mIndexBufferUpload;
+  TacTextureFormat mIndexBufferUploadFormat;
+
+  // clear ----------------------------------------------------------------
+
+  void ClearColor(
+    TacTextureHandle textureHandle,
+    v4 rgba ) override;
+
+  void ClearDepthStencil(
+    TacDepthBufferHandle depthBufferHandle,
+    b32 clearDepth,
+    r32 depth,
+    b32 clearStencil,
+    u8 stencil ) override;
+
+  // shader ---------------------------------------------------------------
+
+  TacShaderHandle LoadShader(
+    const char* paths[ ( u32 )TacShaderType::Count ],
+    const char* entryPoints[ ( u32 )TacShaderType::Count ],
+    const char* shaderModels[ ( u32 )TacShaderType::Count ],
+    FixedString< DEFAULT_ERR_LEN >& errors ) override;
+
+  void RemoveShader( TacShaderHandle shader ) override;
+
+  void ReloadShader( TacShaderHandle shader ) override;
+
+  TacShaderHandle LoadShaderFromString(
+    const char* shaderStr[ ( u32 )TacShaderType::Count ],
+    const char* entryPoints[ ( u32 )TacShaderType::Count ],
+    const char* shaderModels[ ( u32 )TacShaderType::Count ],
+    FixedString< DEFAULT_ERR_LEN >& errors ) override;
+
+  void SetActiveShader( TacShaderHandle shader ) override;
+
+  TacShaderHandle GetCurrentlyBoundShader() override;
+
+  void SetName(
+    TacShaderHandle handle,
+    const char* name ) override;
+
+  TacNullResources mShaderResources;
+  std::vector< TacNullShader > mShaders;
+  TacShaderHandle mCurrentShader;
+
+  // sampler state --------------------------------------------------------
+
+  TacSamplerStateHandle AddSamplerState(
+    const TacAddressMode u,
+    const TacAddressMode v,
+    const TacAddressMode w,
+    TacComparison compare,
+    TacFilter filter,
+    FixedString< DEFAULT_ERR_LEN >& errors ) override;
+
+  void RemoveSamplerState( TacSamplerStateHandle samplerState ) override;
+
+  void AddSampler(
+    const char* samplerName,
+    TacShaderHandle shader,
+    TacShaderType shaderType,
+    u32 samplerIndex,
+    FixedString< DEFAULT_ERR_LEN >& errors ) override;
+
+  void SetSamplerState(
+    const char* samplerName,
+    TacSamplerStateHandle samplerState ) override;
+
+  void SetName(
+    TacSamplerStateHandle handle,
+    const char* name ) override;
+
+  TacNullResources mSamplerStateResources;
+
+  // texture --------------------------------------------------------------
+
+  TacTextureHandle AddTextureResource(
+    const TacImage& myImage,
+    TacTextureUsage textureUsage,
+    TacBinding binding,
+    FixedString< DEFAULT_ERR_LEN >& errors ) override;
+
+  void RemoveTextureResoure( TacTextureHandle texture ) override;
+
+  void AddTexture(
+    const char* textureName,
+    TacShaderHandle shader,
+    TacShaderType shaderType,
+    u32 samplerIndex,
+    FixedString< DEFAULT_ERR_LEN >& errors ) override;
+
+  void SetTexture(
+    const char* textureName,
+    TacTextureHandle texture ) override;
+
+  void SetName(
+    TacTextureHandle handle,
+    const char* name ) override;
+
+  TacNullResources mTextureResources;
+
+  // render targets -------------------------------------------------------
+
+  TacDepthBufferHandle AddDepthBuffer(
+    u32 width,
+    u32 height,
+    TacTextureFormat textureFormat,
+    FixedString< DEFAULT_ERR_LEN >& errors ) override;
+
+  void RemoveDepthBuffer( TacDepthBufferHandle depthBufer ) override;
+
+  void SetRenderTargets(
+    TacTextureHandle* renderTargets,
+    u32 numRenderTargets,
+    TacDepthBufferHandle depthBuffer ) override;
+
+  TacTextureHandle GetBackbufferColor() override;
+  TacDepthBufferHandle GetBackbufferDepth() override;
+
+  void SetName(
+    TacDepthBufferHandle handle,
+    const char* name ) override;
+
+  TacNullResources mDepthBufferResources;
+  TacTextureHandle mBackbufferColor;
+  TacDepthBufferHandle mBackbufferDepth;
+
+  // cbuffer --------------------------------------------------------------
+
+  TacCBufferHandle LoadCbuffer(
+    const char* name,
+    TacConstant* constants,
+    u32 numConstants,
+    FixedString< DEFAULT_ERR_LEN >& errors ) override;
+
+  void RemoveCbuffer( TacCBufferHandle cbuffer ) override;
+
+  void AddCbuffer(
+    TacShaderHandle shader,
+    TacCBufferHandle cbuffer,
+    u32 cbufferRegister,
+    TacShaderType myShaderType,
+    FixedString< DEFAULT_ERR_LEN >& errors ) override;
+
+  void SetName(
+    TacCBufferHandle handle,
+    const char* name ) override;
+
+  TacUniformHandle GetUniformHandle( const char* name ) override;
+
+  TacNullResources mCbufferResources;
+  std::vector< TacNullCBuffer > mCbuffers;
+
+  // indexed by TacUniformHandle
+  std::vector< TacNullUniform > mUniforms;
+
+  // blend state ----------------------------------------------------------
+
+  TacBlendStateHandle AddBlendState(
+    TacBlendConstants srcRGB,
+    TacBlendConstants dstRGB,
+    TacBlendMode blendRGB,
+    TacBlendConstants srcA,
+    TacBlendConstants dstA,
+    TacBlendMode blendA,
+    FixedString< DEFAULT_ERR_LEN >& errors ) override;
+
+  void RemoveBlendState( TacBlendStateHandle blendState ) override;
+
+  void SetBlendState(
+    TacBlendStateHandle blendState,
+    v4 blendFactorRGBA,
+    u32 sampleMask ) override;
+
+  void SetName(
+    TacBlendStateHandle handle,
+    const char* name ) override;
+
+  TacNullResources mBlendStateResources;
+  TacBlendStateHandle mCurrentBlendState;
+
+  // rasterizer state -----------------------------------------------------
+
+  TacRasterizerStateHandle AddRasterizerState(
+    TacFillMode fillMode,
+    TacCullMode cullMode,
+    b32 frontCounterClockwise,
+    b32 scissor,
+    b32 multisample,
+    FixedString< DEFAULT_ERR_LEN >& errors ) override;
+
+  void RemoveRasterizerState(
+    TacRasterizerStateHandle rasterizerState ) override;
+
+  void SetRasterizerState(
+    TacRasterizerStateHandle rasterizerState ) override;
+
+  void SetName(
+    TacRasterizerStateHandle handle,
+    const char* name ) override;
+
+  TacNullResources mRasterizerStateResources;
+  TacRasterizerStateHandle mCurrentRasterizerState;
+
+  // depth state ----------------------------------------------------------
+
+  TacDepthStateHandle AddDepthState(
+    b32 depthTest,
+    b32 depthWrite,
+    TacDepthFunc depthFunc,
+    FixedString< DEFAULT_ERR_LEN >& errors ) override;
+
+  void RemoveDepthState( TacDepthStateHandle depthState ) override;
+
+  void SetDepthState(
+    TacDepthStateHandle depthState,
+    u32 stencilRef ) override;
+
+  void SetName(
+    TacDepthStateHandle handle,
+    const char* name ) override;
+
+  TacNullResources mDepthStateResources;
+  TacDepthStateHandle mCurrentDepthState;
+
+  // vertex format --------------------------------------------------------
+
+  TacVertexFormatHandle AddVertexFormat(
+    TacVertexFormat* vertexFormats,
+    u32 numVertexFormats,
+    TacShaderHandle shader,
+    FixedString< DEFAULT_ERR_LEN >& errors ) override;
+
+  void RemoveVertexFormat( TacVertexFormatHandle vertexFormat ) override;
+
+  void SetVertexFormat( TacVertexFormatHandle vertexFormat ) override;
+
+  void SetName(
+    TacVertexFormatHandle handle,
+    const char* name ) override;
+
+  TacNullResources mVertexFormatResources;
+  TacVertexFormatHandle mCurrentVertexFormat;
+
+  // etc ------------------------------------------------------------------
+
+  void DebugBegin( const char* section ) override;
+  void DebugMark( const char* remark ) override;
+  void DebugEnd() override;
+
+  void Draw() override;
+  void DrawIndexed(
+    u32 elementCount,
+    u32 idxOffset,
+    u32 vtxOffset ) override;
+  void DrawInstanced( u32 numInstances, u32 firstInstance ) override;
+  void DrawIndexedInstanced(
+    u32 elementCount,
+    u32 numInstances,
+    u32 idxOffset,
+    u32 vtxOffset,
+    u32 firstInstance ) override;
+  void SendUniform( const char* name, void* data, u32 size ) override;
+  void SendUniform(
+    TacUniformHandle uniform,
+    void* data,
+    u32 size ) override;
+  void Apply() override;
+  // ends the frame, mStats moves to mLastFrameStats
+  void SwapBuffers() override;
+  void SetViewport(
+    r32 xRelBotLeftCorner,
+    r32 yRelBotLeftCorner,
+    r32 wIncreasingRight,
+    r32 hIncreasingUp ) override;
+  void SetPrimitiveTopology( TacPrimitive primitive ) override;
+  void SetScissorRect(
+    float x1,
+    float y1,
+    float x2,
+    float y2 ) override;
+  void GetPerspectiveProjectionAB(
+    r32 f,
+    r32 n,
+    r32& A,
+    r32& B ) override;
+
+  // non-virtual ---
+
+  // Counts a validation error, and keeps the first one in mFirstError
+  // so a headless run can report it instead of asserting
+  void Validate( b32 valid, const char* error );
+  void ValidateDraw();
+  void CountStateChange( b32 changed );
+  void Record( TacNullCall call, const void* data, u32 size );
+  void Record( TacNullCall call )
+  {
+    Record( call, nullptr, 0 );
+  }
+
+  void SaveRecording(
+    TacThreadContext* thread,
+    const char* filepath,
+    FixedString< DEFAULT_ERR_LEN >& errors );
+
+  TacRendererNullStats mStats;
+  TacRendererNullStats mLastFrameStats;
+  FixedString< DEFAULT_ERR_LEN > mFirstError;
+  u32 mNumFrames;
+
+  b32 mRecording;
+  std::vector< u8 > mRecord;
+
+  u32 mWidth;
+  u32 mHeight;
+};
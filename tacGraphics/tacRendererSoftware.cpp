@@ -0,0 +1,1213 @@
+#include "tacRendererSoftware.h"
+#include "tacLibrary/tacIntrinsics.h"
+
+#include <xmmintrin.h> // sse
+
+internalFunction u32 PackColor( v4 rgba )
+{
+  u32 result = 0;
+  for( u32 i = 0; i < 4; ++i )
+  {
+    r32 component = rgba[ i ];
+    Clamp( component, 0.0f, 1.0f );
+    result |= ( u32 )( component * 255.0f + 0.5f ) << ( i * 8 );
+  }
+  return result;
+}
+
+internalFunction v4 UnpackColor( u32 rgba )
+{
+  v4 result;
+  for( u32 i = 0; i < 4; ++i )
+    result[ i ] = ( ( rgba >> ( i * 8 ) ) & 0xff ) / 255.0f;
+  return result;
+}
+
+internalFunction v4 ReadAttribute( const u8* data, TacTextureFormat format )
+{
+  v4 result = V4( 0.0f, 0.0f, 0.0f, 1.0f );
+  switch( format )
+  {
+    case TacTextureFormat::R32Float:
+    case TacTextureFormat::RG32Float:
+    case TacTextureFormat::RGB32Float:
+    case TacTextureFormat::RGBA32Float:
+    {
+      u32 numComponents =
+        format == TacTextureFormat::R32Float ? 1 :
+        format == TacTextureFormat::RG32Float ? 2 :
+        format == TacTextureFormat::RGB32Float ? 3 : 4;
+      for( u32 i = 0; i < numComponents; ++i )
+        result[ i ] = ( ( const r32* )data )[ i ];
+    } break;
+    case TacTextureFormat::RGBA8Unorm:
+    {
+      for( u32 i = 0; i < 4; ++i )
+        result[ i ] = data[ i ] / 255.0f;
+    } break;
+    case TacTextureFormat::RGBA8Snorm:
+    {
+      for( u32 i = 0; i < 4; ++i )
+        result[ i ] = Maximum( ( ( const s8* )data )[ i ] / 127.0f, -1.0f );
+    } break;
+    case TacTextureFormat::RGBA8Uint:
+    {
+      for( u32 i = 0; i < 4; ++i )
+        result[ i ] = ( r32 )data[ i ];
+    } break;
+    case TacTextureFormat::R16Uint:
+    {
+      result.x = ( r32 )( ( const u16* )data )[ 0 ];
+    } break;
+    case TacTextureFormat::R32Uint:
+    {
+      result.x = ( r32 )( ( const u32* )data )[ 0 ];
+    } break;
+
+    // no vertex format uses these yet
+    case TacTextureFormat::Unknown:
+    case TacTextureFormat::RGBA16Float:
+    case TacTextureFormat::D24S8:
+      break;
+    TacInvalidDefaultCase;
+  }
+  return result;
+}
+
+// shader context -------------------------------------------------------
+
+v4 TacSoftwareShaderContext::GetAttribute(
+  TacAttributeType attributeType,
+  u32 semanticIndex ) const
+{
+  v4 result = V4( 0.0f, 0.0f, 0.0f, 1.0f );
+  const std::vector< TacVertexFormat >& vertexFormats =
+    mRenderer->mVertexFormats[ mRenderer->mCurrentVertexFormat.mIndex ];
+  u32 iSemantic = 0;
+  for( const TacVertexFormat& vertexFormat : vertexFormats )
+  {
+    if( vertexFormat.mAttributeType != attributeType )
+      continue;
+    if( iSemantic++ != semanticIndex )
+      continue;
+    if( vertexFormat.mInputSlot >= mRenderer->mNumCurrentVertexBuffers )
+      break;
+    b32 perInstance =
+      attributeType == TacAttributeType::InstanceWorld ||
+      attributeType == TacAttributeType::InstanceColor;
+    u32 iElement = perInstance ? mInstanceIndex : mVertexIndex;
+    const TacNullUploadBinding& upload =
+      mRenderer->mVertexBufferUploads[ vertexFormat.mInputSlot ];
+    if( upload.mActive )
+    {
+      u64 end = ( u64 )upload.mOffset + ( u64 )( iElement + 1 ) * upload.mStride;
+      if( end > mRenderer->mUploadMemory.size() )
+        break;
+      const u8* data =
+        mRenderer->mUploadMemory.data() +
+        upload.mOffset +
+        iElement * upload.mStride +
+        vertexFormat.mAlignedByteOffset;
+      result = ReadAttribute( data, vertexFormat.textureFormat );
+      break;
+    }
+    TacVertexBufferHandle vertexBuffer =
+      mRenderer->mCurrentVertexBuffers[ vertexFormat.mInputSlot ];
+    if( !mRenderer->mVertexBufferResources.IsAlive( vertexBuffer.mIndex ) )
+      break;
+    const TacNullBuffer& buffer =
+      mRenderer->mVertexBuffers[ vertexBuffer.mIndex ];
+    if( iElement >= buffer.mNumElements )
+      break;
+    u32 stride = ( u32 )buffer.mMemory.size() / buffer.mNumElements;
+    const u8* data =
+      buffer.mMemory.data() +
+      iElement * stride +
+      vertexFormat.mAlignedByteOffset;
+    result = ReadAttribute( data, vertexFormat.textureFormat );
+    break;
+  }
+  return result;
+}
+
+const void* TacSoftwareShaderContext::GetUniform(
+  TacUniformHandle uniform ) const
+{
+  if( uniform.mIndex <= RENDERER_ID_NONE ||
+    uniform.mIndex >= ( s32 )mRenderer->mUniforms.size() )
+    return nullptr;
+  const TacNullUniform& nullUniform = mRenderer->mUniforms[ uniform.mIndex ];
+  const TacNullCBuffer& cbuffer =
+    mRenderer->mCbuffers[ nullUniform.mCBufferHandle.mIndex ];
+  const TacConstant& constant =
+    cbuffer.mConstants[ nullUniform.mConstantIndex ];
+  const std::vector< u8 >& memory =
+    mRenderer->mCbufferMemory[ nullUniform.mCBufferHandle.mIndex ];
+  return memory.data() + constant.offset;
+}
+
+v4 TacSoftwareShaderContext::Sample( const char* textureName, v2 uv ) const
+{
+  v4 result = V4( 0.0f, 0.0f, 0.0f, 1.0f );
+  for( u32 i = 0; i < mRenderer->mNumBoundTextures; ++i )
+  {
+    const TacSoftwareBoundTexture& boundTexture =
+      mRenderer->mBoundTextures[ i ];
+    if( TacStrCmp( boundTexture.mName.buffer, textureName ) )
+      continue;
+    if( !mRenderer->mTextureResources.IsAlive(
+      boundTexture.mTexture.mIndex ) )
+      break;
+    const TacSoftwareTexture& texture =
+      mRenderer->mTextures[ boundTexture.mTexture.mIndex ];
+    if( !texture.mWidth || !texture.mHeight )
+      break;
+    r32 u = uv.x - floorf( uv.x );
+    r32 v = uv.y - floorf( uv.y );
+    u32 x = Minimum( ( u32 )( u * texture.mWidth ), texture.mWidth - 1 );
+    u32 y = Minimum( ( u32 )( v * texture.mHeight ), texture.mHeight - 1 );
+    result = UnpackColor( texture.mTexels[ y * texture.mPitch + x ] );
+    break;
+  }
+  return result;
+}
+
+// renderer -------------------------------------------------------------
+
+RendererSoftware::RendererSoftware(
+  u32 width,
+  u32 height,
+  TacWorkQueue* queue,
+  TacThreadContext* thread ) : RendererNull( width, height )
+{
+  mQueue = queue;
+  mThread = thread;
+
+  ResizeForIndex( mTextures, mBackbufferColor.mIndex );
+  TacSoftwareTexture& backbufferColor = mTextures[ mBackbufferColor.mIndex ];
+  backbufferColor.mWidth = width;
+  backbufferColor.mHeight = height;
+  backbufferColor.mPitch = RoundUpToNearestMultiple( width, 4 );
+  backbufferColor.mTexels.assign( backbufferColor.mPitch * height, 0 );
+
+  ResizeForIndex( mDepthBuffers, mBackbufferDepth.mIndex );
+  TacSoftwareDepthBuffer& backbufferDepth =
+    mDepthBuffers[ mBackbufferDepth.mIndex ];
+  backbufferDepth.mWidth = width;
+  backbufferDepth.mHeight = height;
+  backbufferDepth.mPitch = RoundUpToNearestMultiple( width, 4 );
+  backbufferDepth.mDepths.assign( backbufferDepth.mPitch * height, 1.0f );
+
+  mCurrentRenderTarget = mBackbufferColor;
+  mCurrentDepthBuffer = mBackbufferDepth;
+  mNumBoundTextures = 0;
+
+  mViewportX = 0;
+  mViewportY = 0;
+  mViewportW = ( r32 )width;
+  mViewportH = ( r32 )height;
+  mScissorMinX = 0;
+  mScissorMinY = 0;
+  mScissorMaxX = width;
+  mScissorMaxY = height;
+
+  mNumTilesX = 0;
+  mNumTilesY = 0;
+  mNumPixelsShaded = 0;
+  mLastFrameNumPixelsShaded = 0;
+}
+
+// index buffer ---------------------------------------------------------
+
+TacIndexBufferHandle RendererSoftware::AddIndexBuffer(
+  TacBufferAccess access,
+  void* data,
+  u32 numIndexes,
+  TacTextureFormat dataType,
+  u32 totalBufferSize,
+  FixedString< DEFAULT_ERR_LEN >& errors )
+{
+  if( dataType != TacTextureFormat::R16Uint &&
+    dataType != TacTextureFormat::R32Uint )
+  {
+    TacIndexBufferHandle result;
+    result.mIndex = RENDERER_ID_NONE;
+    errors = "Index buffers must be R16Uint or R32Uint";
+    return result;
+  }
+  TacIndexBufferHandle result = RendererNull::AddIndexBuffer(
+    access,
+    data,
+    numIndexes,
+    dataType,
+    totalBufferSize,
+    errors );
+  ResizeForIndex( mIndexFormats, result.mIndex );
+  mIndexFormats[ result.mIndex ] = dataType;
+  return result;
+}
+
+// clear ----------------------------------------------------------------
+
+void RendererSoftware::ClearColor(
+  TacTextureHandle textureHandle,
+  v4 rgba )
+{
+  RendererNull::ClearColor( textureHandle, rgba );
+  if( !mTextureResources.IsAlive( textureHandle.mIndex ) )
+    return;
+  TacSoftwareTexture& texture = mTextures[ textureHandle.mIndex ];
+  std::fill( texture.mTexels.begin(), texture.mTexels.end(), PackColor( rgba ) );
+}
+
+void RendererSoftware::ClearDepthStencil(
+  TacDepthBufferHandle depthBufferHandle,
+  b32 clearDepth,
+  r32 depth,
+  b32 clearStencil,
+  u8 stencil )
+{
+  RendererNull::ClearDepthStencil(
+    depthBufferHandle,
+    clearDepth,
+    depth,
+    clearStencil,
+    stencil );
+  if( !clearDepth || !mDepthBufferResources.IsAlive( depthBufferHandle.mIndex ) )
+    return;
+  TacSoftwareDepthBuffer& depthBuffer = mDepthBuffers[ depthBufferHandle.mIndex ];
+  std::fill( depthBuffer.mDepths.begin(), depthBuffer.mDepths.end(), depth );
+}
+
+// shader ---------------------------------------------------------------
+
+TacShaderHandle RendererSoftware::LoadShader(
+  const char* paths[ ( u32 )TacShaderType::Count ],
+  const char* entryPoints[ ( u32 )TacShaderType::Count ],
+  const char* shaderModels[ ( u32 )TacShaderType::Count ],
+  FixedString< DEFAULT_ERR_LEN >& errors )
+{
+  TacShaderHandle result =
+    RendererNull::LoadShader( paths, entryPoints, shaderModels, errors );
+  if( errors.size )
+    return result;
+  ResizeForIndex( mSoftwareShaders, result.mIndex );
+  TacSoftwareShader empty = {};
+  mSoftwareShaders[ result.mIndex ] = empty;
+  return result;
+}
+
+void RendererSoftware::SetShaderCallbacks(
+  TacShaderHandle shader,
+  TacSoftwareVertexShader* vertexShader,
+  TacSoftwarePixelShader* pixelShader,
+  u32 numVaryings )
+{
+  Validate(
+    mShaderResources.IsAlive( shader.mIndex ),
+    "SetShaderCallbacks of a shader that isn't alive" );
+  Validate(
+    numVaryings <= SOFTWARE_MAX_VARYINGS,
+    "SetShaderCallbacks with too many varyings" );
+  if( !mShaderResources.IsAlive( shader.mIndex ) )
+    return;
+  TacSoftwareShader& softwareShader = mSoftwareShaders[ shader.mIndex ];
+  softwareShader.mVertexShader = vertexShader;
+  softwareShader.mPixelShader = pixelShader;
+  softwareShader.mNumVaryings = Minimum( numVaryings, SOFTWARE_MAX_VARYINGS );
+}
+
+// texture --------------------------------------------------------------
+
+TacTextureHandle RendererSoftware::AddTextureResource(
+  const TacImage& myImage,
+  TacTextureUsage textureUsage,
+  TacBinding binding,
+  FixedString< DEFAULT_ERR_LEN >& errors )
+{
+  TacTextureHandle result = RendererNull::AddTextureResource(
+    myImage,
+    textureUsage,
+    binding,
+    errors );
+  if( errors.size )
+    return result;
+
+  ResizeForIndex( mTextures, result.mIndex );
+  TacSoftwareTexture& texture = mTextures[ result.mIndex ];
+  texture.mWidth = myImage.mWidth;
+  texture.mHeight = Maximum( myImage.mHeight, 1u );
+  texture.mPitch = RoundUpToNearestMultiple( texture.mWidth, 4 );
+  texture.mTexels.assign( texture.mPitch * texture.mHeight, 0 );
+
+  // other formats are only drawn to, or read as black
+  if( myImage.mData && myImage.mTextureFormat == TacTextureFormat::RGBA8Unorm )
+  {
+    for( u32 y = 0; y < texture.mHeight; ++y )
+    {
+      memcpy(
+        &texture.mTexels[ y * texture.mPitch ],
+        myImage.mData + y * myImage.mPitch,
+        texture.mWidth * sizeof( u32 ) );
+    }
+  }
+  return result;
+}
+
+void RendererSoftware::RemoveTextureResoure( TacTextureHandle texture )
+{
+  RendererNull::RemoveTextureResoure( texture );
+  if( texture.mIndex > 0 && texture.mIndex < ( s32 )mTextures.size() )
+  {
+    TacSoftwareTexture empty = {};
+    mTextures[ texture.mIndex ] = empty;
+  }
+}
+
+void RendererSoftware::SetTexture(
+  const char* textureName,
+  TacTextureHandle texture )
+{
+  RendererNull::SetTexture( textureName, texture );
+  for( u32 i = 0; i < mNumBoundTextures; ++i )
+  {
+    TacSoftwareBoundTexture& boundTexture = mBoundTextures[ i ];
+    if( TacStrCmp( boundTexture.mName.buffer, textureName ) )
+      continue;
+    boundTexture.mTexture = texture;
+    return;
+  }
+  Validate(
+    mNumBoundTextures < BOUND_TEXTURES_MAX,
+    "SetTexture with too many texture names" );
+  if( mNumBoundTextures == BOUND_TEXTURES_MAX )
+    return;
+  TacSoftwareBoundTexture& boundTexture = mBoundTextures[ mNumBoundTextures++ ];
+  boundTexture.mName = textureName;
+  boundTexture.mTexture = texture;
+}
+
+void RendererSoftware::SaveTexture(
+  TacThreadContext* thread,
+  TacTextureHandle textureHandle,
+  const char* filepath,
+  FixedString< DEFAULT_ERR_LEN >& errors )
+{
+  if( !mTextureResources.IsAlive( textureHandle.mIndex ) )
+  {
+    errors = "SaveTexture of a texture that isn't alive";
+    return;
+  }
+  TacSoftwareTexture& texture = mTextures[ textureHandle.mIndex ];
+
+  char header[ 64 ];
+  s32 headerSize = sprintf_s(
+    header,
+    "P6\n%u %u\n255\n",
+    texture.mWidth,
+    texture.mHeight );
+  std::vector< u8 > ppm( header, header + headerSize );
+  ppm.reserve( headerSize + texture.mWidth * texture.mHeight * 3 );
+  for( u32 y = 0; y < texture.mHeight; ++y )
+  {
+    for( u32 x = 0; x < texture.mWidth; ++x )
+    {
+      u32 rgba = texture.mTexels[ y * texture.mPitch + x ];
+      ppm.push_back( ( u8 )( rgba ) );
+      ppm.push_back( ( u8 )( rgba >> 8 ) );
+      ppm.push_back( ( u8 )( rgba >> 16 ) );
+    }
+  }
+
+  TacFile file = PlatformOpenFile(
+    thread,
+    filepath,
+    OpenFileDisposition::CreateAlways,
+    FileAccess::Write,
+    errors );
+  if( errors.size )
+    return;
+  OnDestruct( PlatformCloseFile( thread, file, errors ); );
+  PlatformWriteEntireFile(
+    thread,
+    file,
+    ppm.data(),
+    ( u32 )ppm.size(),
+    errors );
+}
+
+// render targets -------------------------------------------------------
+
+TacDepthBufferHandle RendererSoftware::AddDepthBuffer(
+  u32 width,
+  u32 height,
+  TacTextureFormat textureFormat,
+  FixedString< DEFAULT_ERR_LEN >& errors )
+{
+  TacDepthBufferHandle result = RendererNull::AddDepthBuffer(
+    width,
+    height,
+    textureFormat,
+    errors );
+  if( errors.size )
+    return result;
+  ResizeForIndex( mDepthBuffers, result.mIndex );
+  TacSoftwareDepthBuffer& depthBuffer = mDepthBuffers[ result.mIndex ];
+  depthBuffer.mWidth = width;
+  depthBuffer.mHeight = height;
+  depthBuffer.mPitch = RoundUpToNearestMultiple( width, 4 );
+  depthBuffer.mDepths.assign( depthBuffer.mPitch * height, 1.0f );
+  return result;
+}
+
+void RendererSoftware::RemoveDepthBuffer( TacDepthBufferHandle depthBufer )
+{
+  RendererNull::RemoveDepthBuffer( depthBufer );
+  if( depthBufer.mIndex > 0 &&
+    depthBufer.mIndex < ( s32 )mDepthBuffers.size() )
+  {
+    TacSoftwareDepthBuffer empty = {};
+    mDepthBuffers[ depthBufer.mIndex ] = empty;
+  }
+}
+
+void RendererSoftware::SetRenderTargets(
+  TacTextureHandle* renderTargets,
+  u32 numRenderTargets,
+  TacDepthBufferHandle depthBuffer )
+{
+  RendererNull::SetRenderTargets( renderTargets, numRenderTargets, depthBuffer );
+  mCurrentRenderTarget.mIndex = RENDERER_ID_NONE;
+  if( numRenderTargets )
+    mCurrentRenderTarget = renderTargets[ 0 ];
+  mCurrentDepthBuffer = depthBuffer;
+}
+
+// cbuffer --------------------------------------------------------------
+
+TacCBufferHandle RendererSoftware::LoadCbuffer(
+  const char* name,
+  TacConstant* constants,
+  u32 numConstants,
+  FixedString< DEFAULT_ERR_LEN >& errors )
+{
+  TacCBufferHandle result =
+    RendererNull::LoadCbuffer( name, constants, numConstants, errors );
+  if( errors.size )
+    return result;
+  u32 size = 0;
+  for( u32 i = 0; i < numConstants; ++i )
+    size = Maximum( size, constants[ i ].offset + constants[ i ].size );
+  ResizeForIndex( mCbufferMemory, result.mIndex );
+  mCbufferMemory[ result.mIndex ].assign( size, 0 );
+  return result;
+}
+
+// blend state ----------------------------------------------------------
+
+TacBlendStateHandle RendererSoftware::AddBlendState(
+  TacBlendConstants srcRGB,
+  TacBlendConstants dstRGB,
+  TacBlendMode blendRGB,
+  TacBlendConstants srcA,
+  TacBlendConstants dstA,
+  TacBlendMode blendA,
+  FixedString< DEFAULT_ERR_LEN >& errors )
+{
+  TacBlendStateHandle result = RendererNull::AddBlendState(
+    srcRGB,
+    dstRGB,
+    blendRGB,
+    srcA,
+    dstA,
+    blendA,
+    errors );
+  if( errors.size )
+    return result;
+  ResizeForIndex( mBlendStates, result.mIndex );
+  TacSoftwareBlendState& blendState = mBlendStates[ result.mIndex ];
+  blendState.mAlphaBlend =
+    srcRGB == TacBlendConstants::SrcA &&
+    dstRGB == TacBlendConstants::OneMinusSrcA;
+  return result;
+}
+
+// rasterizer state -----------------------------------------------------
+
+TacRasterizerStateHandle RendererSoftware::AddRasterizerState(
+  TacFillMode fillMode,
+  TacCullMode cullMode,
+  b32 frontCounterClockwise,
+  b32 scissor,
+  b32 multisample,
+  FixedString< DEFAULT_ERR_LEN >& errors )
+{
+  TacRasterizerStateHandle result = RendererNull::AddRasterizerState(
+    fillMode,
+    cullMode,
+    frontCounterClockwise,
+    scissor,
+    multisample,
+    errors );
+  if( errors.size )
+    return result;
+
+  // wireframe is drawn solid
+  ResizeForIndex( mRasterizerStates, result.mIndex );
+  TacSoftwareRasterizerState& rasterizerState =
+    mRasterizerStates[ result.mIndex ];
+  rasterizerState.mCullMode = cullMode;
+  rasterizerState.mFrontCounterClockwise = frontCounterClockwise;
+  rasterizerState.mScissor = scissor;
+  return result;
+}
+
+// depth state ----------------------------------------------------------
+
+TacDepthStateHandle RendererSoftware::AddDepthState(
+  b32 depthTest,
+  b32 depthWrite,
+  TacDepthFunc depthFunc,
+  FixedString< DEFAULT_ERR_LEN >& errors )
+{
+  TacDepthStateHandle result = RendererNull::AddDepthState(
+    depthTest,
+    depthWrite,
+    depthFunc,
+    errors );
+  if( errors.size )
+    return result;
+  ResizeForIndex( mDepthStates, result.mIndex );
+  TacSoftwareDepthState& depthState = mDepthStates[ result.mIndex ];
+  depthState.mDepthTest = depthTest;
+  depthState.mDepthWrite = depthWrite;
+  depthState.mDepthFunc = depthFunc;
+  return result;
+}
+
+// vertex format --------------------------------------------------------
+
+TacVertexFormatHandle RendererSoftware::AddVertexFormat(
+  TacVertexFormat* vertexFormats,
+  u32 numVertexFormats,
+  TacShaderHandle shader,
+  FixedString< DEFAULT_ERR_LEN >& errors )
+{
+  TacVertexFormatHandle result = RendererNull::AddVertexFormat(
+    vertexFormats,
+    numVertexFormats,
+    shader,
+    errors );
+  if( errors.size )
+    return result;
+  ResizeForIndex( mVertexFormats, result.mIndex );
+  mVertexFormats[ result.mIndex ].assign(
+    vertexFormats,
+    vertexFormats + numVertexFormats );
+  return result;
+}
+
+// etc ------------------------------------------------------------------
+
+void RendererSoftware::Draw()
+{
+  RendererNull::Draw();
+  if( !mIndexBufferResources.IsAlive( mCurrentIndexBuffer.mIndex ) )
+    return;
+  u32 numIndexes = mIndexBuffers[ mCurrentIndexBuffer.mIndex ].mNumElements;
+  Rasterize( numIndexes, 1, 0, 0, 0 );
+}
+
+void RendererSoftware::DrawIndexed(
+  u32 elementCount,
+  u32 idxOffset,
+  u32 vtxOffset )
+{
+  RendererNull::DrawIndexed( elementCount, idxOffset, vtxOffset );
+  Rasterize( elementCount, 1, idxOffset, vtxOffset, 0 );
+}
+
+void RendererSoftware::DrawInstanced( u32 numInstances, u32 firstInstance )
+{
+  RendererNull::DrawInstanced( numInstances, firstInstance );
+  if( !mIndexBufferResources.IsAlive( mCurrentIndexBuffer.mIndex ) )
+    return;
+  u32 numIndexes = mIndexBuffers[ mCurrentIndexBuffer.mIndex ].mNumElements;
+  Rasterize( numIndexes, numInstances, 0, 0, firstInstance );
+}
+
+void RendererSoftware::DrawIndexedInstanced(
+  u32 elementCount,
+  u32 numInstances,
+  u32 idxOffset,
+  u32 vtxOffset,
+  u32 firstInstance )
+{
+  RendererNull::DrawIndexedInstanced(
+    elementCount,
+    numInstances,
+    idxOffset,
+    vtxOffset,
+    firstInstance );
+  Rasterize( elementCount, numInstances, idxOffset, vtxOffset, firstInstance );
+}
+
+void RendererSoftware::SendUniform( const char* name, void* data, u32 size )
+{
+  RendererNull::SendUniform( name, data, size );
+  if( !mShaderResources.IsAlive( mCurrentShader.mIndex ) )
+    return;
+  TacNullShader& shader = mShaders[ mCurrentShader.mIndex ];
+  for( u32 iCbuffer = 0; iCbuffer < shader.mNumCbuffers; ++iCbuffer )
+  {
+    TacCBufferHandle cbufferHandle = shader.mCbuffers[ iCbuffer ];
+    TacNullCBuffer& cbuffer = mCbuffers[ cbufferHandle.mIndex ];
+    for( u32 iConstant = 0; iConstant < cbuffer.mNumConstants; ++iConstant )
+    {
+      TacConstant& constant = cbuffer.mConstants[ iConstant ];
+      if( TacStrCmp( constant.name.buffer, name ) )
+        continue;
+      memcpy(
+        mCbufferMemory[ cbufferHandle.mIndex ].data() + constant.offset,
+        data,
+        Minimum( size, constant.size ) );
+      return;
+    }
+  }
+}
+
+void RendererSoftware::SendUniform(
+  TacUniformHandle uniform,
+  void* data,
+  u32 size )
+{
+  RendererNull::SendUniform( uniform, data, size );
+  if( uniform.mIndex <= RENDERER_ID_NONE ||
+    uniform.mIndex >= ( s32 )mUniforms.size() )
+    return;
+  TacNullUniform& nullUniform = mUniforms[ uniform.mIndex ];
+  if( !mCbufferResources.IsAlive( nullUniform.mCBufferHandle.mIndex ) )
+    return;
+  TacNullCBuffer& cbuffer = mCbuffers[ nullUniform.mCBufferHandle.mIndex ];
+  TacConstant& constant = cbuffer.mConstants[ nullUniform.mConstantIndex ];
+  memcpy(
+    mCbufferMemory[ nullUniform.mCBufferHandle.mIndex ].data() + constant.offset,
+    data,
+    Minimum( size, constant.size ) );
+}
+
+void RendererSoftware::SetViewport(
+  r32 xRelBotLeftCorner,
+  r32 yRelBotLeftCorner,
+  r32 wIncreasingRight,
+  r32 hIncreasingUp )
+{
+  RendererNull::SetViewport(
+    xRelBotLeftCorner,
+    yRelBotLeftCorner,
+    wIncreasingRight,
+    hIncreasingUp );
+
+  // Same as the dx11 renderer, relative to the backbuffer
+  r32 rtvHeight = ( r32 )mTextures[ mBackbufferColor.mIndex ].mHeight;
+  mViewportX = xRelBotLeftCorner;
+  mViewportY = rtvHeight - ( yRelBotLeftCorner + hIncreasingUp );
+  mViewportW = wIncreasingRight;
+  mViewportH = hIncreasingUp;
+}
+
+void RendererSoftware::SetScissorRect(
+  float x1,
+  float y1,
+  float x2,
+  float y2 )
+{
+  RendererNull::SetScissorRect( x1, y1, x2, y2 );
+  mScissorMinX = ( s32 )x1;
+  mScissorMinY = ( s32 )y1;
+  mScissorMaxX = ( s32 )x2;
+  mScissorMaxY = ( s32 )y2;
+}
+
+void RendererSoftware::SwapBuffers()
+{
+  RendererNull::SwapBuffers();
+  mLastFrameNumPixelsShaded = mNumPixelsShaded;
+  mNumPixelsShaded = 0;
+}
+
+// rasterization --------------------------------------------------------
+
+void RendererSoftware::ComputeClipRect()
+{
+  TacSoftwareTexture* renderTarget = mDraw.mRenderTarget;
+  mClipMinX = Maximum( CeilReal32ToInt32( mViewportX ), 0 );
+  mClipMinY = Maximum( CeilReal32ToInt32( mViewportY ), 0 );
+  mClipMaxX = Minimum(
+    CeilReal32ToInt32( mViewportX + mViewportW ),
+    ( s32 )renderTarget->mWidth );
+  mClipMaxY = Minimum(
+    CeilReal32ToInt32( mViewportY + mViewportH ),
+    ( s32 )renderTarget->mHeight );
+  if( mDraw.mRasterizerState.mScissor )
+  {
+    mClipMinX = Maximum( mClipMinX, mScissorMinX );
+    mClipMinY = Maximum( mClipMinY, mScissorMinY );
+    mClipMaxX = Minimum( mClipMaxX, mScissorMaxX );
+    mClipMaxY = Minimum( mClipMaxY, mScissorMaxY );
+  }
+}
+
+// Clips against z = 0, which is the near plane with the dx11 projection.
+// Returns the number of vertexes, 0, 3 or 4
+internalFunction u32 ClipNear(
+  const TacSoftwareVertex* vertexes,
+  TacSoftwareVertex* clipped,
+  u32 numVaryings )
+{
+  u32 numClipped = 0;
+  for( u32 i = 0; i < 3; ++i )
+  {
+    const TacSoftwareVertex& a = vertexes[ i ];
+    const TacSoftwareVertex& b = vertexes[ ( i + 1 ) % 3 ];
+    b32 aInside = a.mPosition.z >= 0;
+    b32 bInside = b.mPosition.z >= 0;
+    if( aInside )
+      clipped[ numClipped++ ] = a;
+    if( aInside == bInside )
+      continue;
+    r32 t = a.mPosition.z / ( a.mPosition.z - b.mPosition.z );
+    TacSoftwareVertex& intersection = clipped[ numClipped++ ];
+    intersection.mPosition = a.mPosition + ( b.mPosition - a.mPosition ) * t;
+    for( u32 iVarying = 0; iVarying < numVaryings; ++iVarying )
+    {
+      intersection.mVaryings[ iVarying ] = a.mVaryings[ iVarying ] +
+        ( b.mVaryings[ iVarying ] - a.mVaryings[ iVarying ] ) * t;
+    }
+  }
+  return numClipped;
+}
+
+void RendererSoftware::BinTriangle(
+  TacSoftwareBinChunk& chunk,
+  const TacSoftwareVertex* vertexes )
+{
+  u32 numVaryings = mDraw.mShader->mNumVaryings;
+  r32 xs[ 3 ];
+  r32 ys[ 3 ];
+  r32 invWs[ 3 ];
+  for( u32 i = 0; i < 3; ++i )
+  {
+    const v4& position = vertexes[ i ].mPosition;
+    invWs[ i ] = 1.0f / position.w;
+    r32 ndcX = position.x * invWs[ i ];
+    r32 ndcY = position.y * invWs[ i ];
+    xs[ i ] = mViewportX + ( ndcX + 1.0f ) * 0.5f * mViewportW;
+    ys[ i ] = mViewportY + ( 1.0f - ndcY ) * 0.5f * mViewportH;
+  }
+
+  // y goes down, so clockwise on screen is a positive area
+  r32 area =
+    ( xs[ 1 ] - xs[ 0 ] ) * ( ys[ 2 ] - ys[ 0 ] ) -
+    ( ys[ 1 ] - ys[ 0 ] ) * ( xs[ 2 ] - xs[ 0 ] );
+  if( area == 0 )
+    return;
+  b32 clockwise = area > 0;
+  b32 front = mDraw.mRasterizerState.mFrontCounterClockwise ?
+    !clockwise : clockwise;
+  switch( mDraw.mRasterizerState.mCullMode )
+  {
+    case TacCullMode::None: break;
+    case TacCullMode::Back: if( !front ) return; break;
+    case TacCullMode::Front: if( front ) return; break;
+    TacInvalidDefaultCase;
+  }
+
+  // pixels whose center is inside the bounds
+  r32 minX = Minimum( xs[ 0 ], Minimum( xs[ 1 ], xs[ 2 ] ) );
+  r32 minY = Minimum( ys[ 0 ], Minimum( ys[ 1 ], ys[ 2 ] ) );
+  r32 maxX = Maximum( xs[ 0 ], Maximum( xs[ 1 ], xs[ 2 ] ) );
+  r32 maxY = Maximum( ys[ 0 ], Maximum( ys[ 1 ], ys[ 2 ] ) );
+  TacSoftwareTriangle triangle;
+  triangle.mMinX = Maximum( CeilReal32ToInt32( minX - 0.5f ), mClipMinX );
+  triangle.mMinY = Maximum( CeilReal32ToInt32( minY - 0.5f ), mClipMinY );
+  triangle.mMaxX = Minimum( FloorReal32ToInt32( maxX - 0.5f ) + 1, mClipMaxX );
+  triangle.mMaxY = Minimum( FloorReal32ToInt32( maxY - 0.5f ) + 1, mClipMaxY );
+  if( triangle.mMinX >= triangle.mMaxX || triangle.mMinY >= triangle.mMaxY )
+    return;
+
+  // dividing by the signed area makes the edges positive inside for
+  // either winding
+  r32 invArea = 1.0f / area;
+  for( u32 i = 0; i < 3; ++i )
+  {
+    u32 j = ( i + 1 ) % 3;
+    u32 k = ( i + 2 ) % 3;
+    r32 a = ( ys[ j ] - ys[ k ] ) * invArea;
+    r32 b = ( xs[ k ] - xs[ j ] ) * invArea;
+    triangle.mEdgeA[ i ] = a;
+    triangle.mEdgeB[ i ] = b;
+    triangle.mEdgeC[ i ] = -( a * xs[ j ] + b * ys[ j ] );
+
+    // a shared edge has the opposite a and b in the other triangle
+    triangle.mEdgeInclusive[ i ] = a > 0 || ( a == 0 && b > 0 );
+
+    const TacSoftwareVertex& vertex = vertexes[ i ];
+    triangle.mZ[ i ] = vertex.mPosition.z * invWs[ i ];
+    triangle.mInvW[ i ] = invWs[ i ];
+    for( u32 iVarying = 0; iVarying < numVaryings; ++iVarying )
+    {
+      triangle.mVaryingsOverW[ i ][ iVarying ] =
+        vertex.mVaryings[ iVarying ] * invWs[ i ];
+    }
+  }
+
+  u32 iTriangle = ( u32 )chunk.mTriangles.size();
+  chunk.mTriangles.push_back( triangle );
+  u32 tileMinX = triangle.mMinX / TILE_SIZE;
+  u32 tileMinY = triangle.mMinY / TILE_SIZE;
+  u32 tileMaxX = ( triangle.mMaxX - 1 ) / TILE_SIZE;
+  u32 tileMaxY = ( triangle.mMaxY - 1 ) / TILE_SIZE;
+  for( u32 tileY = tileMinY; tileY <= tileMaxY; ++tileY )
+  {
+    for( u32 tileX = tileMinX; tileX <= tileMaxX; ++tileX )
+    {
+      u32 iTile = tileY * mNumTilesX + tileX;
+      chunk.mTileTriangles[ iTile ].push_back( iTriangle );
+    }
+  }
+}
+
+void RendererSoftware::RasterizeTile( u32 iTile, u32 numChunks )
+{
+  TacSoftwareTexture* renderTarget = mDraw.mRenderTarget;
+  TacSoftwareDepthBuffer* depthBuffer = mDraw.mDepthBuffer;
+  TacSoftwareShader* shader = mDraw.mShader;
+  const TacSoftwareDepthState& depthState = mDraw.mDepthState;
+  b32 depthTest = depthBuffer && depthState.mDepthTest;
+  b32 depthWrite = depthBuffer && depthState.mDepthWrite;
+  b32 lessOrEqual = depthState.mDepthFunc == TacDepthFunc::LessOrEqual;
+  b32 alphaBlend = mDraw.mBlendState.mAlphaBlend;
+  u32 numVaryings = shader->mNumVaryings;
+
+  s32 tileMinX = ( iTile % mNumTilesX ) * TILE_SIZE;
+  s32 tileMinY = ( iTile / mNumTilesX ) * TILE_SIZE;
+  s32 tileMaxX = tileMinX + TILE_SIZE;
+  s32 tileMaxY = tileMinY + TILE_SIZE;
+
+  TacSoftwareShaderContext context;
+  context.mRenderer = this;
+  context.mVertexIndex = 0;
+  context.mInstanceIndex = 0;
+
+  const __m128 laneOffsets = _mm_set_ps( 3.5f, 2.5f, 1.5f, 0.5f );
+  const __m128 zero = _mm_setzero_ps();
+  const __m128 one = _mm_set1_ps( 1.0f );
+  u32 numPixelsShaded = 0;
+  for( u32 iChunk = 0; iChunk < numChunks; ++iChunk )
+  {
+    TacSoftwareBinChunk& chunk = mBinChunks[ iChunk ];
+    for( u32 iTriangle : chunk.mTileTriangles[ iTile ] )
+    {
+      const TacSoftwareTriangle& triangle = chunk.mTriangles[ iTriangle ];
+      s32 minX = Maximum( triangle.mMinX, tileMinX );
+      s32 minY = Maximum( triangle.mMinY, tileMinY );
+      s32 maxX = Minimum( triangle.mMaxX, tileMaxX );
+      s32 maxY = Minimum( triangle.mMaxY, tileMaxY );
+
+      // tiles are a multiple of 4 wide, so groups of 4 never straddle them
+      s32 alignedMinX = minX & ~3;
+      __m128 minXs = _mm_set1_ps( ( r32 )minX );
+      __m128 maxXs = _mm_set1_ps( ( r32 )maxX );
+
+      __m128 edgeA[ 3 ];
+      __m128 edgeInclusive[ 3 ];
+      __m128 zs[ 3 ];
+      for( u32 i = 0; i < 3; ++i )
+      {
+        edgeA[ i ] = _mm_set1_ps( triangle.mEdgeA[ i ] );
+        edgeInclusive[ i ] = triangle.mEdgeInclusive[ i ] ?
+          _mm_castsi128_ps( _mm_set1_epi32( -1 ) ) : zero;
+        zs[ i ] = _mm_set1_ps( triangle.mZ[ i ] );
+      }
+
+      for( s32 y = minY; y < maxY; ++y )
+      {
+        r32 pixelY = y + 0.5f;
+        __m128 edgeRows[ 3 ];
+        for( u32 i = 0; i < 3; ++i )
+        {
+          edgeRows[ i ] = _mm_set1_ps(
+            triangle.mEdgeB[ i ] * pixelY + triangle.mEdgeC[ i ] );
+        }
+        u32* texels = &renderTarget->mTexels[ y * renderTarget->mPitch ];
+        r32* depths =
+          depthBuffer ? &depthBuffer->mDepths[ y * depthBuffer->mPitch ] : nullptr;
+
+        for( s32 x = alignedMinX; x < maxX; x += 4 )
+        {
+          __m128 pixelXs = _mm_add_ps( _mm_set1_ps( ( r32 )x ), laneOffsets );
+          __m128 mask = _mm_and_ps(
+            _mm_cmpge_ps( pixelXs, minXs ),
+            _mm_cmplt_ps( pixelXs, maxXs ) );
+          __m128 barycentrics[ 3 ];
+          for( u32 i = 0; i < 3; ++i )
+          {
+            barycentrics[ i ] = _mm_add_ps(
+              _mm_mul_ps( edgeA[ i ], pixelXs ),
+              edgeRows[ i ] );
+            __m128 inside = _mm_or_ps(
+              _mm_cmpgt_ps( barycentrics[ i ], zero ),
+              _mm_and_ps(
+                _mm_cmpeq_ps( barycentrics[ i ], zero ),
+                edgeInclusive[ i ] ) );
+            mask = _mm_and_ps( mask, inside );
+          }
+          if( !_mm_movemask_ps( mask ) )
+            continue;
+
+          __m128 z = _mm_add_ps(
+            _mm_add_ps(
+              _mm_mul_ps( barycentrics[ 0 ], zs[ 0 ] ),
+              _mm_mul_ps( barycentrics[ 1 ], zs[ 1 ] ) ),
+            _mm_mul_ps( barycentrics[ 2 ], zs[ 2 ] ) );
+
+          // past the far plane
+          mask = _mm_and_ps( mask, _mm_cmple_ps( z, one ) );
+          if( depthBuffer )
+          {
+            __m128 depth = _mm_loadu_ps( depths + x );
+            if( depthTest )
+            {
+              __m128 pass = lessOrEqual ?
+                _mm_cmple_ps( z, depth ) :
+                _mm_cmplt_ps( z, depth );
+              mask = _mm_and_ps( mask, pass );
+            }
+            if( depthWrite )
+            {
+              __m128 written = _mm_or_ps(
+                _mm_and_ps( mask, z ),
+                _mm_andnot_ps( mask, depth ) );
+              _mm_storeu_ps( depths + x, written );
+            }
+          }
+          s32 lanes = _mm_movemask_ps( mask );
+          if( !lanes )
+            continue;
+
+          r32 laneBarycentrics[ 3 ][ 4 ];
+          for( u32 i = 0; i < 3; ++i )
+            _mm_storeu_ps( laneBarycentrics[ i ], barycentrics[ i ] );
+          for( u32 iLane = 0; iLane < 4; ++iLane )
+          {
+            if( !( lanes & ( 1 << iLane ) ) )
+              continue;
+            r32 b0 = laneBarycentrics[ 0 ][ iLane ];
+            r32 b1 = laneBarycentrics[ 1 ][ iLane ];
+            r32 b2 = laneBarycentrics[ 2 ][ iLane ];
+            r32 w = 1.0f / (
+              b0 * triangle.mInvW[ 0 ] +
+              b1 * triangle.mInvW[ 1 ] +
+              b2 * triangle.mInvW[ 2 ] );
+            r32 varyings[ SOFTWARE_MAX_VARYINGS ];
+            for( u32 iVarying = 0; iVarying < numVaryings; ++iVarying )
+            {
+              varyings[ iVarying ] = w * (
+                b0 * triangle.mVaryingsOverW[ 0 ][ iVarying ] +
+                b1 * triangle.mVaryingsOverW[ 1 ][ iVarying ] +
+                b2 * triangle.mVaryingsOverW[ 2 ][ iVarying ] );
+            }
+            v4 color = shader->mPixelShader( context, varyings );
+            u32& texel = texels[ x + iLane ];
+            if( alphaBlend )
+            {
+              v4 dst = UnpackColor( texel );
+              color = color * color.w + dst * ( 1.0f - color.w );
+            }
+            texel = PackColor( color );
+            ++numPixelsShaded;
+          }
+        }
+      }
+    }
+  }
+  mTilePixelsShaded[ iTile ] = numPixelsShaded;
+}
+
+void RendererSoftware::Rasterize(
+  u32 elementCount,
+  u32 numInstances,
+  u32 idxOffset,
+  u32 vtxOffset,
+  u32 firstInstance )
+{
+  // RendererNull already counted the validation errors of skipped draws
+  if( !mShaderResources.IsAlive( mCurrentShader.mIndex ) ||
+    !mVertexFormatResources.IsAlive( mCurrentVertexFormat.mIndex ) ||
+    !mTextureResources.IsAlive( mCurrentRenderTarget.mIndex ) )
+    return;
+  TacSoftwareShader* shader = &mSoftwareShaders[ mCurrentShader.mIndex ];
+  if( !shader->mVertexShader || !shader->mPixelShader )
+    return;
+  b32 shortIndexes;
+  const u8* indexes;
+  if( mIndexBufferUpload.mActive )
+  {
+    u64 end =
+      ( u64 )mIndexBufferUpload.mOffset +
+      ( u64 )( idxOffset + elementCount ) * mIndexBufferUpload.mStride;
+    b32 validRange = end <= mUploadMemory.size();
+    Validate( validRange, "Draw past the end of the upload memory" );
+    if( !validRange )
+      return;
+    shortIndexes = mIndexBufferUploadFormat == TacTextureFormat::R16Uint;
+    indexes = mUploadMemory.data() + mIndexBufferUpload.mOffset;
+  }
+  else
+  {
+    if( !mIndexBufferResources.IsAlive( mCurrentIndexBuffer.mIndex ) )
+      return;
+    TacNullBuffer& indexBuffer = mIndexBuffers[ mCurrentIndexBuffer.mIndex ];
+    b32 validRange = idxOffset + elementCount <= indexBuffer.mNumElements;
+    Validate( validRange, "Draw past the end of the index buffer" );
+    if( !validRange )
+      return;
+    shortIndexes =
+      mIndexFormats[ mCurrentIndexBuffer.mIndex ] == TacTextureFormat::R16Uint;
+    indexes = indexBuffer.mMemory.data();
+  }
+
+  // dx11's defaults for unset state
+  mDraw.mShader = shader;
+  mDraw.mRenderTarget = &mTextures[ mCurrentRenderTarget.mIndex ];
+  mDraw.mDepthBuffer = nullptr;
+  if( mDepthBufferResources.IsAlive( mCurrentDepthBuffer.mIndex ) )
+  {
+    TacSoftwareDepthBuffer* depthBuffer =
+      &mDepthBuffers[ mCurrentDepthBuffer.mIndex ];
+    b32 sameSize =
+      depthBuffer->mWidth == mDraw.mRenderTarget->mWidth &&
+      depthBuffer->mHeight == mDraw.mRenderTarget->mHeight;
+    Validate( sameSize, "Depth buffer isn't the size of the render target" );
+    if( sameSize )
+      mDraw.mDepthBuffer = depthBuffer;
+  }
+  TacSoftwareRasterizerState defaultRasterizerState =
+  { TacCullMode::Back, false, false };
+  mDraw.mRasterizerState =
+    mRasterizerStateResources.IsAlive( mCurrentRasterizerState.mIndex ) ?
+    mRasterizerStates[ mCurrentRasterizerState.mIndex ] :
+    defaultRasterizerState;
+  TacSoftwareDepthState defaultDepthState =
+  { true, true, TacDepthFunc::Less };
+  mDraw.mDepthState =
+    mDepthStateResources.IsAlive( mCurrentDepthState.mIndex ) ?
+    mDepthStates[ mCurrentDepthState.mIndex ] :
+    defaultDepthState;
+  TacSoftwareBlendState defaultBlendState = { false };
+  mDraw.mBlendState =
+    mBlendStateResources.IsAlive( mCurrentBlendState.mIndex ) ?
+    mBlendStates[ mCurrentBlendState.mIndex ] :
+    defaultBlendState;
+
+  ComputeClipRect();
+  if( mClipMinX >= mClipMaxX || mClipMinY >= mClipMaxY )
+    return;
+
+  u32 numTrianglesPerInstance = elementCount / 3;
+  u32 numTriangles = numTrianglesPerInstance * numInstances;
+  if( !numTriangles )
+    return;
+
+  mNumTilesX = ( mDraw.mRenderTarget->mWidth + TILE_SIZE - 1 ) / TILE_SIZE;
+  mNumTilesY = ( mDraw.mRenderTarget->mHeight + TILE_SIZE - 1 ) / TILE_SIZE;
+  u32 numTiles = mNumTilesX * mNumTilesY;
+  mTilePixelsShaded.assign( numTiles, 0 );
+
+  // vertex shading, clipping, setup and binning
+  TacParallelChunks chunks =
+    ComputeParallelChunks( mQueue, 0, numTriangles, 256 );
+  ParallelFor( mQueue, mThread, 0, chunks.numChunks, 1, [ & ]( u32 iChunk )
+  {
+    TacSoftwareBinChunk& chunk = mBinChunks[ iChunk ];
+    chunk.mTriangles.clear();
+    chunk.mTileTriangles.resize( numTiles );
+    for( std::vector< u32 >& tileTriangles : chunk.mTileTriangles )
+      tileTriangles.clear();
+
+    TacSoftwareShaderContext context;
+    context.mRenderer = this;
+    u32 iBegin = iChunk * chunks.grain;
+    u32 iEnd = Minimum( iBegin + chunks.grain, numTriangles );
+    for( u32 iTriangle = iBegin; iTriangle < iEnd; ++iTriangle )
+    {
+      u32 iInstance = iTriangle / numTrianglesPerInstance;
+      u32 iFirstIndex =
+        idxOffset + ( iTriangle % numTrianglesPerInstance ) * 3;
+      context.mInstanceIndex = firstInstance + iInstance;
+
+      TacSoftwareVertex vertexes[ 3 ];
+      u32 numOutside[ 6 ] = {};
+      for( u32 i = 0; i < 3; ++i )
+      {
+        u32 iIndex = iFirstIndex + i;
+        u32 index = shortIndexes ?
+          ( ( const u16* )indexes )[ iIndex ] :
+          ( ( const u32* )indexes )[ iIndex ];
+        context.mVertexIndex = index + vtxOffset;
+        shader->mVertexShader( context, vertexes[ i ] );
+
+        const v4& position = vertexes[ i ].mPosition;
+        numOutside[ 0 ] += position.x < -position.w;
+        numOutside[ 1 ] += position.x > position.w;
+        numOutside[ 2 ] += position.y < -position.w;
+        numOutside[ 3 ] += position.y > position.w;
+        numOutside[ 4 ] += position.z < 0;
+        numOutside[ 5 ] += position.z > position.w;
+      }
+
+      // all 3 outside the same plane
+      b32 culled = false;
+      for( u32 iPlane = 0; iPlane < 6; ++iPlane )
+        culled |= numOutside[ iPlane ] == 3;
+      if( culled )
+        continue;
+      if( !numOutside[ 4 ] )
+      {
+        BinTriangle( chunk, vertexes );
+        continue;
+      }
+
+      TacSoftwareVertex clipped[ 4 ];
+      u32 numClipped = ClipNear( vertexes, clipped, shader->mNumVaryings );
+      if( numClipped < 3 )
+        continue;
+      BinTriangle( chunk, clipped );
+      if( numClipped == 4 )
+      {
+        TacSoftwareVertex fan[ 3 ] = { clipped[ 0 ], clipped[ 2 ], clipped[ 3 ] };
+        BinTriangle( chunk, fan );
+      }
+    }
+  } );
+
+  // only the tiles something landed in
+  std::vector< u32 > tiles;
+  for( u32 iTile = 0; iTile < numTiles; ++iTile )
+  {
+    for( u32 iChunk = 0; iChunk < chunks.numChunks; ++iChunk )
+    {
+      if( mBinChunks[ iChunk ].mTileTriangles[ iTile ].empty() )
+        continue;
+      tiles.push_back( iTile );
+      break;
+    }
+  }
+  ParallelFor( mQueue, mThread, 0, ( u32 )tiles.size(), 1, [ & ]( u32 i )
+  {
+    RasterizeTile( tiles[ i ], chunks.numChunks );
+  } );
+  for( u32 iTile : tiles )
+    mNumPixelsShaded += mTilePixelsShaded[ iTile ];
+}
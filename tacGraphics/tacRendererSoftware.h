@@ -0,0 +1,407 @@
+#pragma once
+
+// tac
+#include "tacRendererNull.h"
+#include "tacLibrary/tacMath.h"
+
+// stl
+#include <vector>
+
+// A TacRenderer that rasterizes on the cpu.
+//
+// Shaders are c++ callbacks, set with SetShaderCallbacks() after the
+// shader is loaded ( the hlsl is never compiled ).
+// Each draw is done before the draw call returns:
+// - triangles are split into chunks, and each chunk is vertex shaded,
+//   clipped against the near plane, set up and binned into tiles
+// - each tile is then rasterized by one thread, 4 pixels at a time, going
+//   through the chunks in order so triangles land in submission order
+//
+// Resource tracking, validation, stats and recording are RendererNull's.
+
+struct RendererSoftware;
+
+const u32 SOFTWARE_MAX_VARYINGS = 16;
+
+struct TacSoftwareVertex
+{
+  // clip space, like the dx11 renderer z / w goes from 0 to 1
+  v4 mPosition;
+  r32 mVaryings[ SOFTWARE_MAX_VARYINGS ];
+};
+
+// What the shader callbacks can read. Callbacks run on many threads at once
+struct TacSoftwareShaderContext
+{
+  RendererSoftware* mRenderer;
+  u32 mVertexIndex;
+  u32 mInstanceIndex;
+
+  // Reads the attribute from the bound vertex buffers, the vertex format
+  // says where it is. Missing components are 0, except w which is 1
+  v4 GetAttribute(
+    TacAttributeType attributeType,
+    u32 semanticIndex = 0 ) const;
+
+  // Points into the cbuffer the uniform was last sent to.
+  // Get the handle once with TacRenderer::GetUniformHandle()
+  const void* GetUniform( TacUniformHandle uniform ) const;
+
+  // Point sampled, wrapped
+  v4 Sample( const char* textureName, v2 uv ) const;
+};
+
+// Fills out.mPosition and the shader's mNumVaryings varyings
+typedef void TacSoftwareVertexShader(
+  const TacSoftwareShaderContext& context,
+  TacSoftwareVertex& out );
+
+// Returns rgba from the perspective correct varyings
+typedef v4 TacSoftwarePixelShader(
+  const TacSoftwareShaderContext& context,
+  const r32* varyings );
+
+struct TacSoftwareShader
+{
+  TacSoftwareVertexShader* mVertexShader;
+  TacSoftwarePixelShader* mPixelShader;
+  u32 mNumVaryings;
+};
+
+// rgba8, rows are padded to a multiple of 4 pixels so the rasterizer
+// can always read 4 at a time
+struct TacSoftwareTexture
+{
+  u32 mWidth;
+  u32 mHeight;
+  u32 mPitch;
+  std::vector< u32 > mTexels;
+};
+
+struct TacSoftwareDepthBuffer
+{
+  u32 mWidth;
+  u32 mHeight;
+  u32 mPitch;
+  std::vector< r32 > mDepths;
+};
+
+struct TacSoftwareRasterizerState
+{
+  TacCullMode mCullMode;
+  b32 mFrontCounterClockwise;
+  b32 mScissor;
+};
+
+struct TacSoftwareDepthState
+{
+  b32 mDepthTest;
+  b32 mDepthWrite;
+  TacDepthFunc mDepthFunc;
+};
+
+struct TacSoftwareBlendState
+{
+  // src * srcA + dst * ( 1 - srcA ), the only blend the renderers use.
+  // Otherwise src overwrites dst
+  b32 mAlphaBlend;
+};
+
+struct TacSoftwareBoundTexture
+{
+  FixedString< 32 > mName;
+  TacTextureHandle mTexture;
+};
+
+// A triangle after setup, in pixels of the render target
+struct TacSoftwareTriangle
+{
+  // edge i is opposite vertex i, e( x, y ) = a * x + b * y + c.
+  // They're divided by the area, so they're also the barycentrics
+  r32 mEdgeA[ 3 ];
+  r32 mEdgeB[ 3 ];
+  r32 mEdgeC[ 3 ];
+
+  // pixels exactly on an edge belong to only one of the two triangles
+  // sharing it
+  b32 mEdgeInclusive[ 3 ];
+
+  // z / w, 1 / w and varyings / w are linear in screen space
+  r32 mZ[ 3 ];
+  r32 mInvW[ 3 ];
+  r32 mVaryingsOverW[ 3 ][ SOFTWARE_MAX_VARYINGS ];
+
+  s32 mMinX;
+  s32 mMinY;
+  s32 mMaxX; // exclusive
+  s32 mMaxY; // exclusive
+};
+
+// What a draw reads from the bound state, looked up once per draw
+struct TacSoftwareDrawState
+{
+  TacSoftwareShader* mShader;
+  TacSoftwareTexture* mRenderTarget;
+  // null if there's no depth buffer, or it isn't the render target's size
+  TacSoftwareDepthBuffer* mDepthBuffer;
+  TacSoftwareRasterizerState mRasterizerState;
+  TacSoftwareDepthState mDepthState;
+  TacSoftwareBlendState mBlendState;
+};
+
+// The triangles one chunk of a draw set up, and which tiles they touch
+struct TacSoftwareBinChunk
+{
+  std::vector< TacSoftwareTriangle > mTriangles;
+
+  // indexes into mTriangles, one list per tile
+  std::vector< std::vector< u32 > > mTileTriangles;
+};
+
+struct RendererSoftware : public RendererNull
+{
+  // queue can be null, then everything runs on the calling thread
+  RendererSoftware(
+    u32 width,
+    u32 height,
+    TacWorkQueue* queue,
+    TacThreadContext* thread );
+
+  // index buffer ---------------------------------------------------------
+
+  TacIndexBufferHandle AddIndexBuffer(
+    TacBufferAccess access,
+    void* data,
+    u32 numIndexes,
+    TacTextureFormat dataType,
+    u32 totalBufferSize,
+    FixedString< DEFAULT_ERR_LEN >& errors ) override;
+
+  // indexed by TacIndexBufferHandle, R16Uint or R32Uint
+  std::vector< TacTextureFormat > mIndexFormats;
+
+  // clear ----------------------------------------------------------------
+
+  void ClearColor(
+    TacTextureHandle textureHandle,
+    v4 rgba ) override;
+
+  void ClearDepthStencil(
+    TacDepthBufferHandle depthBufferHandle,
+    b32 clearDepth,
+    r32 depth,
+    b32 clearStencil,
+    u8 stencil ) override;
+
+  // shader ---------------------------------------------------------------
+
+  TacShaderHandle LoadShader(
+    const char* paths[ ( u32 )TacShaderType::Count ],
+    const char* entryPoints[ ( u32 )TacShaderType::Count ],
+    const char* shaderModels[ ( u32 )TacShaderType::Count ],
+    FixedString< DEFAULT_ERR_LEN >& errors ) override;
+
+  // Draws with a shader that has no callbacks are skipped
+  void SetShaderCallbacks(
+    TacShaderHandle shader,
+    TacSoftwareVertexShader* vertexShader,
+    TacSoftwarePixelShader* pixelShader,
+    u32 numVaryings );
+
+  // indexed by TacShaderHandle
+  std::vector< TacSoftwareShader > mSoftwareShaders;
+
+  // texture --------------------------------------------------------------
+
+  TacTextureHandle AddTextureResource(
+    const TacImage& myImage,
+    TacTextureUsage textureUsage,
+    TacBinding binding,
+    FixedString< DEFAULT_ERR_LEN >& errors ) override;
+
+  void RemoveTextureResoure( TacTextureHandle texture ) override;
+
+  void SetTexture(
+    const char* textureName,
+    TacTextureHandle texture ) override;
+
+  // Writes the texture as a binary ppm, for comparing against golden images
+  void SaveTexture(
+    TacThreadContext* thread,
+    TacTextureHandle texture,
+    const char* filepath,
+    FixedString< DEFAULT_ERR_LEN >& errors );
+
+  // indexed by TacTextureHandle
+  std::vector< TacSoftwareTexture > mTextures;
+
+  static const u32 BOUND_TEXTURES_MAX = 8;
+  TacSoftwareBoundTexture mBoundTextures[ BOUND_TEXTURES_MAX ];
+  u32 mNumBoundTextures;
+
+  // render targets -------------------------------------------------------
+
+  TacDepthBufferHandle AddDepthBuffer(
+    u32 width,
+    u32 height,
+    TacTextureFormat textureFormat,
+    FixedString< DEFAULT_ERR_LEN >& errors ) override;
+
+  void RemoveDepthBuffer( TacDepthBufferHandle depthBufer ) override;
+
+  void SetRenderTargets(
+    TacTextureHandle* renderTargets,
+    u32 numRenderTargets,
+    TacDepthBufferHandle depthBuffer ) override;
+
+  // indexed by TacDepthBufferHandle.
+  // After drawing the occluders, the depths can be used for culling
+  std::vector< TacSoftwareDepthBuffer > mDepthBuffers;
+
+  // only the first render target is drawn to
+  TacTextureHandle mCurrentRenderTarget;
+  TacDepthBufferHandle mCurrentDepthBuffer;
+
+  // cbuffer --------------------------------------------------------------
+
+  TacCBufferHandle LoadCbuffer(
+    const char* name,
+    TacConstant* constants,
+    u32 numConstants,
+    FixedString< DEFAULT_ERR_LEN >& errors ) override;
+
+  // indexed by TacCBufferHandle
+  std::vector< std::vector< u8 > > mCbufferMemory;
+
+  // blend state ----------------------------------------------------------
+
+  TacBlendStateHandle AddBlendState(
+    TacBlendConstants srcRGB,
+    TacBlendConstants dstRGB,
+    TacBlendMode blendRGB,
+    TacBlendConstants srcA,
+    TacBlendConstants dstA,
+    TacBlendMode blendA,
+    FixedString< DEFAULT_ERR_LEN >& errors ) override;
+
+  // indexed by TacBlendStateHandle
+  std::vector< TacSoftwareBlendState > mBlendStates;
+
+  // rasterizer state -----------------------------------------------------
+
+  TacRasterizerStateHandle AddRasterizerState(
+    TacFillMode fillMode,
+    TacCullMode cullMode,
+    b32 frontCounterClockwise,
+    b32 scissor,
+    b32 multisample,
+    FixedString< DEFAULT_ERR_LEN >& errors ) override;
+
+  // indexed by TacRasterizerStateHandle
+  std::vector< TacSoftwareRasterizerState > mRasterizerStates;
+
+  // depth state ----------------------------------------------------------
+
+  TacDepthStateHandle AddDepthState(
+    b32 depthTest,
+    b32 depthWrite,
+    TacDepthFunc depthFunc,
+    FixedString< DEFAULT_ERR_LEN >& errors ) override;
+
+  // indexed by TacDepthStateHandle
+  std::vector< TacSoftwareDepthState > mDepthStates;
+
+  // vertex format --------------------------------------------------------
+
+  TacVertexFormatHandle AddVertexFormat(
+    TacVertexFormat* vertexFormats,
+    u32 numVertexFormats,
+    TacShaderHandle shader,
+    FixedString< DEFAULT_ERR_LEN >& errors ) override;
+
+  // indexed by TacVertexFormatHandle
+  std::vector< std::vector< TacVertexFormat > > mVertexFormats;
+
+  // etc ------------------------------------------------------------------
+
+  void Draw() override;
+  void DrawIndexed(
+    u32 elementCount,
+    u32 idxOffset,
+    u32 vtxOffset ) override;
+  void DrawInstanced( u32 numInstances, u32 firstInstance ) override;
+  void DrawIndexedInstanced(
+    u32 elementCount,
+    u32 numInstances,
+    u32 idxOffset,
+    u32 vtxOffset,
+    u32 firstInstance ) override;
+  void SendUniform( const char* name, void* data, u32 size ) override;
+  void SendUniform(
+    TacUniformHandle uniform,
+    void* data,
+    u32 size ) override;
+  void SetViewport(
+    r32 xRelBotLeftCorner,
+    r32 yRelBotLeftCorner,
+    r32 wIncreasingRight,
+    r32 hIncreasingUp ) override;
+  void SetScissorRect(
+    float x1,
+    float y1,
+    float x2,
+    float y2 ) override;
+  void SwapBuffers() override;
+
+  // non-virtual ---
+
+  // Shades, bins and rasterizes the triangles of one draw
+  void Rasterize(
+    u32 elementCount,
+    u32 numInstances,
+    u32 idxOffset,
+    u32 vtxOffset,
+    u32 firstInstance );
+
+  // Rasterizes every binned triangle that touches the tile
+  void RasterizeTile( u32 iTile, u32 numChunks );
+
+  // Sets up a clip space triangle and bins it into the tiles it touches
+  void BinTriangle(
+    TacSoftwareBinChunk& chunk,
+    const TacSoftwareVertex* vertexes );
+
+  // Where triangles can land this draw, the viewport clamped to the
+  // render target and the scissor rect, in pixels
+  void ComputeClipRect();
+
+  TacWorkQueue* mQueue;
+  TacThreadContext* mThread;
+
+  static const u32 TILE_SIZE = 64;
+  u32 mNumTilesX;
+  u32 mNumTilesY;
+  TacSoftwareBinChunk mBinChunks[ TacParallelChunks::maxChunks ];
+  std::vector< u32 > mTilePixelsShaded;
+
+  // viewport in pixels, top left origin
+  r32 mViewportX;
+  r32 mViewportY;
+  r32 mViewportW;
+  r32 mViewportH;
+  s32 mScissorMinX;
+  s32 mScissorMinY;
+  s32 mScissorMaxX;
+  s32 mScissorMaxY;
+  s32 mClipMinX;
+  s32 mClipMinY;
+  s32 mClipMaxX;
+  s32 mClipMaxY;
+
+  // state of the draw being rasterized, see Rasterize()
+  TacSoftwareDrawState mDraw;
+
+  // shaded pixels that passed the depth test, since the last SwapBuffers
+  u64 mNumPixelsShaded;
+  u64 mLastFrameNumPixelsShaded;
+};
@@ -0,0 +1,534 @@
+#include "tacAabbTree.h"
+
+TacAabb AabbFromSphere( const TacSphere& sphere )
+{
+  v3 radius = V3( sphere.radius, sphere.radius, sphere.radius );
+  TacAabb result;
+  result.mini = sphere.position - radius;
+  result.maxi = sphere.position + radius;
+  return result;
+}
+
+TacAabb AabbUnion( const TacAabb& a, const TacAabb& b )
+{
+  TacAabb result;
+  for( u32 iAxis = 0; iAxis < 3; ++iAxis )
+  {
+    result.mini[ iAxis ] = Minimum( a.mini[ iAxis ], b.mini[ iAxis ] );
+    result.maxi[ iAxis ] = Maximum( a.maxi[ iAxis ], b.maxi[ iAxis ] );
+  }
+  return result;
+}
+
+b32 AabbOverlaps( const TacAabb& a, const TacAabb& b )
+{
+  for( u32 iAxis = 0; iAxis < 3; ++iAxis )
+  {
+    if( a.maxi[ iAxis ] < b.mini[ iAxis ] ||
+      b.maxi[ iAxis ] < a.mini[ iAxis ] )
+      return false;
+  }
+  return true;
+}
+
+b32 AabbContains( const TacAabb& outer, const TacAabb& inner )
+{
+  for( u32 iAxis = 0; iAxis < 3; ++iAxis )
+  {
+    if( inner.mini[ iAxis ] < outer.mini[ iAxis ] ||
+      inner.maxi[ iAxis ] > outer.maxi[ iAxis ] )
+      return false;
+  }
+  return true;
+}
+
+// half the surface area, which is all the insertion cost needs
+internalFunction r32 AabbArea( const TacAabb& aabb )
+{
+  v3 size = aabb.maxi - aabb.mini;
+  r32 result = size.x * size.y + size.y * size.z + size.z * size.x;
+  return result;
+}
+
+internalFunction b32 AabbOverlapsSphere(
+  const TacAabb& aabb,
+  const TacSphere& sphere )
+{
+  r32 distSq = 0;
+  for( u32 iAxis = 0; iAxis < 3; ++iAxis )
+  {
+    r32 val = sphere.position[ iAxis ];
+    r32 closest = val;
+    Clamp( closest, aabb.mini[ iAxis ], aabb.maxi[ iAxis ] );
+    distSq += Square( val - closest );
+  }
+  return distSq <= Square( sphere.radius );
+}
+
+internalFunction b32 AabbOverlapsRay(
+  const TacAabb& aabb,
+  const TacRay& ray,
+  r32 maxDist )
+{
+  r32 tMin = 0;
+  r32 tMax = maxDist;
+  for( u32 iAxis = 0; iAxis < 3; ++iAxis )
+  {
+    r32 pos = ray.pos[ iAxis ];
+    r32 dir = ray.dir[ iAxis ];
+    if( AbsoluteValue( dir ) < 0.000001f )
+    {
+      // parallel to the slab
+      if( pos < aabb.mini[ iAxis ] || pos > aabb.maxi[ iAxis ] )
+        return false;
+      continue;
+    }
+    r32 inverseDir = 1.0f / dir;
+    r32 t0 = ( aabb.mini[ iAxis ] - pos ) * inverseDir;
+    r32 t1 = ( aabb.maxi[ iAxis ] - pos ) * inverseDir;
+    tMin = Maximum( tMin, Minimum( t0, t1 ) );
+    tMax = Minimum( tMax, Maximum( t0, t1 ) );
+    if( tMax < tMin )
+      return false;
+  }
+  return true;
+}
+
+enum class TacFrustumOverlap
+{
+  Outside,
+  Intersects,
+  Inside,
+};
+
+internalFunction TacFrustumOverlap AabbOverlapsFrustum(
+  const TacAabb& aabb,
+  const TacFrustum& frustum )
+{
+  v3 center = ( aabb.mini + aabb.maxi ) * 0.5f;
+  v3 extents = ( aabb.maxi - aabb.mini ) * 0.5f;
+  TacFrustumOverlap result = TacFrustumOverlap::Inside;
+  for( const TacPlane& plane : frustum.planes )
+  {
+    r32 dist = Dot( plane.abc, center ) + plane.d;
+    r32 radius =
+      AbsoluteValue( plane.abc.x ) * extents.x +
+      AbsoluteValue( plane.abc.y ) * extents.y +
+      AbsoluteValue( plane.abc.z ) * extents.z;
+    if( dist < -radius )
+      return TacFrustumOverlap::Outside;
+    if( dist < radius )
+      result = TacFrustumOverlap::Intersects;
+  }
+  return result;
+}
+
+void AabbTreeInit( TacAabbTree* tree, r32 margin )
+{
+  tree->margin = margin;
+  AabbTreeClear( tree );
+}
+
+void AabbTreeClear( TacAabbTree* tree )
+{
+  tree->nodes.clear();
+  tree->leafNodes.clear();
+  tree->root = AABB_TREE_NULL;
+  tree->freeList = AABB_TREE_NULL;
+  tree->numLeaves = 0;
+}
+
+internalFunction s32 AabbTreeAllocateNode( TacAabbTree* tree )
+{
+  s32 nodeIndex = tree->freeList;
+  if( nodeIndex == AABB_TREE_NULL )
+  {
+    nodeIndex = ( s32 )tree->nodes.size();
+    tree->nodes.push_back( TacAabbTreeNode() );
+  }
+  else
+  {
+    tree->freeList = tree->nodes[ nodeIndex ].parent;
+  }
+  TacAabbTreeNode& node = tree->nodes[ nodeIndex ];
+  node = {};
+  node.parent = AABB_TREE_NULL;
+  node.child0 = AABB_TREE_NULL;
+  node.child1 = AABB_TREE_NULL;
+  return nodeIndex;
+}
+
+internalFunction void AabbTreeFreeNode( TacAabbTree* tree, s32 nodeIndex )
+{
+  TacAabbTreeNode& node = tree->nodes[ nodeIndex ];
+  node.parent = tree->freeList;
+  node.height = -1;
+  tree->freeList = nodeIndex;
+}
+
+internalFunction void AabbTreeReplaceChild(
+  TacAabbTree* tree,
+  s32 parentIndex,
+  s32 oldChild,
+  s32 newChild )
+{
+  if( parentIndex == AABB_TREE_NULL )
+  {
+    tree->root = newChild;
+    return;
+  }
+  TacAabbTreeNode& parent = tree->nodes[ parentIndex ];
+  if( parent.child0 == oldChild )
+    parent.child0 = newChild;
+  else
+    parent.child1 = newChild;
+}
+
+// If one child of a is two levels taller than the other, rotates the
+// taller child up into a's place. Returns the node that is now there
+internalFunction s32 AabbTreeBalance( TacAabbTree* tree, s32 iA )
+{
+  TacAabbTreeNode& a = tree->nodes[ iA ];
+  if( a.height < 2 )
+    return iA;
+
+  s32 iB = a.child0;
+  s32 iC = a.child1;
+  TacAabbTreeNode& b = tree->nodes[ iB ];
+  TacAabbTreeNode& c = tree->nodes[ iC ];
+  s32 balance = c.height - b.height;
+
+  if( balance > 1 )
+  {
+    // rotate c up
+    s32 iF = c.child0;
+    s32 iG = c.child1;
+    TacAabbTreeNode& f = tree->nodes[ iF ];
+    TacAabbTreeNode& g = tree->nodes[ iG ];
+    c.child0 = iA;
+    c.parent = a.parent;
+    a.parent = iC;
+    AabbTreeReplaceChild( tree, c.parent, iA, iC );
+
+    // the taller grandchild stays with c
+    s32 iKept = f.height > g.height ? iF : iG;
+    s32 iMoved = f.height > g.height ? iG : iF;
+    TacAabbTreeNode& kept = tree->nodes[ iKept ];
+    TacAabbTreeNode& moved = tree->nodes[ iMoved ];
+    c.child1 = iKept;
+    a.child1 = iMoved;
+    moved.parent = iA;
+    a.aabb = AabbUnion( b.aabb, moved.aabb );
+    c.aabb = AabbUnion( a.aabb, kept.aabb );
+    a.height = 1 + Maximum( b.height, moved.height );
+    c.height = 1 + Maximum( a.height, kept.height );
+    return iC;
+  }
+
+  if( balance < -1 )
+  {
+    // rotate b up
+    s32 iD = b.child0;
+    s32 iE = b.child1;
+    TacAabbTreeNode& d = tree->nodes[ iD ];
+    TacAabbTreeNode& e = tree->nodes[ iE ];
+    b.child0 = iA;
+    b.parent = a.parent;
+    a.parent = iB;
+    AabbTreeReplaceChild( tree, b.parent, iA, iB );
+
+    s32 iKept = d.height > e.height ? iD : iE;
+    s32 iMoved = d.height > e.height ? iE : iD;
+    TacAabbTreeNode& kept = tree->nodes[ iKept ];
+    TacAabbTreeNode& moved = tree->nodes[ iMoved ];
+    b.child1 = iKept;
+    a.child0 = iMoved;
+    moved.parent = iA;
+    a.aabb = AabbUnion( c.aabb, moved.aabb );
+    b.aabb = AabbUnion( a.aabb, kept.aabb );
+    a.height = 1 + Maximum( c.height, moved.height );
+    b.height = 1 + Maximum( a.height, kept.height );
+    return iB;
+  }
+
+  return iA;
+}
+
+// Balances and refits from nodeIndex up to the root
+internalFunction void AabbTreeRefit( TacAabbTree* tree, s32 nodeIndex )
+{
+  while( nodeIndex != AABB_TREE_NULL )
+  {
+    nodeIndex = AabbTreeBalance( tree, nodeIndex );
+    TacAabbTreeNode& node = tree->nodes[ nodeIndex ];
+    const TacAabbTreeNode& child0 = tree->nodes[ node.child0 ];
+    const TacAabbTreeNode& child1 = tree->nodes[ node.child1 ];
+    node.height = 1 + Maximum( child0.height, child1.height );
+    node.aabb = AabbUnion( child0.aabb, child1.aabb );
+    nodeIndex = node.parent;
+  }
+}
+
+internalFunction void AabbTreeInsertLeaf( TacAabbTree* tree, s32 leaf )
+{
+  if( tree->root == AABB_TREE_NULL )
+  {
+    tree->root = leaf;
+    tree->nodes[ leaf ].parent = AABB_TREE_NULL;
+    return;
+  }
+
+  // Walk down to the sibling that grows the total area the least.
+  // Every node above the sibling grows by the same amount, so going
+  // further down only pays if it's cheaper than stopping here
+  TacAabb leafAabb = tree->nodes[ leaf ].aabb;
+  s32 sibling = tree->root;
+  while( tree->nodes[ sibling ].height > 0 )
+  {
+    const TacAabbTreeNode& node = tree->nodes[ sibling ];
+    r32 area = AabbArea( node.aabb );
+    r32 combinedArea = AabbArea( AabbUnion( node.aabb, leafAabb ) );
+    r32 cost = 2.0f * combinedArea;
+    r32 inheritedCost = 2.0f * ( combinedArea - area );
+
+    r32 childCosts[ 2 ];
+    s32 children[ 2 ] = { node.child0, node.child1 };
+    for( u32 iChild = 0; iChild < 2; ++iChild )
+    {
+      const TacAabbTreeNode& child = tree->nodes[ children[ iChild ] ];
+      r32 childCost = AabbArea( AabbUnion( child.aabb, leafAabb ) );
+      if( child.height > 0 )
+        childCost -= AabbArea( child.aabb );
+      childCosts[ iChild ] = childCost + inheritedCost;
+    }
+
+    if( cost < childCosts[ 0 ] && cost < childCosts[ 1 ] )
+      break;
+    sibling = childCosts[ 0 ] < childCosts[ 1 ] ? children[ 0 ] : children[ 1 ];
+  }
+
+  // allocating can move the nodes, so no references until after
+  s32 newParent = AabbTreeAllocateNode( tree );
+  s32 oldParent = tree->nodes[ sibling ].parent;
+  TacAabbTreeNode& parent = tree->nodes[ newParent ];
+  parent.parent = oldParent;
+  parent.aabb = AabbUnion( leafAabb, tree->nodes[ sibling ].aabb );
+  parent.height = tree->nodes[ sibling ].height + 1;
+  parent.child0 = sibling;
+  parent.child1 = leaf;
+  tree->nodes[ sibling ].parent = newParent;
+  tree->nodes[ leaf ].parent = newParent;
+  AabbTreeReplaceChild( tree, oldParent, sibling, newParent );
+
+  AabbTreeRefit( tree, newParent );
+}
+
+internalFunction void AabbTreeRemoveLeaf( TacAabbTree* tree, s32 leaf )
+{
+  if( leaf == tree->root )
+  {
+    tree->root = AABB_TREE_NULL;
+    return;
+  }
+
+  // the sibling takes the parent's place
+  s32 parent = tree->nodes[ leaf ].parent;
+  s32 grandParent = tree->nodes[ parent ].parent;
+  s32 sibling =
+    tree->nodes[ parent ].child0 == leaf ?
+    tree->nodes[ parent ].child1 :
+    tree->nodes[ parent ].child0;
+  AabbTreeReplaceChild( tree, grandParent, parent, sibling );
+  tree->nodes[ sibling ].parent = grandParent;
+  AabbTreeFreeNode( tree, parent );
+
+  AabbTreeRefit( tree, grandParent );
+}
+
+internalFunction TacAabb AabbTreeFatten(
+  const TacAabbTree* tree,
+  const TacAabb& aabb )
+{
+  v3 margin = V3( tree->margin, tree->margin, tree->margin );
+  TacAabb result;
+  result.mini = aabb.mini - margin;
+  result.maxi = aabb.maxi + margin;
+  return result;
+}
+
+b32 AabbTreeNeedsUpdate(
+  const TacAabbTree* tree,
+  u32 key,
+  const TacAabb& aabb )
+{
+  if( key >= tree->leafNodes.size() )
+    return true;
+  s32 leaf = tree->leafNodes[ key ];
+  if( leaf == AABB_TREE_NULL )
+    return true;
+  return !AabbContains( tree->nodes[ leaf ].aabb, aabb );
+}
+
+void AabbTreeUpdate( TacAabbTree* tree, u32 key, const TacAabb& aabb )
+{
+  if( key >= tree->leafNodes.size() )
+    tree->leafNodes.resize( key + 1, AABB_TREE_NULL );
+
+  s32 leaf = tree->leafNodes[ key ];
+  if( leaf == AABB_TREE_NULL )
+  {
+    leaf = AabbTreeAllocateNode( tree );
+    tree->nodes[ leaf ].key = key;
+    tree->leafNodes[ key ] = leaf;
+    tree->numLeaves++;
+  }
+  else
+  {
+    if( AabbContains( tree->nodes[ leaf ].aabb, aabb ) )
+      return;
+    AabbTreeRemoveLeaf( tree, leaf );
+  }
+
+  tree->nodes[ leaf ].aabb = AabbTreeFatten( tree, aabb );
+  AabbTreeInsertLeaf( tree, leaf );
+}
+
+void AabbTreeRemove( TacAabbTree* tree, u32 key )
+{
+  if( key >= tree->leafNodes.size() )
+    return;
+  s32 leaf = tree->leafNodes[ key ];
+  if( leaf == AABB_TREE_NULL )
+    return;
+  AabbTreeRemoveLeaf( tree, leaf );
+  AabbTreeFreeNode( tree, leaf );
+  tree->leafNodes[ key ] = AABB_TREE_NULL;
+  tree->numLeaves--;
+}
+
+s32 AabbTreeHeight( const TacAabbTree* tree )
+{
+  if( tree->root == AABB_TREE_NULL )
+    return 0;
+  return tree->nodes[ tree->root ].height;
+}
+
+// Depth first, writing the keys of the leaves whose boxes pass overlaps.
+// The tree is balanced, so the stack stays around twice log2 of the
+// number of leaves
+template< typename Overlaps >
+internalFunction u32 AabbTreeQuery(
+  const TacAabbTree* tree,
+  const Overlaps& overlaps,
+  u32* keys,
+  u32 maxKeys )
+{
+  if( tree->root == AABB_TREE_NULL )
+    return 0;
+
+  u32 numKeys = 0;
+  s32 stack[ 256 ];
+  u32 stackSize = 0;
+  stack[ stackSize++ ] = tree->root;
+  while( stackSize && numKeys < maxKeys )
+  {
+    const TacAabbTreeNode& node = tree->nodes[ stack[ --stackSize ] ];
+    if( !overlaps( node.aabb ) )
+      continue;
+    if( node.height == 0 )
+    {
+      keys[ numKeys++ ] = node.key;
+      continue;
+    }
+    TacAssert( stackSize + 2 <= ArraySize( stack ) );
+    stack[ stackSize++ ] = node.child0;
+    stack[ stackSize++ ] = node.child1;
+  }
+  return numKeys;
+}
+
+u32 AabbTreeQueryFrustum(
+  const TacAabbTree* tree,
+  const TacFrustum& frustum,
+  u32* keys,
+  u32 maxKeys )
+{
+  if( tree->root == AABB_TREE_NULL )
+    return 0;
+
+  // everything under a node that's inside the frustum is inside too, so
+  // it's collected without testing any more planes
+  u32 numKeys = 0;
+  s32 stack[ 256 ];
+  b32 stackInside[ 256 ];
+  u32 stackSize = 0;
+  stack[ stackSize ] = tree->root;
+  stackInside[ stackSize++ ] = false;
+  while( stackSize && numKeys < maxKeys )
+  {
+    --stackSize;
+    const TacAabbTreeNode& node = tree->nodes[ stack[ stackSize ] ];
+    b32 inside = stackInside[ stackSize ];
+    if( !inside )
+    {
+      TacFrustumOverlap overlap = AabbOverlapsFrustum( node.aabb, frustum );
+      if( overlap == TacFrustumOverlap::Outside )
+        continue;
+      inside = overlap == TacFrustumOverlap::Inside;
+    }
+    if( node.height == 0 )
+    {
+      keys[ numKeys++ ] = node.key;
+      continue;
+    }
+    TacAssert( stackSize + 2 <= ArraySize( stack ) );
+    stack[ stackSize ] = node.child0;
+    stackInside[ stackSize++ ] = inside;
+    stack[ stackSize ] = node.child1;
+    stackInside[ stackSize++ ] = inside;
+  }
+  return numKeys;
+}
+
+u32 AabbTreeQueryRay(
+  const TacAabbTree* tree,
+  const TacRay& ray,
+  r32 maxDist,
+  u32* keys,
+  u32 maxKeys )
+{
+  return AabbTreeQuery(
+    tree,
+    [ & ]( const TacAabb& aabb )
+    {
+      return AabbOverlapsRay( aabb, ray, maxDist );
+    },
+    keys,
+    maxKeys );
+}
+
+u32 AabbTreeQuerySphere(
+  const TacAabbTree* tree,
+  const TacSphere& sphere,
+  u32* keys,
+  u32 maxKeys )
+{
+  return AabbTreeQuery(
+    tree,
+    [ & ]( const TacAabb& aabb ) { return AabbOverlapsSphere( aabb, sphere ); },
+    keys,
+    maxKeys );
+}
+
+u32 AabbTreeQueryAabb(
+  const TacAabbTree* tree,
+  const TacAabb& aabb,
+  u32* keys,
+  u32 maxKeys )
+{
+  return AabbTreeQuery(
+    tree,
+    [ & ]( const TacAabb& nodeAabb ) { return AabbOverlaps( nodeAabb, aabb ); },
+    keys,
+    maxKeys );
+}
@@ -0,0 +1,100 @@
+#pragma once
+#include "tacCulling.h"
+#include "tacMemoryAllocator.h"
+
+#include <vector>
+
+#define AABB_TREE_NULL -1
+
+struct TacAabb
+{
+  v3 mini;
+  v3 maxi;
+};
+
+TacAabb AabbFromSphere( const TacSphere& sphere );
+TacAabb AabbUnion( const TacAabb& a, const TacAabb& b );
+b32 AabbOverlaps( const TacAabb& a, const TacAabb& b );
+b32 AabbContains( const TacAabb& outer, const TacAabb& inner );
+
+struct TacAabbTreeNode
+{
+  TacAabb aabb;
+
+  // the next free node when the node is on the free list
+  s32 parent;
+
+  // both AABB_TREE_NULL for leaves
+  s32 child0;
+  s32 child1;
+
+  // 0 for leaves, -1 for free nodes
+  s32 height;
+
+  // the key of a leaf, ie: an entity index
+  u32 key;
+};
+
+// A dynamic bounding volume hierarchy with one leaf per key.
+//
+// Leaves are stored with a margin, so a key whose box moves a little doesn't
+// change the tree. The tree is kept balanced with rotations, so the queries
+// visit O( log n ) nodes when the boxes don't overlap much.
+//
+// The queries write the keys of the leaves they touch to keys, and return
+// how many they wrote. Leaf boxes are fattened by the margin, so a query is
+// conservative, the caller does the exact test.
+struct TacAabbTree
+{
+  std::vector< TacAabbTreeNode, TacMemoryAllocator< TacAabbTreeNode > > nodes;
+
+  // the leaf node of each key, or AABB_TREE_NULL
+  std::vector< s32, TacMemoryAllocator< s32 > > leafNodes;
+
+  s32 root;
+  s32 freeList;
+  u32 numLeaves;
+  r32 margin;
+};
+
+void AabbTreeInit( TacAabbTree* tree, r32 margin );
+void AabbTreeClear( TacAabbTree* tree );
+
+// Returns true if the key has to be moved in the tree, ie: it isn't in the
+// tree or aabb doesn't fit in its fattened box. Doesn't change the tree, so
+// it can be called from the workers
+b32 AabbTreeNeedsUpdate(
+  const TacAabbTree* tree,
+  u32 key,
+  const TacAabb& aabb );
+
+// Adds the key, or moves it if aabb doesn't fit in its fattened box
+void AabbTreeUpdate( TacAabbTree* tree, u32 key, const TacAabb& aabb );
+void AabbTreeRemove( TacAabbTree* tree, u32 key );
+
+s32 AabbTreeHeight( const TacAabbTree* tree );
+
+u32 AabbTreeQueryFrustum(
+  const TacAabbTree* tree,
+  const TacFrustum& frustum,
+  u32* keys,
+  u32 maxKeys );
+
+u32 AabbTreeQueryRay(
+  const TacAabbTree* tree,
+  const TacRay& ray,
+  r32 maxDist,
+  u32* keys,
+  u32 maxKeys );
+
+u32 AabbTreeQuerySphere(
+  const TacAabbTree* tree,
+  const TacSphere& sphere,
+  u32* keys,
+  u32 maxKeys );
+
+u32 AabbTreeQueryAabb(
+  const TacAabbTree* tree,
+  const TacAabb& aabb,
+  u32* keys,
+  u32 maxKeys );
@@ -0,0 +1,138 @@
+#include "tacCulling.h"
+
+internalFunction TacPlane PlaneThroughOrigin( v3 a, v3 b )
+{
+  TacPlane result;
+  result.abc = Normalize( Cross( a, b ) );
+  result.d = 0;
+  return result;
+}
+
+TacFrustum FrustumFromViewSpaceCorners(
+  const v3 viewSpaceFarCorners[ 4 ],
+  r32 camNear,
+  r32 camFar,
+  const m4& view )
+{
+  const v3* corners = viewSpaceFarCorners;
+
+  // in view space the camera is at the origin looking down -z, so the
+  // side planes go through the origin and two neighbouring far corners
+  TacPlane viewSpacePlanes[ TacFrustum::Count ];
+  viewSpacePlanes[ TacFrustum::Bottom ] =
+    PlaneThroughOrigin( corners[ 1 ], corners[ 0 ] );
+  viewSpacePlanes[ TacFrustum::Right ] =
+    PlaneThroughOrigin( corners[ 2 ], corners[ 1 ] );
+  viewSpacePlanes[ TacFrustum::Top ] =
+    PlaneThroughOrigin( corners[ 3 ], corners[ 2 ] );
+  viewSpacePlanes[ TacFrustum::Left ] =
+    PlaneThroughOrigin( corners[ 0 ], corners[ 3 ] );
+  viewSpacePlanes[ TacFrustum::Near ].abc = V3( 0.0f, 0.0f, -1.0f );
+  viewSpacePlanes[ TacFrustum::Near ].d = -camNear;
+  viewSpacePlanes[ TacFrustum::Far ].abc = V3( 0.0f, 0.0f, 1.0f );
+  viewSpacePlanes[ TacFrustum::Far ].d = camFar;
+
+  // For a world space point p, Dot( plane, view * p ) equals
+  // Dot( transpose( view ) * plane, p ). The view matrix has no scale,
+  // so the normals stay normalized
+  m4 viewTranspose = Transpose( view );
+  TacFrustum result;
+  for( u32 iPlane = 0; iPlane < TacFrustum::Count; ++iPlane )
+  {
+    const TacPlane& viewSpacePlane = viewSpacePlanes[ iPlane ];
+    v4 plane = viewTranspose * V4( viewSpacePlane.abc, viewSpacePlane.d );
+    result.planes[ iPlane ].abc = plane.xyz;
+    result.planes[ iPlane ].d = plane.w;
+  }
+  return result;
+}
+
+b32 SphereInFrustum( const TacFrustum& frustum, const TacSphere& sphere )
+{
+  for( const TacPlane& plane : frustum.planes )
+  {
+    r32 dist = Dot( plane.abc, sphere.position ) + plane.d;
+    if( dist < -sphere.radius )
+      return false;
+  }
+  return true;
+}
+
+u32 CullSpheresScalar(
+  const TacFrustum& frustum,
+  const TacSpheresSoA& spheres,
+  u8* visible )
+{
+  u32 numVisible = 0;
+  for( u32 i = 0; i < spheres.count; ++i )
+  {
+    TacSphere sphere;
+    sphere.position = V3( spheres.xs[ i ], spheres.ys[ i ], spheres.zs[ i ] );
+    sphere.radius = spheres.radii[ i ];
+    visible[ i ] = SphereInFrustum( frustum, sphere ) ? 1 : 0;
+    numVisible += visible[ i ];
+  }
+  return numVisible;
+}
+
+u32 CullSpheres(
+  const TacFrustum& frustum,
+  const TacSpheresSoA& spheres,
+  u8* visible )
+{
+  // each plane component in all four lanes
+  r32x4 planeAs[ TacFrustum::Count ];
+  r32x4 planeBs[ TacFrustum::Count ];
+  r32x4 planeCs[ TacFrustum::Count ];
+  r32x4 planeDs[ TacFrustum::Count ];
+  for( u32 iPlane = 0; iPlane < TacFrustum::Count; ++iPlane )
+  {
+    const TacPlane& plane = frustum.planes[ iPlane ];
+    planeAs[ iPlane ] = R32x4Set( plane.abc.x );
+    planeBs[ iPlane ] = R32x4Set( plane.abc.y );
+    planeCs[ iPlane ] = R32x4Set( plane.abc.z );
+    planeDs[ iPlane ] = R32x4Set( plane.d );
+  }
+  const r32x4 zero = R32x4Set( 0 );
+
+  u32 numVisible = 0;
+  u32 numWide = spheres.count & ~3u;
+  for( u32 i = 0; i < numWide; i += 4 )
+  {
+    r32x4 xs = R32x4Load( spheres.xs + i );
+    r32x4 ys = R32x4Load( spheres.ys + i );
+    r32x4 zs = R32x4Load( spheres.zs + i );
+    r32x4 negRadii = R32x4Sub( zero, R32x4Load( spheres.radii + i ) );
+
+    // all lanes start out visible
+    u32 insideBits = 0xf;
+    for( u32 iPlane = 0; iPlane < TacFrustum::Count; ++iPlane )
+    {
+      r32x4 dists = R32x4Add(
+        R32x4Add(
+        R32x4Mul( planeAs[ iPlane ], xs ),
+        R32x4Mul( planeBs[ iPlane ], ys ) ),
+        R32x4Add(
+        R32x4Mul( planeCs[ iPlane ], zs ),
+        planeDs[ iPlane ] ) );
+      insideBits &= R32x4GreaterEqualBits( dists, negRadii );
+    }
+
+    for( u32 iLane = 0; iLane < 4; ++iLane )
+    {
+      u8 laneVisible = ( insideBits >> iLane ) & 1;
+      visible[ i + iLane ] = laneVisible;
+      numVisible += laneVisible;
+    }
+  }
+
+  // the last few that don't fill a register
+  TacSpheresSoA tail;
+  tail.xs = spheres.xs + numWide;
+  tail.ys = spheres.ys + numWide;
+  tail.zs = spheres.zs + numWide;
+  tail.radii = spheres.radii + numWide;
+  tail.count = spheres.count - numWide;
+  numVisible += CullSpheresScalar( frustum, tail, visible + numWide );
+  return numVisible;
+}
@@ -0,0 +1,46 @@
+#pragma once
+#include "tacRaycast.h"
+#include "tacMath.h"
+
+// The six planes of a camera frustum.
+// Normals point into the frustum, so a point p is inside a plane when
+// Dot( plane.abc, p ) + plane.d >= 0
+struct TacFrustum
+{
+  enum Plane { Left, Right, Bottom, Top, Near, Far, Count };
+  TacPlane planes[ Count ];
+};
+
+// viewSpaceFarCorners - the corners of the far plane in view space,
+//                       counterclockwise from the bottom left, the way
+//                       GetFrustumCorners returns them
+// view - the world to view matrix
+TacFrustum FrustumFromViewSpaceCorners(
+  const v3 viewSpaceFarCorners[ 4 ],
+  r32 camNear,
+  r32 camFar,
+  const m4& view );
+
+b32 SphereInFrustum( const TacFrustum& frustum, const TacSphere& sphere );
+
+struct TacCullStats
+{
+  u32 numTested;
+  u32 numVisible;
+
+  // visible ones that were hidden behind an occluder
+  u32 numOccluded;
+};
+
+// Writes visible[ i ] = 1 for the spheres that touch the frustum, and 0
+// for the ones that don't. Returns the number of visible spheres
+u32 CullSpheres(
+  const TacFrustum& frustum,
+  const TacSpheresSoA& spheres,
+  u8* visible );
+
+// same results as CullSpheres, one sphere at a time
+u32 CullSpheresScalar(
+  const TacFrustum& frustum,
+  const TacSpheresSoA& spheres,
+  u8* visible );
@@ -0,0 +1,290 @@
+#include "tacFastMath.h"
+#include "tacDefines.h"
+
+#include <vector>
+
+// The cephes sinf / cosf approximation. The angles are reduced to
+// [ -pi / 4, pi / 4 ] by octant, and one polynomial each covers that range
+void FastSinCos( __m128 x, __m128* sines, __m128* cosines )
+{
+  const __m128 signBit = _mm_set1_ps( -0.0f );
+  const __m128 fourOverPi = _mm_set1_ps( 1.27323954473516f );
+
+  // pi / 4 split in three, so the reduction doesn't lose bits
+  const __m128 piOverFour0 = _mm_set1_ps( -0.78515625f );
+  const __m128 piOverFour1 = _mm_set1_ps( -2.4187564849853515625e-4f );
+  const __m128 piOverFour2 = _mm_set1_ps( -3.77489497744594108e-8f );
+
+  __m128 sinSigns = _mm_and_ps( x, signBit );
+  x = _mm_andnot_ps( signBit, x );
+
+  // the even octant at or above x
+  __m128i octants = _mm_cvttps_epi32( _mm_mul_ps( x, fourOverPi ) );
+  octants = _mm_add_epi32( octants, _mm_set1_epi32( 1 ) );
+  octants = _mm_and_si128( octants, _mm_set1_epi32( ~1 ) );
+  __m128 y = _mm_cvtepi32_ps( octants );
+
+  sinSigns = _mm_xor_ps( sinSigns, _mm_castsi128_ps( _mm_slli_epi32(
+    _mm_and_si128( octants, _mm_set1_epi32( 4 ) ), 29 ) ) );
+  __m128 cosSigns = _mm_castsi128_ps( _mm_slli_epi32( _mm_andnot_si128(
+    _mm_sub_epi32( octants, _mm_set1_epi32( 2 ) ),
+    _mm_set1_epi32( 4 ) ), 29 ) );
+
+  // octants 2 and 6 swap the sine and cosine polynomials
+  __m128 swap = _mm_castsi128_ps( _mm_cmpeq_epi32(
+    _mm_and_si128( octants, _mm_set1_epi32( 2 ) ),
+    _mm_setzero_si128() ) );
+
+  x = _mm_add_ps( x, _mm_mul_ps( y, piOverFour0 ) );
+  x = _mm_add_ps( x, _mm_mul_ps( y, piOverFour1 ) );
+  x = _mm_add_ps( x, _mm_mul_ps( y, piOverFour2 ) );
+  __m128 z = _mm_mul_ps( x, x );
+
+  __m128 cosPoly = _mm_set1_ps( 2.443315711809948e-5f );
+  cosPoly = _mm_add_ps(
+    _mm_mul_ps( cosPoly, z ),
+    _mm_set1_ps( -1.388731625493765e-3f ) );
+  cosPoly = _mm_add_ps(
+    _mm_mul_ps( cosPoly, z ),
+    _mm_set1_ps( 4.166664568298827e-2f ) );
+  cosPoly = _mm_mul_ps( _mm_mul_ps( cosPoly, z ), z );
+  cosPoly = _mm_sub_ps( cosPoly, _mm_mul_ps( z, _mm_set1_ps( 0.5f ) ) );
+  cosPoly = _mm_add_ps( cosPoly, _mm_set1_ps( 1.0f ) );
+
+  __m128 sinPoly = _mm_set1_ps( -1.9515295891e-4f );
+  sinPoly = _mm_add_ps(
+    _mm_mul_ps( sinPoly, z ),
+    _mm_set1_ps( 8.3321608736e-3f ) );
+  sinPoly = _mm_add_ps(
+    _mm_mul_ps( sinPoly, z ),
+    _mm_set1_ps( -1.6666654611e-1f ) );
+  sinPoly = _mm_add_ps( _mm_mul_ps( _mm_mul_ps( sinPoly, z ), x ), x );
+
+  __m128 sinResult = _mm_or_ps(
+    _mm_and_ps( swap, sinPoly ),
+    _mm_andnot_ps( swap, cosPoly ) );
+  __m128 cosResult = _mm_or_ps(
+    _mm_and_ps( swap, cosPoly ),
+    _mm_andnot_ps( swap, sinPoly ) );
+  *sines = _mm_xor_ps( sinResult, sinSigns );
+  *cosines = _mm_xor_ps( cosResult, cosSigns );
+}
+
+__m128 FastAcos( __m128 x )
+{
+  const __m128 signBit = _mm_set1_ps( -0.0f );
+  const __m128 one = _mm_set1_ps( 1.0f );
+  const __m128 half = _mm_set1_ps( 0.5f );
+  const __m128 pi = _mm_set1_ps( PI32 );
+
+  __m128 signs = _mm_and_ps( x, signBit );
+  __m128 a = _mm_min_ps( _mm_andnot_ps( signBit, x ), one );
+
+  // Past 0.5, acos( a ) = 2 asin( sqrt( ( 1 - a ) / 2 ) ), which keeps the
+  // asin polynomial on [ 0, 0.5 ] where it's accurate
+  __m128 big = _mm_cmpgt_ps( a, half );
+  __m128 bigZ = _mm_mul_ps( half, _mm_sub_ps( one, a ) );
+  __m128 z = _mm_or_ps(
+    _mm_and_ps( big, bigZ ),
+    _mm_andnot_ps( big, _mm_mul_ps( a, a ) ) );
+  __m128 s = _mm_or_ps(
+    _mm_and_ps( big, _mm_sqrt_ps( bigZ ) ),
+    _mm_andnot_ps( big, a ) );
+
+  // cephes asinf
+  __m128 poly = _mm_set1_ps( 4.2163199048e-2f );
+  poly = _mm_add_ps(
+    _mm_mul_ps( poly, z ),
+    _mm_set1_ps( 2.4181311049e-2f ) );
+  poly = _mm_add_ps(
+    _mm_mul_ps( poly, z ),
+    _mm_set1_ps( 4.5470025998e-2f ) );
+  poly = _mm_add_ps(
+    _mm_mul_ps( poly, z ),
+    _mm_set1_ps( 7.4953002686e-2f ) );
+  poly = _mm_add_ps(
+    _mm_mul_ps( poly, z ),
+    _mm_set1_ps( 1.6666752422e-1f ) );
+  __m128 asins = _mm_add_ps( s, _mm_mul_ps( _mm_mul_ps( s, z ), poly ) );
+
+  // acos( x ) = pi / 2 - asin( x ) near zero, and either 2 asin or
+  // pi - 2 asin out by the ends
+  __m128 smallResult = _mm_sub_ps(
+    _mm_set1_ps( HALFPI32 ),
+    _mm_xor_ps( asins, signs ) );
+  __m128 bigResult = _mm_add_ps(
+    _mm_xor_ps( _mm_add_ps( asins, asins ), signs ),
+    _mm_and_ps( _mm_cmplt_ps( x, _mm_setzero_ps() ), pi ) );
+  __m128 result = _mm_or_ps(
+    _mm_and_ps( big, bigResult ),
+    _mm_andnot_ps( big, smallResult ) );
+  return result;
+}
+
+// The cephes expf approximation. x = n ln( 2 ) + r with r in
+// [ -ln( 2 ) / 2, ln( 2 ) / 2 ], so exp( x ) = 2^n exp( r ), and 2^n goes
+// straight into the exponent bits
+__m128 FastExp( __m128 x )
+{
+  const __m128 one = _mm_set1_ps( 1.0f );
+  x = _mm_min_ps( x, _mm_set1_ps( 88.3762626647949f ) );
+  x = _mm_max_ps( x, _mm_set1_ps( -87.3365478515625f ) );
+
+  // n = floor( x / ln( 2 ) + 0.5 )
+  __m128 n = _mm_add_ps(
+    _mm_mul_ps( x, _mm_set1_ps( 1.44269504088896341f ) ),
+    _mm_set1_ps( 0.5f ) );
+  __m128 truncated = _mm_cvtepi32_ps( _mm_cvttps_epi32( n ) );
+  n = _mm_sub_ps(
+    truncated,
+    _mm_and_ps( _mm_cmpgt_ps( truncated, n ), one ) );
+
+  // ln( 2 ) split in two, so the reduction doesn't lose bits
+  x = _mm_sub_ps( x, _mm_mul_ps( n, _mm_set1_ps( 0.693359375f ) ) );
+  x = _mm_sub_ps( x, _mm_mul_ps( n, _mm_set1_ps( -2.12194440e-4f ) ) );
+  __m128 z = _mm_mul_ps( x, x );
+
+  __m128 poly = _mm_set1_ps( 1.9875691500e-4f );
+  poly = _mm_add_ps(
+    _mm_mul_ps( poly, x ),
+    _mm_set1_ps( 1.3981999507e-3f ) );
+  poly = _mm_add_ps(
+    _mm_mul_ps( poly, x ),
+    _mm_set1_ps( 8.3334519073e-3f ) );
+  poly = _mm_add_ps(
+    _mm_mul_ps( poly, x ),
+    _mm_set1_ps( 4.1665795894e-2f ) );
+  poly = _mm_add_ps(
+    _mm_mul_ps( poly, x ),
+    _mm_set1_ps( 1.6666665459e-1f ) );
+  poly = _mm_add_ps(
+    _mm_mul_ps( poly, x ),
+    _mm_set1_ps( 5.0000001201e-1f ) );
+  poly = _mm_add_ps( _mm_add_ps( _mm_mul_ps( poly, z ), x ), one );
+
+  __m128i exponents = _mm_slli_epi32(
+    _mm_add_epi32( _mm_cvttps_epi32( n ), _mm_set1_epi32( 127 ) ),
+    23 );
+  __m128 result = _mm_mul_ps( poly, _mm_castsi128_ps( exponents ) );
+  return result;
+}
+
+void FastSinCos( r32 angle, r32* sine, r32* cosine )
+{
+  __m128 sines;
+  __m128 cosines;
+  FastSinCos( _mm_set_ss( angle ), &sines, &cosines );
+  *sine = _mm_cvtss_f32( sines );
+  *cosine = _mm_cvtss_f32( cosines );
+}
+
+r32 FastAcos( r32 x )
+{
+  r32 result = _mm_cvtss_f32( FastAcos( _mm_set_ss( x ) ) );
+  return result;
+}
+
+r32 FastExp( r32 x )
+{
+  r32 result = _mm_cvtss_f32( FastExp( _mm_set_ss( x ) ) );
+  return result;
+}
+
+struct TacFastMathBenchmarkResult
+{
+  u64 libmCycles;
+  u64 fastCycles;
+  r32 maxError;
+};
+
+// Runs libm and the approximation over inputs, timing each and keeping
+// the largest difference. relative divides the difference by libm's value
+template< typename LibmFn, typename FastFn >
+internalFunction TacFastMathBenchmarkResult FastMathBenchmarkFunction(
+  const std::vector< r32 >& inputs,
+  b32 relative,
+  LibmFn libmFn,
+  FastFn fastFn )
+{
+  u32 count = inputs.size();
+  std::vector< r32 > libmOutputs( count );
+  std::vector< r32 > fastOutputs( count );
+  TacFastMathBenchmarkResult result = {};
+
+  u64 begin = ReadCycleCounter();
+  for( u32 i = 0; i < count; ++i )
+    libmOutputs[ i ] = libmFn( inputs[ i ] );
+  result.libmCycles = ReadCycleCounter() - begin;
+
+  begin = ReadCycleCounter();
+  for( u32 i = 0; i < count; i += 4 )
+    _mm_storeu_ps( &fastOutputs[ i ], fastFn( _mm_loadu_ps( &inputs[ i ] ) ) );
+  result.fastCycles = ReadCycleCounter() - begin;
+
+  for( u32 i = 0; i < count; ++i )
+  {
+    r32 error = AbsoluteValue( fastOutputs[ i ] - libmOutputs[ i ] );
+    if( relative )
+      error /= AbsoluteValue( libmOutputs[ i ] );
+    result.maxError = Maximum( result.maxError, error );
+  }
+  return result;
+}
+
+void FastMathBenchmark()
+{
+  // a multiple of four, so the fast loops don't need a tail
+  const u32 count = 1 << 20;
+  std::vector< r32 > inputs( count );
+  auto Fill = [ & ]( r32 r0, r32 r1 )
+  {
+    for( u32 i = 0; i < count; ++i )
+      inputs[ i ] = Lerp( r0, r1, i / ( r32 )( count - 1 ) );
+  };
+
+  Fill( -8192.0f, 8192.0f );
+  TacFastMathBenchmarkResult sines = FastMathBenchmarkFunction(
+    inputs,
+    false,
+    []( r32 x ){ return Sin( x ); },
+    []( __m128 x ){ __m128 s, c; FastSinCos( x, &s, &c ); return s; } );
+  TacFastMathBenchmarkResult cosines = FastMathBenchmarkFunction(
+    inputs,
+    false,
+    []( r32 x ){ return Cos( x ); },
+    []( __m128 x ){ __m128 s, c; FastSinCos( x, &s, &c ); return c; } );
+
+  Fill( -1.0f, 1.0f );
+  TacFastMathBenchmarkResult acoses = FastMathBenchmarkFunction(
+    inputs,
+    false,
+    []( r32 x ){ return Acos( x ); },
+    []( __m128 x ){ return FastAcos( x ); } );
+
+  Fill( -87.0f, 88.0f );
+  TacFastMathBenchmarkResult exps = FastMathBenchmarkFunction(
+    inputs,
+    true,
+    []( r32 x ){ return ( r32 )exp( x ); },
+    []( __m128 x ){ return FastExp( x ); } );
+
+  const char* names[] = { "sin", "cos", "acos", "exp" };
+  TacFastMathBenchmarkResult* results[] =
+  {
+    &sines,
+    &cosines,
+    &acoses,
+    &exps
+  };
+  for( u32 i = 0; i < ArraySize( results ); ++i )
+  {
+    std::stringstream ss;
+    ss <<
+      names[ i ] << ": libm " <<
+      results[ i ]->libmCycles / ( r64 )count << " cycles / value, fast " <<
+      results[ i ]->fastCycles / ( r64 )count << " cycles / value, " <<
+      "max error " << results[ i ]->maxError << std::endl;
+    std::cout << ss.str();
+    OutputDebugString( ss.str().c_str() );
+  }
+}
@@ -0,0 +1,35 @@
+#pragma once
+#include "tacMath.h"
+
+#include <emmintrin.h> // sse2
+
+// Polynomial approximations of libm's sinf, cosf, acosf and expf, four
+// lanes at a time. They trade the last few bits of precision for a few
+// cycles a value, and have no branches, so they vectorize.
+//
+// Max error against libm, as measured by FastMathBenchmark:
+//   FastSinCos  absolute error < 1e-7 for | angle | <= 8192
+//   FastAcos    absolute error < 3e-7 over [ -1, 1 ]
+//   FastExp     relative error < 2e-7 over [ -87, 88 ]
+//
+// Building with TACFASTMATH routes the per frame trig in tacMath
+// ( M3RotRadX/Y/Z, M4Transform, Slerp, the spherical coordinates ) through
+// these instead of libm. tacPropsCommon.props defines it from the
+// TacFastMath property, ie: msbuild tac.sln /p:TacFastMath=1
+
+void FastSinCos( __m128 angles, __m128* sines, __m128* cosines );
+
+// inputs are clamped to [ -1, 1 ]
+__m128 FastAcos( __m128 x );
+
+// inputs are clamped to [ -87.3, 88.3 ], where the result stays finite
+__m128 FastExp( __m128 x );
+
+// one lane versions of the above
+void FastSinCos( r32 angle, r32* sine, r32* cosine );
+r32 FastAcos( r32 x );
+r32 FastExp( r32 x );
+
+// Times the functions above against libm, and prints the throughput and the
+// max error of each
+void FastMathBenchmark();
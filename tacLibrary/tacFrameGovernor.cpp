@@ -0,0 +1,180 @@
+#include "tacFrameGovernor.h"
+#include "tacMath.h"
+
+#include <chrono>
+#include <stdarg.h>
+#include <stdio.h>
+
+u64 GovernorNow()
+{
+  auto now = std::chrono::steady_clock::now().time_since_epoch();
+  u64 result = ( u64 )std::chrono::duration_cast<
+    std::chrono::nanoseconds >( now ).count();
+  return result;
+}
+
+void GovernorInit( TacFrameGovernor* governor, r32 targetMs )
+{
+  governor->enabled = true;
+  governor->targetMs = targetMs;
+  governor->headroom = 0.2f;
+  governor->cooldownFrames = 30;
+  governor->framesUntilChange = governor->cooldownFrames;
+  governor->numSubsystems = 0;
+  governor->numKnobs = 0;
+  governor->frameBeginNanoseconds = 0;
+  governor->lastFrameMs = 0;
+  governor->avgFrameMs = 0;
+  governor->numFrames = 0;
+  governor->numLogLinesWritten = 0;
+}
+
+u32 GovernorAddSubsystem( TacFrameGovernor* governor, const char* name )
+{
+  TacAssertIndex( governor->numSubsystems, TacFrameGovernor::maxSubsystems );
+  u32 subsystemIndex = governor->numSubsystems++;
+  TacGovernorSubsystem& subsystem = governor->subsystems[ subsystemIndex ];
+  subsystem.name = name;
+  subsystem.frameNanoseconds = 0;
+  subsystem.lastMs = 0;
+  subsystem.avgMs = 0;
+  return subsystemIndex;
+}
+
+u32 GovernorAddKnob(
+  TacFrameGovernor* governor,
+  const char* name,
+  u32 subsystemIndex,
+  r32 minValue,
+  r32 maxValue,
+  r32 step )
+{
+  TacAssertIndex( subsystemIndex, governor->numSubsystems );
+  TacAssertIndex( governor->numKnobs, TacFrameGovernor::maxKnobs );
+  TacAssert( minValue <= maxValue && step > 0 );
+  u32 knobIndex = governor->numKnobs++;
+  TacGovernorKnob& knob = governor->knobs[ knobIndex ];
+  knob.name = name;
+  knob.subsystemIndex = subsystemIndex;
+  knob.value = maxValue;
+  knob.minValue = minValue;
+  knob.maxValue = maxValue;
+  knob.step = step;
+  return knobIndex;
+}
+
+void GovernorBeginFrame( TacFrameGovernor* governor )
+{
+  governor->frameBeginNanoseconds = GovernorNow();
+}
+
+void GovernorLog( TacFrameGovernor* governor, const char* format, ... )
+{
+  FixedString< 128 >& line = governor->log[
+    governor->numLogLinesWritten++ % TacFrameGovernor::maxLogLines ];
+  va_list args;
+  va_start( args, format );
+  int numWritten = vsnprintf(
+    line.buffer,
+    ArraySize( line.buffer ),
+    format,
+    args );
+  va_end( args );
+  line.size = numWritten < 0 ? 0 :
+    Minimum( ( u32 )numWritten, ( u32 )ArraySize( line.buffer ) - 1 );
+}
+
+// the knob of the most expensive subsystem that can still go down, or
+// the cheapest one that can still go up
+internalFunction TacGovernorKnob* GovernorPickKnob(
+  TacFrameGovernor* governor,
+  b32 overBudget )
+{
+  TacGovernorKnob* result = nullptr;
+  r32 resultMs = 0;
+  for( u32 iKnob = 0; iKnob < governor->numKnobs; ++iKnob )
+  {
+    TacGovernorKnob* knob = &governor->knobs[ iKnob ];
+    if( overBudget ? knob->value <= knob->minValue :
+      knob->value >= knob->maxValue )
+      continue;
+    r32 ms = governor->subsystems[ knob->subsystemIndex ].avgMs;
+    if( !result || ( overBudget ? ms > resultMs : ms < resultMs ) )
+    {
+      result = knob;
+      resultMs = ms;
+    }
+  }
+  return result;
+}
+
+void GovernorEndFrame( TacFrameGovernor* governor )
+{
+  // smoothed so one slow frame doesn't turn everything down
+  const r32 smoothing = 0.1f;
+
+  r32 frameMs =
+    ( GovernorNow() - governor->frameBeginNanoseconds ) / 1000000.0f;
+  governor->lastFrameMs = frameMs;
+  governor->avgFrameMs = governor->numFrames ?
+    Lerp( governor->avgFrameMs, frameMs, smoothing ) :
+    frameMs;
+  for( u32 iSubsystem = 0;
+    iSubsystem < governor->numSubsystems;
+    ++iSubsystem )
+  {
+    TacGovernorSubsystem& subsystem = governor->subsystems[ iSubsystem ];
+    subsystem.lastMs = subsystem.frameNanoseconds / 1000000.0f;
+    subsystem.avgMs = governor->numFrames ?
+      Lerp( subsystem.avgMs, subsystem.lastMs, smoothing ) :
+      subsystem.lastMs;
+    subsystem.frameNanoseconds = 0;
+  }
+  governor->numFrames++;
+
+  if( !governor->enabled )
+    return;
+  if( governor->framesUntilChange )
+  {
+    governor->framesUntilChange--;
+    return;
+  }
+
+  b32 overBudget = governor->avgFrameMs > governor->targetMs;
+  b32 underBudget =
+    governor->avgFrameMs < governor->targetMs * ( 1.0f - governor->headroom );
+  if( !overBudget && !underBudget )
+    return;
+  TacGovernorKnob* knob = GovernorPickKnob( governor, overBudget );
+  if( !knob )
+    return;
+
+  r32 oldValue = knob->value;
+  knob->value += overBudget ? -knob->step : knob->step;
+  Clamp( knob->value, knob->minValue, knob->maxValue );
+  governor->framesUntilChange = governor->cooldownFrames;
+  GovernorLog(
+    governor,
+    "frame %u: %.2fms %s %.2fms, %s %g -> %g",
+    governor->numFrames,
+    governor->avgFrameMs,
+    overBudget ? "over" : "under",
+    governor->targetMs,
+    knob->name.buffer,
+    oldValue,
+    knob->value );
+}
+
+TacGovernorScope::TacGovernorScope(
+  TacFrameGovernor* governor,
+  u32 subsystemIndex )
+{
+  TacAssertIndex( subsystemIndex, governor->numSubsystems );
+  subsystem = &governor->subsystems[ subsystemIndex ];
+  beginNanoseconds = GovernorNow();
+}
+
+TacGovernorScope::~TacGovernorScope()
+{
+  subsystem->frameNanoseconds += GovernorNow() - beginNanoseconds;
+}
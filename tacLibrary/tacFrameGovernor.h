@@ -0,0 +1,122 @@
+#pragma once
+
+#include "tacTypes.h"
+#include "tacDefines.h"
+#include "tacString.h"
+
+// Keeps the cpu time of a frame under a budget by turning knobs down when
+// the frame is over it, and back up when there's room again.
+//
+// Usage:
+//
+//   init
+//     GovernorInit( &governor, 8.0f );
+//     u32 particles = GovernorAddSubsystem( &governor, "Particles" );
+//     u32 spawnCap = GovernorAddKnob(
+//       &governor, "Particle cap", particles, 16, 1024, 64 );
+//
+//   every frame, from the main thread
+//     GovernorBeginFrame( &governor );
+//     {
+//       TacGovernorScope scope( &governor, particles );
+//       UpdateParticles( ( u32 )governor.knobs[ spawnCap ].value );
+//     }
+//     GovernorEndFrame( &governor );
+//
+// Knobs are turned one step at a time, the knob of the most expensive
+// subsystem first when over budget, and the knob of the cheapest one first
+// when under. Every change is written to the log.
+
+struct TacGovernorSubsystem
+{
+  FixedString< 32 > name;
+
+  // time in the subsystem's scopes this frame
+  u64 frameNanoseconds;
+
+  r32 lastMs;
+  // smoothed over the last few frames
+  r32 avgMs;
+};
+
+struct TacGovernorKnob
+{
+  FixedString< 32 > name;
+
+  // the subsystem whose time this knob trades for quality
+  u32 subsystemIndex;
+
+  r32 value;
+  // the cheapest setting
+  r32 minValue;
+  // the best looking setting
+  r32 maxValue;
+  r32 step;
+};
+
+struct TacFrameGovernor
+{
+  // when false the knobs are only changed by hand
+  b32 enabled;
+  r32 targetMs;
+
+  // quality only goes back up when the frame is this fraction under the
+  // target, so the knobs don't flip every frame
+  r32 headroom;
+
+  // frames to wait after a change, so it shows up in the averages before
+  // the next one
+  u32 cooldownFrames;
+  u32 framesUntilChange;
+
+  static const u32 maxSubsystems = 16;
+  TacGovernorSubsystem subsystems[ maxSubsystems ];
+  u32 numSubsystems;
+
+  static const u32 maxKnobs = 16;
+  TacGovernorKnob knobs[ maxKnobs ];
+  u32 numKnobs;
+
+  u64 frameBeginNanoseconds;
+  r32 lastFrameMs;
+  r32 avgFrameMs;
+  u32 numFrames;
+
+  static const u32 maxLogLines = 32;
+  FixedString< 128 > log[ maxLogLines ];
+  u32 numLogLinesWritten;
+};
+
+void GovernorInit( TacFrameGovernor* governor, r32 targetMs );
+
+// Returns the index of the subsystem
+u32 GovernorAddSubsystem( TacFrameGovernor* governor, const char* name );
+
+// Returns the index of the knob, which starts at maxValue
+u32 GovernorAddKnob(
+  TacFrameGovernor* governor,
+  const char* name,
+  u32 subsystemIndex,
+  r32 minValue,
+  r32 maxValue,
+  r32 step );
+
+void GovernorBeginFrame( TacFrameGovernor* governor );
+
+// Updates the averages and turns at most one knob
+void GovernorEndFrame( TacFrameGovernor* governor );
+
+void GovernorLog( TacFrameGovernor* governor, const char* format, ... );
+
+u64 GovernorNow();
+
+// Adds the time until the end of the scope to the subsystem.
+// Only for the main thread, a subsystem that runs on the workers is timed
+// around the ParallelFor that waits for them
+struct TacGovernorScope
+{
+  TacGovernorScope( TacFrameGovernor* governor, u32 subsystemIndex );
+  ~TacGovernorScope();
+  TacGovernorSubsystem* subsystem;
+  u64 beginNanoseconds;
+};
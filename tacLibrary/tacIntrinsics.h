@@ -8,6 +8,13 @@
 #pragma intrinsic( _BitScanForward )
 #endif
 
+#if defined( _M_ARM64 ) || defined( __aarch64__ )
+#define TACINTRINSICSNEON 1
+#include <arm_neon.h>
+#else
+#include <xmmintrin.h> // sse
+#endif
+
 
 inline s32
   SignOf( s32 val )
@@ -166,4 +173,160 @@ inline u32
   return result;
 }
 
+// cpu timestamp counter, see TacProfiler::cyclesPerMillisecond to convert it
+inline u64
+  ReadCycleCounter()
+{
+#if _MSC_VER
+  u64 result = __rdtsc();
+#else
+  u64 result = __builtin_ia32_rdtsc();
+#endif
+  return result;
+}
+
+// Four r32 lanes, for the SoA loops in tacMath, tacCulling, etc.
+// It's SSE on x86 and x64, and NEON on ARM64, so code written against
+// these builds for both. Loads and stores don't have to be aligned
+#if TACINTRINSICSNEON
+typedef float32x4_t r32x4;
+#else
+typedef __m128 r32x4;
+#endif
+
+inline r32x4
+  R32x4Load( const r32* src )
+{
+#if TACINTRINSICSNEON
+  r32x4 result = vld1q_f32( src );
+#else
+  r32x4 result = _mm_loadu_ps( src );
+#endif
+  return result;
+}
+
+inline void
+  R32x4Store( r32* dst, r32x4 val )
+{
+#if TACINTRINSICSNEON
+  vst1q_f32( dst, val );
+#else
+  _mm_storeu_ps( dst, val );
+#endif
+}
+
+// the same value in all four lanes
+inline r32x4
+  R32x4Set( r32 val )
+{
+#if TACINTRINSICSNEON
+  r32x4 result = vdupq_n_f32( val );
+#else
+  r32x4 result = _mm_set1_ps( val );
+#endif
+  return result;
+}
+
+inline r32x4
+  R32x4Add( r32x4 lhs, r32x4 rhs )
+{
+#if TACINTRINSICSNEON
+  r32x4 result = vaddq_f32( lhs, rhs );
+#else
+  r32x4 result = _mm_add_ps( lhs, rhs );
+#endif
+  return result;
+}
+
+inline r32x4
+  R32x4Sub( r32x4 lhs, r32x4 rhs )
+{
+#if TACINTRINSICSNEON
+  r32x4 result = vsubq_f32( lhs, rhs );
+#else
+  r32x4 result = _mm_sub_ps( lhs, rhs );
+#endif
+  return result;
+}
+
+inline r32x4
+  R32x4Mul( r32x4 lhs, r32x4 rhs )
+{
+#if TACINTRINSICSNEON
+  r32x4 result = vmulq_f32( lhs, rhs );
+#else
+  r32x4 result = _mm_mul_ps( lhs, rhs );
+#endif
+  return result;
+}
+
+inline r32x4
+  R32x4Div( r32x4 lhs, r32x4 rhs )
+{
+#if TACINTRINSICSNEON
+  r32x4 result = vdivq_f32( lhs, rhs );
+#else
+  r32x4 result = _mm_div_ps( lhs, rhs );
+#endif
+  return result;
+}
+
+inline r32x4
+  R32x4Max( r32x4 lhs, r32x4 rhs )
+{
+#if TACINTRINSICSNEON
+  r32x4 result = vmaxq_f32( lhs, rhs );
+#else
+  r32x4 result = _mm_max_ps( lhs, rhs );
+#endif
+  return result;
+}
+
+inline r32x4
+  R32x4SquareRoot( r32x4 val )
+{
+#if TACINTRINSICSNEON
+  r32x4 result = vsqrtq_f32( val );
+#else
+  r32x4 result = _mm_sqrt_ps( val );
+#endif
+  return result;
+}
 
+// bit i is set when lane i of lhs >= lane i of rhs
+inline u32
+  R32x4GreaterEqualBits( r32x4 lhs, r32x4 rhs )
+{
+#if TACINTRINSICSNEON
+  static const u32 laneBits[ 4 ] = { 1, 2, 4, 8 };
+  uint32x4_t bits = vandq_u32( vcgeq_f32( lhs, rhs ), vld1q_u32( laneBits ) );
+  u32 result = vaddvq_u32( bits );
+#else
+  u32 result = ( u32 )_mm_movemask_ps( _mm_cmpge_ps( lhs, rhs ) );
+#endif
+  return result;
+}
+
+// four rows in, four columns out
+inline void
+  R32x4Transpose( r32x4& row0, r32x4& row1, r32x4& row2, r32x4& row3 )
+{
+#if TACINTRINSICSNEON
+  float32x4x2_t row01 = vzipq_f32( row0, row1 );
+  float32x4x2_t row23 = vzipq_f32( row2, row3 );
+  row0 = vcombine_f32(
+    vget_low_f32( row01.val[ 0 ] ),
+    vget_low_f32( row23.val[ 0 ] ) );
+  row1 = vcombine_f32(
+    vget_high_f32( row01.val[ 0 ] ),
+    vget_high_f32( row23.val[ 0 ] ) );
+  row2 = vcombine_f32(
+    vget_low_f32( row01.val[ 1 ] ),
+    vget_low_f32( row23.val[ 1 ] ) );
+  row3 = vcombine_f32(
+    vget_high_f32( row01.val[ 1 ] ),
+    vget_high_f32( row23.val[ 1 ] ) );
+#else
+  _MM_TRANSPOSE4_PS( row0, row1, row2, row3 );
+#endif
+}
@@ -0,0 +1,142 @@
+#include "tacJobProfiler.h"
+
+#include <chrono>
+#include <sstream>
+
+u64 JobProfilerNow()
+{
+  auto now = std::chrono::steady_clock::now().time_since_epoch();
+  u64 result = ( u64 )std::chrono::duration_cast<
+    std::chrono::nanoseconds >( now ).count();
+  return result;
+}
+
+void JobProfilerInit( TacJobProfiler* profiler, u32 numThreads )
+{
+  profiler->enabled = false;
+  profiler->numThreads = numThreads;
+  profiler->threads = new TacJobProfilerThread[ numThreads ];
+  JobProfilerClear( profiler );
+}
+
+void JobProfilerUninit( TacJobProfiler* profiler )
+{
+  delete[] profiler->threads;
+  profiler->threads = nullptr;
+  profiler->numThreads = 0;
+}
+
+void JobProfilerClear( TacJobProfiler* profiler )
+{
+  for( u32 iThread = 0; iThread < profiler->numThreads; ++iThread )
+  {
+    profiler->threads[ iThread ].numEventsWritten = 0;
+  }
+}
+
+const char* JobPriorityToString( TacJobPriority priority )
+{
+  switch( priority )
+  {
+    case TacJobPriority::FrameCritical: return "FrameCritical";
+    case TacJobPriority::Normal: return "Normal";
+    case TacJobPriority::Background: return "Background";
+    case TacJobPriority::Count: TacInvalidCodePath; break;
+    TacInvalidDefaultCase;
+  }
+  return "";
+}
+
+void JobProfilerExportChromeTrace(
+  TacThreadContext* thread,
+  TacJobProfiler* profiler,
+  const char* filepath,
+  FixedString< DEFAULT_ERR_LEN >& errors )
+{
+  u64 firstTime = ~0ULL;
+  for( u32 iThread = 0; iThread < profiler->numThreads; ++iThread )
+  {
+    TacJobProfilerThread& profilerThread = profiler->threads[ iThread ];
+    u32 numEventsWritten = profilerThread.numEventsWritten;
+    if( !numEventsWritten )
+      continue;
+    u32 iOldest = numEventsWritten > TacJobProfilerThread::maxEvents ?
+      numEventsWritten - TacJobProfilerThread::maxEvents : 0;
+    TacJobEvent& oldest =
+      profilerThread.events[ iOldest % TacJobProfilerThread::maxEvents ];
+    firstTime = Minimum( firstTime, oldest.time );
+  }
+
+  std::stringstream ss;
+  ss << "{\"traceEvents\":[" << std::endl;
+  b32 first = true;
+  for( u32 iThread = 0; iThread < profiler->numThreads; ++iThread )
+  {
+    TacJobProfilerThread& profilerThread = profiler->threads[ iThread ];
+    u32 numEventsWritten = profilerThread.numEventsWritten;
+    u32 iOldest = numEventsWritten > TacJobProfilerThread::maxEvents ?
+      numEventsWritten - TacJobProfilerThread::maxEvents : 0;
+    for( u32 iEvent = iOldest; iEvent < numEventsWritten; ++iEvent )
+    {
+      TacJobEvent& event =
+        profilerThread.events[ iEvent % TacJobProfilerThread::maxEvents ];
+      const char* phase = "i";
+      const char* name = nullptr;
+      switch( event.type )
+      {
+        case TacJobEventType::Enqueue: phase = "i"; name = "enqueue"; break;
+        case TacJobEventType::Start: phase = "B"; break;
+        case TacJobEventType::End: phase = "E"; break;
+        case TacJobEventType::SleepBegin: phase = "B"; name = "sleep"; break;
+        case TacJobEventType::SleepEnd: phase = "E"; name = "sleep"; break;
+        case TacJobEventType::Count: TacInvalidCodePath; break;
+        TacInvalidDefaultCase;
+      }
+      if( !first )
+        ss << "," << std::endl;
+      first = false;
+
+      // chrome wants microseconds
+      r64 timestamp = ( event.time - firstTime ) / 1000.0;
+      ss << "{\"ph\":\"" << phase << "\"";
+      ss << ",\"pid\":0,\"tid\":" << iThread;
+      ss << ",\"ts\":" << std::fixed << timestamp;
+      if( name )
+      {
+        ss << ",\"name\":\"" << name << "\"";
+      }
+      else
+      {
+        ss << ",\"name\":\"" << ( void* )event.callback << "\"";
+      }
+      if( event.type != TacJobEventType::SleepBegin &&
+        event.type != TacJobEventType::SleepEnd )
+      {
+        ss << ",\"cat\":\"" << JobPriorityToString( event.priority ) << "\"";
+      }
+      if( *phase == 'i' )
+      {
+        ss << ",\"s\":\"t\"";
+      }
+      ss << "}";
+    }
+  }
+  ss << "]}" << std::endl;
+  std::string json = ss.str();
+
+  TacFile file = PlatformOpenFile(
+    thread,
+    filepath,
+    OpenFileDisposition::CreateAlways,
+    FileAccess::Write,
+    errors );
+  if( errors.size )
+    return;
+  OnDestruct( PlatformCloseFile( thread, file, errors ); );
+  PlatformWriteEntireFile(
+    thread,
+    file,
+    ( void* )json.data(),
+    json.size(),
+    errors );
+}
@@ -0,0 +1,81 @@
+#pragma once
+
+#include "tacPlatform.h"
+
+enum class TacJobEventType
+{
+  Enqueue,
+  Start,
+  End,
+  SleepBegin,
+  SleepEnd,
+  Count
+};
+
+struct TacJobEvent
+{
+  u64 time; // nanoseconds, see JobProfilerNow()
+  WorkQueueCallback* callback;
+  TacJobEventType type;
+  TacJobPriority priority;
+};
+
+// Only the owning thread writes, so the ring doesn't need any locks.
+// Readers can see a partially written event if the ring wraps while they
+// are reading, which is fine for a profiler
+struct TacJobProfilerThread
+{
+  const static u32 maxEvents = 4096;
+  TacJobEvent events[ maxEvents ];
+  std::atomic< u32 > numEventsWritten;
+};
+
+struct TacJobProfiler
+{
+  b32 enabled;
+
+  // one per worker, plus one for the thread that pushes the entries,
+  // indexed by TacThreadContext::logicalThreadIndex
+  TacJobProfilerThread* threads;
+  u32 numThreads;
+};
+
+u64 JobProfilerNow();
+
+inline void JobProfilerRecord(
+  TacJobProfiler* profiler,
+  u32 logicalThreadIndex,
+  TacJobEventType type,
+  WorkQueueCallback* callback,
+  TacJobPriority priority )
+{
+  if( !profiler || !profiler->enabled )
+    return;
+  TacAssertIndex( logicalThreadIndex, profiler->numThreads );
+  TacJobProfilerThread& profilerThread =
+    profiler->threads[ logicalThreadIndex ];
+  u32 numEventsWritten =
+    profilerThread.numEventsWritten.load( std::memory_order_relaxed );
+  TacJobEvent& event = profilerThread.events[
+    numEventsWritten % TacJobProfilerThread::maxEvents ];
+  event.time = JobProfilerNow();
+  event.callback = callback;
+  event.type = type;
+  event.priority = priority;
+  profilerThread.numEventsWritten.store(
+    numEventsWritten + 1,
+    std::memory_order_release );
+}
+
+void JobProfilerInit( TacJobProfiler* profiler, u32 numThreads );
+void JobProfilerUninit( TacJobProfiler* profiler );
+void JobProfilerClear( TacJobProfiler* profiler );
+
+const char* JobPriorityToString( TacJobPriority priority );
+
+// Writes every event still in the rings in the chrome://tracing format
+void JobProfilerExportChromeTrace(
+  TacThreadContext* thread,
+  TacJobProfiler* profiler,
+  const char* filepath,
+  FixedString< DEFAULT_ERR_LEN >& errors );
@@ -1,5 +1,41 @@
 #include "tacMath.h"
 #include "tacDefines.h"
+#if TACFASTMATH
+#include "tacFastMath.h"
+#endif
+
+// The trig that runs every frame goes through these, so TACFASTMATH can
+// swap libm for the tacFastMath polynomials
+internalFunction void MathSinCos( r32 angle, r32* sine, r32* cosine )
+{
+#if TACFASTMATH
+  FastSinCos( angle, sine, cosine );
+#else
+  *sine = Sin( angle );
+  *cosine = Cos( angle );
+#endif
+}
+
+internalFunction r32 MathSin( r32 angle )
+{
+#if TACFASTMATH
+  r32 sine;
+  r32 cosine;
+  FastSinCos( angle, &sine, &cosine );
+  return sine;
+#else
+  return Sin( angle );
+#endif
+}
+
+internalFunction r32 MathAcos( r32 x )
+{
+#if TACFASTMATH
+  return FastAcos( x );
+#else
+  return Acos( x );
+#endif
+}
 
 bool IsAboutEqual( float a, float b )
 {
@@ -39,7 +75,7 @@ void SphericalCoordinatesTo(
   r32* phi )
 {
   *radius = SquareRoot( x*x + y*y + z*z );
-  *phi = Acos( z / *radius );
+  *phi = MathAcos( z / *radius );
   *theta = Atan2( y, x );
 }
 void SphericalCoordinatesFrom(
@@ -50,10 +86,15 @@ void SphericalCoordinatesFrom(
   r32* y,
   r32* z )
 {
-  r32 sinphi = sin( phi );
-  *z = radius * cos( phi );
-  *x = radius * cos( theta ) * sinphi;
-  *y = radius * sin( theta ) * sinphi;
+  r32 sinphi;
+  r32 cosphi;
+  r32 sintheta;
+  r32 costheta;
+  MathSinCos( phi, &sinphi, &cosphi );
+  MathSinCos( theta, &sintheta, &costheta );
+  *z = radius * cosphi;
+  *x = radius * costheta * sinphi;
+  *y = radius * sintheta * sinphi;
 }
 
 void GetFrameRH( v3 normalizedDir, v3& normalizedtan1, v3& normalizedtan2 )
@@ -107,8 +148,9 @@ m4 M4FromM3( const m3& rot )
 
 m3 M3RotRadX( float rotRad )
 {
-  float s = sin( rotRad );
-  float c = cos( rotRad );
+  float s;
+  float c;
+  MathSinCos( rotRad, &s, &c );
   return M3(
     1, 0, 0,
     0, c, -s,
@@ -116,8 +158,9 @@ m3 M3RotRadX( float rotRad )
 }
 m3 M3RotRadY( float rotRad )
 {
-  float s = sin( rotRad );
-  float c = cos( rotRad );
+  float s;
+  float c;
+  MathSinCos( rotRad, &s, &c );
   return M3(
     c, 0, s,
     0, 1, 0,
@@ -125,8 +168,9 @@ m3 M3RotRadY( float rotRad )
 }
 m3 M3RotRadZ( float rotRad )
 {
-  float s = sin( rotRad );
-  float c = cos( rotRad );
+  float s;
+  float c;
+  MathSinCos( rotRad, &s, &c );
   return M3(
     c, -s, 0,
     s, c, 0,
@@ -250,8 +294,9 @@ m3 M3AngleAxis( r32 angleRadians, v3 axisNormalized )
   TacAssert( AbsoluteValue( LengthSq( axisNormalized ) - 1.0f ) < 0.001f );
 
   m3 m;
-  r32 c = Cos(angleRadians);
-  r32 s = Sin(angleRadians);
+  r32 s;
+  r32 c;
+  MathSinCos( angleRadians, &s, &c );
   r32 t = 1.0f - c;
 
   m( 0, 0 ) = c + axisNormalized.x*axisNormalized.x*t;
@@ -324,6 +369,260 @@ m3 M3Scale( v3 scale )
   return result;
 }
 
+r32 Determinant( const m3& m )
+{
+  r32 result =
+    m( 0, 0 ) * ( m( 1, 1 ) * m( 2, 2 ) - m( 1, 2 ) * m( 2, 1 ) ) +
+    m( 0, 1 ) * ( m( 1, 2 ) * m( 2, 0 ) - m( 1, 0 ) * m( 2, 2 ) ) +
+    m( 0, 2 ) * ( m( 1, 0 ) * m( 2, 1 ) - m( 1, 1 ) * m( 2, 0 ) );
+  return result;
+}
+
+m3 Inverse( const m3& m )
+{
+  // the cofactors of the first row, which the determinant reuses
+  r32 c00 = m( 1, 1 ) * m( 2, 2 ) - m( 1, 2 ) * m( 2, 1 );
+  r32 c01 = m( 1, 2 ) * m( 2, 0 ) - m( 1, 0 ) * m( 2, 2 );
+  r32 c02 = m( 1, 0 ) * m( 2, 1 ) - m( 1, 1 ) * m( 2, 0 );
+  r32 invDet = 1.0f / ( m( 0, 0 ) * c00 + m( 0, 1 ) * c01 + m( 0, 2 ) * c02 );
+  m3 result = M3(
+    c00,
+    m( 0, 2 ) * m( 2, 1 ) - m( 0, 1 ) * m( 2, 2 ),
+    m( 0, 1 ) * m( 1, 2 ) - m( 0, 2 ) * m( 1, 1 ),
+    c01,
+    m( 0, 0 ) * m( 2, 2 ) - m( 0, 2 ) * m( 2, 0 ),
+    m( 0, 2 ) * m( 1, 0 ) - m( 0, 0 ) * m( 1, 2 ),
+    c02,
+    m( 0, 1 ) * m( 2, 0 ) - m( 0, 0 ) * m( 2, 1 ),
+    m( 0, 0 ) * m( 1, 1 ) - m( 0, 1 ) * m( 1, 0 ) );
+  result *= invDet;
+  return result;
+}
+
+// The 2x2 determinants of the top two rows ( s ) and the bottom two rows
+// ( c ), which the 4x4 determinant and inverse are built from
+struct TacM4Minors
+{
+  r32 s[ 6 ];
+  r32 c[ 6 ];
+};
+
+internalFunction TacM4Minors M4Minors( const m4& m )
+{
+  TacM4Minors result;
+  r32* s = result.s;
+  r32* c = result.c;
+  s[ 0 ] = m( 0, 0 ) * m( 1, 1 ) - m( 1, 0 ) * m( 0, 1 );
+  s[ 1 ] = m( 0, 0 ) * m( 1, 2 ) - m( 1, 0 ) * m( 0, 2 );
+  s[ 2 ] = m( 0, 0 ) * m( 1, 3 ) - m( 1, 0 ) * m( 0, 3 );
+  s[ 3 ] = m( 0, 1 ) * m( 1, 2 ) - m( 1, 1 ) * m( 0, 2 );
+  s[ 4 ] = m( 0, 1 ) * m( 1, 3 ) - m( 1, 1 ) * m( 0, 3 );
+  s[ 5 ] = m( 0, 2 ) * m( 1, 3 ) - m( 1, 2 ) * m( 0, 3 );
+  c[ 0 ] = m( 2, 0 ) * m( 3, 1 ) - m( 3, 0 ) * m( 2, 1 );
+  c[ 1 ] = m( 2, 0 ) * m( 3, 2 ) - m( 3, 0 ) * m( 2, 2 );
+  c[ 2 ] = m( 2, 0 ) * m( 3, 3 ) - m( 3, 0 ) * m( 2, 3 );
+  c[ 3 ] = m( 2, 1 ) * m( 3, 2 ) - m( 3, 1 ) * m( 2, 2 );
+  c[ 4 ] = m( 2, 1 ) * m( 3, 3 ) - m( 3, 1 ) * m( 2, 3 );
+  c[ 5 ] = m( 2, 2 ) * m( 3, 3 ) - m( 3, 2 ) * m( 2, 3 );
+  return result;
+}
+
+internalFunction r32 M4MinorsDeterminant( const TacM4Minors& minors )
+{
+  const r32* s = minors.s;
+  const r32* c = minors.c;
+  r32 result =
+    s[ 0 ] * c[ 5 ] - s[ 1 ] * c[ 4 ] + s[ 2 ] * c[ 3 ] +
+    s[ 3 ] * c[ 2 ] - s[ 4 ] * c[ 1 ] + s[ 5 ] * c[ 0 ];
+  return result;
+}
+
+r32 Determinant( const m4& m )
+{
+  r32 result = M4MinorsDeterminant( M4Minors( m ) );
+  return result;
+}
+
+#if TACMATHSSE
+// Shuffles for the 2x2 blocks of the inverse below. Each __m128 holds a
+// row major 2x2 matrix
+#define TAC_SWIZZLE( v, x, y, z, w )\
+  _mm_shuffle_ps( v, v, _MM_SHUFFLE( w, z, y, x ) )
+
+// lhs * rhs
+internalFunction __m128 M2Mul( __m128 lhs, __m128 rhs )
+{
+  __m128 result = _mm_add_ps(
+    _mm_mul_ps( lhs, TAC_SWIZZLE( rhs, 0, 3, 0, 3 ) ),
+    _mm_mul_ps(
+    TAC_SWIZZLE( lhs, 1, 0, 3, 2 ),
+    TAC_SWIZZLE( rhs, 2, 1, 2, 1 ) ) );
+  return result;
+}
+
+// Adjugate( lhs ) * rhs
+internalFunction __m128 M2AdjugateMul( __m128 lhs, __m128 rhs )
+{
+  __m128 result = _mm_sub_ps(
+    _mm_mul_ps( TAC_SWIZZLE( lhs, 3, 3, 0, 0 ), rhs ),
+    _mm_mul_ps(
+    TAC_SWIZZLE( lhs, 1, 1, 2, 2 ),
+    TAC_SWIZZLE( rhs, 2, 3, 0, 1 ) ) );
+  return result;
+}
+
+// lhs * Adjugate( rhs )
+internalFunction __m128 M2MulAdjugate( __m128 lhs, __m128 rhs )
+{
+  __m128 result = _mm_sub_ps(
+    _mm_mul_ps( lhs, TAC_SWIZZLE( rhs, 3, 0, 3, 0 ) ),
+    _mm_mul_ps(
+    TAC_SWIZZLE( lhs, 1, 0, 3, 2 ),
+    TAC_SWIZZLE( rhs, 2, 1, 2, 1 ) ) );
+  return result;
+}
+
+// Blockwise inverse. With the matrix split into 2x2 blocks
+//   | A B |
+//   | C D |
+// the inverse is 1 / det * | X Y | where, with # the adjugate,
+//                          | Z W |
+//   X# = det( D ) A - B ( D# C )   Y# = det( B ) C - D ( A# B )#
+//   Z# = det( C ) B - A ( D# C )#  W# = det( A ) D - C ( A# B )
+//   det = det( A ) det( D ) + det( B ) det( C ) - trace( ( A# B )( D# C ) )
+m4 Inverse( const m4& m )
+{
+  __m128 row0 = _mm_loadu_ps( m.e + 0 );
+  __m128 row1 = _mm_loadu_ps( m.e + 4 );
+  __m128 row2 = _mm_loadu_ps( m.e + 8 );
+  __m128 row3 = _mm_loadu_ps( m.e + 12 );
+  __m128 a = _mm_movelh_ps( row0, row1 );
+  __m128 b = _mm_movehl_ps( row1, row0 );
+  __m128 c = _mm_movelh_ps( row2, row3 );
+  __m128 d = _mm_movehl_ps( row3, row2 );
+
+  // ( det( A ), det( B ), det( C ), det( D ) )
+  __m128 blockDets = _mm_sub_ps(
+    _mm_mul_ps(
+    _mm_shuffle_ps( row0, row2, _MM_SHUFFLE( 2, 0, 2, 0 ) ),
+    _mm_shuffle_ps( row1, row3, _MM_SHUFFLE( 3, 1, 3, 1 ) ) ),
+    _mm_mul_ps(
+    _mm_shuffle_ps( row0, row2, _MM_SHUFFLE( 3, 1, 3, 1 ) ),
+    _mm_shuffle_ps( row1, row3, _MM_SHUFFLE( 2, 0, 2, 0 ) ) ) );
+  __m128 detA = TAC_SWIZZLE( blockDets, 0, 0, 0, 0 );
+  __m128 detB = TAC_SWIZZLE( blockDets, 1, 1, 1, 1 );
+  __m128 detC = TAC_SWIZZLE( blockDets, 2, 2, 2, 2 );
+  __m128 detD = TAC_SWIZZLE( blockDets, 3, 3, 3, 3 );
+
+  __m128 adjugateDC = M2AdjugateMul( d, c );
+  __m128 adjugateAB = M2AdjugateMul( a, b );
+  __m128 x = _mm_sub_ps( _mm_mul_ps( detD, a ), M2Mul( b, adjugateDC ) );
+  __m128 w = _mm_sub_ps( _mm_mul_ps( detA, d ), M2Mul( c, adjugateAB ) );
+  __m128 y = _mm_sub_ps(
+    _mm_mul_ps( detB, c ),
+    M2MulAdjugate( d, adjugateAB ) );
+  __m128 z = _mm_sub_ps(
+    _mm_mul_ps( detC, b ),
+    M2MulAdjugate( a, adjugateDC ) );
+
+  __m128 trace = _mm_mul_ps(
+    adjugateAB,
+    TAC_SWIZZLE( adjugateDC, 0, 2, 1, 3 ) );
+  trace = _mm_add_ps( trace, _mm_movehl_ps( trace, trace ) );
+  trace = _mm_add_ps( trace, TAC_SWIZZLE( trace, 1, 0, 1, 0 ) );
+  trace = TAC_SWIZZLE( trace, 0, 0, 0, 0 );
+  __m128 det = _mm_sub_ps(
+    _mm_add_ps( _mm_mul_ps( detA, detD ), _mm_mul_ps( detB, detC ) ),
+    trace );
+
+  // the adjugate of each block flips the signs of its off diagonal
+  __m128 invDets = _mm_div_ps( _mm_setr_ps( 1, -1, -1, 1 ), det );
+  x = _mm_mul_ps( x, invDets );
+  y = _mm_mul_ps( y, invDets );
+  z = _mm_mul_ps( z, invDets );
+  w = _mm_mul_ps( w, invDets );
+
+  // undoing the adjugates and putting the blocks back into rows
+  m4 result;
+  _mm_storeu_ps(
+    result.e + 0,
+    _mm_shuffle_ps( x, y, _MM_SHUFFLE( 1, 3, 1, 3 ) ) );
+  _mm_storeu_ps(
+    result.e + 4,
+    _mm_shuffle_ps( x, y, _MM_SHUFFLE( 0, 2, 0, 2 ) ) );
+  _mm_storeu_ps(
+    result.e + 8,
+    _mm_shuffle_ps( z, w, _MM_SHUFFLE( 1, 3, 1, 3 ) ) );
+  _mm_storeu_ps(
+    result.e + 12,
+    _mm_shuffle_ps( z, w, _MM_SHUFFLE( 0, 2, 0, 2 ) ) );
+  return result;
+}
+#undef TAC_SWIZZLE
+#else
+m4 Inverse( const m4& m )
+{
+  TacM4Minors minors = M4Minors( m );
+  const r32* s = minors.s;
+  const r32* c = minors.c;
+  r32 invDet = 1.0f / M4MinorsDeterminant( minors );
+  m4 result = M4(
+    m( 1, 1 ) * c[ 5 ] - m( 1, 2 ) * c[ 4 ] + m( 1, 3 ) * c[ 3 ],
+    -m( 0, 1 ) * c[ 5 ] + m( 0, 2 ) * c[ 4 ] - m( 0, 3 ) * c[ 3 ],
+    m( 3, 1 ) * s[ 5 ] - m( 3, 2 ) * s[ 4 ] + m( 3, 3 ) * s[ 3 ],
+    -m( 2, 1 ) * s[ 5 ] + m( 2, 2 ) * s[ 4 ] - m( 2, 3 ) * s[ 3 ],
+
+    -m( 1, 0 ) * c[ 5 ] + m( 1, 2 ) * c[ 2 ] - m( 1, 3 ) * c[ 1 ],
+    m( 0, 0 ) * c[ 5 ] - m( 0, 2 ) * c[ 2 ] + m( 0, 3 ) * c[ 1 ],
+    -m( 3, 0 ) * s[ 5 ] + m( 3, 2 ) * s[ 2 ] - m( 3, 3 ) * s[ 1 ],
+    m( 2, 0 ) * s[ 5 ] - m( 2, 2 ) * s[ 2 ] + m( 2, 3 ) * s[ 1 ],
+
+    m( 1, 0 ) * c[ 4 ] - m( 1, 1 ) * c[ 2 ] + m( 1, 3 ) * c[ 0 ],
+    -m( 0, 0 ) * c[ 4 ] + m( 0, 1 ) * c[ 2 ] - m( 0, 3 ) * c[ 0 ],
+    m( 3, 0 ) * s[ 4 ] - m( 3, 1 ) * s[ 2 ] + m( 3, 3 ) * s[ 0 ],
+    -m( 2, 0 ) * s[ 4 ] + m( 2, 1 ) * s[ 2 ] - m( 2, 3 ) * s[ 0 ],
+
+    -m( 1, 0 ) * c[ 3 ] + m( 1, 1 ) * c[ 1 ] - m( 1, 2 ) * c[ 0 ],
+    m( 0, 0 ) * c[ 3 ] - m( 0, 1 ) * c[ 1 ] + m( 0, 2 ) * c[ 0 ],
+    -m( 3, 0 ) * s[ 3 ] + m( 3, 1 ) * s[ 1 ] - m( 3, 2 ) * s[ 0 ],
+    m( 2, 0 ) * s[ 3 ] - m( 2, 1 ) * s[ 1 ] + m( 2, 2 ) * s[ 0 ] );
+  result *= invDet;
+  return result;
+}
+#endif
+
+m4 InverseAffine( const m4& m )
+{
+  m3 linear = M3(
+    m( 0, 0 ), m( 0, 1 ), m( 0, 2 ),
+    m( 1, 0 ), m( 1, 1 ), m( 1, 2 ),
+    m( 2, 0 ), m( 2, 1 ), m( 2, 2 ) );
+  m3 r = Inverse( linear );
+  v3 t = -( r * V3( m( 0, 3 ), m( 1, 3 ), m( 2, 3 ) ) );
+  m4 result = M4(
+    r( 0, 0 ), r( 0, 1 ), r( 0, 2 ), t.x,
+    r( 1, 0 ), r( 1, 1 ), r( 1, 2 ), t.y,
+    r( 2, 0 ), r( 2, 1 ), r( 2, 2 ), t.z,
+    0, 0, 0, 1 );
+  return result;
+}
+
+m4 InverseRigid( const m4& m )
+{
+  // the inverse of a rotation is its transpose
+  m3 r = M3(
+    m( 0, 0 ), m( 1, 0 ), m( 2, 0 ),
+    m( 0, 1 ), m( 1, 1 ), m( 2, 1 ),
+    m( 0, 2 ), m( 1, 2 ), m( 2, 2 ) );
+  v3 t = -( r * V3( m( 0, 3 ), m( 1, 3 ), m( 2, 3 ) ) );
+  m4 result = M4(
+    r( 0, 0 ), r( 0, 1 ), r( 0, 2 ), t.x,
+    r( 1, 0 ), r( 1, 1 ), r( 1, 2 ), t.y,
+    r( 2, 0 ), r( 2, 1 ), r( 2, 2 ), t.z,
+    0, 0, 0, 1 );
+  return result;
+}
+
   void Test (
     const char* origname,
     const m4& orig,
@@ -440,6 +739,78 @@ void MatrixUnitTests()
   Test( "a inv 2", ainv   , test_ainv2  );
 }
 
+void MatrixSimdUnitTests()
+{
+  // explicit template arguments skip the non-template m4 and v4 overloads
+  for( u32 iTest = 0; iTest < 1000; ++iTest )
+  {
+    m4 a;
+    m4 b;
+    v4 v;
+    v4 w;
+    for( u32 i = 0; i < 16; ++i )
+    {
+      a[ i ] = RandReal( -10, 10 );
+      b[ i ] = RandReal( -10, 10 );
+    }
+    for( u32 i = 0; i < 4; ++i )
+    {
+      v[ i ] = RandReal( -10, 10 );
+      w[ i ] = RandReal( -10, 10 );
+    }
+
+    // scaled down so the determinants stay within IsAboutEqual's tolerance
+    m4 small = a * 0.1f;
+    m3 small3 = M3(
+      small( 0, 0 ), small( 0, 1 ), small( 0, 2 ),
+      small( 1, 0 ), small( 1, 1 ), small( 1, 2 ),
+      small( 2, 0 ), small( 2, 1 ), small( 2, 2 ) );
+    TacAssert( IsAboutEqual(
+      Determinant( small ),
+      Determinant< r32, 4 >( small ) ) );
+    TacAssert( IsAboutEqual(
+      Determinant( small3 ),
+      Determinant< r32, 3 >( small3 ) ) );
+    if( AbsoluteValue( Determinant( small ) ) > 0.1f )
+    {
+      m4 identity;
+      Identity( identity );
+      TacAssert( IsAboutEqual( Inverse( small ), Inverse< r32, 4 >( small ) ) );
+      TacAssert( IsAboutEqual( Inverse( small ) * small, identity ) );
+    }
+    if( AbsoluteValue( Determinant( small3 ) ) > 0.1f )
+    {
+      TacAssert( IsAboutEqual(
+        Inverse( small3 ),
+        Inverse< r32, 3 >( small3 ) ) );
+    }
+
+    v3 scale = V3(
+      RandReal( 0.5f, 2 ),
+      RandReal( 0.5f, 2 ),
+      RandReal( 0.5f, 2 ) );
+    v3 rotate = V3(
+      RandReal( -3, 3 ),
+      RandReal( -3, 3 ),
+      RandReal( -3, 3 ) );
+    v3 translate = V3( v[ 0 ], v[ 1 ], v[ 2 ] );
+    TacAssert( IsAboutEqual(
+      InverseAffine( M4Transform( scale, rotate, translate ) ),
+      M4TransformInverse( scale, rotate, translate ) ) );
+    v3 one = V3( 1.0f, 1.0f, 1.0f );
+    TacAssert( IsAboutEqual(
+      InverseRigid( M4Transform( one, rotate, translate ) ),
+      M4TransformInverse( one, rotate, translate ) ) );
+
+    TacAssert( IsAboutEqual( a * b, operator*< r32, 4, 4, 4 >( a, b ) ) );
+    TacAssert( IsAboutEqual( a * v, operator*< r32, 4 >( a, v ) ) );
+    TacAssert( IsAboutEqual( Transpose( a ), Transpose< r32, 4 >( a ) ) );
+    TacAssert( IsAboutEqual( Dot( v, w ), Dot< r32, 4 >( v, w ) ) );
+    if( LengthSq( v ) > EPSILON )
+      TacAssert( IsAboutEqual( Normalize( v ), Normalize< r32, 4 >( v ) ) );
+  }
+}
+
 void PrintMatrix( const m4& m )
 {
   for( u32 r = 0; r < 4; ++r )
@@ -510,10 +881,10 @@ v4 Slerp( v4 q1, v4 q2, r32 t )
   {
     // Standard case (slerp)
     r32 omega, sinom;
-    omega = acos( cosom); // extract theta from dot product's cos theta
-    sinom = sin( omega);
-    sclp  = sin( (1.0f - t) * omega) / sinom;
-    sclq  = sin( t * omega) / sinom;
+    omega = MathAcos( cosom); // extract theta from dot product's cos theta
+    sinom = MathSin( omega);
+    sclp  = MathSin( (1.0f - t) * omega) / sinom;
+    sclq  = MathSin( t * omega) / sinom;
   } else
   {
     // Very close, do linear interp (because it's faster)
@@ -619,3 +990,240 @@ TacSphere SphereExtents( v3* points, u32 numPoints )
   return result;
 }
 
+
+// one row of m4 * V4( p, 1 ), for four points
+internalFunction r32x4 TransformRow(
+  const r32x4 row[ 4 ],
+  r32x4 xs,
+  r32x4 ys,
+  r32x4 zs )
+{
+  r32x4 result = R32x4Add(
+    R32x4Add( R32x4Mul( row[ 0 ], xs ), R32x4Mul( row[ 1 ], ys ) ),
+    R32x4Add( R32x4Mul( row[ 2 ], zs ), row[ 3 ] ) );
+  return result;
+}
+
+void TransformPoints(
+  const m4& transform,
+  const TacVectorsSoA& points,
+  const TacVectorsSoA& result )
+{
+  // each element of the top three rows in all four lanes
+  r32x4 m[ 12 ];
+  for( u32 i = 0; i < 12; ++i )
+    m[ i ] = R32x4Set( transform[ i ] );
+
+  u32 numWide = points.count & ~3u;
+  for( u32 i = 0; i < numWide; i += 4 )
+  {
+    r32x4 xs = R32x4Load( points.xs + i );
+    r32x4 ys = R32x4Load( points.ys + i );
+    r32x4 zs = R32x4Load( points.zs + i );
+    R32x4Store(
+      result.xs + i,
+      TransformRow( m + 0, xs, ys, zs ) );
+    R32x4Store(
+      result.ys + i,
+      TransformRow( m + 4, xs, ys, zs ) );
+    R32x4Store(
+      result.zs + i,
+      TransformRow( m + 8, xs, ys, zs ) );
+  }
+
+  // the last few that don't fill a register
+  for( u32 i = numWide; i < points.count; ++i )
+  {
+    v3 point = ( transform *
+      V4( points.xs[ i ], points.ys[ i ], points.zs[ i ], 1.0f ) ).xyz;
+    result.xs[ i ] = point.x;
+    result.ys[ i ] = point.y;
+    result.zs[ i ] = point.z;
+  }
+}
+
+void TransformSpheres(
+  const m4* transforms,
+  const TacSpheresSoA& spheres,
+  const TacSpheresSoA& result )
+{
+  u32 numWide = spheres.count & ~3u;
+  for( u32 i = 0; i < numWide; i += 4 )
+  {
+    // Transposing row r of four transforms leaves element ( r, c ) of
+    // transform i + j in lane j of m[ r ][ c ]
+    r32x4 m[ 3 ][ 4 ];
+    for( u32 r = 0; r < 3; ++r )
+    {
+      for( u32 j = 0; j < 4; ++j )
+        m[ r ][ j ] = R32x4Load( transforms[ i + j ].e + r * 4 );
+      R32x4Transpose( m[ r ][ 0 ], m[ r ][ 1 ], m[ r ][ 2 ], m[ r ][ 3 ] );
+    }
+
+    r32x4 xs = R32x4Load( spheres.xs + i );
+    r32x4 ys = R32x4Load( spheres.ys + i );
+    r32x4 zs = R32x4Load( spheres.zs + i );
+    r32x4 radii = R32x4Load( spheres.radii + i );
+    r32x4 resultXs = TransformRow( m[ 0 ], xs, ys, zs );
+    r32x4 resultYs = TransformRow( m[ 1 ], xs, ys, zs );
+    r32x4 resultZs = TransformRow( m[ 2 ], xs, ys, zs );
+
+    r32x4 axisLengthSqs[ 3 ];
+    for( u32 c = 0; c < 3; ++c )
+    {
+      axisLengthSqs[ c ] = R32x4Add(
+        R32x4Add(
+        R32x4Mul( m[ 0 ][ c ], m[ 0 ][ c ] ),
+        R32x4Mul( m[ 1 ][ c ], m[ 1 ][ c ] ) ),
+        R32x4Mul( m[ 2 ][ c ], m[ 2 ][ c ] ) );
+    }
+    r32x4 scales = R32x4SquareRoot( R32x4Max(
+      R32x4Max( axisLengthSqs[ 0 ], axisLengthSqs[ 1 ] ),
+      axisLengthSqs[ 2 ] ) );
+
+    R32x4Store( result.xs + i, resultXs );
+    R32x4Store( result.ys + i, resultYs );
+    R32x4Store( result.zs + i, resultZs );
+    R32x4Store( result.radii + i, R32x4Mul( radii, scales ) );
+  }
+
+  // the last few that don't fill a register
+  for( u32 i = numWide; i < spheres.count; ++i )
+  {
+    const m4& transform = transforms[ i ];
+    v3 position = ( transform *
+      V4( spheres.xs[ i ], spheres.ys[ i ], spheres.zs[ i ], 1.0f ) ).xyz;
+    r32 axisLengthSq = 0;
+    for( u32 c = 0; c < 3; ++c )
+    {
+      axisLengthSq = Maximum( axisLengthSq,
+        Square( transform( 0, c ) ) +
+        Square( transform( 1, c ) ) +
+        Square( transform( 2, c ) ) );
+    }
+    result.xs[ i ] = position.x;
+    result.ys[ i ] = position.y;
+    result.zs[ i ] = position.z;
+    result.radii[ i ] = spheres.radii[ i ] * SquareRoot( axisLengthSq );
+  }
+}
+
+void DotProducts(
+  const TacVectorsSoA& vectors,
+  v3 v,
+  r32* results )
+{
+  r32x4 vx = R32x4Set( v.x );
+  r32x4 vy = R32x4Set( v.y );
+  r32x4 vz = R32x4Set( v.z );
+  u32 numWide = vectors.count & ~3u;
+  for( u32 i = 0; i < numWide; i += 4 )
+  {
+    r32x4 dots = R32x4Add(
+      R32x4Add(
+      R32x4Mul( R32x4Load( vectors.xs + i ), vx ),
+      R32x4Mul( R32x4Load( vectors.ys + i ), vy ) ),
+      R32x4Mul( R32x4Load( vectors.zs + i ), vz ) );
+    R32x4Store( results + i, dots );
+  }
+
+  // the last few that don't fill a register
+  for( u32 i = numWide; i < vectors.count; ++i )
+  {
+    results[ i ] =
+      vectors.xs[ i ] * v.x +
+      vectors.ys[ i ] * v.y +
+      vectors.zs[ i ] * v.z;
+  }
+}
+
+void StreamUnitTests()
+{
+  const u32 maxCount = 11;
+  r32 xs[ maxCount ];
+  r32 ys[ maxCount ];
+  r32 zs[ maxCount ];
+  r32 radii[ maxCount ];
+  r32 resultXs[ maxCount ];
+  r32 resultYs[ maxCount ];
+  r32 resultZs[ maxCount ];
+  r32 resultRadii[ maxCount ];
+  r32 dots[ maxCount ];
+  m4 transforms[ maxCount ];
+  r32 maxScales[ maxCount ];
+  for( u32 iTest = 0; iTest < 100; ++iTest )
+  {
+    for( u32 i = 0; i < maxCount; ++i )
+    {
+      xs[ i ] = RandReal( -10, 10 );
+      ys[ i ] = RandReal( -10, 10 );
+      zs[ i ] = RandReal( -10, 10 );
+      radii[ i ] = RandReal( 0, 5 );
+      v3 scale = V3(
+        RandReal( 0.5f, 2 ),
+        RandReal( 0.5f, 2 ),
+        RandReal( 0.5f, 2 ) );
+      v3 rotate = V3(
+        RandReal( -3, 3 ),
+        RandReal( -3, 3 ),
+        RandReal( -3, 3 ) );
+      v3 translate = V3(
+        RandReal( -10, 10 ),
+        RandReal( -10, 10 ),
+        RandReal( -10, 10 ) );
+      transforms[ i ] = M4Transform( scale, rotate, translate );
+
+      // the columns of a scale rotate translate are as long as the scale
+      maxScales[ i ] = Maximum( Maximum( scale.x, scale.y ), scale.z );
+    }
+    v3 v = V3(
+      RandReal( -10, 10 ),
+      RandReal( -10, 10 ),
+      RandReal( -10, 10 ) );
+
+    for( u32 count = 0; count <= maxCount; ++count )
+    {
+      TacVectorsSoA points = { xs, ys, zs, count };
+      TacVectorsSoA transformed = { resultXs, resultYs, resultZs, count };
+      TransformPoints( transforms[ 0 ], points, transformed );
+      for( u32 i = 0; i < count; ++i )
+      {
+        v3 point = ( transforms[ 0 ] *
+          V4( xs[ i ], ys[ i ], zs[ i ], 1.0f ) ).xyz;
+        TacAssert( IsAboutEqual(
+          V3( resultXs[ i ], resultYs[ i ], resultZs[ i ] ),
+          point ) );
+      }
+
+      TacSpheresSoA spheres = { xs, ys, zs, radii, count };
+      TacSpheresSoA transformedSpheres =
+      {
+        resultXs,
+        resultYs,
+        resultZs,
+        resultRadii,
+        count
+      };
+      TransformSpheres( transforms, spheres, transformedSpheres );
+      for( u32 i = 0; i < count; ++i )
+      {
+        v3 position = ( transforms[ i ] *
+          V4( xs[ i ], ys[ i ], zs[ i ], 1.0f ) ).xyz;
+        TacAssert( IsAboutEqual(
+          V3( resultXs[ i ], resultYs[ i ], resultZs[ i ] ),
+          position ) );
+        TacAssert( IsAboutEqual(
+          resultRadii[ i ],
+          radii[ i ] * maxScales[ i ] ) );
+      }
+
+      DotProducts( points, v, dots );
+      for( u32 i = 0; i < count; ++i )
+      {
+        TacAssert( IsAboutEqual(
+          dots[ i ],
+          Dot( V3( xs[ i ], ys[ i ], zs[ i ] ), v ) ) );
+      }
+    }
+  }
+}
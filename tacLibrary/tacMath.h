@@ -13,6 +13,18 @@
 #endif
 #include <windows.h>
 
+// The m4 and v4 overloads at the end of the matrix section use SSE when
+// the target has it, and AVX when built with /arch:AVX.
+// Define TACMATHSCALAR to use the generic templates everywhere
+#if !defined( TACMATHSCALAR ) && \
+  ( defined( _M_X64 ) || _M_IX86_FP >= 1 || defined( __SSE__ ) )
+#define TACMATHSSE 1
+#include <xmmintrin.h> // sse
+#if defined( __AVX__ )
+#define TACMATHAVX 1
+#include <immintrin.h> // avx
+#endif
+#endif
 
 #define PI32     3.1415926535f
 #define TWOPI32  6.2831853071f
@@ -23,21 +35,21 @@
 #define RAD2DEG ( 180.0f / PI32 )
 
 
-inline u32 RoundUpToNearestMultiple( u32 val, u32 multiple )
+constexpr u32 RoundUpToNearestMultiple( u32 val, u32 multiple )
 {
   u32 result = ( ( val + multiple - 1 ) / multiple ) * multiple;
   return result;
 }
 
 template< typename T>
-T Square( T t )
+constexpr T Square( T t )
 {
   T result = t * t;
   return result;
 }
 
 template< typename T >
-T Lerp( T r0, T r1, r32 t )
+constexpr T Lerp( T r0, T r1, r32 t )
 {
   return r0 + ( r1 - r0 ) * t;
 }
@@ -56,6 +68,43 @@ inline s32 RandInt( s32 beginInclusive, s32 endExclusive )
   return beginInclusive + rand() % ( endExclusive - beginInclusive - 1 );
 }
 
+// Scrambles the bits of x. Unlike rand(), it works at compile time, so
+// random looking tables can be built with MakeTable
+constexpr u32 HashU32( u32 x )
+{
+  x ^= x >> 16;
+  x *= 0x7feb352d;
+  x ^= x >> 15;
+  x *= 0x846ca68b;
+  x ^= x >> 16;
+  return x;
+}
+
+// a real in [ r0, r1 ) from the hash of seed
+constexpr r32 HashReal( u32 seed, r32 r0 = 0.0f, r32 r1 = 1.0f )
+{
+  r32 t = ( HashU32( seed ) >> 8 ) / 16777216.0f;
+  r32 result = r0 + ( r1 - r0 ) * t;
+  return result;
+}
+
+// SquareRoot calls sqrt, which can't run at compile time.
+// Newton's method, for building tables at compile time
+constexpr r32 CompileTimeSquareRoot( r32 val )
+{
+  if( val <= 0 )
+    return 0;
+  r64 guess = val > 1 ? val : 1;
+  for( u32 i = 0; i < 128; ++i )
+  {
+    r64 next = ( guess + val / guess ) * 0.5;
+    if( next >= guess )
+      break;
+    guess = next;
+  }
+  return ( r32 )guess;
+}
+
 //          z             .(xyz)
 //          ^         ___/|
 //          |-phi-___/    |
@@ -113,8 +162,8 @@ void Clamp( T& val, const T& mini, const T& maxi )
 }
 
 #define VECTOR_ACCESS_OPERATORS \
-  T& operator[]( u32 index ) { return e[ index ]; }\
-  const T& operator[]( u32 index ) const { return e[ index ]; }
+  constexpr T& operator[]( u32 index ) { return e[ index ]; }\
+  constexpr const T& operator[]( u32 index ) const { return e[ index ]; }
 
 // column vector
 template < typename T, int N >
@@ -140,7 +189,7 @@ struct TacVector< T, 2 >
 };
 typedef TacVector< r32, 2 > v2;
 template< typename T >
-TacVector< T, 2 > V2( T x, T y )
+constexpr TacVector< T, 2 > V2( T x, T y )
 {
   TacVector< T, 2 > result = { x, y };
   return result;
@@ -170,7 +219,7 @@ struct TacVector< T, 3 >
 typedef TacVector< r32, 3 > v3;
 typedef TacVector< u32, 3 > v3u;
 template< typename T >
-TacVector< T, 3 > V3( T x, T y, T z )
+constexpr TacVector< T, 3 > V3( T x, T y, T z )
 {
   TacVector< T, 3 > result = { x, y, z };
   return result;
@@ -200,17 +249,15 @@ struct TacVector< T, 4 >
 typedef TacVector< r32, 4 > v4;
 typedef TacVector< u32, 4 > v4u;
 template< typename T >
-TacVector< T, 4 >  V4( T x, T y, T z, T w )
+constexpr TacVector< T, 4 >  V4( T x, T y, T z, T w )
 {
   TacVector< T, 4 >  result = { x, y, z, w };
   return result;
 }
 template< typename T >
-TacVector< T, 4 > V4( const TacVector< T, 3 >& xyz, T w )
+constexpr TacVector< T, 4 > V4( const TacVector< T, 3 >& xyz, T w )
 {
-  TacVector< T, 4 > result;
-  result.xyz = xyz;
-  result.w = w;
+  TacVector< T, 4 > result = { xyz.x, xyz.y, xyz.z, w };
   return result;
 }
 
@@ -456,14 +503,20 @@ struct TacMatrix
 {
   T e[ NUM_ROWS * NUM_COLUMNS ];
 
-  T& operator()( u32 row, u32 column ) { return e[ row * NUM_COLUMNS + column ]; }
-  const T& operator()( u32 row, u32 column ) const { return e[ row * NUM_COLUMNS + column ]; }
-  T& operator[]( u32 index ) { return e[ index ]; }
-  const T& operator[]( u32 index ) const { return e[ index ]; }
+  constexpr T& operator()( u32 row, u32 column )
+  {
+    return e[ row * NUM_COLUMNS + column ];
+  }
+  constexpr const T& operator()( u32 row, u32 column ) const
+  {
+    return e[ row * NUM_COLUMNS + column ];
+  }
+  constexpr T& operator[]( u32 index ) { return e[ index ]; }
+  constexpr const T& operator[]( u32 index ) const { return e[ index ]; }
 };
 
 typedef TacMatrix< r32, 2, 2 > m2;
-inline m2 M2(
+constexpr m2 M2(
   r32 m00, r32 m01,
   r32 m10, r32 m11 )
 {
@@ -474,7 +527,7 @@ inline m2 M2(
 }
 
 typedef TacMatrix< r32, 3, 3 > m3;
-inline m3 M3(
+constexpr m3 M3(
   r32 m00, r32 m01, r32 m02,
   r32 m10, r32 m11, r32 m12,
   r32 m20, r32 m21, r32 m22 )
@@ -487,7 +540,7 @@ inline m3 M3(
 }
 
 typedef TacMatrix< r32, 3, 4 > m34;
-inline m34 M34(
+constexpr m34 M34(
   r32 m00, r32 m01, r32 m02, r32 m03,
   r32 m10, r32 m11, r32 m12, r32 m13,
   r32 m20, r32 m21, r32 m22, r32 m23 )
@@ -500,7 +553,7 @@ inline m34 M34(
 }
 
 typedef TacMatrix< r32, 4, 4 > m4;
-inline m4 M4(
+constexpr m4 M4(
   r32 m00, r32 m01, r32 m02, r32 m03,
   r32 m10, r32 m11, r32 m12, r32 m13,
   r32 m20, r32 m21, r32 m22, r32 m23,
@@ -515,11 +568,11 @@ inline m4 M4(
 }
 
 template< typename T, int NUM_ROWS, int NUM_MIDDLE, int NUM_COLS >
-TacMatrix< T, NUM_ROWS, NUM_COLS > operator* (
+constexpr TacMatrix< T, NUM_ROWS, NUM_COLS > operator* (
   const TacMatrix< T, NUM_ROWS, NUM_MIDDLE >& lhs,
   const TacMatrix< T, NUM_MIDDLE , NUM_COLS >& rhs )
 {
-  TacMatrix< T, NUM_ROWS, NUM_COLS > result;
+  TacMatrix< T, NUM_ROWS, NUM_COLS > result = {};
   for( int r = 0; r < NUM_ROWS; ++r )
   {
     for( int c = 0; c < NUM_COLS; ++c )
@@ -566,11 +619,11 @@ TacVector< T, N > operator * (
 }
 
 template< typename T, int N >
-TacMatrix< T, N, N > operator * (
+constexpr TacMatrix< T, N, N > operator * (
   const TacMatrix< T, N, N >& lhs,
   T val )
 {
-  TacMatrix< T, N, N > result;
+  TacMatrix< T, N, N > result = {};
   for( u32 i = 0; i < N * N; ++i )
   {
     result.e[ i ] = lhs.e[ i ] * val;
@@ -580,11 +633,11 @@ TacMatrix< T, N, N > operator * (
 
 
 template< typename T, int N >
-TacMatrix< T, N, N > operator * (
+constexpr TacMatrix< T, N, N > operator * (
   T val,
   const TacMatrix< T, N, N >& lhs )
 {
-  TacMatrix< T, N, N > result;
+  TacMatrix< T, N, N > result = {};
   for( u32 i = 0; i < N * N; ++i )
   {
     result.e[ i ] = lhs.e[ i ] * val;
@@ -605,7 +658,7 @@ TacMatrix< T, N, N >& operator *= (
 }
 
 template< typename T, int M, int N >
-void Identity( TacMatrix< T, M, N >& mat )
+constexpr void Identity( TacMatrix< T, M, N >& mat )
 {
   for( int r = 0; r < M; ++r )
   {
@@ -616,7 +669,7 @@ void Identity( TacMatrix< T, M, N >& mat )
   }
 }
 
-template< typename T, int N > TacMatrix< T, N, N >
+template< typename T, int N > constexpr TacMatrix< T, N, N >
 Transpose( const TacMatrix< T, N, N >& mat )
 {
   TacMatrix< T, N, N > result = {};
@@ -734,6 +787,148 @@ TacMatrix< T, 2, 2 >
   return result;
 }
 
+// Closed form versions of the templates above for the sizes that get
+// used, instead of recursing through cofactors.
+// Inverse( m4 ) uses SSE when it's on
+r32 Determinant( const m3& mat );
+r32 Determinant( const m4& mat );
+m3 Inverse( const m3& mat );
+m4 Inverse( const m4& mat );
+
+// Inverse of a matrix whose bottom row is 0, 0, 0, 1, like a world matrix
+m4 InverseAffine( const m4& mat );
+
+// Inverse of a matrix that only rotates and translates, like a view matrix
+m4 InverseRigid( const m4& mat );
+
+#if TACMATHSSE
+// Non-template overloads win over the templates above, so these are
+// picked for m4 and v4 everywhere, including inside other templates.
+// Nothing is aligned, so everything uses unaligned loads and stores.
+//
+// v3 stays 12 bytes because vertex formats and the asset files depend on
+// it, so v3 math stays on the generic templates
+
+inline r32 Dot( const v4& lhs, const v4& rhs )
+{
+  __m128 products = _mm_mul_ps(
+    _mm_loadu_ps( lhs.e ),
+    _mm_loadu_ps( rhs.e ) );
+  __m128 sums = _mm_add_ps( products, _mm_movehl_ps( products, products ) );
+  sums = _mm_add_ss(
+    sums,
+    _mm_shuffle_ps( sums, sums, _MM_SHUFFLE( 1, 1, 1, 1 ) ) );
+  r32 result = _mm_cvtss_f32( sums );
+  return result;
+}
+
+inline v4 Normalize( const v4& lhs )
+{
+  __m128 v = _mm_loadu_ps( lhs.e );
+  __m128 products = _mm_mul_ps( v, v );
+
+  // the squared length ends up in every lane
+  __m128 sums = _mm_add_ps(
+    products,
+    _mm_shuffle_ps( products, products, _MM_SHUFFLE( 2, 3, 0, 1 ) ) );
+  sums = _mm_add_ps(
+    sums,
+    _mm_shuffle_ps( sums, sums, _MM_SHUFFLE( 1, 0, 3, 2 ) ) );
+
+  v4 result;
+  _mm_storeu_ps( result.e, _mm_div_ps( v, _mm_sqrt_ps( sums ) ) );
+  return result;
+}
+
+inline v4 operator * ( const m4& lhs, const v4& rhs )
+{
+  __m128 v = _mm_loadu_ps( rhs.e );
+  __m128 row0 = _mm_mul_ps( _mm_loadu_ps( lhs.e + 0 ), v );
+  __m128 row1 = _mm_mul_ps( _mm_loadu_ps( lhs.e + 4 ), v );
+  __m128 row2 = _mm_mul_ps( _mm_loadu_ps( lhs.e + 8 ), v );
+  __m128 row3 = _mm_mul_ps( _mm_loadu_ps( lhs.e + 12 ), v );
+
+  // after the transpose, lane r of each register is a product from row r
+  _MM_TRANSPOSE4_PS( row0, row1, row2, row3 );
+  __m128 sums = _mm_add_ps(
+    _mm_add_ps( row0, row1 ),
+    _mm_add_ps( row2, row3 ) );
+
+  v4 result;
+  _mm_storeu_ps( result.e, sums );
+  return result;
+}
+
+// Each row of the result is the rhs rows weighted by the lhs row, summed
+// in the same order as the generic template
+inline m4 operator * ( const m4& lhs, const m4& rhs )
+{
+  m4 result;
+#if TACMATHAVX
+  // two result rows at a time, with the rhs rows repeated in both halves
+  __m256 rhsRow0 = _mm256_broadcast_ps( ( const __m128* )( rhs.e + 0 ) );
+  __m256 rhsRow1 = _mm256_broadcast_ps( ( const __m128* )( rhs.e + 4 ) );
+  __m256 rhsRow2 = _mm256_broadcast_ps( ( const __m128* )( rhs.e + 8 ) );
+  __m256 rhsRow3 = _mm256_broadcast_ps( ( const __m128* )( rhs.e + 12 ) );
+  for( u32 r = 0; r < 4; r += 2 )
+  {
+    __m256 lhsRows = _mm256_loadu_ps( lhs.e + r * 4 );
+    __m256 rows = _mm256_mul_ps(
+      _mm256_shuffle_ps( lhsRows, lhsRows, _MM_SHUFFLE( 0, 0, 0, 0 ) ),
+      rhsRow0 );
+    rows = _mm256_add_ps( rows, _mm256_mul_ps(
+      _mm256_shuffle_ps( lhsRows, lhsRows, _MM_SHUFFLE( 1, 1, 1, 1 ) ),
+      rhsRow1 ) );
+    rows = _mm256_add_ps( rows, _mm256_mul_ps(
+      _mm256_shuffle_ps( lhsRows, lhsRows, _MM_SHUFFLE( 2, 2, 2, 2 ) ),
+      rhsRow2 ) );
+    rows = _mm256_add_ps( rows, _mm256_mul_ps(
+      _mm256_shuffle_ps( lhsRows, lhsRows, _MM_SHUFFLE( 3, 3, 3, 3 ) ),
+      rhsRow3 ) );
+    _mm256_storeu_ps( result.e + r * 4, rows );
+  }
+#else
+  __m128 rhsRow0 = _mm_loadu_ps( rhs.e + 0 );
+  __m128 rhsRow1 = _mm_loadu_ps( rhs.e + 4 );
+  __m128 rhsRow2 = _mm_loadu_ps( rhs.e + 8 );
+  __m128 rhsRow3 = _mm_loadu_ps( rhs.e + 12 );
+  for( u32 r = 0; r < 4; ++r )
+  {
+    __m128 lhsRow = _mm_loadu_ps( lhs.e + r * 4 );
+    __m128 row = _mm_mul_ps(
+      _mm_shuffle_ps( lhsRow, lhsRow, _MM_SHUFFLE( 0, 0, 0, 0 ) ),
+      rhsRow0 );
+    row = _mm_add_ps( row, _mm_mul_ps(
+      _mm_shuffle_ps( lhsRow, lhsRow, _MM_SHUFFLE( 1, 1, 1, 1 ) ),
+      rhsRow1 ) );
+    row = _mm_add_ps( row, _mm_mul_ps(
+      _mm_shuffle_ps( lhsRow, lhsRow, _MM_SHUFFLE( 2, 2, 2, 2 ) ),
+      rhsRow2 ) );
+    row = _mm_add_ps( row, _mm_mul_ps(
+      _mm_shuffle_ps( lhsRow, lhsRow, _MM_SHUFFLE( 3, 3, 3, 3 ) ),
+      rhsRow3 ) );
+    _mm_storeu_ps( result.e + r * 4, row );
+  }
+#endif
+  return result;
+}
+
+inline m4 Transpose( const m4& mat )
+{
+  __m128 row0 = _mm_loadu_ps( mat.e + 0 );
+  __m128 row1 = _mm_loadu_ps( mat.e + 4 );
+  __m128 row2 = _mm_loadu_ps( mat.e + 8 );
+  __m128 row3 = _mm_loadu_ps( mat.e + 12 );
+  _MM_TRANSPOSE4_PS( row0, row1, row2, row3 );
+  m4 result;
+  _mm_storeu_ps( result.e + 0, row0 );
+  _mm_storeu_ps( result.e + 4, row1 );
+  _mm_storeu_ps( result.e + 8, row2 );
+  _mm_storeu_ps( result.e + 12, row3 );
+  return result;
+}
+#endif
+
 m3 M3Scale( v3 scale );
 m3 M3RotRadX( float rotRad );
 m3 M3RotRadY( float rotRad );
@@ -753,6 +948,10 @@ void M3ToEuler( m3 m, v3& euler );
 
 void MatrixUnitTests();
 
+// Checks the closed form and SSE / AVX overloads against the generic
+// templates
+void MatrixSimdUnitTests();
+
 template< typename T, int N >
 bool IsAboutEqual(
   const TacVector< T, N >& v0,
@@ -781,6 +980,37 @@ bool IsAboutEqual(
 
 void PrintMatrix( const m4& m );
 
+// A fixed size array that can be built and returned at compile time
+template< typename T, u32 N >
+struct TacTable
+{
+  T e[ N ];
+  constexpr T& operator[]( u32 index ) { return e[ index ]; }
+  constexpr const T& operator[]( u32 index ) const { return e[ index ]; }
+};
+
+// Entry i of the table is generator( i ). With a constexpr generator the
+// table is built by the compiler, for example
+//
+//   struct Squares
+//   {
+//     constexpr r32 operator()( u32 i ) const { return Square( ( r32 )i ); }
+//   };
+//   static constexpr TacTable< r32, 8 > squares =
+//     MakeTable< r32, 8 >( Squares() );
+//
+// Since vectors are unions, the generator should read them through x, y,
+// z, w rather than e[], and the SSE m4 and v4 overloads don't run at
+// compile time
+template< typename T, u32 N, typename Generator >
+constexpr TacTable< T, N > MakeTable( Generator generator )
+{
+  TacTable< T, N > result = {};
+  for( u32 i = 0; i < N; ++i )
+    result.e[ i ] = generator( i );
+  return result;
+}
+
 struct TacQuaternion
 {
   union
@@ -814,6 +1044,55 @@ struct TacHypersphere
 typedef TacHypersphere< v3 > TacSphere;
 typedef TacHypersphere< v2 > TacCircle;
 
+// v3s stored by component, so the stream functions below can do four at
+// a time. The arrays don't have to be aligned
+struct TacVectorsSoA
+{
+  r32* xs;
+  r32* ys;
+  r32* zs;
+  u32 count;
+};
+
+// Bounding spheres stored by component, so four can be done at once.
+// The arrays don't have to be aligned
+struct TacSpheresSoA
+{
+  r32* xs;
+  r32* ys;
+  r32* zs;
+  r32* radii;
+  u32 count;
+};
+
+// The stream functions read count elements from the input, and write
+// that many to the result's arrays. The result can use the same arrays
+// as the input.
+
+// result[ i ] = ( transform * V4( points[ i ], 1 ) ).xyz
+void TransformPoints(
+  const m4& transform,
+  const TacVectorsSoA& points,
+  const TacVectorsSoA& result );
+
+// Moves each sphere by its own transform, and scales its radius by the
+// longest axis of the transform, so the result bounds the transformed
+// sphere even when the scale isn't uniform
+void TransformSpheres(
+  const m4* transforms,
+  const TacSpheresSoA& spheres,
+  const TacSpheresSoA& result );
+
+// results[ i ] = Dot( vectors[ i ], v )
+void DotProducts(
+  const TacVectorsSoA& vectors,
+  v3 v,
+  r32* results );
+
+// Checks the stream functions against the scalar m4 and v3 math, for every
+// count up to a few registers so the leftover lanes are covered too
+void StreamUnitTests();
+
 // naive approach, makes a shitty sphere
 TacSphere SphereCentroid(
   v3* points,
@@ -0,0 +1,368 @@
+#include "tacOcclusion.h"
+
+#include <xmmintrin.h> // sse
+
+void OcclusionBufferBegin(
+  TacOcclusionBuffer* buffer,
+  r32* invDepths,
+  TacOcclusionTriangle* triangles,
+  u32 maxTriangles,
+  const m4& viewProj,
+  r32 camNear )
+{
+  buffer->invDepths = invDepths;
+  buffer->triangles = triangles;
+  buffer->numTriangles = 0;
+  buffer->maxTriangles = maxTriangles;
+  buffer->viewProj = viewProj;
+  buffer->camNear = camNear;
+}
+
+// clip space to pixels, with 1 / w in z
+internalFunction v3 OcclusionScreenPos( const v4& clip )
+{
+  r32 invW = 1.0f / clip.w;
+  v3 result;
+  result.x = ( clip.x * invW * 0.5f + 0.5f ) * TacOcclusionBuffer::width;
+  result.y = ( 0.5f - clip.y * invW * 0.5f ) * TacOcclusionBuffer::height;
+  result.z = invW;
+  return result;
+}
+
+// The pixels a screen space rect touches, clamped to the buffer before
+// converting, since points near the camera can be far off screen
+internalFunction void OcclusionPixelRect(
+  r32 minX,
+  r32 minY,
+  r32 maxX,
+  r32 maxY,
+  s32& pixelMinX,
+  s32& pixelMinY,
+  s32& pixelMaxX,
+  s32& pixelMaxY )
+{
+  r32 width = ( r32 )TacOcclusionBuffer::width;
+  r32 height = ( r32 )TacOcclusionBuffer::height;
+  Clamp( minX, 0.0f, width );
+  Clamp( minY, 0.0f, height );
+  Clamp( maxX, 0.0f, width );
+  Clamp( maxY, 0.0f, height );
+  pixelMinX = FloorReal32ToInt32( minX );
+  pixelMinY = FloorReal32ToInt32( minY );
+  pixelMaxX = CeilReal32ToInt32( maxX );
+  pixelMaxY = CeilReal32ToInt32( maxY );
+}
+
+internalFunction b32 OcclusionSetupTriangle(
+  TacOcclusionBuffer* buffer,
+  const v3& p0,
+  const v3& p1,
+  const v3& p2 )
+{
+  const v3* p[ 3 ] = { &p0, &p1, &p2 };
+
+  // edge i is the one across from vertex i
+  TacOcclusionTriangle triangle;
+  for( u32 i = 0; i < 3; ++i )
+  {
+    const v3& a = *p[ ( i + 1 ) % 3 ];
+    const v3& b = *p[ ( i + 2 ) % 3 ];
+    triangle.edgeA[ i ] = a.y - b.y;
+    triangle.edgeB[ i ] = b.x - a.x;
+    triangle.edgeC[ i ] = a.x * b.y - a.y * b.x;
+  }
+  r32 area =
+    triangle.edgeA[ 0 ] * p0.x +
+    triangle.edgeB[ 0 ] * p0.y +
+    triangle.edgeC[ 0 ];
+  if( AbsoluteValue( area ) < 0.0001f )
+    return true;
+
+  // both windings are drawn, flip the edges so inside is positive
+  r32 sign = area < 0 ? -1.0f : 1.0f;
+  r32 invArea = 1.0f / ( area * sign );
+  triangle.depthA = 0;
+  triangle.depthB = 0;
+  triangle.depthC = 0;
+  for( u32 i = 0; i < 3; ++i )
+  {
+    triangle.edgeA[ i ] *= sign;
+    triangle.edgeB[ i ] *= sign;
+    triangle.edgeC[ i ] *= sign;
+    r32 weight = p[ i ]->z * invArea;
+    triangle.depthA += triangle.edgeA[ i ] * weight;
+    triangle.depthB += triangle.edgeB[ i ] * weight;
+    triangle.depthC += triangle.edgeC[ i ] * weight;
+  }
+
+  OcclusionPixelRect(
+    Minimum( Minimum( p0.x, p1.x ), p2.x ),
+    Minimum( Minimum( p0.y, p1.y ), p2.y ),
+    Maximum( Maximum( p0.x, p1.x ), p2.x ),
+    Maximum( Maximum( p0.y, p1.y ), p2.y ),
+    triangle.minX,
+    triangle.minY,
+    triangle.maxX,
+    triangle.maxY );
+  if( triangle.minX >= triangle.maxX || triangle.minY >= triangle.maxY )
+    return true;
+
+  if( buffer->numTriangles == buffer->maxTriangles )
+    return false;
+  buffer->triangles[ buffer->numTriangles++ ] = triangle;
+  return true;
+}
+
+b32 OcclusionBufferAddOccluder(
+  TacOcclusionBuffer* buffer,
+  const m4& world,
+  const v3* vertexes,
+  const u32* indexes,
+  u32 numIndexes )
+{
+  m4 worldViewProj = buffer->viewProj * world;
+  r32 camNear = buffer->camNear;
+  for( u32 iIndex = 0; iIndex + 2 < numIndexes; iIndex += 3 )
+  {
+    v4 clip[ 3 ];
+    for( u32 i = 0; i < 3; ++i )
+    {
+      const v3& vertex = vertexes[ indexes[ iIndex + i ] ];
+      clip[ i ] = worldViewProj * V4( vertex, 1.0f );
+    }
+
+    // clip against the near plane, which can make a quad
+    v4 clipped[ 4 ];
+    u32 numClipped = 0;
+    for( u32 i = 0; i < 3; ++i )
+    {
+      const v4& cur = clip[ i ];
+      const v4& next = clip[ ( i + 1 ) % 3 ];
+      r32 curDist = cur.w - camNear;
+      r32 nextDist = next.w - camNear;
+      if( curDist >= 0 )
+        clipped[ numClipped++ ] = cur;
+      if( ( curDist >= 0 ) != ( nextDist >= 0 ) )
+      {
+        r32 t = curDist / ( curDist - nextDist );
+        clipped[ numClipped++ ] = Lerp( cur, next, t );
+      }
+    }
+    if( numClipped < 3 )
+      continue;
+
+    v3 screen[ 4 ];
+    for( u32 i = 0; i < numClipped; ++i )
+      screen[ i ] = OcclusionScreenPos( clipped[ i ] );
+    for( u32 i = 1; i + 1 < numClipped; ++i )
+    {
+      if( !OcclusionSetupTriangle(
+        buffer,
+        screen[ 0 ],
+        screen[ i ],
+        screen[ i + 1 ] ) )
+        return false;
+    }
+  }
+  return true;
+}
+
+internalFunction void OcclusionRasterizeTile(
+  TacOcclusionBuffer* buffer,
+  u32 iTile )
+{
+  const s32 pitch = TacOcclusionBuffer::width;
+  s32 tileMinX = ( iTile % TacOcclusionBuffer::numTilesX ) *
+    TacOcclusionBuffer::tileSize;
+  s32 tileMinY = ( iTile / TacOcclusionBuffer::numTilesX ) *
+    TacOcclusionBuffer::tileSize;
+  s32 tileMaxX = tileMinX + TacOcclusionBuffer::tileSize;
+  s32 tileMaxY = tileMinY + TacOcclusionBuffer::tileSize;
+
+  const __m128 laneOffsets = _mm_set_ps( 3.5f, 2.5f, 1.5f, 0.5f );
+  const __m128 zero = _mm_setzero_ps();
+
+  for( s32 y = tileMinY; y < tileMaxY; ++y )
+  {
+    r32* invDepths = buffer->invDepths + y * pitch;
+    for( s32 x = tileMinX; x < tileMaxX; x += 4 )
+      _mm_storeu_ps( invDepths + x, zero );
+  }
+
+  for( u32 iTriangle = 0; iTriangle < buffer->numTriangles; ++iTriangle )
+  {
+    const TacOcclusionTriangle& triangle = buffer->triangles[ iTriangle ];
+    s32 minX = Maximum( triangle.minX, tileMinX );
+    s32 minY = Maximum( triangle.minY, tileMinY );
+    s32 maxX = Minimum( triangle.maxX, tileMaxX );
+    s32 maxY = Minimum( triangle.maxY, tileMaxY );
+    if( minX >= maxX || minY >= maxY )
+      continue;
+
+    // Tiles are a multiple of 4 wide, so groups of 4 never straddle them.
+    // Lanes outside the triangle's bounds are outside an edge too
+    s32 alignedMinX = minX & ~3;
+    __m128 edgeA[ 3 ];
+    for( u32 i = 0; i < 3; ++i )
+      edgeA[ i ] = _mm_set1_ps( triangle.edgeA[ i ] );
+    __m128 depthA = _mm_set1_ps( triangle.depthA );
+
+    for( s32 y = minY; y < maxY; ++y )
+    {
+      r32 pixelY = y + 0.5f;
+      __m128 edgeRows[ 3 ];
+      for( u32 i = 0; i < 3; ++i )
+      {
+        edgeRows[ i ] = _mm_set1_ps(
+          triangle.edgeB[ i ] * pixelY + triangle.edgeC[ i ] );
+      }
+      __m128 depthRow = _mm_set1_ps(
+        triangle.depthB * pixelY + triangle.depthC );
+      r32* invDepths = buffer->invDepths + y * pitch;
+
+      for( s32 x = alignedMinX; x < maxX; x += 4 )
+      {
+        __m128 pixelXs = _mm_add_ps( _mm_set1_ps( ( r32 )x ), laneOffsets );
+        __m128 mask = _mm_cmpge_ps(
+          _mm_add_ps( _mm_mul_ps( edgeA[ 0 ], pixelXs ), edgeRows[ 0 ] ),
+          zero );
+        for( u32 i = 1; i < 3; ++i )
+        {
+          mask = _mm_and_ps( mask, _mm_cmpge_ps(
+            _mm_add_ps( _mm_mul_ps( edgeA[ i ], pixelXs ), edgeRows[ i ] ),
+            zero ) );
+        }
+        if( !_mm_movemask_ps( mask ) )
+          continue;
+
+        __m128 invDepth = _mm_add_ps(
+          _mm_mul_ps( depthA, pixelXs ),
+          depthRow );
+        __m128 old = _mm_loadu_ps( invDepths + x );
+        __m128 written = _mm_or_ps(
+          _mm_and_ps( mask, _mm_max_ps( old, invDepth ) ),
+          _mm_andnot_ps( mask, old ) );
+        _mm_storeu_ps( invDepths + x, written );
+      }
+    }
+  }
+
+  __m128 tileMins = _mm_set1_ps( R32MAX );
+  for( s32 y = tileMinY; y < tileMaxY; ++y )
+  {
+    r32* invDepths = buffer->invDepths + y * pitch;
+    for( s32 x = tileMinX; x < tileMaxX; x += 4 )
+      tileMins = _mm_min_ps( tileMins, _mm_loadu_ps( invDepths + x ) );
+  }
+  r32 lanes[ 4 ];
+  _mm_storeu_ps( lanes, tileMins );
+  buffer->tileMinInvDepths[ iTile ] = Minimum(
+    Minimum( lanes[ 0 ], lanes[ 1 ] ),
+    Minimum( lanes[ 2 ], lanes[ 3 ] ) );
+}
+
+void OcclusionBufferRasterize(
+  TacOcclusionBuffer* buffer,
+  TacWorkQueue* queue,
+  TacThreadContext* thread )
+{
+  ParallelFor(
+    queue,
+    thread,
+    0,
+    TacOcclusionBuffer::numTiles,
+    1,
+    [ & ]( u32 iTile )
+  {
+    OcclusionRasterizeTile( buffer, iTile );
+  } );
+}
+
+b32 OcclusionBufferTestAabb(
+  const TacOcclusionBuffer* buffer,
+  const TacAabb& aabb )
+{
+  r32 minX = R32MAX;
+  r32 minY = R32MAX;
+  r32 maxX = -R32MAX;
+  r32 maxY = -R32MAX;
+  r32 minW = R32MAX;
+  for( u32 iCorner = 0; iCorner < 8; ++iCorner )
+  {
+    v3 corner = V3(
+      iCorner & 1 ? aabb.maxi.x : aabb.mini.x,
+      iCorner & 2 ? aabb.maxi.y : aabb.mini.y,
+      iCorner & 4 ? aabb.maxi.z : aabb.mini.z );
+    v4 clip = buffer->viewProj * V4( corner, 1.0f );
+    if( clip.w < buffer->camNear )
+      return true;
+    v3 screen = OcclusionScreenPos( clip );
+    minX = Minimum( minX, screen.x );
+    minY = Minimum( minY, screen.y );
+    maxX = Maximum( maxX, screen.x );
+    maxY = Maximum( maxY, screen.y );
+    minW = Minimum( minW, clip.w );
+  }
+
+  s32 rectMinX;
+  s32 rectMinY;
+  s32 rectMaxX;
+  s32 rectMaxY;
+  OcclusionPixelRect(
+    minX,
+    minY,
+    maxX,
+    maxY,
+    rectMinX,
+    rectMinY,
+    rectMaxX,
+    rectMaxY );
+
+  // off screen, that's for the frustum culling to decide
+  if( rectMinX >= rectMaxX || rectMinY >= rectMaxY )
+    return true;
+
+  // the closest the box gets, any pixel at least this far away shows it
+  r32 boxInvDepth = 1.0f / minW;
+  const __m128 laneOffsets = _mm_set_ps( 3.5f, 2.5f, 1.5f, 0.5f );
+  const __m128 boxInvDepths = _mm_set1_ps( boxInvDepth );
+  const __m128 rectMinXs = _mm_set1_ps( ( r32 )rectMinX );
+  const __m128 rectMaxXs = _mm_set1_ps( ( r32 )rectMaxX );
+  const u32 tileSize = TacOcclusionBuffer::tileSize;
+  for( u32 tileY = rectMinY / tileSize;
+    tileY * tileSize < ( u32 )rectMaxY;
+    ++tileY )
+  {
+    for( u32 tileX = rectMinX / tileSize;
+      tileX * tileSize < ( u32 )rectMaxX;
+      ++tileX )
+    {
+      u32 iTile = tileY * TacOcclusionBuffer::numTilesX + tileX;
+      if( buffer->tileMinInvDepths[ iTile ] > boxInvDepth )
+        continue;
+
+      s32 minTileX = Maximum( rectMinX, ( s32 )( tileX * tileSize ) );
+      s32 minTileY = Maximum( rectMinY, ( s32 )( tileY * tileSize ) );
+      s32 maxTileX = Minimum( rectMaxX, ( s32 )( ( tileX + 1 ) * tileSize ) );
+      s32 maxTileY = Minimum( rectMaxY, ( s32 )( ( tileY + 1 ) * tileSize ) );
+      for( s32 y = minTileY; y < maxTileY; ++y )
+      {
+        const r32* invDepths =
+          buffer->invDepths + y * TacOcclusionBuffer::width;
+        for( s32 x = minTileX & ~3; x < maxTileX; x += 4 )
+        {
+          __m128 pixelXs = _mm_add_ps( _mm_set1_ps( ( r32 )x ), laneOffsets );
+          __m128 mask = _mm_and_ps(
+            _mm_cmpge_ps( pixelXs, rectMinXs ),
+            _mm_cmplt_ps( pixelXs, rectMaxXs ) );
+          __m128 shows = _mm_cmple_ps(
+            _mm_loadu_ps( invDepths + x ),
+            boxInvDepths );
+          if( _mm_movemask_ps( _mm_and_ps( mask, shows ) ) )
+            return true;
+        }
+      }
+    }
+  }
+  return false;
+}
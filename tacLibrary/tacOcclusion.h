@@ -0,0 +1,94 @@
+#pragma once
+#include "tacAabbTree.h"
+#include "tacPlatform.h"
+
+// A small cpu depth buffer that a few big occluders are drawn into, so
+// entities hidden behind them can be skipped before they're drawn.
+//
+// Usage, every frame:
+//
+//   OcclusionBufferBegin( &buffer, invDepths, triangles, maxTriangles,
+//     viewProj, camNear );
+//   OcclusionBufferAddOccluder( &buffer, ground.world, ... );
+//   OcclusionBufferRasterize( &buffer, queue, thread );
+//   if( OcclusionBufferTestAabb( &buffer, entityAabb ) )
+//     draw the entity
+//
+// The buffer stores 1 / view space depth, which is linear in screen space,
+// so bigger values are closer and 0 is nothing drawn. Nothing here touches
+// the renderer.
+
+struct TacOcclusionTriangle
+{
+  // edge functions, >= 0 inside
+  r32 edgeA[ 3 ];
+  r32 edgeB[ 3 ];
+  r32 edgeC[ 3 ];
+
+  // invDepth = depthA * x + depthB * y + depthC
+  r32 depthA;
+  r32 depthB;
+  r32 depthC;
+
+  // pixel bounds, max exclusive
+  s32 minX;
+  s32 minY;
+  s32 maxX;
+  s32 maxY;
+};
+
+struct TacOcclusionBuffer
+{
+  static const u32 width = 256;
+  static const u32 height = 128;
+
+  // each tile is rasterized by one job
+  static const u32 tileSize = 32;
+  static const u32 numTilesX = width / tileSize;
+  static const u32 numTilesY = height / tileSize;
+  static const u32 numTiles = numTilesX * numTilesY;
+
+  // width * height
+  r32* invDepths;
+
+  // The farthest value in each tile. A box closer than this is hidden
+  // in the whole tile without looking at the pixels
+  r32 tileMinInvDepths[ numTiles ];
+
+  TacOcclusionTriangle* triangles;
+  u32 numTriangles;
+  u32 maxTriangles;
+
+  m4 viewProj;
+  r32 camNear;
+};
+
+void OcclusionBufferBegin(
+  TacOcclusionBuffer* buffer,
+  r32* invDepths,
+  TacOcclusionTriangle* triangles,
+  u32 maxTriangles,
+  const m4& viewProj,
+  r32 camNear );
+
+// The triangles are drawn from both sides, so occluders should be closed.
+// Returns false if there wasn't room for all the triangles
+b32 OcclusionBufferAddOccluder(
+  TacOcclusionBuffer* buffer,
+  const m4& world,
+  const v3* vertexes,
+  const u32* indexes,
+  u32 numIndexes );
+
+// Draws the occluders, one tile per job
+void OcclusionBufferRasterize(
+  TacOcclusionBuffer* buffer,
+  TacWorkQueue* queue,
+  TacThreadContext* thread );
+
+// Returns false if every pixel the box covers is in front of it.
+// Boxes that cross the near plane are always visible.
+// Can be called from the workers after OcclusionBufferRasterize
+b32 OcclusionBufferTestAabb(
+  const TacOcclusionBuffer* buffer,
+  const TacAabb& aabb );
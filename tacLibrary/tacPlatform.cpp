@@ -1,4 +1,5 @@
 #include "tacPlatform.h"
+#include "tacJobProfiler.h"
 
 
 void GameOnLoadStub( TacGameInterface& onLoadInterface )
@@ -30,16 +31,18 @@ const char* VA( const char* format, ... )
 void PushEntry(
   TacWorkQueue* queue,
   WorkQueueCallback* callback,
-  void* data )
+  void* data,
+  TacJobPriority priority )
 {
+  TacWorkRing& ring = queue->rings[ ( u32 )priority ];
   u32 newNextEntryToWrite =
-    ( queue->nextEntryToWrite + 1 ) % queue->maxEntries;
-  TacAssert( newNextEntryToWrite != queue->nextEntryToRead );
+    ( ring.nextEntryToWrite + 1 ) % ring.maxEntries;
+  TacAssert( newNextEntryToWrite != ring.nextEntryToRead );
 
   // TODO( N8 ): CAS so any thread can add
 
   // a
-  TacEntryStorage& entry = queue->entries[ queue->nextEntryToWrite ];
+  TacEntryStorage& entry = ring.entries[ ring.nextEntryToWrite ];
 
   // b
   entry.data = data;
@@ -51,36 +54,103 @@ void PushEntry(
   std::atomic_thread_fence( std::memory_order_release );
 
   // c
-  queue->nextEntryToWrite = newNextEntryToWrite;
+  ring.nextEntryToWrite = newNextEntryToWrite;
   ++queue->numToComplete;
+
+  // entries are pushed from the thread after the workers
+  JobProfilerRecord(
+    queue->profiler,
+    queue->threads.size(),
+    TacJobEventType::Enqueue,
+    callback,
+    priority );
 }
 
-b32 DoNextEntry( TacWorkQueue* queue, TacThreadContext* thread )
+enum class TacRingResult
+{
+  Empty,
+  LostRace,
+  DidWork,
+};
+
+internalFunction TacRingResult DoNextRingEntry(
+  TacWorkQueue* queue,
+  TacJobPriority priority,
+  TacThreadContext* thread )
 {
-  b32 shouldSleep = false;
+  TacWorkRing& ring = queue->rings[ ( u32 )priority ];
+  u32 originalNextEntryToRead = ring.nextEntryToRead;
+  if( originalNextEntryToRead == ring.nextEntryToWrite )
+    return TacRingResult::Empty;
+
+  u32 newNextEntryToRead = ( originalNextEntryToRead + 1 ) % ring.maxEntries;
+  if( !ring.nextEntryToRead.compare_exchange_strong(
+    originalNextEntryToRead,
+    newNextEntryToRead,
+    std::memory_order_relaxed ) )
+    return TacRingResult::LostRace;
 
-  u32 originalNextEntryToRead = queue->nextEntryToRead;
-  u32 newNextEntryToRead = ( originalNextEntryToRead + 1 ) % queue->maxEntries;
-  if( originalNextEntryToRead != queue->nextEntryToWrite )
+  std::atomic_thread_fence( std::memory_order_consume );
+  TacEntryStorage& storage = ring.entries[ originalNextEntryToRead ];
+  WorkQueueCallback* callback = storage.callback;
+  JobProfilerRecord(
+    queue->profiler,
+    thread->logicalThreadIndex,
+    TacJobEventType::Start,
+    callback,
+    priority );
+  callback( thread, storage.data );
+  JobProfilerRecord(
+    queue->profiler,
+    thread->logicalThreadIndex,
+    TacJobEventType::End,
+    callback,
+    priority );
+  std::atomic_thread_fence( std::memory_order_release );
+  ++queue->numCompleted;
+  return TacRingResult::DidWork;
+}
+
+b32 DoNextEntry(
+  TacWorkQueue* queue,
+  TacThreadContext* thread,
+  TacJobPriority lowestPriority )
+{
+  for( u32 iPriority = 0; iPriority <= ( u32 )lowestPriority; ++iPriority )
   {
-    if( queue->nextEntryToRead.compare_exchange_strong(
-      originalNextEntryToRead,
-      newNextEntryToRead,
-      std::memory_order_relaxed ) )
+    TacWorkRing& ring = queue->rings[ iPriority ];
+    if( ring.nextEntryToRead == ring.nextEntryToWrite )
+      continue;
+
+    TacRingResult ringResult;
+    if( iPriority == ( u32 )TacJobPriority::Background )
     {
-      std::atomic_thread_fence( std::memory_order_consume );
-      TacEntryStorage& storage = queue->entries[ originalNextEntryToRead ];
-      storage.callback( thread, storage.data );
-      std::atomic_thread_fence( std::memory_order_release );
-      ++queue->numCompleted;
+      // reserve a background slot before taking the entry
+      u32 numRunning = queue->numBackgroundThreadsRunning;
+      if( numRunning >= queue->maxBackgroundThreads )
+        continue;
+      if( !queue->numBackgroundThreadsRunning.compare_exchange_strong(
+        numRunning,
+        numRunning + 1 ) )
+        return false;
+      ringResult = DoNextRingEntry(
+        queue,
+        ( TacJobPriority )iPriority,
+        thread );
+      --queue->numBackgroundThreadsRunning;
+    }
+    else
+    {
+      ringResult = DoNextRingEntry(
+        queue,
+        ( TacJobPriority )iPriority,
+        thread );
     }
-  }
-  else
-  {
-    shouldSleep = true;
-  }
 
-  return shouldSleep;
+    if( ringResult != TacRingResult::Empty )
+      return false;
+  }
+  return true;
 }
 
 void CompleteAllWork( TacWorkQueue* queue, TacThreadContext* thread )
@@ -93,6 +163,50 @@ void CompleteAllWork( TacWorkQueue* queue, TacThreadContext* thread )
   queue->numToComplete = 0;
 }
 
+void CompleteWorkGroup(
+  TacWorkQueue* queue,
+  TacThreadContext* thread,
+  TacWorkGroup* group )
+{
+  while( group->numRemaining )
+  {
+    // don't get stuck in a background entry while the frame waits
+    DoNextEntry( queue, thread, TacJobPriority::FrameCritical );
+  }
+  std::atomic_thread_fence( std::memory_order_acquire );
+}
+
+TacParallelChunks ComputeParallelChunks(
+  TacWorkQueue* queue,
+  u32 begin,
+  u32 end,
+  u32 grain )
+{
+  TacParallelChunks chunks = {};
+  if( end <= begin )
+    return chunks;
+  u32 numItems = end - begin;
+  if( !queue || queue->threads.empty() )
+  {
+    chunks.numChunks = 1;
+    chunks.grain = numItems;
+    return chunks;
+  }
+  if( !grain )
+  {
+    // a few chunks per thread so a slow chunk doesn't stall everyone
+    u32 numThreads = queue->threads.size() + 1;
+    u32 desiredNumChunks = numThreads * 4;
+    grain = ( numItems + desiredNumChunks - 1 ) / desiredNumChunks;
+    grain = Maximum( grain, 1 );
+  }
+  chunks.grain = Maximum( grain,
+    ( numItems + TacParallelChunks::maxChunks - 1 ) /
+    TacParallelChunks::maxChunks );
+  chunks.numChunks = ( numItems + chunks.grain - 1 ) / chunks.grain;
+  return chunks;
+}
+
 void ThreadProc(
   TacWorkQueue* queue,
   TacThreadContext* thread,
@@ -102,17 +216,40 @@ void ThreadProc(
   {
     if( DoNextEntry( queue, thread ) )
     {
+      JobProfilerRecord(
+        queue->profiler,
+        thread->logicalThreadIndex,
+        TacJobEventType::SleepBegin,
+        nullptr,
+        TacJobPriority::Count );
       std::this_thread::sleep_for( std::chrono::milliseconds( 1 ) );
+      JobProfilerRecord(
+        queue->profiler,
+        thread->logicalThreadIndex,
+        TacJobEventType::SleepEnd,
+        nullptr,
+        TacJobPriority::Count );
     }
   }
 }
 
-void TacWorkQueue::Init( u32 numThreads, b32* running )
+void TacWorkQueue::Init(
+  u32 numThreads,
+  u32 maxBackgroundThreads,
+  b32* running )
 {
-  nextEntryToRead = ( 0 );
+  for( TacWorkRing& ring : rings )
+  {
+    ring.nextEntryToRead = ( 0 );
+    ring.nextEntryToWrite = ( 0 );
+  }
   numCompleted = ( 0 );
   numToComplete = ( 0 );
-  nextEntryToWrite = ( 0 );
+  numBackgroundThreadsRunning = ( 0 );
+  profiler = new TacJobProfiler;
+  JobProfilerInit( profiler, numThreads + 1 );
+  this->maxBackgroundThreads = maxBackgroundThreads;
+  this->running = running;
 
   threads.resize( numThreads );
   threadcontexts.resize( numThreads );
@@ -123,10 +260,25 @@ void TacWorkQueue::Init( u32 numThreads, b32* running )
     threadcontext.logicalThreadIndex = i;
     std::thread& curThread = threads[ i ];
     curThread = std::thread( ThreadProc, this, &threadcontext, running );
-    curThread.detach();
   }
 }
 
+void TacWorkQueue::Uninit()
+{
+  *running = false;
+  for( std::thread& curThread : threads )
+  {
+    curThread.join();
+  }
+  threads.clear();
+  threadcontexts.clear();
+
+  // the workers are gone, so nothing records into the profiler anymore
+  JobProfilerUninit( profiler );
+  delete profiler;
+  profiler = nullptr;
+}
+
 time_t PlatformGetFileModifiedTime(
   TacThreadContext* thread,
   const char* filepath,
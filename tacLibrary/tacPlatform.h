@@ -183,33 +183,255 @@ struct TacEntryStorage
   void* data;
 };
 
-struct TacWorkQueue
+// Entries of a higher priority are always dequeued before entries of a
+// lower priority
+enum class TacJobPriority
+{
+  // work the current frame is waiting on, ie: ParallelFor chunks
+  FrameCritical,
+  Normal,
+  // long running work like streaming assets in
+  Background,
+  Count
+};
+
+// Single producer, multiple consumer ring buffer of entries
+struct TacWorkRing
 {
-  void Init( u32 numThreads, b32* running );
-  std::vector< std::thread > threads;
-  std::vector< TacThreadContext > threadcontexts;
   const static u32 maxEntries = 100;
   TacEntryStorage entries[ maxEntries ];
   std::atomic< u32 > nextEntryToRead;
+  std::atomic< u32 > nextEntryToWrite;
+};
+
+struct TacJobProfiler;
+struct TacWorkQueue
+{
+  // at most maxBackgroundThreads threads will be running background
+  // entries at once, so the rest are always free for per-frame work
+  void Init( u32 numThreads, u32 maxBackgroundThreads, b32* running );
+
+  // Clears *running and waits for the workers to finish the entries they
+  // are on, then frees the profiler. Entries still in the rings are dropped
+  void Uninit();
+  b32* running;
+  std::vector< std::thread > threads;
+  std::vector< TacThreadContext > threadcontexts;
+  TacWorkRing rings[ ( u32 )TacJobPriority::Count ];
   std::atomic< u32 > numCompleted;
   std::atomic< u32 > numToComplete;
-  std::atomic< u32 > nextEntryToWrite;
+  std::atomic< u32 > numBackgroundThreadsRunning;
+  u32 maxBackgroundThreads;
+
+  // see tacJobProfiler.h
+  TacJobProfiler* profiler;
 };
 void PushEntry(
   TacWorkQueue* queue,
   WorkQueueCallback* callback,
-  void* data );
+  void* data,
+  TacJobPriority priority = TacJobPriority::Normal );
 
-b32 DoNextEntry( TacWorkQueue* queue, TacThreadContext* thread );
+// Only entries with a priority of at least lowestPriority are considered.
+// Returns true if there was nothing to do
+b32 DoNextEntry(
+  TacWorkQueue* queue,
+  TacThreadContext* thread,
+  TacJobPriority lowestPriority = TacJobPriority::Background );
 
 void CompleteAllWork( TacWorkQueue* queue, TacThreadContext* thread );
 
+// Parallel For -----------------------------------------------------------
+
+// A set of entries that can be waited on without waiting for the rest of
+// the queue ( ie: the async model loads )
+struct TacWorkGroup
+{
+  std::atomic< u32 > numRemaining;
+};
+
+// The calling thread helps out with frame critical entries until the group
+// is done
+void CompleteWorkGroup(
+  TacWorkQueue* queue,
+  TacThreadContext* thread,
+  TacWorkGroup* group );
+
+// Splits [ begin, end ) into chunks of roughly grain items.
+// A grain of 0 picks one based on the number of threads.
+struct TacParallelChunks
+{
+  const static u32 maxChunks = 32;
+  u32 numChunks;
+  u32 grain;
+};
+TacParallelChunks ComputeParallelChunks(
+  TacWorkQueue* queue,
+  u32 begin,
+  u32 end,
+  u32 grain );
+
+template< typename Fn >
+struct TacParallelForChunk
+{
+  const Fn* fn;
+  TacWorkGroup* group;
+  u32 begin;
+  u32 end;
+};
+
+template< typename Fn >
+void ParallelForCallback( TacThreadContext* thread, void* data )
+{
+  TacUnusedParameter( thread );
+  TacParallelForChunk< Fn >* chunk = ( TacParallelForChunk< Fn >* )data;
+  for( u32 i = chunk->begin; i < chunk->end; ++i )
+  {
+    ( *chunk->fn )( i );
+  }
+  std::atomic_thread_fence( std::memory_order_release );
+  --chunk->group->numRemaining;
+}
+
+// Calls fn( u32 i ) for every i in [ begin, end ).
+// Must be called from the thread that owns PushEntry.
+// Returns after every call has finished.
+template< typename Fn >
+void ParallelFor(
+  TacWorkQueue* queue,
+  TacThreadContext* thread,
+  u32 begin,
+  u32 end,
+  u32 grain,
+  const Fn& fn )
+{
+  TacParallelChunks chunks =
+    ComputeParallelChunks( queue, begin, end, grain );
+  if( chunks.numChunks <= 1 )
+  {
+    for( u32 i = begin; i < end; ++i )
+    {
+      fn( i );
+    }
+    return;
+  }
+
+  TacWorkGroup group;
+  group.numRemaining = chunks.numChunks;
+  TacParallelForChunk< Fn > chunkDatas[ TacParallelChunks::maxChunks ];
+  for( u32 iChunk = 0; iChunk < chunks.numChunks; ++iChunk )
+  {
+    TacParallelForChunk< Fn >& chunk = chunkDatas[ iChunk ];
+    chunk.fn = &fn;
+    chunk.group = &group;
+    chunk.begin = begin + iChunk * chunks.grain;
+    chunk.end = Minimum( chunk.begin + chunks.grain, end );
+  }
+
+  // the first chunk is done by the calling thread
+  for( u32 iChunk = 1; iChunk < chunks.numChunks; ++iChunk )
+  {
+    PushEntry(
+      queue,
+      ParallelForCallback< Fn >,
+      &chunkDatas[ iChunk ],
+      TacJobPriority::FrameCritical );
+  }
+  ParallelForCallback< Fn >( thread, &chunkDatas[ 0 ] );
+  CompleteWorkGroup( queue, thread, &group );
+}
+
+template< typename T, typename Fn, typename Combine >
+struct TacParallelReduceChunk
+{
+  const Fn* fn;
+  const Combine* combine;
+  TacWorkGroup* group;
+  u32 begin;
+  u32 end;
+  T result;
+};
+
+template< typename T, typename Fn, typename Combine >
+void ParallelReduceCallback( TacThreadContext* thread, void* data )
+{
+  TacUnusedParameter( thread );
+  TacParallelReduceChunk< T, Fn, Combine >* chunk =
+    ( TacParallelReduceChunk< T, Fn, Combine >* )data;
+  for( u32 i = chunk->begin; i < chunk->end; ++i )
+  {
+    chunk->result = ( *chunk->combine )( chunk->result, ( *chunk->fn )( i ) );
+  }
+  std::atomic_thread_fence( std::memory_order_release );
+  --chunk->group->numRemaining;
+}
+
+// Returns combine( ... combine( combine( identity, fn( begin ) ),
+// fn( begin + 1 ) ) ..., fn( end - 1 ) ).
+// The chunk results are combined in order, so the result is the same
+// no matter which threads did the work.
+template< typename T, typename Fn, typename Combine >
+T ParallelReduce(
+  TacWorkQueue* queue,
+  TacThreadContext* thread,
+  u32 begin,
+  u32 end,
+  u32 grain,
+  const T& identity,
+  const Fn& fn,
+  const Combine& combine )
+{
+  TacParallelChunks chunks =
+    ComputeParallelChunks( queue, begin, end, grain );
+  if( chunks.numChunks <= 1 )
+  {
+    T result = identity;
+    for( u32 i = begin; i < end; ++i )
+    {
+      result = combine( result, fn( i ) );
+    }
+    return result;
+  }
+
+  typedef TacParallelReduceChunk< T, Fn, Combine > Chunk;
+  TacWorkGroup group;
+  group.numRemaining = chunks.numChunks;
+  Chunk chunkDatas[ TacParallelChunks::maxChunks ];
+  for( u32 iChunk = 0; iChunk < chunks.numChunks; ++iChunk )
+  {
+    Chunk& chunk = chunkDatas[ iChunk ];
+    chunk.fn = &fn;
+    chunk.combine = &combine;
+    chunk.group = &group;
+    chunk.begin = begin + iChunk * chunks.grain;
+    chunk.end = Minimum( chunk.begin + chunks.grain, end );
+    chunk.result = identity;
+  }
+  for( u32 iChunk = 1; iChunk < chunks.numChunks; ++iChunk )
+  {
+    PushEntry(
+      queue,
+      ParallelReduceCallback< T, Fn, Combine >,
+      &chunkDatas[ iChunk ],
+      TacJobPriority::FrameCritical );
+  }
+  ParallelReduceCallback< T, Fn, Combine >( thread, &chunkDatas[ 0 ] );
+  CompleteWorkGroup( queue, thread, &group );
+
+  T result = identity;
+  for( u32 iChunk = 0; iChunk < chunks.numChunks; ++iChunk )
+  {
+    result = combine( result, chunkDatas[ iChunk ].result );
+  }
+  return result;
+}
+
 
 
 struct TacGameMemory
 {
   b32 initialized;
-  TacWorkQueue* highPriorityQueue;
+  TacWorkQueue* workQueue;
 
   u32 permanentStorageSize;
   void* permanentStorage; // required to be cleard to zero on startup
@@ -219,6 +441,7 @@ struct TacGameMemory
 };
 
 struct TacRenderer;
+struct RendererSoftware;
 struct TacGameInterface
 {
   TacThreadContext* thread;
@@ -226,6 +449,9 @@ struct TacGameInterface
   TacGameInput* gameInput;
   void* imguiInternalState;
   TacRenderer* renderer;
+  // Also set when renderer is a RendererSoftware, which only draws with
+  // the shader callbacks the game gives it
+  RendererSoftware* softwareRenderer;
   u32 windowWidth;
   u32 windowHeight;
   b32 running;
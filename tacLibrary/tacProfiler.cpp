@@ -0,0 +1,191 @@
+#include "tacProfiler.h"
+
+#include <chrono>
+#include <mutex>
+
+globalVariable std::mutex gProfilerThreadsMutex;
+globalVariable std::vector< TacProfileThread* > gProfilerThreads;
+globalVariable TacProfiler gProfiler;
+thread_local TacProfileThread* tProfilerThread = nullptr;
+
+TacProfileThread* ProfilerGetThread()
+{
+  if( !tProfilerThread )
+  {
+    tProfilerThread = new TacProfileThread();
+    tProfilerThread->numEventsWritten = 0;
+    std::lock_guard< std::mutex > lock( gProfilerThreadsMutex );
+    gProfilerThreads.push_back( tProfilerThread );
+  }
+  return tProfilerThread;
+}
+
+TacProfiler* ProfilerGet()
+{
+  return &gProfiler;
+}
+
+internalFunction u32 ProfilerAddNode(
+  TacProfiler* profiler,
+  const char* name,
+  u32 parentIndex )
+{
+  u32 nodeIndex = profiler->nodes.size();
+  profiler->nodes.resize( nodeIndex + 1 );
+  TacProfileNode& node = profiler->nodes[ nodeIndex ];
+  node.name = name;
+  node.parentIndex = parentIndex;
+  node.depth = 0;
+  if( parentIndex )
+  {
+    TacProfileNode& parent = profiler->nodes[ parentIndex ];
+    parent.childIndexes.push_back( nodeIndex );
+    node.depth = parent.depth + 1;
+  }
+  return nodeIndex;
+}
+
+internalFunction u32 ProfilerGetChild(
+  TacProfiler* profiler,
+  u32 parentIndex,
+  const char* name )
+{
+  for( u32 childIndex : profiler->nodes[ parentIndex ].childIndexes )
+  {
+    if( profiler->nodes[ childIndex ].name == name )
+      return childIndex;
+  }
+  return ProfilerAddNode( profiler, name, parentIndex );
+}
+
+// the tsc frequency isn't exposed anywhere, so measure it against the
+// steady clock over the lifetime of the profiler
+internalFunction void ProfilerCalibrate( TacProfiler* profiler )
+{
+  typedef std::chrono::steady_clock Clock;
+  localPersist Clock::time_point firstTime = Clock::now();
+  localPersist u64 firstCycles = ReadCycleCounter();
+  r64 elapsedMs = std::chrono::duration< r64, std::milli >(
+    Clock::now() - firstTime ).count();
+  u64 elapsedCycles = ReadCycleCounter() - firstCycles;
+  if( elapsedMs > 1.0 )
+  {
+    profiler->cyclesPerMillisecond = elapsedCycles / elapsedMs;
+  }
+}
+
+internalFunction void ProfilerReadThread(
+  TacProfiler* profiler,
+  TacProfileThread* thread,
+  u32 iThread )
+{
+  if( !thread->rootNodeIndex )
+  {
+    localPersist const char* threadNames[] =
+    {
+      "thread 0", "thread 1", "thread 2", "thread 3",
+      "thread 4", "thread 5", "thread 6", "thread 7",
+    };
+    const char* threadName = iThread < ArraySize( threadNames ) ?
+      threadNames[ iThread ] :
+      "thread";
+    thread->rootNodeIndex = ProfilerAddNode( profiler, threadName, 0 );
+    profiler->threadRootIndexes.push_back( thread->rootNodeIndex );
+  }
+
+  u32 numEventsWritten =
+    thread->numEventsWritten.load( std::memory_order_acquire );
+  if( numEventsWritten - thread->numEventsRead > TacProfileThread::maxEvents )
+  {
+    // the thread lapped us, the open zones can't be trusted anymore
+    thread->numEventsRead = numEventsWritten - TacProfileThread::maxEvents;
+    thread->openZones.clear();
+  }
+
+  for( ; thread->numEventsRead != numEventsWritten; ++thread->numEventsRead )
+  {
+    TacProfileEvent& event = thread->events[
+      thread->numEventsRead % TacProfileThread::maxEvents ];
+    if( event.name )
+    {
+      u32 parentIndex = thread->openZones.empty() ?
+        thread->rootNodeIndex :
+        thread->openZones.back().nodeIndex;
+      TacProfileThread::OpenZone openZone;
+      openZone.nodeIndex = ProfilerGetChild( profiler, parentIndex, event.name );
+      openZone.beginCycles = event.cycles;
+      thread->openZones.push_back( openZone );
+    }
+    else if( !thread->openZones.empty() )
+    {
+      TacProfileThread::OpenZone openZone = thread->openZones.back();
+      thread->openZones.pop_back();
+      TacProfileNode& node = profiler->nodes[ openZone.nodeIndex ];
+      node.frameCycles += event.cycles - openZone.beginCycles;
+      node.frameCalls++;
+    }
+  }
+}
+
+void ProfilerFrameEnd()
+{
+  TacProfiler* profiler = &gProfiler;
+  if( profiler->nodes.empty() )
+  {
+    ProfilerAddNode( profiler, "null", 0 );
+  }
+  ProfilerCalibrate( profiler );
+
+  {
+    std::lock_guard< std::mutex > lock( gProfilerThreadsMutex );
+    for( u32 iThread = 0; iThread < gProfilerThreads.size(); ++iThread )
+    {
+      ProfilerReadThread( profiler, gProfilerThreads[ iThread ], iThread );
+    }
+  }
+
+  // a thread's time is the time spent in its top level zones
+  for( u32 rootIndex : profiler->threadRootIndexes )
+  {
+    TacProfileNode& root = profiler->nodes[ rootIndex ];
+    root.frameCycles = 0;
+    root.frameCalls = 1;
+    for( u32 childIndex : root.childIndexes )
+    {
+      root.frameCycles += profiler->nodes[ childIndex ].frameCycles;
+    }
+  }
+
+  if( profiler->cyclesPerMillisecond <= 0 )
+    return;
+
+  u32 iFrame = profiler->numFramesRecorded % TacProfileNode::sNumFrames;
+  profiler->numFramesRecorded++;
+  u32 numFrames = Minimum(
+    profiler->numFramesRecorded,
+    TacProfileNode::sNumFrames );
+  for( u32 nodeIndex = 1; nodeIndex < profiler->nodes.size(); ++nodeIndex )
+  {
+    TacProfileNode& node = profiler->nodes[ nodeIndex ];
+    node.lastMs = ( r32 )( node.frameCycles / profiler->cyclesPerMillisecond );
+    node.lastCalls = node.frameCalls;
+    node.historyMs[ iFrame ] = node.lastMs;
+    node.historyCalls[ iFrame ] = node.lastCalls;
+    node.frameCycles = 0;
+    node.frameCalls = 0;
+
+    // nodes added after the first frames have zeros in their history,
+    // which is correct since they didn't run
+    node.minMs = R32MAX;
+    node.maxMs = 0;
+    r32 totalMs = 0;
+    for( u32 iHistory = 0; iHistory < numFrames; ++iHistory )
+    {
+      r32 ms = node.historyMs[ iHistory ];
+      node.minMs = Minimum( node.minMs, ms );
+      node.maxMs = Maximum( node.maxMs, ms );
+      totalMs += ms;
+    }
+    node.avgMs = totalMs / numFrames;
+  }
+}
@@ -0,0 +1,106 @@
+#pragma once
+
+#include "tacTypes.h"
+#include "tacDefines.h"
+#include "tacIntrinsics.h"
+
+#include <atomic>
+#include <vector>
+
+// Usage:
+//
+//   void Foo()
+//   {
+//     TAC_PROFILE_SCOPE( "Foo" );
+//     ...
+//   }
+//
+// The name must be a string literal, nodes are matched by pointer.
+// Call ProfilerFrameEnd() once per frame from the main thread to fold the
+// zones recorded by every thread into the profile tree.
+
+#define TAC_PROFILE_SCOPE( name )\
+  TacProfileScope COMBINE( UNIQUE, profileScope )( name );
+
+struct TacProfileEvent
+{
+  const char* name; // null for the end of a zone
+  u64 cycles;
+};
+
+// Each thread only writes to its own ring, the main thread reads them
+// in ProfilerFrameEnd()
+struct TacProfileThread
+{
+  const static u32 maxEvents = 8192;
+  TacProfileEvent events[ maxEvents ];
+  std::atomic< u32 > numEventsWritten;
+
+  // owned by ProfilerFrameEnd()
+  u32 numEventsRead;
+  u32 rootNodeIndex;
+  struct OpenZone
+  {
+    u32 nodeIndex;
+    u64 beginCycles;
+  };
+  std::vector< OpenZone > openZones;
+};
+
+TacProfileThread* ProfilerGetThread();
+
+inline void ProfilerRecord( const char* name )
+{
+  TacProfileThread* thread = ProfilerGetThread();
+  u32 numEventsWritten =
+    thread->numEventsWritten.load( std::memory_order_relaxed );
+  TacProfileEvent& event =
+    thread->events[ numEventsWritten % TacProfileThread::maxEvents ];
+  event.name = name;
+  event.cycles = ReadCycleCounter();
+  thread->numEventsWritten.store(
+    numEventsWritten + 1,
+    std::memory_order_release );
+}
+
+struct TacProfileScope
+{
+  TacProfileScope( const char* name ) { ProfilerRecord( name ); }
+  ~TacProfileScope() { ProfilerRecord( nullptr ); }
+};
+
+struct TacProfileNode
+{
+  const char* name;
+  u32 parentIndex;
+  u32 depth;
+  std::vector< u32 > childIndexes;
+
+  // totals for the frame that is being recorded
+  u64 frameCycles;
+  u32 frameCalls;
+
+  // the last sNumFrames frames
+  static const u32 sNumFrames = 60;
+  r32 historyMs[ sNumFrames ];
+  u32 historyCalls[ sNumFrames ];
+
+  r32 minMs;
+  r32 avgMs;
+  r32 maxMs;
+  r32 lastMs;
+  u32 lastCalls;
+};
+
+struct TacProfiler
+{
+  // node 0 is unused, every thread gets a root node
+  std::vector< TacProfileNode > nodes;
+  std::vector< u32 > threadRootIndexes;
+  u32 numFramesRecorded;
+  r64 cyclesPerMillisecond;
+};
+
+void ProfilerFrameEnd();
+
+TacProfiler* ProfilerGet();
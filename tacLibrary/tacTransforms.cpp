@@ -0,0 +1,181 @@
+#include "tacTransforms.h"
+#include "tacFastMath.h"
+#include "tacDefines.h"
+
+#include <emmintrin.h> // sse2
+
+// The rotation is Rz * Ry * Rx, the order M4Transform uses. The world
+// matrix scales the rotation's columns, the inverse scales the rows of the
+// transposed rotation by the reciprocal scale and undoes the translation
+internalFunction void ComputeTransform(
+  const TacTransformsSoA& transforms,
+  u32 i,
+  m4& world,
+  m4& worldInverse )
+{
+  r32 sx = Sin( transforms.rotateXs[ i ] );
+  r32 cx = Cos( transforms.rotateXs[ i ] );
+  r32 sy = Sin( transforms.rotateYs[ i ] );
+  r32 cy = Cos( transforms.rotateYs[ i ] );
+  r32 sz = Sin( transforms.rotateZs[ i ] );
+  r32 cz = Cos( transforms.rotateZs[ i ] );
+
+  r32 r00 = cz * cy;
+  r32 r01 = cz * sy * sx - sz * cx;
+  r32 r02 = cz * sy * cx + sz * sx;
+  r32 r10 = sz * cy;
+  r32 r11 = sz * sy * sx + cz * cx;
+  r32 r12 = sz * sy * cx - cz * sx;
+  r32 r20 = -sy;
+  r32 r21 = cy * sx;
+  r32 r22 = cy * cx;
+
+  r32 scaleX = transforms.scaleXs[ i ];
+  r32 scaleY = transforms.scaleYs[ i ];
+  r32 scaleZ = transforms.scaleZs[ i ];
+  r32 tx = transforms.translateXs[ i ];
+  r32 ty = transforms.translateYs[ i ];
+  r32 tz = transforms.translateZs[ i ];
+  world = M4(
+    r00 * scaleX, r01 * scaleY, r02 * scaleZ, tx,
+    r10 * scaleX, r11 * scaleY, r12 * scaleZ, ty,
+    r20 * scaleX, r21 * scaleY, r22 * scaleZ, tz,
+    0, 0, 0, 1 );
+
+  r32 invScaleX = 1.0f / scaleX;
+  r32 invScaleY = 1.0f / scaleY;
+  r32 invScaleZ = 1.0f / scaleZ;
+  r32 i00 = r00 * invScaleX;
+  r32 i01 = r10 * invScaleX;
+  r32 i02 = r20 * invScaleX;
+  r32 i10 = r01 * invScaleY;
+  r32 i11 = r11 * invScaleY;
+  r32 i12 = r21 * invScaleY;
+  r32 i20 = r02 * invScaleZ;
+  r32 i21 = r12 * invScaleZ;
+  r32 i22 = r22 * invScaleZ;
+  worldInverse = M4(
+    i00, i01, i02, -( i00 * tx + i01 * ty + i02 * tz ),
+    i10, i11, i12, -( i10 * tx + i11 * ty + i12 * tz ),
+    i20, i21, i22, -( i20 * tx + i21 * ty + i22 * tz ),
+    0, 0, 0, 1 );
+}
+
+void ComputeTransformsScalar(
+  const TacTransformsSoA& transforms,
+  m4* worlds,
+  m4* worldInverses )
+{
+  for( u32 i = 0; i < transforms.count; ++i )
+    ComputeTransform( transforms, i, worlds[ i ], worldInverses[ i ] );
+}
+
+// rows[ 0 .. 3 ] hold one row of four matrixes, a column per register
+internalFunction void StoreRows( __m128 rows[ 4 ], m4* matrixes, u32 iRow )
+{
+  _MM_TRANSPOSE4_PS( rows[ 0 ], rows[ 1 ], rows[ 2 ], rows[ 3 ] );
+  for( u32 iMatrix = 0; iMatrix < 4; ++iMatrix )
+    _mm_storeu_ps( &matrixes[ iMatrix ]( iRow, 0 ), rows[ iMatrix ] );
+}
+
+void ComputeTransforms(
+  const TacTransformsSoA& transforms,
+  m4* worlds,
+  m4* worldInverses )
+{
+  const __m128 ones = _mm_set1_ps( 1.0f );
+  u32 i = 0;
+  for( ; i + 4 <= transforms.count; i += 4 )
+  {
+    __m128 sx, cx, sy, cy, sz, cz;
+    FastSinCos( _mm_loadu_ps( transforms.rotateXs + i ), &sx, &cx );
+    FastSinCos( _mm_loadu_ps( transforms.rotateYs + i ), &sy, &cy );
+    FastSinCos( _mm_loadu_ps( transforms.rotateZs + i ), &sz, &cz );
+
+    __m128 czsy = _mm_mul_ps( cz, sy );
+    __m128 szsy = _mm_mul_ps( sz, sy );
+    __m128 r00 = _mm_mul_ps( cz, cy );
+    __m128 r01 = _mm_sub_ps( _mm_mul_ps( czsy, sx ), _mm_mul_ps( sz, cx ) );
+    __m128 r02 = _mm_add_ps( _mm_mul_ps( czsy, cx ), _mm_mul_ps( sz, sx ) );
+    __m128 r10 = _mm_mul_ps( sz, cy );
+    __m128 r11 = _mm_add_ps( _mm_mul_ps( szsy, sx ), _mm_mul_ps( cz, cx ) );
+    __m128 r12 = _mm_sub_ps( _mm_mul_ps( szsy, cx ), _mm_mul_ps( cz, sx ) );
+    __m128 r20 = _mm_sub_ps( _mm_setzero_ps(), sy );
+    __m128 r21 = _mm_mul_ps( cy, sx );
+    __m128 r22 = _mm_mul_ps( cy, cx );
+
+    __m128 scaleX = _mm_loadu_ps( transforms.scaleXs + i );
+    __m128 scaleY = _mm_loadu_ps( transforms.scaleYs + i );
+    __m128 scaleZ = _mm_loadu_ps( transforms.scaleZs + i );
+    __m128 tx = _mm_loadu_ps( transforms.translateXs + i );
+    __m128 ty = _mm_loadu_ps( transforms.translateYs + i );
+    __m128 tz = _mm_loadu_ps( transforms.translateZs + i );
+
+    __m128 worldRows[ 3 ][ 4 ] =
+    {
+      {
+        _mm_mul_ps( r00, scaleX ),
+        _mm_mul_ps( r01, scaleY ),
+        _mm_mul_ps( r02, scaleZ ),
+        tx
+      },
+      {
+        _mm_mul_ps( r10, scaleX ),
+        _mm_mul_ps( r11, scaleY ),
+        _mm_mul_ps( r12, scaleZ ),
+        ty
+      },
+      {
+        _mm_mul_ps( r20, scaleX ),
+        _mm_mul_ps( r21, scaleY ),
+        _mm_mul_ps( r22, scaleZ ),
+        tz
+      },
+    };
+
+    __m128 invScaleX = _mm_div_ps( ones, scaleX );
+    __m128 invScaleY = _mm_div_ps( ones, scaleY );
+    __m128 invScaleZ = _mm_div_ps( ones, scaleZ );
+    __m128 inverseRows[ 3 ][ 4 ] =
+    {
+      {
+        _mm_mul_ps( r00, invScaleX ),
+        _mm_mul_ps( r10, invScaleX ),
+        _mm_mul_ps( r20, invScaleX ),
+      },
+      {
+        _mm_mul_ps( r01, invScaleY ),
+        _mm_mul_ps( r11, invScaleY ),
+        _mm_mul_ps( r21, invScaleY ),
+      },
+      {
+        _mm_mul_ps( r02, invScaleZ ),
+        _mm_mul_ps( r12, invScaleZ ),
+        _mm_mul_ps( r22, invScaleZ ),
+      },
+    };
+    for( u32 iRow = 0; iRow < 3; ++iRow )
+    {
+      __m128* row = inverseRows[ iRow ];
+      row[ 3 ] = _mm_sub_ps( _mm_setzero_ps(), _mm_add_ps(
+        _mm_add_ps( _mm_mul_ps( row[ 0 ], tx ), _mm_mul_ps( row[ 1 ], ty ) ),
+        _mm_mul_ps( row[ 2 ], tz ) ) );
+    }
+
+    for( u32 iRow = 0; iRow < 3; ++iRow )
+    {
+      StoreRows( worldRows[ iRow ], worlds + i, iRow );
+      StoreRows( inverseRows[ iRow ], worldInverses + i, iRow );
+    }
+    for( u32 iMatrix = i; iMatrix < i + 4; ++iMatrix )
+    {
+      _mm_storeu_ps( &worlds[ iMatrix ]( 3, 0 ), _mm_set_ps( 1, 0, 0, 0 ) );
+      _mm_storeu_ps(
+        &worldInverses[ iMatrix ]( 3, 0 ),
+        _mm_set_ps( 1, 0, 0, 0 ) );
+    }
+  }
+
+  for( ; i < transforms.count; ++i )
+    ComputeTransform( transforms, i, worlds[ i ], worldInverses[ i ] );
+}
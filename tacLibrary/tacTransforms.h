@@ -0,0 +1,36 @@
+#pragma once
+#include "tacMath.h"
+
+// Scales, euler rotations ( radians ), and translations stored by
+// component, so four transforms can be built at once.
+// The arrays don't have to be aligned
+struct TacTransformsSoA
+{
+  r32* scaleXs;
+  r32* scaleYs;
+  r32* scaleZs;
+  r32* rotateXs;
+  r32* rotateYs;
+  r32* rotateZs;
+  r32* translateXs;
+  r32* translateYs;
+  r32* translateZs;
+  u32 count;
+};
+
+// Writes worlds[ i ] = M4Transform( scale, rotate, translate ) and
+// worldInverses[ i ] = M4TransformInverse( scale, rotate, translate ).
+//
+// The sines and cosines are computed four at a time, and the inverse is
+// built from the transposed rotation and the reciprocal scale instead of
+// inverting a 4x4
+void ComputeTransforms(
+  const TacTransformsSoA& transforms,
+  m4* worlds,
+  m4* worldInverses );
+
+// same results as ComputeTransforms, one transform at a time
+void ComputeTransformsScalar(
+  const TacTransformsSoA& transforms,
+  m4* worlds,
+  m4* worldInverses );
@@ -4,11 +4,7 @@
 
 globalVariable s64 g_Time;
 globalVariable s64 g_TicksPerSecond;
-globalVariable int VERTEX_BUFFER_SIZE = 20000;
-globalVariable int INDEX_BUFFER_SIZE = 40000;
 
-globalVariable TacVertexBufferHandle    g_ImguiVertexBuffer;
-globalVariable TacIndexBufferHandle     g_ImguiIndexBuffer;
 globalVariable TacDepthStateHandle      g_ImguiDepthState;
 globalVariable TacShaderHandle          g_ImguiShader;
 globalVariable TacSamplerStateHandle    g_ImguiSamplerState;
@@ -108,26 +104,23 @@ LRESULT ImGui_ImplDX11_WndProcHandler(
 internalFunction void ImGui_ImplDX11_RenderDrawLists(
   ImDrawData* draw_data )
 {
-  renderer->SetDepthState( g_ImguiDepthState, 0 );
-  renderer->SetIndexBuffer( g_ImguiIndexBuffer );
-  renderer->SetVertexBuffers( &g_ImguiVertexBuffer, 1 );
-
-  ImDrawVert* vtx_dst;
-  ImDrawIdx* idx_dst;
-  FixedString< DEFAULT_ERR_LEN > myErrors = {};
+  if( !draw_data->TotalVtxCount || !draw_data->TotalIdxCount )
+    return;
 
-  renderer->MapVertexBuffer(
-    ( void** )&vtx_dst,
-    TacMap::WriteDiscard,
-    myErrors );
-  TacAssert( myErrors.size == 0 );
+  // the vertexes and indexes only live for this frame
+  TacUploadAllocation vtxUpload = renderer->AllocateUpload(
+    draw_data->TotalVtxCount * sizeof( ImDrawVert ),
+    4 );
+  TacUploadAllocation idxUpload = renderer->AllocateUpload(
+    draw_data->TotalIdxCount * sizeof( ImDrawIdx ),
+    4 );
+  if( !vtxUpload.mData || !idxUpload.mData )
+    return;
 
-  renderer->MapIndexBuffer(
-    ( void** )&idx_dst,
-    TacMap::WriteDiscard,
-    myErrors );
-  TacAssert( myErrors.size == 0 );
+  renderer->SetDepthState( g_ImguiDepthState, 0 );
 
+  ImDrawVert* vtx_dst = ( ImDrawVert* )vtxUpload.mData;
+  ImDrawIdx* idx_dst = ( ImDrawIdx* )idxUpload.mData;
   for( int n = 0; n < draw_data->CmdListsCount; n++ )
   {
     const ImDrawList* cmd_list = draw_data->CmdLists[n];
@@ -142,10 +135,6 @@ internalFunction void ImGui_ImplDX11_RenderDrawLists(
     vtx_dst += cmd_list->VtxBuffer.size();
     idx_dst += cmd_list->IdxBuffer.size();
   }
-  renderer->UnmapVertexBuffer(myErrors );
-  TacAssert( myErrors.size == 0 );
-  renderer->UnmapIndexBuffer(myErrors );
-  TacAssert( myErrors.size == 0 );
 
   // Setup viewport
   r32 w = ImGui::GetIO().DisplaySize.x;
@@ -172,8 +161,9 @@ internalFunction void ImGui_ImplDX11_RenderDrawLists(
       ( void* )mvp,
       sizeof( mvp ) );
   }
-  renderer->SetIndexBuffer( g_ImguiIndexBuffer );
-  renderer->SetVertexBuffers( &g_ImguiVertexBuffer, 1 );
+  TacAssert( sizeof( ImDrawIdx ) == 2 );
+  renderer->SetIndexBufferUpload( idxUpload.mOffset, TacTextureFormat::R16Uint );
+  renderer->SetVertexBufferUpload( 0, vtxUpload.mOffset, sizeof( ImDrawVert ) );
   renderer->SetPrimitiveTopology(
     TacPrimitive::TriangleList );
   renderer->SetSamplerState( "sampler0", g_ImguiSamplerState );
@@ -503,42 +493,6 @@ internalFunction void ImGui_ImplDX11_CreateDeviceObjects(
       g_ImguiDepthState,
       STRINGIFY( g_ImguiDepthState ) );
   }
-
-  // Vertex buffer
-  {
-    g_ImguiVertexBuffer = renderer->AddVertexBuffer(
-      TacBufferAccess::Dynamic,
-      nullptr,
-      VERTEX_BUFFER_SIZE,
-      sizeof( ImDrawVert ),
-      errors );
-    if( errors.size )
-      return;
-    gameInterface.renderer->SetName(
-      g_ImguiVertexBuffer,
-      STRINGIFY( g_ImguiVertexBuffer ) );
-  }
-
-
-  // index buffer
-  {
-    TacAssert( sizeof( ImDrawIdx ) == 2 );
-
-    g_ImguiIndexBuffer = renderer->AddIndexBuffer(
-      TacBufferAccess::Dynamic,
-      nullptr,
-      INDEX_BUFFER_SIZE,
-      TacTextureFormat::R16Uint,
-      INDEX_BUFFER_SIZE * 2,
-      //TacVariableType::uint,
-      //2,
-      errors );
-    if( errors.size )
-      return;
-    gameInterface.renderer->SetName(
-      g_ImguiIndexBuffer,
-      STRINGIFY( g_ImguiIndexBuffer ) );
-  }
 }
 
 internalFunction bool ImGui_ImplDX11_Init( HWND g_hWnd )
@@ -580,8 +534,6 @@ internalFunction bool ImGui_ImplDX11_Init( HWND g_hWnd )
 
 internalFunction void ImGui_ImplDX11_Shutdown()
 {
-  renderer->RemoveVertexBuffer( g_ImguiVertexBuffer );
-  renderer->RemoveIndexBuffer( g_ImguiIndexBuffer );
   renderer->RemoveDepthState( g_ImguiDepthState );
   renderer->RemoveShader( g_ImguiShader );
   renderer->RemoveSamplerState( g_ImguiSamplerState );
@@ -1021,10 +973,65 @@ void PrintStringCallback(
   OutputDebugString( buffer );
 }
 
+internalFunction void AddNullRendererStats(
+  TacRendererNullStats& total,
+  const TacRendererNullStats& frame )
+{
+  total.mNumCalls += frame.mNumCalls;
+  total.mNumDraws += frame.mNumDraws;
+  total.mNumInstances += frame.mNumInstances;
+  total.mNumIndexes += frame.mNumIndexes;
+  total.mNumStateChanges += frame.mNumStateChanges;
+  total.mNumRedundantStateChanges += frame.mNumRedundantStateChanges;
+  total.mNumBytesUploaded += frame.mNumBytesUploaded;
+  total.mNumResourcesCreated += frame.mNumResourcesCreated;
+  total.mNumResourcesRemoved += frame.mNumResourcesRemoved;
+  total.mNumValidationErrors += frame.mNumValidationErrors;
+}
+
+internalFunction void SaveNullRendererStats(
+  RendererNull* nullRenderer,
+  const TacRendererNullStats& total,
+  const char* filepath,
+  FixedString< DEFAULT_ERR_LEN >& errors )
+{
+  std::ofstream ofs( filepath );
+  if( !ofs.is_open() )
+  {
+    errors = "Failed to open ";
+    FixedStringAppend( errors, filepath );
+    return;
+  }
+  const TacRendererNullStats& last = nullRenderer->mLastFrameStats;
+  ofs << "frames " << nullRenderer->mNumFrames << std::endl;
+  ofs << "counter total lastframe" << std::endl;
+  ofs << "calls " << total.mNumCalls << " " << last.mNumCalls << std::endl;
+  ofs << "draws " << total.mNumDraws << " " << last.mNumDraws << std::endl;
+  ofs << "instances " << total.mNumInstances << " "
+    << last.mNumInstances << std::endl;
+  ofs << "indexes " << total.mNumIndexes << " "
+    << last.mNumIndexes << std::endl;
+  ofs << "statechanges " << total.mNumStateChanges << " "
+    << last.mNumStateChanges << std::endl;
+  ofs << "redundantstatechanges " << total.mNumRedundantStateChanges << " "
+    << last.mNumRedundantStateChanges << std::endl;
+  ofs << "bytesuploaded " << total.mNumBytesUploaded << " "
+    << last.mNumBytesUploaded << std::endl;
+  ofs << "resourcescreated " << total.mNumResourcesCreated << " "
+    << last.mNumResourcesCreated << std::endl;
+  ofs << "resourcesremoved " << total.mNumResourcesRemoved << " "
+    << last.mNumResourcesRemoved << std::endl;
+  ofs << "validationerrors " << total.mNumValidationErrors << " "
+    << last.mNumValidationErrors << std::endl;
+  if( nullRenderer->mFirstError.size )
+    ofs << "firsterror " << nullRenderer->mFirstError.buffer << std::endl;
+}
+
 void RunGame( 
   HINSTANCE hInstance,
   int nCmdShow,
   const char* dllname,
+  const TacWin32Options& options,
   FixedString< DEFAULT_ERR_LEN >& unrecoverableErrors )
 {
   // setup the vkcodemap
@@ -1226,10 +1233,56 @@ void RunGame(
     }
   }
 
+  gameInterface.running = true;
+
+#ifdef TACDEBUG
+  // unit tests -----------------------------------------------------------
+  MatrixSimdUnitTests();
+  StreamUnitTests();
+#endif
+
+  // threading ------------------------------------------------------------
+  const u32 numWorkerThreads = 3;
+  // leave the other workers free for per-frame work while models stream in
+  const u32 numBackgroundThreads = 1;
+  TacWorkQueue workQueue;
+  workQueue.Init(
+    numWorkerThreads,
+    numBackgroundThreads,
+    &gameInterface.running );
+  OnDestruct( workQueue.Uninit(); );
+  win32State.memory.workQueue = &workQueue;
+  thread.logicalThreadIndex = numWorkerThreads;
+  gameInterface.thread = &thread;
+  if( false )
+  {
+    PushEntry( &workQueue, PrintStringCallback, "String  0" );
+    PushEntry( &workQueue, PrintStringCallback, "String  1" );
+    PushEntry( &workQueue, PrintStringCallback, "String  2" );
+    PushEntry( &workQueue, PrintStringCallback, "String  3" );
+    PushEntry( &workQueue, PrintStringCallback, "String  4" );
+    PushEntry( &workQueue, PrintStringCallback, "String  5" );
+    PushEntry( &workQueue, PrintStringCallback, "String  6" );
+    PushEntry( &workQueue, PrintStringCallback, "String  7" );
+    PushEntry( &workQueue, PrintStringCallback, "String  8" );
+    PushEntry( &workQueue, PrintStringCallback, "String  9" );
+    PushEntry( &workQueue, PrintStringCallback, "String 10" );
+    PushEntry( &workQueue, PrintStringCallback, "String 11" );
+    PushEntry( &workQueue, PrintStringCallback, "String 12" );
+    PushEntry( &workQueue, PrintStringCallback, "String 13" );
+    PushEntry( &workQueue, PrintStringCallback, "String 14" );
+    PushEntry( &workQueue, PrintStringCallback, "String 15" );
+    PushEntry( &workQueue, PrintStringCallback, "String 16" );
+    PushEntry( &workQueue, PrintStringCallback, "String 17" );
+    PushEntry( &workQueue, PrintStringCallback, "String 18" );
+    PushEntry( &workQueue, PrintStringCallback, "String 19" );
+    CompleteAllWork( &workQueue, &thread );
+  }
+
   // renderer -------------------------------------------------------------
   void* rendererBlock = VirtualAlloc(
     0,
-    sizeof( RendererDX11 ),
+    Maximum( sizeof( RendererDX11 ), sizeof( RendererSoftware ) ),
     MEM_RESERVE | MEM_COMMIT,
     PAGE_READWRITE );
   if( !rendererBlock )
@@ -1238,13 +1291,37 @@ void RunGame(
     AppendFileInfo( unrecoverableErrors );
     return;
   }
-  renderer = new( rendererBlock ) RendererDX11(
-    g_hWnd,
-    unrecoverableErrors );
-  if( unrecoverableErrors.size )
-    return;
+  // only set for TacWin32RendererType::Null and Software
+  RendererNull* nullRenderer = nullptr;
+  RendererSoftware* softwareRenderer = nullptr;
+  TacRendererNullStats nullRendererTotals = {};
+  if( options.rendererType == TacWin32RendererType::Null )
+  {
+    nullRenderer = new( rendererBlock ) RendererNull( width, height );
+    nullRenderer->mRecording = true;
+    renderer = nullRenderer;
+  }
+  else if( options.rendererType == TacWin32RendererType::Software )
+  {
+    softwareRenderer = new( rendererBlock ) RendererSoftware(
+      width,
+      height,
+      &workQueue,
+      &thread );
+    nullRenderer = softwareRenderer;
+    renderer = softwareRenderer;
+  }
+  else
+  {
+    renderer = new( rendererBlock ) RendererDX11(
+      g_hWnd,
+      unrecoverableErrors );
+    if( unrecoverableErrors.size )
+      return;
+  }
   OnDestruct( renderer->~TacRenderer(); );
   gameInterface.renderer = renderer;
+  gameInterface.softwareRenderer = softwareRenderer;
 
   // imgui ----------------------------------------------------------------
   ImGui_ImplDX11_Init( g_hWnd );
@@ -1275,40 +1352,6 @@ void RunGame(
     tmpPDB = dllname;
     FixedStringAppend( tmpPDB, "Open.pdb" );
   }
-  gameInterface.running = true;
-
-  // threading ------------------------------------------------------------
-  const u32 numWorkerThreads = 3;
-  TacWorkQueue highPriorityQueue;
-  highPriorityQueue.Init( numWorkerThreads, &gameInterface.running );
-  win32State.memory.highPriorityQueue = &highPriorityQueue;
-  thread.logicalThreadIndex = numWorkerThreads;
-  gameInterface.thread = &thread;
-  if( false )
-  {
-    PushEntry( &highPriorityQueue, PrintStringCallback, "String  0" );
-    PushEntry( &highPriorityQueue, PrintStringCallback, "String  1" );
-    PushEntry( &highPriorityQueue, PrintStringCallback, "String  2" );
-    PushEntry( &highPriorityQueue, PrintStringCallback, "String  3" );
-    PushEntry( &highPriorityQueue, PrintStringCallback, "String  4" );
-    PushEntry( &highPriorityQueue, PrintStringCallback, "String  5" );
-    PushEntry( &highPriorityQueue, PrintStringCallback, "String  6" );
-    PushEntry( &highPriorityQueue, PrintStringCallback, "String  7" );
-    PushEntry( &highPriorityQueue, PrintStringCallback, "String  8" );
-    PushEntry( &highPriorityQueue, PrintStringCallback, "String  9" );
-    PushEntry( &highPriorityQueue, PrintStringCallback, "String 10" );
-    PushEntry( &highPriorityQueue, PrintStringCallback, "String 11" );
-    PushEntry( &highPriorityQueue, PrintStringCallback, "String 12" );
-    PushEntry( &highPriorityQueue, PrintStringCallback, "String 13" );
-    PushEntry( &highPriorityQueue, PrintStringCallback, "String 14" );
-    PushEntry( &highPriorityQueue, PrintStringCallback, "String 15" );
-    PushEntry( &highPriorityQueue, PrintStringCallback, "String 16" );
-    PushEntry( &highPriorityQueue, PrintStringCallback, "String 17" );
-    PushEntry( &highPriorityQueue, PrintStringCallback, "String 18" );
-    PushEntry( &highPriorityQueue, PrintStringCallback, "String 19" );
-    CompleteAllWork( &highPriorityQueue, &thread );
-  }
-
   // framerate /input ----------------------------------------------------
   gameInput.dt = 1.0f / 60.0f;
   gameInput.windowWidth = width;
@@ -1431,6 +1474,41 @@ void RunGame(
 
     gameInterface.renderer->SwapBuffers();
 
+    if( nullRenderer )
+    {
+      AddNullRendererStats(
+        nullRendererTotals,
+        nullRenderer->mLastFrameStats );
+      if( nullRenderer->mNumFrames == options.numHeadlessFrames &&
+        softwareRenderer )
+      {
+        softwareRenderer->SaveTexture(
+          &thread,
+          softwareRenderer->GetBackbufferColor(),
+          "tacData/softwareRenderer.ppm",
+          unrecoverableErrors );
+        if( unrecoverableErrors.size )
+          return;
+        gameInterface.running = false;
+      }
+      else if( nullRenderer->mNumFrames == options.numHeadlessFrames )
+      {
+        nullRenderer->SaveRecording(
+          &thread,
+          "tacData/nullRenderer.tacbinary",
+          unrecoverableErrors );
+        if( unrecoverableErrors.size )
+          return;
+        SaveNullRendererStats(
+          nullRenderer,
+          nullRendererTotals,
+          "tacData/nullRendererStats.txt",
+          unrecoverableErrors );
+        if( unrecoverableErrors.size )
+          return;
+        gameInterface.running = false;
+      }
+    }
 
     const double secondsPerReload = 1.0f; 
     static double secondsLeftTillNextReload = 0;
@@ -1536,14 +1614,43 @@ int WINAPI wWinMain(
   _In_ int nCmdShow )
 {
   UNREFERENCED_PARAMETER( hPrevInstance );
-  UNREFERENCED_PARAMETER( lpCmdLine );
   FixedString< DEFAULT_ERR_LEN > mainErrors = {};
   const char* projects[] = 
   {
     "tacModelConverter",
     "tacDemo",
   };
-  RunGame( hInstance, nCmdShow, projects[ 1 ], mainErrors );
+
+  TacWin32Options options = {};
+  options.rendererType = TacWin32RendererType::DX11;
+  // -nullrenderer <frames> or -softwarerenderer <frames>, 100 frames if
+  // the count is left out. Models stream in, so the first few frames
+  // don't have everything
+  struct RendererSwitch
+  {
+    const wchar_t* name;
+    TacWin32RendererType rendererType;
+  };
+  const RendererSwitch rendererSwitches[] =
+  {
+    { L"-nullrenderer", TacWin32RendererType::Null },
+    { L"-softwarerenderer", TacWin32RendererType::Software },
+  };
+  for( const RendererSwitch& rendererSwitch : rendererSwitches )
+  {
+    const wchar_t* arg = wcsstr( lpCmdLine, rendererSwitch.name );
+    if( !arg )
+      continue;
+    options.rendererType = rendererSwitch.rendererType;
+    options.numHeadlessFrames = ( u32 )wcstoul(
+      arg + wcslen( rendererSwitch.name ),
+      nullptr,
+      10 );
+    if( !options.numHeadlessFrames )
+      options.numHeadlessFrames = 100;
+  }
+
+  RunGame( hInstance, nCmdShow, projects[ 1 ], options, mainErrors );
   HandleErrors( mainErrors );
   return 0;
 }
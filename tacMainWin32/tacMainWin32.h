@@ -8,6 +8,8 @@
 #include "tacGraphics/tac3camera.h"
 #include "tacGraphics/tacRenderer.h"
 #include "tacGraphics/tacRendererDX11.h"
+#include "tacGraphics/tacRendererNull.h"
+#include "tacGraphics/tacRendererSoftware.h"
 
 // std libs
 #include <iostream>
@@ -21,10 +23,29 @@
 // window icon
 #include "resource.h"
 
+enum class TacWin32RendererType
+{
+  DX11,
+  // Runs numHeadlessFrames frames, then saves the recorded calls and the
+  // counters and quits
+  Null,
+  // Runs numHeadlessFrames frames, then saves the backbuffer as a ppm
+  // and quits
+  Software,
+};
+
+// from the command line
+struct TacWin32Options
+{
+  TacWin32RendererType rendererType;
+  u32 numHeadlessFrames;
+};
+
 void RunGame( 
   HINSTANCE hInstance,
   int nCmdShow,
   const char* dllname,
+  const TacWin32Options& options,
   FixedString< DEFAULT_ERR_LEN >& unrecoverableErrors );
 
 void HandleErrors(
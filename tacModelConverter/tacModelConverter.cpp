@@ -242,6 +242,11 @@ void LoadModelAssip(
   }
 
   myModel.numSubModels = scene->mNumMeshes;
+  // Only full detail. The converter doesn't save lods, the game simplifies
+  // models when it loads them, see ModelFormatGenerateLods
+  myModel.numLods = 1;
+  for( r32& lodError : myModel.lodErrors )
+    lodError = 0;
 
   for( u32 i = 0; i < scene->mNumMeshes; ++i )
   {
@@ -506,7 +511,8 @@ void LoadModelAssip(
       const TacVariableType indexType = TacVariableType::uint;
       const u32 indexNumBytes = 4;
 
-      mySubModel.buffers = ModelBuffersCreate(
+      mySubModel.numLods = 1;
+      mySubModel.lods[ 0 ] = ModelBuffersCreate(
         myRenderer,
         myAiMesh->mNumVertices,
         vertexBufferDatas,
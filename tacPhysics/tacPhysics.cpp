@@ -1,13 +1,19 @@
 #include "tacPhysics.h"
+#include "tacLibrary\tacProfiler.h"
 
 u32 TacPhysics::GetDimensions()
 {
   return mNumParticles * 6;
 }
 
-void TacPhysics::Update( float dt )
+void TacPhysics::Update( float dt, u32 numSubsteps )
 {
-  EulerStep( dt );
+  TAC_PROFILE_SCOPE( "TacPhysics::Update" );
+  TacAssert( numSubsteps );
+  for( u32 iSubstep = 0; iSubstep < numSubsteps; ++iSubstep )
+  {
+    EulerStep( dt / numSubsteps );
+  }
 
   // Recalculate manifolds between every box-box collision
   mNumManifolds = 0;
@@ -155,22 +161,17 @@ void TacPhysicsBox::RecalculateVertexes()
 {
   m4 world = M4Transform( mBoxScale, mBoxRot, mBoxPos );
 
-  // calculate the 8 box vertexes
-  v3* worldSpaceBoxVertex = mWorldSpaceBoxVertexes;
-  for( u32 x = 0; x < 2; ++x )
-  {
-    r32 xval = x * 2.0f - 1.0f;
-    for( u32 y = 0; y < 2; ++y )
-    {
-      r32 yval = y * 2.0f - 1.0f;
-      for( u32 z = 0; z < 2; ++z )
-      {
-        worldSpaceBoxVertex->x = xval;
-        worldSpaceBoxVertex->y = yval;
-        worldSpaceBoxVertex->z = z * 2.0f - 1.0f;
-        *worldSpaceBoxVertex = ( world * V4( *worldSpaceBoxVertex, 1.0f ) ).xyz;
-        ++worldSpaceBoxVertex;
-      }
-    }
-  }
+  // the model space box vertexes, by component
+  r32 xs[ sNumBoxVertexes ] = { -1, -1, -1, -1, 1, 1, 1, 1 };
+  r32 ys[ sNumBoxVertexes ] = { -1, -1, 1, 1, -1, -1, 1, 1 };
+  r32 zs[ sNumBoxVertexes ] = { -1, 1, -1, 1, -1, 1, -1, 1 };
+
+  TacVectorsSoA vertexes;
+  vertexes.xs = xs;
+  vertexes.ys = ys;
+  vertexes.zs = zs;
+  vertexes.count = sNumBoxVertexes;
+  TransformPoints( world, vertexes, vertexes );
+  for( u32 i = 0; i < sNumBoxVertexes; ++i )
+    mWorldSpaceBoxVertexes[ i ] = V3( xs[ i ], ys[ i ], zs[ i ] );
 }
@@ -44,7 +44,8 @@ struct TacPhysics
   TacPhysicsParticle mParticles[ sMaxParticles ];
   u32 mNumParticles;
   u32 GetDimensions();
-  void Update( float dt );
+  // numSubsteps euler steps of dt / numSubsteps
+  void Update( float dt, u32 numSubsteps );
   void AddPartile( const TacPhysicsParticle& particle );
   void AddBox( const TacPhysicsBox& box );
   void GetState( r32* destination );